@@ -31,6 +31,36 @@ extern "C" {
 /** Executor type (opaque) */
 typedef struct vlc_executor vlc_executor_t;
 
+/**
+ * Priority of a submitted runnable.
+ *
+ * Runnables from the interactive lane are always started before any runnable
+ * from the background lane.
+ */
+enum vlc_executor_priority
+{
+    /** Bulk work, nobody is actively waiting for it (default) */
+    VLC_EXECUTOR_PRIORITY_BACKGROUND,
+    /** Work a user is waiting for */
+    VLC_EXECUTOR_PRIORITY_INTERACTIVE,
+};
+
+/**
+ * Executor statistics, cumulated since its creation.
+ */
+struct vlc_executor_stats
+{
+    /** Number of runnables started */
+    uint64_t started;
+    /** Number of runnables started by another thread than the one they were
+     * queued to */
+    uint64_t stolen;
+    /** Sum of the delays between submission and start */
+    vlc_tick_t latency_total;
+    /** Maximum delay between submission and start */
+    vlc_tick_t latency_max;
+};
+
 /**
  * A Runnable encapsulates a task to be run from an executor thread.
  */
@@ -60,6 +90,8 @@ struct vlc_runnable {
 
     /* Private data used by the vlc_executor_t (do not touch) */
     struct vlc_list node;
+    void *queue;
+    vlc_tick_t submitted;
 };
 
 /**
@@ -145,6 +177,21 @@ vlc_executor_Delete(vlc_executor_t *executor);
 VLC_API void
 vlc_executor_Submit(vlc_executor_t *executor, struct vlc_runnable *runnable);
 
+/**
+ * Submit a runnable for execution with a given priority.
+ *
+ * vlc_executor_Submit() is equivalent to this function with
+ * VLC_EXECUTOR_PRIORITY_BACKGROUND.
+ *
+ * \param executor the executor
+ * \param runnable the task to run
+ * \param priority the lane to queue the runnable to
+ */
+VLC_API void
+vlc_executor_SubmitWithPriority(vlc_executor_t *executor,
+                                struct vlc_runnable *runnable,
+                                enum vlc_executor_priority priority);
+
 /**
  * Cancel a runnable previously submitted.
  *
@@ -176,6 +223,16 @@ vlc_executor_Cancel(vlc_executor_t *executor, struct vlc_runnable *runnable);
 VLC_API void
 vlc_executor_WaitIdle(vlc_executor_t *executor);
 
+/**
+ * Get the executor statistics.
+ *
+ * \param executor the executor
+ * \param stats the structure to fill
+ */
+VLC_API void
+vlc_executor_GetStats(vlc_executor_t *executor,
+                      struct vlc_executor_stats *stats);
+
 # ifdef __cplusplus
 }
 # endif
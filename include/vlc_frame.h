@@ -170,6 +170,27 @@ VLC_API vlc_frame_t *vlc_frame_Init(vlc_frame_t *frame,
  */
 VLC_API vlc_frame_t *vlc_frame_Alloc(size_t size) VLC_USED VLC_MALLOC;
 
+/**
+ * Frame allocator statistics.
+ *
+ * Small frames from vlc_frame_Alloc() are recycled through per-thread caches.
+ * These counters only track the slow paths, since process start.
+ */
+struct vlc_frame_cache_stats
+{
+    uint64_t allocated; /**< frames allocated from the heap */
+    uint64_t freed; /**< frames returned to the heap */
+    uint64_t refills; /**< batches moved from the shared depot to a thread */
+    uint64_t spills; /**< batches moved from a thread to the shared depot */
+};
+
+/**
+ * Gets the frame allocator statistics.
+ *
+ * @param stats structure to fill [OUT]
+ */
+VLC_API void vlc_frame_GetCacheStats(struct vlc_frame_cache_stats *stats);
+
 VLC_API vlc_frame_t *vlc_frame_TryRealloc(vlc_frame_t *, ssize_t pre, size_t body) VLC_USED;
 
 /**
@@ -824,6 +845,93 @@ static inline size_t vlc_fifo_Count (vlc_fifo_t *fifo)
     return depth;
 }
 
+/**
+ * @}
+ * \defgroup frame_spsc_fifo Lock-free frame FIFO
+ * Bounded frame queue between exactly one producer thread and one consumer
+ * thread.
+ *
+ * Unlike vlc_fifo_t, queueing and dequeueing frames do not take any lock,
+ * and the producer only issues a wake-up when the consumer is actually
+ * sleeping. Frames count and bytes accounting are the same as with
+ * vlc_fifo_GetCount() and vlc_fifo_GetBytes().
+ * @{
+ */
+
+typedef struct vlc_spsc_fifo vlc_spsc_fifo_t;
+
+/**
+ * Creates a single producer, single consumer FIFO.
+ *
+ * @param capacity maximum number of queued frames, rounded up to a power
+ *                 of two
+ * @return the FIFO or NULL if the capacity is too large or on memory error
+ */
+VLC_API vlc_spsc_fifo_t *vlc_spsc_fifo_New(size_t capacity)
+VLC_USED VLC_MALLOC;
+
+/**
+ * Deletes a FIFO created by vlc_spsc_fifo_New().
+ *
+ * @note Any queued frames are also released.
+ * @warning Neither the producer nor the consumer may be using the FIFO.
+ */
+VLC_API void vlc_spsc_fifo_Delete(vlc_spsc_fifo_t *);
+
+/**
+ * Queues one frame at the end of the FIFO.
+ *
+ * This function may only be called from the producer thread. It never
+ * waits.
+ *
+ * @param frame frame to queue (must not be a chain)
+ * @retval true the frame was queued
+ * @retval false the FIFO is full, the frame still belongs to the caller
+ */
+VLC_API bool vlc_spsc_fifo_Put(vlc_spsc_fifo_t *, vlc_frame_t *frame) VLC_USED;
+
+/**
+ * Dequeues the first frame from the FIFO, if any.
+ *
+ * This function may only be called from the consumer thread. It never
+ * waits.
+ *
+ * @return the first frame or NULL if the FIFO is empty
+ */
+VLC_API vlc_frame_t *vlc_spsc_fifo_TryGet(vlc_spsc_fifo_t *) VLC_USED;
+
+/**
+ * Dequeues the first frame from the FIFO, waiting for one if necessary.
+ *
+ * This function may only be called from the consumer thread.
+ *
+ * @return the first frame, or NULL if the FIFO is empty and was killed
+ */
+VLC_API vlc_frame_t *vlc_spsc_fifo_Get(vlc_spsc_fifo_t *) VLC_USED;
+
+/**
+ * Wakes up the consumer for good.
+ *
+ * Subsequent vlc_spsc_fifo_Get() calls return NULL instead of waiting once
+ * the FIFO is empty. This function can be called from any thread.
+ */
+VLC_API void vlc_spsc_fifo_Kill(vlc_spsc_fifo_t *);
+
+/**
+ * Counts the frames in the FIFO.
+ *
+ * The value is exact from the producer and consumer threads with respect to
+ * their own operations, and a snapshot from any other thread.
+ */
+VLC_API size_t vlc_spsc_fifo_GetCount(const vlc_spsc_fifo_t *) VLC_USED;
+
+/**
+ * Counts the bytes of the frames in the FIFO.
+ *
+ * Same remarks as vlc_spsc_fifo_GetCount() apply.
+ */
+VLC_API size_t vlc_spsc_fifo_GetBytes(const vlc_spsc_fifo_t *) VLC_USED;
+
 /** @} */
 
 /** @} */
@@ -544,6 +544,12 @@ struct input_stats_t
     /* Aout */
     int64_t i_played_abuffers;
     int64_t i_lost_abuffers;
+
+    /* Frame allocator caches, for the whole process */
+    int64_t i_frame_cache_allocated;
+    int64_t i_frame_cache_freed;
+    int64_t i_frame_cache_refills;
+    int64_t i_frame_cache_spills;
 };
 
 /**
@@ -42,6 +42,7 @@ struct vlc_http_conn
 {
     const struct vlc_http_conn_cbs *cbs;
     struct vlc_tls *tls;
+    bool multiplexed; /**< Whether concurrent streams are supported */
 };
 
 static inline struct vlc_http_stream *
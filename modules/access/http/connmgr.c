@@ -287,6 +287,11 @@ struct vlc_http_cookie_jar_t *vlc_http_mgr_get_jar(struct vlc_http_mgr *mgr)
     return mgr->jar;
 }
 
+bool vlc_http_mgr_can_multiplex(struct vlc_http_mgr *mgr)
+{
+    return mgr->conn != NULL && mgr->conn->multiplexed;
+}
+
 struct vlc_http_mgr *vlc_http_mgr_create(vlc_object_t *obj,
                                          struct vlc_http_cookie_jar_t *jar)
 {
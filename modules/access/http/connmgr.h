@@ -57,6 +57,14 @@ struct vlc_http_msg *vlc_http_mgr_request(struct vlc_http_mgr *mgr, bool https,
 
 struct vlc_http_cookie_jar_t *vlc_http_mgr_get_jar(struct vlc_http_mgr *);
 
+/**
+ * Checks for request multiplexing
+ *
+ * @return true if further requests would be multiplexed on the current
+ * connection (HTTP/2) rather than require a new connection.
+ */
+bool vlc_http_mgr_can_multiplex(struct vlc_http_mgr *);
+
 /**
  * Creates an HTTP connection manager
  *
@@ -34,15 +34,31 @@
 #include <vlc_block.h>
 #include <vlc_strings.h>
 #include "message.h"
+#include "connmgr.h"
 #include "resource.h"
 #include "file.h"
 
 #pragma GCC visibility push(default)
 
+/** Number of earlier ranged responses kept open for later seeks */
+#define VLC_HTTP_FILE_RANGES 3
+/** Distance to skip through rather than to issue a new request for */
+#define VLC_HTTP_FILE_SKIP (1u << 20)
+/** Largest receive window of a kept response (the HTTP/2 initial window) */
+#define VLC_HTTP_FILE_PARK_WINDOW (1u << 20)
+
+struct vlc_http_file_range
+{
+    struct vlc_http_msg *response;
+    uintmax_t offset; /**< Offset of the next byte to read from response */
+};
+
 struct vlc_http_file
 {
     struct vlc_http_resource resource;
     uintmax_t offset;
+    block_t *head; /**< Data already read past a seek target */
+    struct vlc_http_file_range ranges[VLC_HTTP_FILE_RANGES]; /**< MRU first */
 };
 
 static int vlc_http_file_req(const struct vlc_http_resource *res,
@@ -104,10 +120,23 @@ fail:
     return -1;
 }
 
+static void vlc_http_file_destroy_ranges(struct vlc_http_resource *res)
+{
+    struct vlc_http_file *file = (struct vlc_http_file *)res;
+
+    if (file->head != NULL)
+        block_Release(file->head);
+
+    for (unsigned i = 0; i < VLC_HTTP_FILE_RANGES; i++)
+        if (file->ranges[i].response != NULL)
+            vlc_http_msg_destroy(file->ranges[i].response);
+}
+
 static const struct vlc_http_resource_cbs vlc_http_file_callbacks =
 {
     vlc_http_file_req,
     vlc_http_file_resp,
+    vlc_http_file_destroy_ranges,
 };
 
 struct vlc_http_resource *vlc_http_file_create(struct vlc_http_mgr *mgr,
@@ -118,6 +147,10 @@ struct vlc_http_resource *vlc_http_file_create(struct vlc_http_mgr *mgr,
     if (unlikely(file == NULL))
         return NULL;
 
+    file->head = NULL;
+    for (unsigned i = 0; i < VLC_HTTP_FILE_RANGES; i++)
+        file->ranges[i].response = NULL;
+
     if (vlc_http_res_init(&file->resource, &vlc_http_file_callbacks, mgr,
                           uri, ua, ref))
     {
@@ -201,14 +234,119 @@ bool vlc_http_file_can_seek(struct vlc_http_resource *res)
     return vlc_http_msg_can_seek(res->response);
 }
 
-int vlc_http_file_seek(struct vlc_http_resource *res, uintmax_t offset)
+/**
+ * Retires the current response.
+ *
+ * Over HTTP/2, a ranged response is kept open rather than reset: the server
+ * keeps sending data up to the stream receive window, so that returning close
+ * to that offset later does not cost a round trip. Only responses whose
+ * window did not grow while being read are kept: nothing can shrink it back,
+ * so the server could otherwise fill many megabytes per kept response.
+ */
+static void vlc_http_file_park(struct vlc_http_file *file)
 {
-    struct vlc_http_msg *resp = vlc_http_res_open(res, &offset);
+    struct vlc_http_resource *res = &file->resource;
+    struct vlc_http_msg *resp = res->response;
+    uintmax_t offset = file->offset;
+
+    res->response = NULL;
+
+    if (file->head != NULL)
+    {
+        offset += file->head->i_buffer;
+        block_Release(file->head);
+        file->head = NULL;
+    }
+
     if (resp == NULL)
+        return;
+
+    if (vlc_http_msg_get_status(resp) != 206
+     || !vlc_http_mgr_can_multiplex(res->manager)
+     || vlc_http_msg_get_window(resp) > VLC_HTTP_FILE_PARK_WINDOW)
+    {
+        vlc_http_msg_destroy(resp);
+        return;
+    }
+
+    struct vlc_http_file_range *last = &file->ranges[VLC_HTTP_FILE_RANGES - 1];
+
+    if (last->response != NULL)
+        vlc_http_msg_destroy(last->response);
+    memmove(file->ranges + 1, file->ranges,
+            (VLC_HTTP_FILE_RANGES - 1) * sizeof (file->ranges[0]));
+    file->ranges[0].response = resp;
+    file->ranges[0].offset = offset;
+}
+
+/**
+ * Resumes reading from a parked response slightly before the seek target.
+ */
+static int vlc_http_file_resume(struct vlc_http_file *file, uintmax_t offset)
+{
+    unsigned i;
+
+    for (i = 0; i < VLC_HTTP_FILE_RANGES; i++)
+    {
+        const struct vlc_http_file_range *r = &file->ranges[i];
+
+        if (r->response != NULL && offset >= r->offset
+         && offset - r->offset <= VLC_HTTP_FILE_SKIP)
+            break;
+    }
+
+    if (i == VLC_HTTP_FILE_RANGES)
         return -1;
 
+    struct vlc_http_file_range range = file->ranges[i];
+    block_t *head = NULL;
+
+    memmove(file->ranges + i, file->ranges + i + 1,
+            (VLC_HTTP_FILE_RANGES - 1 - i) * sizeof (file->ranges[0]));
+    file->ranges[VLC_HTTP_FILE_RANGES - 1].response = NULL;
+
+    while (range.offset < offset)
+    {
+        block_t *block = vlc_http_msg_read(range.response);
+        if (block == NULL || block == vlc_http_error)
+        {
+            vlc_http_msg_destroy(range.response);
+            return -1;
+        }
+
+        if (block->i_buffer > offset - range.offset)
+        {
+            size_t skip = offset - range.offset;
+
+            block->p_buffer += skip;
+            block->i_buffer -= skip;
+            range.offset += skip;
+            head = block;
+            break;
+        }
+
+        range.offset += block->i_buffer;
+        block_Release(block);
+    }
+
+    vlc_http_file_park(file);
+    file->resource.response = range.response;
+    file->offset = offset;
+    file->head = head;
+    return 0;
+}
+
+int vlc_http_file_seek(struct vlc_http_resource *res, uintmax_t offset)
+{
     struct vlc_http_file *file = (struct vlc_http_file *)res;
 
+    if (vlc_http_file_resume(file, offset) == 0)
+        return 0;
+
+    struct vlc_http_msg *resp = vlc_http_res_open(res, &offset);
+    if (resp == NULL)
+        return -1;
+
     int status = vlc_http_msg_get_status(resp);
     if (res->response != NULL)
     {   /* Accept the new and ditch the old one if:
@@ -221,9 +359,9 @@ int vlc_http_file_seek(struct vlc_http_resource *res, uintmax_t offset)
             vlc_http_msg_destroy(resp);
             return -1;
         }
-        vlc_http_msg_destroy(res->response);
     }
 
+    vlc_http_file_park(file);
     res->response = resp;
     file->offset = offset;
     return 0;
@@ -232,7 +370,16 @@ int vlc_http_file_seek(struct vlc_http_resource *res, uintmax_t offset)
 block_t *vlc_http_file_read(struct vlc_http_resource *res)
 {
     struct vlc_http_file *file = (struct vlc_http_file *)res;
-    block_t *block = vlc_http_res_read(res);
+    block_t *block = file->head;
+
+    if (block != NULL)
+    {
+        file->head = NULL;
+        file->offset += block->i_buffer;
+        return block;
+    }
+
+    block = vlc_http_res_read(res);
 
     if (block == vlc_http_error)
     {   /* Automatically reconnect on error if server supports seek */
@@ -47,6 +47,8 @@ static const char *replies[2] = { NULL, NULL };
 static uintmax_t offset = 0;
 static bool secure = true;
 static bool etags = false;
+static bool multiplex = false;
+static size_t window = SIZE_MAX;
 static int lang = -1;
 
 static vlc_http_cookie_jar_t *jar;
@@ -135,6 +137,64 @@ int main(void)
     assert(vlc_http_file_read(f) == NULL);
     vlc_http_file_destroy(f);
 
+    /* Multiplexed seeks */
+    replies[0] = "HTTP/1.1 206 Partial Content\r\n"
+                 "Content-Range: bytes 0-2344/2345\r\n"
+                 "ETag: W/\"foobar42\"\r\n"
+                 "\r\n";
+
+    offset = 0;
+    multiplex = true;
+    window = 1048575;
+    f = vlc_http_file_create(NULL, url, ua, NULL);
+    assert(f != NULL);
+    assert(vlc_http_file_get_size(f) == 2345);
+
+    replies[0] = "HTTP/1.1 206 Partial Content\r\n"
+                 "Content-Range: bytes 1234-3455/3456\r\n"
+                 "ETag: W/\"foobar42\"\r\n"
+                 "\r\n";
+    assert(vlc_http_file_seek(f, offset = 1234) == 0);
+    assert(vlc_http_file_get_size(f) == 3456);
+
+    /* Earlier responses are resumed without any new request */
+    assert(replies[0] == NULL);
+    assert(vlc_http_file_seek(f, 0) == 0);
+    assert(vlc_http_file_get_size(f) == 2345);
+    assert(vlc_http_file_seek(f, 1234) == 0);
+    assert(vlc_http_file_get_size(f) == 3456);
+    vlc_http_file_destroy(f);
+
+    /* Responses with a grown receive window are not kept */
+    replies[0] = "HTTP/1.1 206 Partial Content\r\n"
+                 "Content-Range: bytes 0-2344/2345\r\n"
+                 "ETag: W/\"foobar42\"\r\n"
+                 "\r\n";
+
+    offset = 0;
+    window = 16 << 20;
+    f = vlc_http_file_create(NULL, url, ua, NULL);
+    assert(f != NULL);
+    assert(vlc_http_file_get_size(f) == 2345);
+
+    replies[0] = "HTTP/1.1 206 Partial Content\r\n"
+                 "Content-Range: bytes 1234-3455/3456\r\n"
+                 "ETag: W/\"foobar42\"\r\n"
+                 "\r\n";
+    assert(vlc_http_file_seek(f, offset = 1234) == 0);
+    assert(vlc_http_file_get_size(f) == 3456);
+
+    replies[0] = "HTTP/1.1 206 Partial Content\r\n"
+                 "Content-Range: bytes 0-2344/2345\r\n"
+                 "ETag: W/\"foobar42\"\r\n"
+                 "\r\n";
+    assert(vlc_http_file_seek(f, offset = 0) == 0);
+    assert(replies[0] == NULL);
+    assert(vlc_http_file_get_size(f) == 2345);
+    vlc_http_file_destroy(f);
+    multiplex = false;
+    window = SIZE_MAX;
+
     /* Redirect */
     replies[0] = "HTTP/1.1 301 Permanent Redirect\r\n"
                  "Location: /somewhere/else/#here\r\n"
@@ -324,12 +384,19 @@ static void stream_close(struct vlc_http_stream *s, bool abort)
     assert(!abort);
 }
 
+static size_t stream_get_window(struct vlc_http_stream *s)
+{
+    assert(s == &stream);
+    return window;
+}
+
 static const struct vlc_http_stream_cbs stream_callbacks =
 {
     stream_read_headers,
     NULL,
     stream_read,
     stream_close,
+    stream_get_window,
 };
 
 static struct vlc_http_stream stream = { &stream_callbacks };
@@ -404,3 +471,9 @@ struct vlc_http_cookie_jar_t *vlc_http_mgr_get_jar(struct vlc_http_mgr *mgr)
     assert(mgr == NULL);
     return jar;
 }
+
+bool vlc_http_mgr_can_multiplex(struct vlc_http_mgr *mgr)
+{
+    assert(mgr == NULL);
+    return multiplex;
+}
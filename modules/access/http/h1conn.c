@@ -314,6 +314,7 @@ static const struct vlc_http_stream_cbs vlc_h1_stream_callbacks =
     vlc_h1_stream_write,
     vlc_h1_stream_read,
     vlc_h1_stream_close,
+    NULL,
 };
 
 static void vlc_h1_conn_destroy(struct vlc_h1_conn *conn)
@@ -354,6 +355,7 @@ struct vlc_http_conn *vlc_h1_conn_create(void *ctx, vlc_tls_t *tls, bool proxy)
 
     conn->conn.cbs = &vlc_h1_conn_callbacks;
     conn->conn.tls = tls;
+    conn->conn.multiplexed = false;
     conn->stream.cbs = &vlc_h1_stream_callbacks;
     conn->active = false;
     conn->released = false;
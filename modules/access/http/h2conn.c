@@ -45,6 +45,9 @@
 #define CO(c) ((c)->opaque)
 #define SO(s) CO((s)->conn)
 
+/** Upper bound for the receive window of a stream */
+#define VLC_H2_MAX_STREAM_WINDOW (16 << 20)
+
 /** HTTP/2 connection */
 struct vlc_h2_conn
 {
@@ -82,6 +85,7 @@ struct vlc_h2_stream
     struct vlc_http_msg *recv_hdr; /**< Latest received headers (or NULL) */
 
     size_t recv_cwnd; /**< Free space in receive congestion window */
+    uint32_t recv_window; /**< Receive congestion window size */
     struct vlc_h2_frame *recv_head; /**< Earliest pending received buffer */
     struct vlc_h2_frame **recv_tailp; /**< Tail of receive queue */
     vlc_cond_t recv_wait;
@@ -410,11 +414,27 @@ static block_t *vlc_h2_stream_read(struct vlc_http_stream *stream)
     assert(s->recv_cwnd >= len);
     s->recv_cwnd -= len;
 
-    /* Credit the receive window if missing credit exceeds 50%. */
-    uint_fast32_t credit = VLC_H2_INIT_WINDOW - s->recv_cwnd;
-    if (credit >= (VLC_H2_INIT_WINDOW / 2)
+    uint_fast32_t window = s->recv_window;
+    uint_fast32_t credit = window - s->recv_cwnd;
+    bool starved = s->recv_head == NULL && !s->recv_end;
+
+    if (starved && credit >= (window / 4) && window < VLC_H2_MAX_STREAM_WINDOW)
+    {   /* The reader consumes data as fast as it arrives: the window may be
+         * smaller than the bandwidth-delay product. Grow it. Streams that are
+         * not read from keep the initial window, which bounds their memory
+         * usage. */
+        credit += window;
+        window *= 2;
+    }
+
+    /* Credit the receive window if missing credit exceeds 50%, or 25% if
+     * the reader is waiting for more data. */
+    if (credit >= (window / (starved ? 4 : 2))
      && !vlc_h2_conn_queue(conn, vlc_h2_frame_window_update(s->id, credit)))
+    {
         s->recv_cwnd += credit;
+        s->recv_window = window;
+    }
 
     vlc_h2_stream_unlock(s);
 
@@ -434,6 +454,23 @@ static block_t *vlc_h2_stream_read(struct vlc_http_stream *stream)
     return block;
 }
 
+/**
+ * Reports the stream receive window.
+ *
+ * The window grows while the stream is read (see vlc_h2_stream_read()).
+ * Credit already sent cannot be taken back, so it never shrinks.
+ */
+static size_t vlc_h2_stream_get_window(struct vlc_http_stream *stream)
+{
+    struct vlc_h2_stream *s =
+        container_of(stream, struct vlc_h2_stream, stream);
+
+    vlc_h2_stream_lock(s);
+    size_t window = s->recv_window;
+    vlc_h2_stream_unlock(s);
+    return window;
+}
+
 /**
  * Terminates a stream.
  *
@@ -488,6 +525,7 @@ static const struct vlc_http_stream_cbs vlc_h2_stream_callbacks =
     vlc_h2_stream_write,
     vlc_h2_stream_read,
     vlc_h2_stream_close,
+    vlc_h2_stream_get_window,
 };
 
 /**
@@ -517,6 +555,7 @@ static struct vlc_http_stream *vlc_h2_stream_open(struct vlc_http_conn *c,
     s->recv_err = 0;
     s->recv_hdr = NULL;
     s->recv_cwnd = VLC_H2_INIT_WINDOW;
+    s->recv_window = VLC_H2_INIT_WINDOW;
     s->recv_head = NULL;
     s->recv_tailp = &s->recv_head;
     vlc_cond_init(&s->recv_wait);
@@ -875,6 +914,7 @@ struct vlc_http_conn *vlc_h2_conn_create(void *ctx, struct vlc_tls *tls)
 
     conn->conn.cbs = &vlc_h2_conn_callbacks;
     conn->conn.tls = tls;
+    conn->conn.multiplexed = true;
     conn->out = vlc_h2_output_create(tls, true);
     conn->opaque = ctx;
     conn->streams = NULL;
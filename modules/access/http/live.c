@@ -53,6 +53,7 @@ static const struct vlc_http_resource_cbs vlc_http_live_callbacks =
 {
     vlc_http_live_req,
     vlc_http_live_resp,
+    NULL,
 };
 
 struct vlc_http_resource *vlc_http_live_create(struct vlc_http_mgr *mgr,
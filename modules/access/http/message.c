@@ -288,6 +288,14 @@ struct vlc_http_msg *vlc_http_msg_get_final(struct vlc_http_msg *m)
     return m;
 }
 
+size_t vlc_http_msg_get_window(const struct vlc_http_msg *m)
+{
+    if (m->payload == NULL)
+        return 0; /* Nothing more will be received */
+
+    return vlc_http_stream_get_window(m->payload);
+}
+
 block_t *vlc_http_msg_read(struct vlc_http_msg *m)
 {
     if (m->payload == NULL)
@@ -257,6 +257,14 @@ const char *vlc_http_next_token(const char *);
  */
 uintmax_t vlc_http_msg_get_size(const struct vlc_http_msg *);
 
+/**
+ * Gets HTTP payload receive window.
+ *
+ * @return the receive window of the payload stream in bytes,
+ *         or SIZE_MAX if unbounded (see vlc_http_stream_get_window())
+ */
+size_t vlc_http_msg_get_window(const struct vlc_http_msg *);
+
 /**
  * Gets next response headers.
  *
@@ -359,6 +367,7 @@ struct vlc_http_stream_cbs
     ssize_t (*write)(struct vlc_http_stream *, const void *, size_t, bool eos);
     block_t *(*read)(struct vlc_http_stream *);
     void (*close)(struct vlc_http_stream *, bool abort);
+    size_t (*get_window)(struct vlc_http_stream *);
 };
 
 /** HTTP stream */
@@ -423,6 +432,22 @@ static inline block_t *vlc_http_stream_read(struct vlc_http_stream *s)
     return s->cbs->read(s);
 }
 
+/**
+ * Gets the receive flow control window.
+ *
+ * Data that the peer may send on an HTTP stream before it is read is bounded
+ * by the stream receive window, if the protocol provides one (HTTP/2).
+ *
+ * @param s HTTP stream
+ * @return the window size in bytes, or SIZE_MAX if unbounded
+ */
+static inline size_t vlc_http_stream_get_window(struct vlc_http_stream *s)
+{
+    if (s->cbs->get_window == NULL)
+        return SIZE_MAX;
+    return s->cbs->get_window(s);
+}
+
 /**
  * Closes an HTTP stream.
  *
@@ -147,6 +147,9 @@ int vlc_http_res_get_status(struct vlc_http_resource *res)
 
 static void vlc_http_res_deinit(struct vlc_http_resource *res)
 {
+    if (res->cbs->destroy != NULL)
+        res->cbs->destroy(res);
+
     free(res->referrer);
     free(res->agent);
     free(res->password);
@@ -53,10 +53,190 @@
  */
 #define MRU 65507u
 
+#ifdef HAVE_RECVMMSG
+/*****************************************************************************
+ * Datagram slabs
+ *****************************************************************************
+ * Batched reception receives each batch into one slab, with one slot per
+ * datagram, and hands the datagrams over to the stream layer as blocks
+ * pointing into their slot, without copying. A slab goes back to a small
+ * free list once all its datagrams are released.
+ *
+ * Slots can hold MRU bytes but start on a page boundary, and only the
+ * written pages are backed by memory: a slab of 1316 bytes TS payloads uses
+ * one page per datagram, not a whole slot.
+ *
+ * The pool is reference counted by the access and by every slab currently out
+ * of the free list, so that it survives blocks released after the access is
+ * closed.
+ *****************************************************************************/
+#define UDP_SLOT 65536u /* MRU rounded up to a multiple of the page size */
+
+static_assert(UDP_SLOT >= MRU, "UDP slot too small");
+
+struct udp_slab;
+
+struct udp_datagram
+{
+    block_t self;
+    struct udp_slab *slab;
+};
+
+struct udp_pool
+{
+    vlc_atomic_rc_t rc;
+    vlc_mutex_t lock;
+    struct udp_slab *free_list;
+    unsigned free_count;
+    unsigned max_free;
+    unsigned slots; /**< datagrams per slab */
+};
+
+struct udp_slab
+{
+    struct udp_pool *pool;
+    struct udp_slab *next; /**< in the free list */
+    vlc_atomic_rc_t rc; /**< the access while receiving, and each datagram */
+    uint8_t *buffer;
+    struct udp_datagram datagrams[];
+};
+
+static void udp_slab_Delete(struct udp_slab *slab)
+{
+    aligned_free(slab->buffer);
+    free(slab);
+}
+
+static void udp_pool_Release(struct udp_pool *pool)
+{
+    if (!vlc_atomic_rc_dec(&pool->rc))
+        return;
+
+    while (pool->free_list != NULL)
+    {
+        struct udp_slab *slab = pool->free_list;
+
+        pool->free_list = slab->next;
+        udp_slab_Delete(slab);
+    }
+    free(pool);
+}
+
+static void udp_slab_Release(struct udp_slab *slab)
+{
+    if (!vlc_atomic_rc_dec(&slab->rc))
+        return;
+
+    struct udp_pool *pool = slab->pool;
+
+    vlc_mutex_lock(&pool->lock);
+    if (pool->free_count < pool->max_free)
+    {
+        slab->next = pool->free_list;
+        pool->free_list = slab;
+        pool->free_count++;
+        slab = NULL;
+    }
+    vlc_mutex_unlock(&pool->lock);
+
+    if (slab != NULL)
+        udp_slab_Delete(slab);
+    udp_pool_Release(pool);
+}
+
+static void udp_datagram_Release(block_t *block)
+{
+    struct udp_datagram *dgram = container_of(block, struct udp_datagram,
+                                              self);
+
+    udp_slab_Release(dgram->slab);
+}
+
+static const struct vlc_block_callbacks udp_datagram_cbs =
+{
+    udp_datagram_Release,
+};
+
+static struct udp_pool *udp_pool_New(unsigned slots, unsigned max_free)
+{
+    struct udp_pool *pool = malloc(sizeof (*pool));
+    if (unlikely(pool == NULL))
+        return NULL;
+
+    vlc_atomic_rc_init(&pool->rc);
+    vlc_mutex_init(&pool->lock);
+    pool->free_list = NULL;
+    pool->free_count = 0;
+    pool->max_free = max_free;
+    pool->slots = slots;
+    return pool;
+}
+
+static struct udp_slab *udp_pool_Get(struct udp_pool *pool)
+{
+    struct udp_slab *slab;
+
+    vlc_mutex_lock(&pool->lock);
+    slab = pool->free_list;
+    if (slab != NULL)
+    {
+        pool->free_list = slab->next;
+        pool->free_count--;
+    }
+    vlc_mutex_unlock(&pool->lock);
+
+    if (slab == NULL)
+    {
+        slab = malloc(sizeof (*slab)
+                      + pool->slots * sizeof (slab->datagrams[0]));
+        if (unlikely(slab == NULL))
+            return NULL;
+
+        slab->buffer = aligned_alloc(UDP_SLOT, (size_t)pool->slots * UDP_SLOT);
+        if (unlikely(slab->buffer == NULL))
+        {
+            free(slab);
+            return NULL;
+        }
+
+        slab->pool = pool;
+        for (unsigned i = 0; i < pool->slots; i++)
+            slab->datagrams[i].slab = slab;
+    }
+
+    vlc_atomic_rc_init(&slab->rc);
+    vlc_atomic_rc_inc(&pool->rc);
+    return slab;
+}
+
+#ifdef SO_RXQ_OVFL
+# define UDP_CMSG_SIZE CMSG_SPACE(sizeof (uint32_t))
+#else
+# define UDP_CMSG_SIZE 0
+#endif
+#endif /* HAVE_RECVMMSG */
+
 typedef struct {
     int fd;
     int timeout;
 
+#ifdef HAVE_RECVMMSG
+    struct udp_pool *pool;
+    struct udp_slab *slab; /**< slab of the last batch */
+    bool slab_used; /**< datagrams of the slab were delivered */
+    unsigned batch; /**< datagrams per receive call */
+    unsigned pending; /**< received datagrams in the slab */
+    unsigned next; /**< next slot to deliver */
+    struct mmsghdr *msgs;
+    struct iovec *iovs;
+    unsigned char *cmsgs;
+
+    uint32_t drops; /**< kernel receive queue overflow counter */
+    uint64_t datagrams;
+    uint64_t calls;
+    uint64_t truncated;
+#endif
+
     size_t length;
     char *offset;
     char buf[MRU];
@@ -132,6 +312,195 @@ static ssize_t Read(stream_t *access, void *buf, size_t len)
     return val;
 }
 
+#ifdef HAVE_RECVMMSG
+static void UpdateDrops(stream_t *access, struct msghdr *hdr)
+{
+#ifdef SO_RXQ_OVFL
+    access_sys_t *sys = access->p_sys;
+
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(hdr); cmsg != NULL;
+         cmsg = CMSG_NXTHDR(hdr, cmsg))
+    {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SO_RXQ_OVFL)
+            continue;
+
+        uint32_t drops;
+
+        memcpy(&drops, CMSG_DATA(cmsg), sizeof (drops));
+        if (drops != sys->drops)
+        {
+            msg_Warn(access, "%"PRIu32" datagram(s) dropped by the kernel "
+                     "(receive buffer overrun)", drops - sys->drops);
+            sys->drops = drops;
+        }
+    }
+#else
+    VLC_UNUSED(access); VLC_UNUSED(hdr);
+#endif
+}
+
+/**
+ * Receives as many datagrams as available, up to the batch size, with a
+ * single system call.
+ *
+ * \return the number of received datagrams, 0 on time-out, -1 on error
+ */
+static int Refill(stream_t *access)
+{
+    access_sys_t *sys = access->p_sys;
+
+    /* The delivered datagrams keep the previous slab alive */
+    if (sys->slab != NULL && sys->slab_used)
+    {
+        udp_slab_Release(sys->slab);
+        sys->slab = NULL;
+    }
+
+    if (sys->slab == NULL)
+    {
+        sys->slab = udp_pool_Get(sys->pool);
+        if (unlikely(sys->slab == NULL))
+            return -1;
+        sys->slab_used = false;
+
+        for (unsigned i = 0; i < sys->batch; i++)
+            sys->iovs[i].iov_base = sys->slab->buffer + i * UDP_SLOT;
+    }
+
+    for (unsigned i = 0; i < sys->batch; i++)
+    {
+        struct msghdr *hdr = &sys->msgs[i].msg_hdr;
+
+        hdr->msg_controllen = UDP_CMSG_SIZE;
+        hdr->msg_flags = 0;
+    }
+
+    struct pollfd ufd[1];
+
+    ufd[0].fd = sys->fd;
+    ufd[0].events = POLLIN;
+
+    switch (vlc_poll_i11e(ufd, 1, sys->timeout)) {
+        case 0:
+            msg_Err(access, "receive time-out");
+            return 0;
+        case -1:
+            return -1;
+    }
+
+    int val = recvmmsg(sys->fd, sys->msgs, sys->batch, MSG_DONTWAIT, NULL);
+    if (val <= 0)
+        return -1;
+
+    sys->calls++;
+    sys->datagrams += val;
+
+    for (int i = 0; i < val; i++)
+    {
+        struct msghdr *hdr = &sys->msgs[i].msg_hdr;
+
+        if (unlikely(hdr->msg_flags & MSG_TRUNC))
+            sys->truncated++;
+        if (hdr->msg_controllen > 0)
+            UpdateDrops(access, hdr);
+    }
+
+    sys->pending = val;
+    sys->next = 0;
+    return val;
+}
+
+static block_t *BlockRecv(stream_t *access, bool *restrict eof)
+{
+    access_sys_t *sys = access->p_sys;
+
+    for (;;)
+    {
+        if (sys->next >= sys->pending)
+        {
+            int val = Refill(access);
+
+            if (val <= 0)
+            {
+                if (val == 0)
+                    *eof = true;
+                return NULL;
+            }
+        }
+
+        unsigned i = sys->next++;
+        size_t len = sys->msgs[i].msg_len;
+
+        /* Empty datagrams are skipped */
+        if (len == 0)
+            continue;
+
+        struct udp_slab *slab = sys->slab;
+
+        vlc_atomic_rc_inc(&slab->rc);
+        sys->slab_used = true;
+        return block_Init(&slab->datagrams[i].self, &udp_datagram_cbs,
+                          slab->buffer + i * UDP_SLOT, len);
+    }
+}
+
+static int OpenBatch(stream_t *access, unsigned batch)
+{
+    access_sys_t *sys = access->p_sys;
+
+    sys->batch = batch;
+    sys->pool = NULL;
+    sys->slab = NULL;
+    sys->pending = sys->next = 0;
+    sys->drops = 0;
+    sys->datagrams = sys->calls = sys->truncated = 0;
+
+    sys->msgs = vlc_obj_calloc(access, batch, sizeof (*sys->msgs));
+    sys->iovs = vlc_obj_calloc(access, batch, sizeof (*sys->iovs));
+    sys->cmsgs = (UDP_CMSG_SIZE > 0)
+        ? vlc_obj_calloc(access, batch, UDP_CMSG_SIZE) : NULL;
+    if (unlikely(sys->msgs == NULL || sys->iovs == NULL
+              || (UDP_CMSG_SIZE > 0 && sys->cmsgs == NULL)))
+        return VLC_ENOMEM;
+
+    sys->pool = udp_pool_New(batch, 4);
+    if (unlikely(sys->pool == NULL))
+        return VLC_ENOMEM;
+
+    for (unsigned i = 0; i < batch; i++)
+    {
+        struct msghdr *hdr = &sys->msgs[i].msg_hdr;
+
+        hdr->msg_iov = &sys->iovs[i];
+        hdr->msg_iovlen = 1;
+        sys->iovs[i].iov_len = MRU;
+        if (sys->cmsgs != NULL)
+            hdr->msg_control = sys->cmsgs + i * UDP_CMSG_SIZE;
+    }
+
+#ifdef SO_RXQ_OVFL
+    int on = 1;
+
+    if (setsockopt(sys->fd, SOL_SOCKET, SO_RXQ_OVFL, &on, sizeof (on)))
+        msg_Dbg(access, "receive overflow counter not available");
+#endif
+    return VLC_SUCCESS;
+}
+
+static void CloseBatch(stream_t *access)
+{
+    access_sys_t *sys = access->p_sys;
+
+    if (sys->slab != NULL)
+        udp_slab_Release(sys->slab);
+    udp_pool_Release(sys->pool);
+
+    msg_Dbg(access, "received %"PRIu64" datagram(s) in %"PRIu64" call(s), "
+            "%"PRIu32" dropped, %"PRIu64" truncated", sys->datagrams,
+            sys->calls, sys->drops, sys->truncated);
+}
+#endif /* HAVE_RECVMMSG */
+
 /*****************************************************************************
  * Open: open the socket
  *****************************************************************************/
@@ -217,6 +586,25 @@ static int Open( vlc_object_t *p_this )
     if( sys->timeout > 0)
         sys->timeout *= 1000;
 
+#ifdef HAVE_RECVMMSG
+    sys->batch = 0;
+
+    int64_t i_batch = var_InheritInteger( p_access, "udp-batch" );
+    if( i_batch > 1 )
+    {
+        if( OpenBatch( p_access, __MIN( i_batch, 1024 ) ) )
+        {
+            if( sys->pool != NULL )
+                udp_pool_Release( sys->pool );
+            net_Close( sys->fd );
+            return VLC_ENOMEM;
+        }
+
+        p_access->pf_read = NULL;
+        p_access->pf_block = BlockRecv;
+    }
+#endif
+
     return VLC_SUCCESS;
 }
 
@@ -228,10 +616,18 @@ static void Close( vlc_object_t *p_this )
     stream_t     *p_access = (stream_t*)p_this;
     access_sys_t *sys = p_access->p_sys;
 
+#ifdef HAVE_RECVMMSG
+    if( sys->batch > 0 )
+        CloseBatch( p_access );
+#endif
     net_Close( sys->fd );
 }
 
 #define TIMEOUT_TEXT N_("UDP Source timeout (sec)")
+#define BATCH_TEXT N_("Datagrams per receive call")
+#define BATCH_LONGTEXT N_( \
+    "Maximum number of datagrams received with a single system call. " \
+    "Set to 1 to receive one datagram at a time.")
 
 vlc_module_begin()
     set_shortname(N_("UDP"))
@@ -240,6 +636,10 @@ vlc_module_begin()
 
     add_obsolete_integer("udp-buffer") /* since 3.0.0 */
     add_integer("udp-timeout", -1, TIMEOUT_TEXT, NULL)
+#ifdef HAVE_RECVMMSG
+    add_integer("udp-batch", 32, BATCH_TEXT, BATCH_LONGTEXT)
+        change_integer_range(1, 1024)
+#endif
 
     set_capability("access", 0)
     add_shortcut("udp", "udpstream", "udp4", "udp6")
@@ -43,6 +43,9 @@
 #include <vlc_fs.h>
 #include <vlc_strings.h>
 #include <vlc_charset.h>
+#include <vlc_queue.h>
+#include <vlc_memstream.h>
+#include <vlc_httpd.h>
 
 #include <gcrypt.h>
 #include <vlc_gcrypt.h>
@@ -56,6 +59,8 @@
 #define STR_ENDLIST "#EXT-X-ENDLIST\n"
 
 #define MAX_RENAME_RETRIES        10
+/* Bytes queued for the thread before Write() waits for it */
+#define MAX_QUEUED_BYTES          (32 << 20)
 
 /*****************************************************************************
  * Module descriptor
@@ -105,6 +110,12 @@ static void Close( vlc_object_t * );
 #define INTITIAL_SEG_TEXT N_("Number of first segment")
 #define INITIAL_SEG_LONGTEXT N_("The number of the first segment generated")
 
+#define MEMORY_TEXT N_("Keep segments in memory")
+#define MEMORY_LONGTEXT N_("Keep the last segments and the index in memory and "\
+                           "serve them with the built-in HTTP server instead of "\
+                           "writing files. The segment path and the index are "\
+                           "then used as HTTP URL paths.")
+
 vlc_module_begin ()
     set_description( N_("HTTP Live streaming output") )
     set_shortname( N_("LiveHTTP" ))
@@ -132,6 +143,8 @@ vlc_module_begin ()
                 KEYURI_TEXT, NULL )
     add_loadfile(SOUT_CFG_PREFIX "key-file", NULL,
                  KEYFILE_TEXT, KEYFILE_LONGTEXT)
+    add_bool( SOUT_CFG_PREFIX "memory", false,
+              MEMORY_TEXT, MEMORY_LONGTEXT )
     add_loadfile(SOUT_CFG_PREFIX "key-loadfile", NULL,
                  KEYLOADFILE_TEXT, KEYLOADFILE_LONGTEXT)
     set_callbacks( Open, Close )
@@ -155,6 +168,7 @@ static const char *const ppsz_sout_options[] = {
     "key-loadfile",
     "generate-iv",
     "initial-segment-number",
+    "memory",
     NULL
 };
 
@@ -170,6 +184,8 @@ typedef struct output_segment
     vlc_tick_t segment_length;
     uint32_t i_segment_number;
     uint8_t aes_ivs[16];
+    block_t *p_data;
+    httpd_file_t *p_httpd_file;
 } output_segment_t;
 
 typedef struct
@@ -201,6 +217,25 @@ typedef struct
     uint8_t stuffing_bytes[16];
     ssize_t stuffing_size;
     vlc_array_t segments_t;
+
+    /* Segmenting, encryption and writes happen in this thread */
+    vlc_thread_t thread;
+    vlc_queue_t queue;
+    vlc_cond_t queue_wait;  /* signaled when the thread takes the queue */
+    size_t i_queued;
+    bool b_dead;
+    bool b_error;           /* the thread failed, reported by Write() */
+
+    /* In-memory segments served by the HTTP server */
+    bool b_memory;
+    bool b_memory_open;
+    block_t *memory_segment;
+    block_t **memory_segment_end;
+    httpd_host_t *p_httpd_host;
+    httpd_file_t *p_httpd_index;
+    vlc_mutex_t index_lock;
+    char *psz_index;
+    size_t i_index;
 } sout_access_out_sys_t;
 
 static int LoadCryptFile( sout_access_out_t *p_access);
@@ -208,6 +243,9 @@ static int CryptSetup( sout_access_out_t *p_access, char *keyfile );
 static int CheckSegmentChange( sout_access_out_t *p_access, block_t *p_buffer );
 static ssize_t writeSegment( sout_access_out_t *p_access );
 static ssize_t openNextFile( sout_access_out_t *p_access, sout_access_out_sys_t *p_sys );
+static ssize_t WriteBlocks( sout_access_out_t *, block_t * );
+static void *Thread( void * );
+static int MemorySetup( sout_access_out_t *p_access );
 /*****************************************************************************
  * Open: open the file
  *****************************************************************************/
@@ -245,6 +283,7 @@ static int Open( vlc_object_t *p_this )
     p_sys->b_ratecontrol = var_GetBool( p_access, SOUT_CFG_PREFIX "ratecontrol") ;
     p_sys->b_caching = var_GetBool( p_access, SOUT_CFG_PREFIX "caching") ;
     p_sys->b_generate_iv = var_GetBool( p_access, SOUT_CFG_PREFIX "generate-iv") ;
+    p_sys->b_memory = var_GetBool( p_access, SOUT_CFG_PREFIX "memory" );
     p_sys->b_segment_has_data = false;
 
     vlc_array_init( &p_sys->segments_t );
@@ -264,7 +303,7 @@ static int Open( vlc_object_t *p_this )
             return VLC_ENOMEM;
         }
         p_sys->psz_indexPath = psz_tmp;
-        if( p_sys->i_initial_segment != 1 )
+        if( p_sys->i_initial_segment != 1 && !p_sys->b_memory )
             vlc_unlink( p_sys->psz_indexPath );
     }
 
@@ -295,10 +334,133 @@ static int Open( vlc_object_t *p_this )
     p_sys->i_segment = p_sys->i_initial_segment-1;
     p_sys->psz_cursegPath = NULL;
 
+    p_sys->b_memory_open = false;
+    p_sys->memory_segment = NULL;
+    p_sys->memory_segment_end = &p_sys->memory_segment;
+    p_sys->p_httpd_host = NULL;
+    p_sys->p_httpd_index = NULL;
+    vlc_mutex_init( &p_sys->index_lock );
+    p_sys->psz_index = NULL;
+    p_sys->i_index = 0;
+
+    if( p_sys->b_memory && MemorySetup( p_access ) )
+        goto error;
+
+    vlc_queue_Init( &p_sys->queue, offsetof (block_t, p_next) );
+    vlc_cond_init( &p_sys->queue_wait );
+    p_sys->i_queued = 0;
+    p_sys->b_dead = false;
+    p_sys->b_error = false;
+    if( vlc_clone( &p_sys->thread, Thread, p_access ) )
+        goto error;
+
     p_access->pf_write = Write;
     p_access->pf_control = Control;
 
     return VLC_SUCCESS;
+
+error:
+    if( p_sys->p_httpd_index )
+        httpd_FileDelete( p_sys->p_httpd_index );
+    if( p_sys->p_httpd_host )
+        httpd_HostDelete( p_sys->p_httpd_host );
+    if( p_sys->key_uri )
+    {
+        gcry_cipher_close( p_sys->aes_ctx );
+        free( p_sys->key_uri );
+    }
+    free( p_sys->psz_keyfile );
+    free( p_sys->psz_indexUrl );
+    free( p_sys->psz_indexPath );
+    free( p_sys );
+    return VLC_EGENERIC;
+}
+
+/************************************************************************
+ * IndexCallback: Serve the index from memory
+ ************************************************************************/
+static int IndexCallback( httpd_file_sys_t *p_args, httpd_file_t *f,
+                          uint8_t *p_request, uint8_t **pp_data, int *pi_data )
+{
+    VLC_UNUSED(f); VLC_UNUSED(p_request);
+    sout_access_out_sys_t *p_sys = (sout_access_out_sys_t *)p_args;
+
+    *pp_data = NULL;
+    *pi_data = 0;
+
+    vlc_mutex_lock( &p_sys->index_lock );
+    if( p_sys->psz_index )
+    {
+        *pp_data = malloc( p_sys->i_index );
+        if( *pp_data )
+        {
+            memcpy( *pp_data, p_sys->psz_index, p_sys->i_index );
+            *pi_data = p_sys->i_index;
+        }
+    }
+    vlc_mutex_unlock( &p_sys->index_lock );
+
+    return VLC_SUCCESS;
+}
+
+/************************************************************************
+ * SegmentCallback: Serve a complete segment from memory
+ ************************************************************************/
+static int SegmentCallback( httpd_file_sys_t *p_args, httpd_file_t *f,
+                            uint8_t *p_request, uint8_t **pp_data, int *pi_data )
+{
+    VLC_UNUSED(f); VLC_UNUSED(p_request);
+    const output_segment_t *segment = (const output_segment_t *)p_args;
+
+    /* The data does not change once the segment is published, and the
+     * segment is unpublished before being destroyed.
+     * httpd takes ownership of the answer body, so every GET still copies
+     * the whole segment. */
+    *pp_data = malloc( segment->p_data->i_buffer );
+    if( !*pp_data )
+    {
+        *pi_data = 0;
+        return VLC_SUCCESS;
+    }
+    memcpy( *pp_data, segment->p_data->p_buffer, segment->p_data->i_buffer );
+    *pi_data = segment->p_data->i_buffer;
+
+    return VLC_SUCCESS;
+}
+
+/************************************************************************
+ * MemorySetup: Prepare serving segments from memory
+ ************************************************************************/
+static int MemorySetup( sout_access_out_t *p_access )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+
+    if( !p_sys->psz_indexPath )
+    {
+        msg_Err( p_access, "an index is needed to serve segments from memory" );
+        return VLC_EGENERIC;
+    }
+
+    /* Memory is bounded by the sliding window */
+    if( p_sys->i_numsegs == 0 )
+    {
+        p_sys->i_numsegs = 3;
+        msg_Warn( p_access, "keeping %u segments in memory", p_sys->i_numsegs );
+    }
+    p_sys->b_delsegs = true;
+
+    p_sys->p_httpd_host = vlc_http_HostNew( VLC_OBJECT(p_access) );
+    if( !p_sys->p_httpd_host )
+        return VLC_EGENERIC;
+
+    p_sys->p_httpd_index = httpd_FileNew( p_sys->p_httpd_host, p_sys->psz_indexPath,
+                                          "application/vnd.apple.mpegurl",
+                                          NULL, NULL, IndexCallback,
+                                          (httpd_file_sys_t *)p_sys );
+    if( !p_sys->p_httpd_index )
+        return VLC_EGENERIC;
+
+    return VLC_SUCCESS;
 }
 
 /************************************************************************
@@ -500,6 +662,10 @@ static char *formatSegmentPath( char *psz_path, uint32_t i_seg )
 
 static void destroySegment( output_segment_t *segment )
 {
+    if( segment->p_httpd_file )
+        httpd_FileDelete( segment->p_httpd_file );
+    if( segment->p_data )
+        block_Release( segment->p_data );
     free( segment->psz_filename );
     free( segment->psz_duration );
     free( segment->psz_uri );
@@ -549,6 +715,48 @@ static bool isFirstItemRemovable( sout_access_out_sys_t *p_sys, uint32_t i_first
     return duration >= (first->segment_length + (p_sys->i_numsegs * p_sys->segment_max_length));
 }
 
+/************************************************************************
+ * writeIndexFile: Replace the index file with the given content
+ ************************************************************************/
+static int writeIndexFile( sout_access_out_t *p_access, sout_access_out_sys_t *p_sys,
+                           const char *psz_index, size_t i_index )
+{
+    int val;
+    FILE *fp;
+    char *psz_idxTmp;
+    if ( asprintf( &psz_idxTmp, "%s.tmp", p_sys->psz_indexPath ) < 0)
+        return -1;
+
+    fp = vlc_fopen( psz_idxTmp, "wt");
+    if ( !fp )
+    {
+        msg_Err( p_access, "cannot open index file `%s'", psz_idxTmp );
+        free( psz_idxTmp );
+        return -1;
+    }
+
+    if ( fwrite( psz_index, 1, i_index, fp ) != i_index )
+    {
+        free( psz_idxTmp );
+        fclose( fp );
+        return -1;
+    }
+    fclose( fp );
+
+    val = vlc_rename ( psz_idxTmp, p_sys->psz_indexPath);
+
+    if ( val < 0 )
+    {
+        vlc_unlink( psz_idxTmp );
+        msg_Err( p_access, "Error moving LiveHttp index file" );
+    }
+    else
+        msg_Dbg( p_access, "LiveHttpIndexComplete: %s" , p_sys->psz_indexPath );
+
+    free( psz_idxTmp );
+    return 0;
+}
+
 /************************************************************************
  * updateIndexAndDel: If necessary, update index file & delete old segments
  ************************************************************************/
@@ -573,31 +781,17 @@ static int updateIndexAndDel( sout_access_out_t *p_access, sout_access_out_sys_t
     // First update index
     if ( p_sys->psz_indexPath )
     {
-        int val;
-        FILE *fp;
-        char *psz_idxTmp;
-        if ( asprintf( &psz_idxTmp, "%s.tmp", p_sys->psz_indexPath ) < 0)
-            return -1;
+        struct vlc_memstream ms;
 
-        fp = vlc_fopen( psz_idxTmp, "wt");
-        if ( !fp )
-        {
-            msg_Err( p_access, "cannot open index file `%s'", psz_idxTmp );
-            free( psz_idxTmp );
+        if( vlc_memstream_open( &ms ) )
             return -1;
-        }
 
-        if ( fprintf( fp, "#EXTM3U\n#EXT-X-TARGETDURATION:%.0f\n#EXT-X-VERSION:3\n#EXT-X-ALLOW-CACHE:%s"
+        vlc_memstream_printf( &ms, "#EXTM3U\n#EXT-X-TARGETDURATION:%.0f\n#EXT-X-VERSION:3\n#EXT-X-ALLOW-CACHE:%s"
                           "%s\n#EXT-X-MEDIA-SEQUENCE:%"PRIu32"\n%s", ceil(secf_from_vlc_tick( p_sys->segment_max_length )) ,
                           p_sys->b_caching ? "YES" : "NO",
                           p_sys->i_numsegs > 0 ? "" : b_isend ? "\n#EXT-X-PLAYLIST-TYPE:VOD" : "\n#EXT-X-PLAYLIST-TYPE:EVENT",
                           i_firstseg, ((p_sys->i_initial_segment > 1) && (p_sys->i_initial_segment == i_firstseg)) ? "#EXT-X-DISCONTINUITY\n" : ""
-                          ) < 0 )
-        {
-            free( psz_idxTmp );
-            fclose( fp );
-            return -1;
-        }
+                          );
         char *psz_current_uri=NULL;
 
 
@@ -611,7 +805,6 @@ static int updateIndexAndDel( sout_access_out_t *p_access, sout_access_out_sys_t
                 ( !psz_current_uri ||  strcmp( psz_current_uri, segment->psz_key_uri ) )
               )
             {
-                int ret = 0;
                 free( psz_current_uri );
                 psz_current_uri = strdup( segment->psz_key_uri );
                 if( p_sys->b_generate_iv )
@@ -625,55 +818,39 @@ static int updateIndexAndDel( sout_access_out_t *p_access, sout_access_out_sys_t
                         iv_lo <<= 8;
                         iv_lo |= segment->aes_ivs[8+j] & 0xff;
                     }
-                    ret = fprintf( fp, "#EXT-X-KEY:METHOD=AES-128,URI=\"%s\",IV=0X%16.16llx%16.16llx\n",
-                                   segment->psz_key_uri, iv_hi, iv_lo );
+                    vlc_memstream_printf( &ms, "#EXT-X-KEY:METHOD=AES-128,URI=\"%s\",IV=0X%16.16llx%16.16llx\n",
+                                          segment->psz_key_uri, iv_hi, iv_lo );
 
                 } else {
-                    ret = fprintf( fp, "#EXT-X-KEY:METHOD=AES-128,URI=\"%s\"\n", segment->psz_key_uri );
-                }
-                if( ret < 0 )
-                {
-                    free( psz_current_uri );
-                    free( psz_idxTmp );
-                    fclose( fp );
-                    return -1;
+                    vlc_memstream_printf( &ms, "#EXT-X-KEY:METHOD=AES-128,URI=\"%s\"\n", segment->psz_key_uri );
                 }
             }
 
-            val = fprintf( fp, "#EXTINF:%s,\n%s\n", segment->psz_duration, segment->psz_uri);
-            if ( val < 0 )
-            {
-                free( psz_current_uri );
-                free( psz_idxTmp );
-                fclose( fp );
-                return -1;
-            }
+            vlc_memstream_printf( &ms, "#EXTINF:%s,\n%s\n", segment->psz_duration, segment->psz_uri);
         }
         free( psz_current_uri );
 
         if ( b_isend )
-        {
-            if ( fputs ( STR_ENDLIST, fp ) < 0)
-            {
-                free( psz_idxTmp );
-                fclose( fp ) ;
-                return -1;
-            }
+            vlc_memstream_puts( &ms, STR_ENDLIST );
 
-        }
-        fclose( fp );
-
-        val = vlc_rename ( psz_idxTmp, p_sys->psz_indexPath);
+        if( vlc_memstream_close( &ms ) )
+            return -1;
 
-        if ( val < 0 )
+        if( p_sys->b_memory )
         {
-            vlc_unlink( psz_idxTmp );
-            msg_Err( p_access, "Error moving LiveHttp index file" );
+            vlc_mutex_lock( &p_sys->index_lock );
+            free( p_sys->psz_index );
+            p_sys->psz_index = ms.ptr;
+            p_sys->i_index = ms.length;
+            vlc_mutex_unlock( &p_sys->index_lock );
         }
         else
-            msg_Dbg( p_access, "LiveHttpIndexComplete: %s" , p_sys->psz_indexPath );
-
-        free( psz_idxTmp );
+        {
+            int val = writeIndexFile( p_access, p_sys, ms.ptr, ms.length );
+            free( ms.ptr );
+            if( val < 0 )
+                return -1;
+        }
     }
 
     // Then take care of deletion
@@ -686,7 +863,7 @@ static int updateIndexAndDel( sout_access_out_t *p_access, sout_access_out_sys_t
          msg_Dbg( p_access, "Removing segment number %d", segment->i_segment_number );
          vlc_array_remove( &p_sys->segments_t, 0 );
 
-         if ( segment->psz_filename )
+         if ( segment->psz_filename && !p_sys->b_memory )
          {
              vlc_unlink( segment->psz_filename );
          }
@@ -702,9 +879,14 @@ static int updateIndexAndDel( sout_access_out_t *p_access, sout_access_out_sys_t
 /*****************************************************************************
  * closeCurrentSegment: Close the segment file
  *****************************************************************************/
+static bool isSegmentOpen( const sout_access_out_sys_t *p_sys )
+{
+    return p_sys->b_memory ? p_sys->b_memory_open : p_sys->i_handle >= 0;
+}
+
 static void closeCurrentSegment( sout_access_out_t *p_access, sout_access_out_sys_t *p_sys, bool b_isend )
 {
-    if ( p_sys->i_handle >= 0 )
+    if ( isSegmentOpen( p_sys ) )
     {
         output_segment_t *segment = vlc_array_item_at_index( &p_sys->segments_t, vlc_array_count( &p_sys->segments_t ) - 1 );
 
@@ -716,6 +898,13 @@ static void closeCurrentSegment( sout_access_out_t *p_access, sout_access_out_sy
 
             if( err ) {
                msg_Err( p_access, "Couldn't encrypt 16 bytes: %s", gpg_strerror(err) );
+            } else if( p_sys->b_memory ) {
+                block_t *p_stuffing = block_Alloc( 16 );
+                if( p_stuffing )
+                {
+                    memcpy( p_stuffing->p_buffer, p_sys->stuffing_bytes, 16 );
+                    block_ChainLastAppend( &p_sys->memory_segment_end, p_stuffing );
+                }
             } else {
 
             int ret = vlc_write( p_sys->i_handle, p_sys->stuffing_bytes, 16 );
@@ -726,8 +915,27 @@ static void closeCurrentSegment( sout_access_out_t *p_access, sout_access_out_sy
         }
 
 
-        vlc_close( p_sys->i_handle );
-        p_sys->i_handle = -1;
+        if( p_sys->b_memory )
+        {
+            /* Publish the complete segment */
+            if( p_sys->memory_segment )
+                segment->p_data = block_ChainGather( p_sys->memory_segment );
+            p_sys->memory_segment = NULL;
+            p_sys->memory_segment_end = &p_sys->memory_segment;
+            p_sys->b_memory_open = false;
+
+            if( segment->p_data )
+                segment->p_httpd_file = httpd_FileNew( p_sys->p_httpd_host,
+                                                       segment->psz_filename,
+                                                       "video/MP2T", NULL, NULL,
+                                                       SegmentCallback,
+                                                       (httpd_file_sys_t *)segment );
+        }
+        else
+        {
+            vlc_close( p_sys->i_handle );
+            p_sys->i_handle = -1;
+        }
 
         if( vlc_asprintf_c( &segment->psz_duration, "%.2f", secf_from_vlc_tick( p_sys->current_segment_length ) ) == -1 )
         {
@@ -756,6 +964,10 @@ static void Close( vlc_object_t * p_this )
     sout_access_out_t *p_access = (sout_access_out_t*)p_this;
     sout_access_out_sys_t *p_sys = p_access->p_sys;
 
+    /* Let the thread write everything already queued */
+    vlc_queue_Kill( &p_sys->queue, &p_sys->b_dead );
+    vlc_join( p_sys->thread, NULL );
+
     if( p_sys->ongoing_segment )
         block_ChainLastAppend( &p_sys->full_segments_end, p_sys->ongoing_segment );
     p_sys->ongoing_segment = NULL;
@@ -770,7 +982,7 @@ static void Close( vlc_object_t * p_this )
         block_t *p_next = output_block->p_next;
         output_block->p_next = NULL;
 
-        Write( p_access, output_block );
+        WriteBlocks( p_access, output_block );
         output_block = p_next;
     }
     if( p_sys->ongoing_segment )
@@ -802,7 +1014,8 @@ static void Close( vlc_object_t * p_this )
     {
         output_segment_t *segment = vlc_array_item_at_index( &p_sys->segments_t, 0 );
         vlc_array_remove( &p_sys->segments_t, 0 );
-        if( p_sys->b_delsegs && p_sys->i_numsegs && segment->psz_filename )
+        if( p_sys->b_delsegs && p_sys->i_numsegs && segment->psz_filename &&
+            !p_sys->b_memory )
         {
             msg_Dbg( p_access, "Removing segment number %d name %s", segment->i_segment_number, segment->psz_filename );
             vlc_unlink( segment->psz_filename );
@@ -811,6 +1024,14 @@ static void Close( vlc_object_t * p_this )
         destroySegment( segment );
     }
 
+    if( p_sys->memory_segment )
+        block_ChainRelease( p_sys->memory_segment );
+    if( p_sys->p_httpd_index )
+        httpd_FileDelete( p_sys->p_httpd_index );
+    if( p_sys->p_httpd_host )
+        httpd_HostDelete( p_sys->p_httpd_host );
+    free( p_sys->psz_index );
+
     free( p_sys->psz_indexUrl );
     free( p_sys->psz_indexPath );
     free( p_sys );
@@ -843,7 +1064,7 @@ static int Control( sout_access_out_t *p_access, int i_query, va_list args )
  *****************************************************************************/
 static ssize_t openNextFile( sout_access_out_t *p_access, sout_access_out_sys_t *p_sys )
 {
-    int fd;
+    int fd = -1;
 
     uint32_t i_newseg = p_sys->i_segment + 1;
 
@@ -864,14 +1085,18 @@ static ssize_t openNextFile( sout_access_out_t *p_access, sout_access_out_sys_t
         return -1;
     }
 
-    fd = vlc_open( segment->psz_filename, O_WRONLY | O_CREAT | O_LARGEFILE |
-                     O_TRUNC, 0666 );
-    if ( fd == -1 )
+    /* Memory segments are gathered in memory_segment, not in a file */
+    if( !p_sys->b_memory )
     {
-        msg_Err( p_access, "cannot open `%s' (%s)", segment->psz_filename,
-                 vlc_strerror_c(errno) );
-        destroySegment( segment );
-        return -1;
+        fd = vlc_open( segment->psz_filename, O_WRONLY | O_CREAT | O_LARGEFILE |
+                         O_TRUNC, 0666 );
+        if ( fd == -1 )
+        {
+            msg_Err( p_access, "cannot open `%s' (%s)", segment->psz_filename,
+                     vlc_strerror_c(errno) );
+            destroySegment( segment );
+            return -1;
+        }
     }
 
     vlc_array_append_or_abort( &p_sys->segments_t, segment );
@@ -891,10 +1116,13 @@ static ssize_t openNextFile( sout_access_out_t *p_access, sout_access_out_sys_t
     msg_Dbg( p_access, "Successfully opened livehttp file: %s (%"PRIu32")" , segment->psz_filename, i_newseg );
 
     p_sys->psz_cursegPath = strdup(segment->psz_filename);
-    p_sys->i_handle = fd;
+    if( p_sys->b_memory )
+        p_sys->b_memory_open = true;
+    else
+        p_sys->i_handle = fd;
     p_sys->i_segment = i_newseg;
     p_sys->b_segment_has_data = false;
-    return fd;
+    return VLC_SUCCESS;
 }
 /*****************************************************************************
  * CheckSegmentChange: Check if segment needs to be closed and new opened
@@ -910,7 +1138,7 @@ static int CheckSegmentChange( sout_access_out_t *p_access, block_t *p_buffer )
     block_ChainProperties( p_sys->full_segments, NULL, NULL, &current_length );
     block_ChainProperties( p_sys->ongoing_segment, NULL, NULL, &ongoing_length );
 
-    if( p_sys->i_handle > 0 &&
+    if( isSegmentOpen( p_sys ) &&
        (( p_buffer->i_length + current_length + ongoing_length ) >= p_sys->segment_max_length ) )
     {
         writevalue = writeSegment( p_access );
@@ -923,10 +1151,13 @@ static int CheckSegmentChange( sout_access_out_t *p_access, block_t *p_buffer )
         return writevalue;
     }
 
-    if ( unlikely( p_sys->i_handle < 0 ) )
+    if ( unlikely( !isSegmentOpen( p_sys ) ) )
     {
         if ( openNextFile( p_access, p_sys ) < 0 )
+        {
+           block_ChainRelease ( p_buffer );
            return -1;
+        }
     }
     return writevalue;
 }
@@ -979,6 +1210,17 @@ static ssize_t writeSegment( sout_access_out_t *p_access )
 
         }
 
+        if( p_sys->b_memory )
+        {
+            block_t *p_next = output->p_next;
+            output->p_next = NULL;
+            i_write += output->i_buffer;
+            block_ChainLastAppend( &p_sys->memory_segment_end, output );
+            output = p_next;
+            encrypted=false;
+            continue;
+        }
+
         ssize_t val = vlc_write( p_sys->i_handle, output->p_buffer, output->i_buffer );
         if ( val == -1 )
         {
@@ -1006,9 +1248,9 @@ static ssize_t writeSegment( sout_access_out_t *p_access )
 }
 
 /*****************************************************************************
- * Write: standard write on a file descriptor.
+ * WriteBlocks: segment, encrypt and write blocks, in the thread
  *****************************************************************************/
-static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
+static ssize_t WriteBlocks( sout_access_out_t *p_access, block_t *p_buffer )
 {
     size_t i_write = 0;
     sout_access_out_sys_t *p_sys = p_access->p_sys;
@@ -1042,3 +1284,71 @@ static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
 
     return i_write;
 }
+
+/*****************************************************************************
+ * Thread: keep disk writes and encryption away from the muxer thread
+ *****************************************************************************/
+static void *Thread( void *data )
+{
+    sout_access_out_t *p_access = data;
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+
+    vlc_thread_set_name( "vlc-livehttp" );
+
+    for( ;; )
+    {
+        vlc_queue_Lock( &p_sys->queue );
+        while( vlc_queue_IsEmpty( &p_sys->queue ) && !p_sys->b_dead )
+            vlc_queue_Wait( &p_sys->queue );
+        block_t *p_buffer = vlc_queue_DequeueAllUnlocked( &p_sys->queue );
+        p_sys->i_queued = 0;
+        vlc_cond_broadcast( &p_sys->queue_wait );
+        bool b_error = p_sys->b_error;
+        vlc_queue_Unlock( &p_sys->queue );
+
+        if( p_buffer == NULL )
+            break;
+        if( b_error )
+        {
+            block_ChainRelease( p_buffer );
+            continue;
+        }
+        if( WriteBlocks( p_access, p_buffer ) < 0 )
+        {
+            msg_Err( p_access, "Error in write thread" );
+            vlc_queue_Lock( &p_sys->queue );
+            p_sys->b_error = true;
+            vlc_cond_broadcast( &p_sys->queue_wait );
+            vlc_queue_Unlock( &p_sys->queue );
+        }
+    }
+    return NULL;
+}
+
+/*****************************************************************************
+ * Write: queue blocks for the thread
+ *****************************************************************************/
+static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    size_t i_size;
+
+    block_ChainProperties( p_buffer, NULL, &i_size, NULL );
+
+    vlc_queue_Lock( &p_sys->queue );
+    /* Hold the muxer back while the thread is behind */
+    while( p_sys->i_queued > MAX_QUEUED_BYTES && !p_sys->b_error )
+        vlc_cond_wait( &p_sys->queue_wait, &p_sys->queue.lock );
+
+    if( p_sys->b_error )
+    {
+        vlc_queue_Unlock( &p_sys->queue );
+        block_ChainRelease( p_buffer );
+        return -1;
+    }
+
+    p_sys->i_queued += i_size;
+    vlc_queue_EnqueueUnlocked( &p_sys->queue, p_buffer );
+    vlc_queue_Unlock( &p_sys->queue );
+    return i_size;
+}
@@ -901,6 +901,18 @@ static int Statistics(struct cli_client *cl, const char *const *args,
                    item->p_stats->i_lost_abuffers);
         cli_printf(cl, "|");
 
+        /* Frame allocator */
+        cli_printf(cl, "%s", _("+-[Frame Cache]"));
+        cli_printf(cl, _("| frames allocated :    %5"PRIi64),
+                   item->p_stats->i_frame_cache_allocated);
+        cli_printf(cl, _("| frames freed     :    %5"PRIi64),
+                   item->p_stats->i_frame_cache_freed);
+        cli_printf(cl, _("| batch refills    :    %5"PRIi64),
+                   item->p_stats->i_frame_cache_refills);
+        cli_printf(cl, _("| batch spills     :    %5"PRIi64),
+                   item->p_stats->i_frame_cache_spills);
+        cli_printf(cl, "|");
+
         vlc_mutex_unlock(&item->lock);
         cli_printf(cl,  "+----[ end of statistical info ]" );
     }
@@ -141,6 +141,7 @@ SegmentTracker::SegmentTracker(SharedResources *res,
     setAdaptationLogic(logic_);
     adaptationSet = adaptSet;
     synchronizationReferences = refs;
+    bufferingLevel = VLC_TICK_INVALID;
     format = StreamFormat::Type::Unknown;
 }
 
@@ -226,6 +227,7 @@ void SegmentTracker::reset()
     current = Position();
     next = Position();
     resetChunksSequence();
+    bufferingLevel = VLC_TICK_INVALID;
     initializing = true;
     format = StreamFormat::Type::Unknown;
 }
@@ -335,6 +337,32 @@ SegmentTracker::prepareChunk(bool switch_allowed, Position pos) const
     return ChunkEntry(segmentChunk, pos, startTime, duration, displayTime);
 }
 
+void SegmentTracker::prefetchChunks(vlc_tick_t duration)
+{
+    const unsigned lookahead = bufferingLogic->getLookahead(adaptationSet->getPlaylist(),
+                                                            bufferingLevel, duration);
+    Position pos = next;
+    if(!chunkssequence.empty())
+    {
+        pos = chunkssequence.back().pos;
+        ++pos;
+    }
+
+    /* Creating the chunks schedules their download */
+    while(chunkssequence.size() < lookahead)
+    {
+        ChunkEntry entry = prepareChunk(false, pos);
+        if(!entry.isValid())
+        {
+            delete entry.chunk;
+            break;
+        }
+        chunkssequence.push_back(entry);
+        pos = entry.pos;
+        ++pos;
+    }
+}
+
 void SegmentTracker::resetChunksSequence()
 {
     while(!chunkssequence.empty())
@@ -349,6 +377,18 @@ ChunkInterface * SegmentTracker::getNextChunk(bool switch_allowed)
     if(!adaptationSet || !next.isValid())
         return nullptr;
 
+    /* Drop prefetched chunks if the logic now wants another representation */
+    if(!chunkssequence.empty() && switch_allowed && adaptationSet->isSegmentAligned())
+    {
+        const Position &pos = chunkssequence.front().pos;
+        if(pos.init_sent && pos.index_sent)
+        {
+            BaseRepresentation *rep = logic->getNextRepresentation(adaptationSet, pos.rep);
+            if(rep && rep != pos.rep)
+                resetChunksSequence();
+        }
+    }
+
     if(chunkssequence.empty())
     {
         ChunkEntry chunk = prepareChunk(switch_allowed, next);
@@ -436,7 +476,10 @@ ChunkInterface * SegmentTracker::getNextChunk(bool switch_allowed)
                                chunk.starttime, chunk.duration, chunk.displaytime));
 
     if(!b_gap)
+    {
         ++next;
+        prefetchChunks(chunk.duration);
+    }
 
     return returnedChunk;
 }
@@ -579,8 +622,9 @@ void SegmentTracker::notifyBufferingState(bool enabled) const
 }
 
 void SegmentTracker::notifyBufferingLevel(vlc_tick_t min, vlc_tick_t max,
-                                          vlc_tick_t current, vlc_tick_t target) const
+                                          vlc_tick_t current, vlc_tick_t target)
 {
+    bufferingLevel = current;
     notify(BufferingLevelChangedEvent(adaptationSet->getID(), min, max, current, target));
 }
 
@@ -233,7 +233,7 @@ namespace adaptive
             bool getSynchronizationReference(uint64_t, vlc_tick_t, SynchronizationReference &) const;
             void updateSynchronizationReference(uint64_t, const Times &);
             void notifyBufferingState(bool) const;
-            void notifyBufferingLevel(vlc_tick_t, vlc_tick_t, vlc_tick_t, vlc_tick_t) const;
+            void notifyBufferingLevel(vlc_tick_t, vlc_tick_t, vlc_tick_t, vlc_tick_t);
             void registerListener(SegmentTrackerListenerInterface *);
             bool updateSelected();
             bool bufferingAvailable() const;
@@ -253,6 +253,7 @@ namespace adaptive
             };
             std::list<ChunkEntry> chunkssequence;
             ChunkEntry prepareChunk(bool switch_allowed, Position pos) const;
+            void prefetchChunks(vlc_tick_t);
             void resetChunksSequence();
             void setAdaptationLogic(AbstractAdaptationLogic *);
             void notify(const TrackerEvent &) const;
@@ -260,6 +261,7 @@ namespace adaptive
             bool initializing;
             Position current;
             Position next;
+            vlc_tick_t bufferingLevel;
             StreamFormat format;
             SharedResources *resources;
             SynchronizationReferences *synchronizationReferences;
@@ -76,6 +76,20 @@ static void Close   (vlc_object_t *);
 
 #define ADAPT_MAXBUFFER_TEXT N_("Max buffering (ms)")
 
+#define ADAPT_TRANSFERS_TEXT N_("Concurrent downloads")
+#define ADAPT_TRANSFERS_LONGTEXT N_("Maximum number of segments downloaded at the same time")
+
+#define ADAPT_PREFETCH_TEXT N_("Prefetched segments")
+#define ADAPT_PREFETCH_LONGTEXT N_("Number of segments requested ahead for each stream")
+
+#define ADAPT_CACHESIZE_TEXT N_("Segment disk cache size (MiB)")
+#define ADAPT_CACHESIZE_LONGTEXT N_("Keeps init segments and played segments on disk " \
+                                    "for reuse by later sessions. 0 disables the cache")
+
+#define ADAPT_CACHEDIR_TEXT N_("Segment disk cache directory")
+#define ADAPT_CACHEDIR_LONGTEXT N_("Directory of the segment cache, which can be " \
+                                   "shared by several players")
+
 #define ADAPT_LOGIC_TEXT N_("Adaptive Logic")
 
 #define ADAPT_ACCESS_TEXT N_("Use regular HTTP modules")
@@ -141,6 +155,14 @@ vlc_module_begin ()
         add_integer( "adaptive-maxbuffer",
                      MS_FROM_VLC_TICK(AbstractBufferingLogic::DEFAULT_MAX_BUFFERING),
                      ADAPT_MAXBUFFER_TEXT, nullptr );
+        add_integer_with_range( "adaptive-transfers", 3, 1, 16,
+                     ADAPT_TRANSFERS_TEXT, ADAPT_TRANSFERS_LONGTEXT );
+        add_integer_with_range( "adaptive-prefetch",
+                     AbstractBufferingLogic::DEFAULT_LOOKAHEAD, 0, 16,
+                     ADAPT_PREFETCH_TEXT, ADAPT_PREFETCH_LONGTEXT );
+        add_integer( "adaptive-cache-size", 0, ADAPT_CACHESIZE_TEXT, ADAPT_CACHESIZE_LONGTEXT );
+            change_integer_range( 0, 1 << 20 )
+        add_directory( "adaptive-cache-dir", nullptr, ADAPT_CACHEDIR_TEXT, ADAPT_CACHEDIR_LONGTEXT )
         add_integer( "adaptive-lowlatency", -1, ADAPT_LOWLATENCY_TEXT, ADAPT_LOWLATENCY_LONGTEXT );
             change_integer_list(rgi_latency, ppsz_latency)
         set_callbacks( Open, Close )
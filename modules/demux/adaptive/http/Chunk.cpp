@@ -29,6 +29,7 @@
 #include "HTTPConnection.hpp"
 #include "HTTPConnectionManager.h"
 #include "Downloader.hpp"
+#include "DiskCache.hpp"
 
 #include <vlc_common.h>
 #include <vlc_block.h>
@@ -336,11 +337,13 @@ HTTPChunkBufferedSource::HTTPChunkBufferedSource(const std::string& url, Abstrac
     HTTPChunkSource(url, manager, sourceid, type, range, access),
     p_head     (nullptr),
     pp_tail    (&p_head),
-    buffered     (0)
+    buffered     (0),
+    transferTime (0)
 {
     done = false;
     eof = false;
     held = false;
+    diskcache = nullptr;
     p_read = nullptr;
     inblockreadoffset = 0;
 }
@@ -384,8 +387,11 @@ void HTTPChunkBufferedSource::release()
     avail.signal();
 }
 
-void HTTPChunkBufferedSource::bufferize(size_t readsize)
+void HTTPChunkBufferedSource::bufferize(size_t readsize, unsigned transfers)
 {
+    if(loadFromDiskCache())
+        return;
+
     {
         mutex_locker locker {lock};
         if(!prepare())
@@ -416,8 +422,14 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
         vlc_tick_t time;
         vlc_tick_t latency;
     } rate = {0,0,0};
+    bool b_store = false;
 
+    /* When transfers run concurrently, each only gets a share of the link.
+     * Account for that share so that the reported rate stays the link
+     * rate the adaptation logic expects. */
+    const vlc_tick_t readStartTime = vlc_tick_now();
     ssize_t ret = connection->read(p_block->p_buffer, readsize);
+    const vlc_tick_t readTime = (vlc_tick_now() - readStartTime) / transfers;
     if(ret <= 0)
     {
         block_Release(p_block);
@@ -425,14 +437,17 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
         mutex_locker locker {lock};
         done = true;
         downloadEndTime = vlc_tick_now();
+        transferTime += readTime;
         rate.size = buffered;
-        rate.time = downloadEndTime - requestStartTime;
         rate.latency = responseTime - requestStartTime;
+        rate.time = rate.latency + transferTime;
+        b_store = ret == 0 && isStorable();
     }
     else
     {
         p_block->i_buffer = (size_t) ret;
         mutex_locker locker {lock};
+        transferTime += readTime;
         buffered += p_block->i_buffer;
         block_ChainLastAppend(&pp_tail, p_block);
         if(p_read == nullptr)
@@ -445,8 +460,9 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
             done = true;
             downloadEndTime = vlc_tick_now();
             rate.size = buffered;
-            rate.time = downloadEndTime - requestStartTime;
             rate.latency = responseTime - requestStartTime;
+            rate.time = rate.latency + transferTime;
+            b_store = isStorable();
         }
     }
 
@@ -457,6 +473,50 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
     }
 
     avail.signal();
+
+    /* The chain is complete and stays alive while we are held */
+    if(b_store)
+        diskcache->put(getStorageID(), getContentType(), p_head);
+}
+
+void HTTPChunkBufferedSource::setDiskCache(DiskCache *cache)
+{
+    mutex_locker locker {lock};
+    diskcache = cache;
+}
+
+/* Called from the downloader, before any request */
+bool HTTPChunkBufferedSource::loadFromDiskCache()
+{
+    {
+        mutex_locker locker {lock};
+        if(!diskcache || prepared || done)
+            return false;
+    }
+
+    std::string contenttype;
+    block_t *p_block = diskcache->get(getStorageID(), &contenttype);
+    if(!p_block)
+        return false;
+
+    mutex_locker locker {lock};
+    cachedContentType = contenttype;
+    contentLength = buffered = p_block->i_buffer;
+    block_ChainLastAppend(&pp_tail, p_block);
+    p_read = p_head;
+    inblockreadoffset = 0;
+    prepared = true;
+    requeststatus = RequestStatus::Success;
+    done = true;
+    avail.signal();
+    return true;
+}
+
+/* Only complete transfers the server allowed to store */
+bool HTTPChunkBufferedSource::isStorable() const
+{
+    return diskcache && connection && connection->isStorable() && buffered &&
+           (!contentLength || contentLength == buffered);
 }
 
 bool HTTPChunkBufferedSource::hasMoreData() const
@@ -465,6 +525,16 @@ bool HTTPChunkBufferedSource::hasMoreData() const
     return !eof;
 }
 
+std::string HTTPChunkBufferedSource::getContentType() const
+{
+    {
+        mutex_locker locker {lock};
+        if(!connection)
+            return cachedContentType;
+    }
+    return HTTPChunkSource::getContentType();
+}
+
 void HTTPChunkBufferedSource::recycle()
 {
     p_read = p_head;
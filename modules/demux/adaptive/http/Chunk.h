@@ -42,6 +42,7 @@ namespace adaptive
         class AbstractConnection;
         class AbstractConnectionManager;
         class AbstractChunk;
+        class DiskCache;
 
         enum class ChunkType
         {
@@ -164,13 +165,15 @@ namespace adaptive
                 virtual block_t *  readBlock       ()  override;
                 virtual block_t *  read            (size_t)  override;
                 virtual bool       hasMoreData     () const  override;
+                virtual std::string getContentType  () const  override;
                 virtual void        recycle() override;
 
             protected:
                 HTTPChunkBufferedSource(const std::string &url, AbstractConnectionManager *,
                                         const ID &, ChunkType, const BytesRange &,
                                         bool = false);
-                void               bufferize(size_t);
+                void               bufferize(size_t, unsigned = 1);
+                void               setDiskCache(DiskCache *);
                 bool               isDone() const;
                 void               hold();
                 void               release();
@@ -181,10 +184,15 @@ namespace adaptive
                 const block_t      *p_read;
                 size_t              inblockreadoffset;
                 size_t              buffered; /* read cache size */
+                vlc_tick_t          transferTime; /* share of the link used */
                 bool                done;
                 bool                eof;
                 vlc::threads::condition_variable avail;
                 bool                held;
+                DiskCache          *diskcache;
+                std::string         cachedContentType; /* when read from disk */
+                bool               loadFromDiskCache();
+                bool               isStorable() const;
         };
 
         class HTTPChunk : public AbstractChunk
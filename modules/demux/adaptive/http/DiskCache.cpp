@@ -0,0 +1,321 @@
+/*
+ * DiskCache.cpp
+ *****************************************************************************
+ * Copyright (C) 2026 - VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "DiskCache.hpp"
+
+#include <vlc_block.h>
+#include <vlc_configuration.h>
+#include <vlc_fs.h>
+#include <vlc_hash.h>
+#include <vlc_strings.h>
+
+#include <algorithm>
+#include <tuple>
+#include <vector>
+#include <cerrno>
+#include <cstdio>
+#include <sys/stat.h>
+
+using namespace adaptive::http;
+
+/* file layout: magic, storage ID, content type, then payload */
+static const char DISKCACHE_MAGIC[8] = { 'V','L','C','A','D','C','1','\n' };
+static const char DISKCACHE_SUFFIX[] = ".chunk";
+/* seconds between directory rescans when evicting */
+static const time_t DISKCACHE_RESCAN_INTERVAL = 60;
+/* seconds after which a temporary file is left over from a crash */
+static const time_t DISKCACHE_TEMP_EXPIRY = 600;
+/* length of the vlc_mkstemp() suffix of temporary files */
+static const size_t DISKCACHE_TEMP_SUFFIXLEN = sizeof(".XXXXXX") - 1;
+
+DiskCache::DiskCache(vlc_object_t *obj_, const std::string &dir_, size_t maxsize_)
+{
+    obj = obj_;
+    dir = dir_;
+    maxsize = maxsize_;
+    total = 0;
+    lastscan = 0;
+    clock = 0;
+    vlc::threads::mutex_locker locker {lock};
+    scan();
+}
+
+DiskCache::~DiskCache()
+{
+}
+
+DiskCache * DiskCache::create(vlc_object_t *obj)
+{
+    int64_t size = var_InheritInteger(obj, "adaptive-cache-size");
+    if(size <= 0)
+        return nullptr;
+
+    std::string dir;
+    char *psz = var_InheritString(obj, "adaptive-cache-dir");
+    if(psz)
+    {
+        dir = psz;
+        free(psz);
+    }
+    else
+    {
+        char *cachedir = config_GetUserDir(VLC_CACHE_DIR);
+        if(!cachedir)
+            return nullptr;
+        if(vlc_mkdir(cachedir, 0700) && errno != EEXIST)
+        {
+            free(cachedir);
+            return nullptr;
+        }
+        dir = std::string(cachedir) + DIR_SEP "adaptive";
+        free(cachedir);
+    }
+
+    if(vlc_mkdir(dir.c_str(), 0700) && errno != EEXIST)
+    {
+        msg_Warn(obj, "cannot create segment cache directory %s", dir.c_str());
+        return nullptr;
+    }
+
+    msg_Dbg(obj, "using segment cache %s (%" PRId64 " MiB)", dir.c_str(), size);
+    return new DiskCache(obj, dir, static_cast<size_t>(size) << 20);
+}
+
+std::string DiskCache::getPath(const std::string &id) const
+{
+    vlc_hash_md5_t md5;
+    vlc_hash_md5_Init(&md5);
+    vlc_hash_md5_Update(&md5, id.c_str(), id.length());
+    uint8_t digest[VLC_HASH_MD5_DIGEST_SIZE];
+    vlc_hash_md5_Finish(&md5, digest, sizeof(digest));
+    char hex[VLC_HASH_MD5_DIGEST_HEX_SIZE];
+    vlc_hex_encode_binary(digest, sizeof(digest), hex);
+    return std::string(hex) + DISKCACHE_SUFFIX;
+}
+
+block_t * DiskCache::get(const std::string &id, std::string *type)
+{
+    const std::string name = getPath(id);
+    const std::string path = dir + DIR_SEP + name;
+
+    FILE *f = vlc_fopen(path.c_str(), "rb");
+    if(!f)
+        return nullptr;
+
+#ifndef _WIN32
+    /* the other players evict by mtime, so mark the hit on the file too */
+    futimens(fileno(f), nullptr);
+#endif
+
+    block_t *p_block = nullptr;
+    long size;
+    if(fseek(f, 0, SEEK_END) == 0 && (size = ftell(f)) > (long) sizeof(DISKCACHE_MAGIC) &&
+       fseek(f, 0, SEEK_SET) == 0 && (p_block = block_Alloc(size)))
+    {
+        if(fread(p_block->p_buffer, 1, size, f) != (size_t) size)
+        {
+            block_Release(p_block);
+            p_block = nullptr;
+        }
+    }
+    fclose(f);
+
+    if(!p_block)
+        return nullptr;
+
+    /* check this is not a hash collision nor a foreign file */
+    const char *p = reinterpret_cast<const char *>(p_block->p_buffer);
+    const char *end = p + p_block->i_buffer;
+    const char *idend = nullptr, *typeend = nullptr;
+    if(!memcmp(p, DISKCACHE_MAGIC, sizeof(DISKCACHE_MAGIC)))
+    {
+        p += sizeof(DISKCACHE_MAGIC);
+        idend = static_cast<const char *>(memchr(p, '\n', end - p));
+        if(idend)
+            typeend = static_cast<const char *>(memchr(idend + 1, '\n', end - idend - 1));
+    }
+    if(!typeend || id.compare(0, std::string::npos, p, idend - p) != 0)
+    {
+        block_Release(p_block);
+        return nullptr;
+    }
+
+    *type = std::string(idend + 1, typeend - idend - 1);
+    const size_t header = typeend + 1 - reinterpret_cast<const char *>(p_block->p_buffer);
+    p_block->p_buffer += header;
+    p_block->i_buffer -= header;
+
+    vlc::threads::mutex_locker locker {lock};
+    auto it = entries.find(name);
+    if(it == entries.end())
+    {
+        Entry entry;
+        entry.size = size;
+        it = entries.insert(std::make_pair(name, entry)).first;
+        total += size;
+    }
+    (*it).second.stamp = time(nullptr);
+    (*it).second.seq = ++clock;
+
+    return p_block;
+}
+
+void DiskCache::put(const std::string &id, const std::string &type, const block_t *p_chain)
+{
+    const std::string headerstr = std::string(DISKCACHE_MAGIC, sizeof(DISKCACHE_MAGIC))
+                                + id + '\n' + type + '\n';
+    size_t size = headerstr.length();
+    for(const block_t *p_block = p_chain; p_block; p_block = p_block->p_next)
+        size += p_block->i_buffer;
+    if(size > maxsize / 4)
+        return;
+
+    const std::string name = getPath(id);
+    const std::string path = dir + DIR_SEP + name;
+    std::vector<char> tmp(path.begin(), path.end());
+    static const char tmpsuffix[] = ".XXXXXX";
+    static_assert(sizeof(tmpsuffix) - 1 == DISKCACHE_TEMP_SUFFIXLEN, "suffix length");
+    tmp.insert(tmp.end(), tmpsuffix, tmpsuffix + sizeof(tmpsuffix));
+
+    int fd = vlc_mkstemp(&tmp[0]);
+    if(fd == -1)
+        return;
+
+    bool b_ok = vlc_write(fd, headerstr.c_str(), headerstr.length()) == (ssize_t) headerstr.length();
+    for(const block_t *p_block = p_chain; p_block && b_ok; p_block = p_block->p_next)
+        b_ok = vlc_write(fd, p_block->p_buffer, p_block->i_buffer) == (ssize_t) p_block->i_buffer;
+    if(vlc_close(fd))
+        b_ok = false;
+
+    /* readers in other players only ever see complete files */
+    if(!b_ok || vlc_rename(&tmp[0], path.c_str()))
+    {
+        vlc_unlink(&tmp[0]);
+        return;
+    }
+
+    vlc::threads::mutex_locker locker {lock};
+    auto it = entries.find(name);
+    if(it != entries.end())
+        total -= (*it).second.size;
+    Entry &entry = entries[name];
+    entry.size = size;
+    entry.stamp = time(nullptr);
+    entry.seq = ++clock;
+    total += size;
+    if(total > maxsize)
+        trim();
+}
+
+bool DiskCache::isTemporary(const std::string &name)
+{
+    const size_t suffixlen = sizeof(DISKCACHE_SUFFIX) - 1;
+    if(name.length() <= suffixlen + DISKCACHE_TEMP_SUFFIXLEN)
+        return false;
+    const size_t pos = name.length() - DISKCACHE_TEMP_SUFFIXLEN;
+    return name[pos] == '.' &&
+           !name.compare(pos - suffixlen, suffixlen, DISKCACHE_SUFFIX);
+}
+
+void DiskCache::scan()
+{
+    lastscan = time(nullptr);
+    vlc_DIR *d = vlc_opendir(dir.c_str());
+    if(!d)
+        return;
+
+    /* Other players share the directory, so the files are the reference.
+     * Keep our own access times as they are more recent than the mtime. */
+    std::map<std::string, Entry> found;
+    size_t foundtotal = 0;
+    const size_t suffixlen = sizeof(DISKCACHE_SUFFIX) - 1;
+    const char *psz;
+    while((psz = vlc_readdir(d)))
+    {
+        const std::string name(psz);
+        const std::string path = dir + DIR_SEP + name;
+        struct stat st;
+
+        if(isTemporary(name))
+        {
+            /* a player died while writing it */
+            if(!vlc_stat(path.c_str(), &st) &&
+               lastscan - st.st_mtime > DISKCACHE_TEMP_EXPIRY)
+            {
+                vlc_unlink(path.c_str());
+                msg_Dbg(obj, "segment cache removed stale %s", name.c_str());
+            }
+            continue;
+        }
+        if(name.length() <= suffixlen ||
+           name.compare(name.length() - suffixlen, suffixlen, DISKCACHE_SUFFIX))
+            continue;
+        if(vlc_stat(path.c_str(), &st))
+            continue;
+        Entry entry;
+        entry.size = st.st_size;
+        entry.stamp = st.st_mtime;
+        entry.seq = 0;
+        auto it = entries.find(name);
+        if(it != entries.end())
+        {
+            entry.stamp = std::max(entry.stamp, (*it).second.stamp);
+            entry.seq = (*it).second.seq;
+        }
+        found[name] = entry;
+        foundtotal += entry.size;
+    }
+    vlc_closedir(d);
+
+    entries.swap(found);
+    total = foundtotal;
+}
+
+void DiskCache::trim()
+{
+    if(time(nullptr) - lastscan >= DISKCACHE_RESCAN_INTERVAL)
+    {
+        scan();
+        if(total <= maxsize)
+            return;
+    }
+
+    std::vector<std::tuple<time_t, uint64_t, std::string>> lru;
+    lru.reserve(entries.size());
+    for(const auto &e : entries)
+        lru.push_back(std::make_tuple(e.second.stamp, e.second.seq, e.first));
+    std::sort(lru.begin(), lru.end());
+
+    /* leave some headroom so we don't rescan on every put */
+    const size_t target = maxsize - maxsize / 8;
+    for(auto it = lru.cbegin(); it != lru.cend() && total > target; ++it)
+    {
+        const std::string &name = std::get<2>(*it);
+        auto entry = entries.find(name);
+        /* may already be gone if another player evicted it */
+        vlc_unlink((dir + DIR_SEP + name).c_str());
+        total -= (*entry).second.size;
+        entries.erase(entry);
+        msg_Dbg(obj, "segment cache purged %s", name.c_str());
+    }
+}
@@ -0,0 +1,74 @@
+/*
+ * DiskCache.hpp
+ *****************************************************************************
+ * Copyright (C) 2026 - VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef DISKCACHE_HPP_
+#define DISKCACHE_HPP_
+
+#include <vlc_common.h>
+#include <vlc_cxx_helpers.hpp>
+
+#include <map>
+#include <string>
+#include <ctime>
+
+namespace adaptive
+{
+    namespace http
+    {
+        /* Size bounded, content addressed store of downloaded chunks.
+         * Entries are files named after the hash of their storage ID,
+         * so any player pointed to the same directory can reuse them.
+         * Files are published with an atomic rename and evicted in
+         * least recently used order. Usage is tracked in memory, the
+         * directory is only rescanned from time to time to account for
+         * the other players. The methods do blocking file I/O. */
+        class DiskCache
+        {
+            public:
+                DiskCache(vlc_object_t *, const std::string &, size_t);
+                ~DiskCache();
+                static DiskCache * create(vlc_object_t *);
+                block_t * get(const std::string &, std::string *);
+                void put(const std::string &, const std::string &, const block_t *);
+
+            private:
+                class Entry
+                {
+                    public:
+                        size_t size;
+                        time_t stamp;
+                        uint64_t seq; /* orders accesses within a second */
+                };
+                std::string getPath(const std::string &) const;
+                static bool isTemporary(const std::string &);
+                void scan();
+                void trim();
+                vlc_object_t *obj;
+                std::string dir;
+                size_t maxsize;
+                size_t total;
+                time_t lastscan;
+                uint64_t clock;
+                std::map<std::string, Entry> entries;
+                vlc::threads::mutex lock;
+        };
+    }
+}
+
+#endif
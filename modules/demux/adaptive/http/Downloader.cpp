@@ -25,42 +25,41 @@
 
 #include <vlc_threads.h>
 
-#include <atomic>
+#include <algorithm>
 
 using namespace adaptive::http;
 
-Downloader::Downloader()
+Downloader::Downloader(unsigned transfers)
 {
     killed = false;
-    thread_handle_valid = false;
-    current = nullptr;
-    cancel_current = false;
+    maxtransfers = std::max(transfers, 1U);
 }
 
 bool Downloader::start()
 {
-    if(!thread_handle_valid &&
-       vlc_clone(&thread_handle, downloaderThread, static_cast<void *>(this)))
+    while(threads.size() < maxtransfers)
     {
-        return false;
+        vlc_thread_t th;
+        if(vlc_clone(&th, downloaderThread, static_cast<void *>(this)))
+            break;
+        threads.push_back(th);
     }
-    thread_handle_valid = true;
-    return true;
+    return !threads.empty();
 }
 
 Downloader::~Downloader()
 {
     kill();
 
-    if(thread_handle_valid)
-        vlc_join(thread_handle, nullptr);
+    for(vlc_thread_t th : threads)
+        vlc_join(th, nullptr);
 }
 
 void Downloader::kill()
 {
     vlc::threads::mutex_locker locker {lock};
     killed = true;
-    wait_cond.signal();
+    wait_cond.broadcast();
 }
 
 void Downloader::schedule(HTTPChunkBufferedSource *source)
@@ -74,9 +73,9 @@ void Downloader::schedule(HTTPChunkBufferedSource *source)
 void Downloader::cancel(HTTPChunkBufferedSource *source)
 {
     vlc::threads::mutex_locker locker {lock};
-    while (current == source)
+    while (isCurrent(source))
     {
-        cancel_current = true;
+        cancelled.push_back(source);
         updated_cond.wait(lock);
     }
 
@@ -87,6 +86,21 @@ void Downloader::cancel(HTTPChunkBufferedSource *source)
     }
 }
 
+bool Downloader::isCurrent(const HTTPChunkBufferedSource *source) const
+{
+    return std::find(current.begin(), current.end(), source) != current.end();
+}
+
+HTTPChunkBufferedSource * Downloader::getNextQueued() const
+{
+    for(HTTPChunkBufferedSource *source : chunks)
+    {
+        if(!isCurrent(source))
+            return source;
+    }
+    return nullptr;
+}
+
 void * Downloader::downloaderThread(void *opaque)
 {
     vlc_thread_set_name("vlc-adapt-dl");
@@ -101,7 +115,8 @@ void Downloader::Run()
     {
         lock.lock();
 
-        while(chunks.empty() && !killed)
+        HTTPChunkBufferedSource *source;
+        while(!(source = getNextQueued()) && !killed)
             wait_cond.wait(lock);
 
         if(killed)
@@ -110,18 +125,26 @@ void Downloader::Run()
             break;
         }
 
-        current = chunks.front();
+        current.push_back(source);
+        const unsigned transfers = current.size();
         lock.unlock();
-        current->bufferize(HTTPChunkSource::CHUNK_SIZE);
+        source->bufferize(HTTPChunkSource::CHUNK_SIZE, transfers);
         lock.lock();
-        if(current->isDone() || cancel_current)
+        current.remove(source);
+        const bool b_cancelled = std::find(cancelled.begin(), cancelled.end(),
+                                           source) != cancelled.end();
+        if(source->isDone() || b_cancelled)
+        {
+            chunks.remove(source);
+            source->release();
+        }
+        else
         {
-            chunks.pop_front();
-            current->release();
+            /* still queued, maybe waiting for a thread */
+            wait_cond.signal();
         }
-        cancel_current = false;
-        current = nullptr;
-        updated_cond.signal();
+        cancelled.remove(source);
+        updated_cond.broadcast();
         lock.unlock();
     }
 }
@@ -25,6 +25,7 @@
 #include <vlc_common.h>
 #include <vlc_cxx_helpers.hpp>
 #include <list>
+#include <vector>
 
 namespace adaptive
 {
@@ -32,10 +33,12 @@ namespace adaptive
     namespace http
     {
 
+        /* Runs up to a given number of transfers at once. Sources are
+         * serviced in scheduling order, each by one thread at a time. */
         class Downloader
         {
             public:
-                Downloader();
+                Downloader(unsigned = 1);
                 ~Downloader();
                 bool start();
                 void schedule(HTTPChunkBufferedSource *);
@@ -45,15 +48,17 @@ namespace adaptive
                 static void * downloaderThread(void *);
                 void Run();
                 void kill();
-                vlc_thread_t thread_handle;
+                HTTPChunkBufferedSource * getNextQueued() const;
+                bool isCurrent(const HTTPChunkBufferedSource *) const;
+                std::vector<vlc_thread_t> threads;
+                unsigned     maxtransfers;
                 vlc::threads::mutex lock;
                 vlc::threads::condition_variable wait_cond;
                 vlc::threads::condition_variable updated_cond;
-                bool         thread_handle_valid;
                 bool         killed;
-                bool         cancel_current;
                 std::list<HTTPChunkBufferedSource *> chunks;
-                HTTPChunkBufferedSource *current;
+                std::list<HTTPChunkBufferedSource *> current;
+                std::list<HTTPChunkBufferedSource *> cancelled;
         };
 
     }
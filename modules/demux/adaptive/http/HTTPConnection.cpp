@@ -46,6 +46,7 @@ AbstractConnection::AbstractConnection(vlc_object_t *p_object_)
     available = true;
     bytesRead = 0;
     contentLength = 0;
+    storable = true;
 }
 
 AbstractConnection::~AbstractConnection()
@@ -78,6 +79,11 @@ const std::string & AbstractConnection::getContentType() const
     return contentType;
 }
 
+bool AbstractConnection::isStorable() const
+{
+    return storable;
+}
+
 const ConnectionParams & AbstractConnection::getRedirection() const
 {
     return locationparams;
@@ -273,6 +279,7 @@ void LibVLCHTTPConnection::reset()
     }
     bytesRange = BytesRange();
     contentType = std::string();
+    storable = true;
     bytesRead = 0;
     contentLength = 0;
 }
@@ -399,6 +406,9 @@ RequestStatus LibVLCHTTPConnection::request(const std::string &path,
     if(s)
         contentType = std::string(s);
 
+    storable = !vlc_http_msg_get_token(source->http_res->response,
+                                       "Cache-Control", "no-store");
+
     s = vlc_http_msg_get_header(source->http_res->response, "Content-Encoding");
     if(s && stream && (strstr(s, "deflate") || strstr(s, "gzip")))
     {
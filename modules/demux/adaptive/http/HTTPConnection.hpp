@@ -56,6 +56,7 @@ namespace adaptive
                 virtual size_t  getContentLength() const;
                 virtual size_t  getBytesRead() const;
                 virtual const std::string & getContentType() const;
+                virtual bool    isStorable() const;
                 virtual const ConnectionParams &getRedirection() const;
                 virtual void    setUsed( bool ) = 0;
 
@@ -66,6 +67,7 @@ namespace adaptive
                 bool               available;
                 size_t             contentLength;
                 std::string        contentType;
+                bool               storable; /* response may be kept */
                 BytesRange         bytesRange;
                 size_t             bytesRead;
         };
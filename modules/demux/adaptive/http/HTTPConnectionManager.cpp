@@ -29,6 +29,7 @@
 #include "HTTPConnection.hpp"
 #include "ConnectionParams.hpp"
 #include "Downloader.hpp"
+#include "DiskCache.hpp"
 #include "../tools/Debug.hpp"
 #include <vlc_url.h>
 #include <vlc_http.h>
@@ -77,12 +78,14 @@ HTTPConnectionManager::HTTPConnectionManager    (vlc_object_t *p_object_)
       localAllowed(false)
 {
     vlc_mutex_init(&lock);
-    downloader = new Downloader();
+    unsigned transfers = p_object ? var_InheritInteger(p_object, "adaptive-transfers") : 1;
+    downloader = new Downloader(transfers);
     downloaderhp = new Downloader();
     downloader->start();
     downloaderhp->start();
     cache_total = 0;
     cache_max = 1 << 19;
+    diskcache = p_object ? DiskCache::create(p_object) : nullptr;
 }
 
 HTTPConnectionManager::~HTTPConnectionManager   ()
@@ -99,6 +102,7 @@ HTTPConnectionManager::~HTTPConnectionManager   ()
     }
     delete downloader;
     delete downloaderhp;
+    delete diskcache;
     this->closeAllConnections();
     while(!factories.empty())
     {
@@ -194,8 +198,16 @@ AbstractChunkSource *HTTPConnectionManager::makeSource(const std::string &url,
         case ChunkType::Key:
         case ChunkType::Playlist:
         default:
-            return new HTTPChunkBufferedSource(url, this, id, type, range);
+            break;
     }
+
+    HTTPChunkBufferedSource *source = new HTTPChunkBufferedSource(url, this, id, type, range);
+    /* Never store playlists, nor keys in the clear. The downloader does
+     * the disk I/O. */
+    if(diskcache && !storageid.empty() && (type == ChunkType::Init ||
+       type == ChunkType::Index || type == ChunkType::Segment))
+        source->setDiskCache(diskcache);
+    return source;
 }
 
 void HTTPConnectionManager::recycleSource(AbstractChunkSource *source)
@@ -42,6 +42,7 @@ namespace adaptive
         class AbstractConnectionFactory;
         class AbstractConnection;
         class Downloader;
+        class DiskCache;
         class AbstractChunkSource;
         class HTTPChunkBufferedSource;
         enum class ChunkType;
@@ -104,6 +105,7 @@ namespace adaptive
                 std::list<HTTPChunkBufferedSource *> cache;
                 size_t cache_total;
                 size_t cache_max;
+                DiskCache *diskcache;
         };
     }
 }
@@ -40,12 +40,16 @@ const vlc_tick_t AbstractBufferingLogic::BUFFERING_LOWEST_LIMIT = VLC_TICK_FROM_
 const vlc_tick_t AbstractBufferingLogic::DEFAULT_MIN_BUFFERING = VLC_TICK_FROM_SEC(6);
 const vlc_tick_t AbstractBufferingLogic::DEFAULT_MAX_BUFFERING = VLC_TICK_FROM_SEC(30);
 const vlc_tick_t AbstractBufferingLogic::DEFAULT_LIVE_BUFFERING = VLC_TICK_FROM_SEC(15);
+const vlc_tick_t AbstractBufferingLogic::LOW_LATENCY_LOWEST_LIMIT = VLC_TICK_FROM_MS(500);
+const vlc_tick_t AbstractBufferingLogic::DEFAULT_LOW_LATENCY_BUFFERING = VLC_TICK_FROM_MS(1500);
+const unsigned AbstractBufferingLogic::DEFAULT_LOOKAHEAD = 2;
 
 AbstractBufferingLogic::AbstractBufferingLogic()
 {
     userMinBuffering = 0;
     userMaxBuffering = 0;
     userLiveDelay = 0;
+    userLookahead = DEFAULT_LOOKAHEAD;
 }
 
 void AbstractBufferingLogic::setLowDelay(bool b)
@@ -68,6 +72,11 @@ void AbstractBufferingLogic::setUserLiveDelay(vlc_tick_t v)
     userLiveDelay = v;
 }
 
+void AbstractBufferingLogic::setUserLookahead(unsigned v)
+{
+    userLookahead = v;
+}
+
 /* Try to never buffer up to really end */
 /* Enforce no overlap for demuxers segments 3.0.0 */
 /* FIXME: check duration instead ? */
@@ -101,8 +110,16 @@ uint64_t DefaultBufferingLogic::getStartSegmentNumber(BaseRepresentation *rep) c
 
 vlc_tick_t DefaultBufferingLogic::getMinBuffering(const BasePlaylist *p) const
 {
+    /* Low latency keeps a single target for buffering and live delay,
+     * as advertised by the playlist (part hold back, latency target) */
     if(isLowLatency(p))
-        return BUFFERING_LOWEST_LIMIT;
+    {
+        vlc_tick_t target = p->targetLatency.Get() ? p->targetLatency.Get()
+                                                   : DEFAULT_LOW_LATENCY_BUFFERING;
+        if(userLiveDelay)
+            target = userLiveDelay;
+        return std::max(target, LOW_LATENCY_LOWEST_LIMIT);
+    }
 
     vlc_tick_t buffering = userMinBuffering ? userMinBuffering
                                             : DEFAULT_MIN_BUFFERING;
@@ -151,6 +168,23 @@ vlc_tick_t DefaultBufferingLogic::getStableBuffering(const BasePlaylist *p) cons
     return std::min(getMinBuffering(p) * 2, max);
 }
 
+unsigned DefaultBufferingLogic::getLookahead(const BasePlaylist *p, vlc_tick_t buffered,
+                                             vlc_tick_t duration) const
+{
+    /* Low latency must stay on the edge, and nothing can be decided
+     * until the stream has reported its buffering level */
+    if(isLowLatency(p) || buffered == VLC_TICK_INVALID || duration <= 0)
+        return 0;
+
+    /* Only fetch ahead what still fits the buffering window once
+     * the current segment has been demuxed */
+    vlc_tick_t room = getMaxBuffering(p) - buffered;
+    if(room < 2 * duration)
+        return 0;
+    return std::min(static_cast<uint64_t>(room / duration - 1),
+                    static_cast<uint64_t>(userLookahead));
+}
+
 uint64_t DefaultBufferingLogic::getLiveStartSegmentNumber(BaseRepresentation *rep) const
 {
     BasePlaylist *playlist = rep->getPlaylist();
@@ -240,7 +274,8 @@ uint64_t DefaultBufferingLogic::getLiveStartSegmentNumber(BaseRepresentation *re
         if(scaledduration)
         {
             /* Compute playback offset and effective finished segment from wall time */
-            vlc_tick_t now = vlc_tick_from_sec(time(nullptr));
+            vlc_tick_t now = vlc_tick_from_sec(time(nullptr)) +
+                             mediaSegmentTemplate->inheritAvailabilityTimeOffset();
             vlc_tick_t playbacktime = now - i_buffering;
             vlc_tick_t minavailtime = playlist->availabilityStartTime.Get() + rep->getPeriodStart();
             const uint64_t startnumber = mediaSegmentTemplate->inheritStartNumber();
@@ -47,19 +47,26 @@ namespace adaptive
                 virtual vlc_tick_t getMaxBuffering(const BasePlaylist *) const = 0;
                 virtual vlc_tick_t getLiveDelay(const BasePlaylist *) const = 0;
                 virtual vlc_tick_t getStableBuffering(const BasePlaylist *) const = 0;
+                /* Number of segments to request ahead of the current one */
+                virtual unsigned getLookahead(const BasePlaylist *, vlc_tick_t, vlc_tick_t) const = 0;
                 void setUserMinBuffering(vlc_tick_t);
                 void setUserMaxBuffering(vlc_tick_t);
                 void setUserLiveDelay(vlc_tick_t);
+                void setUserLookahead(unsigned);
                 void setLowDelay(bool);
                 static const vlc_tick_t BUFFERING_LOWEST_LIMIT;
                 static const vlc_tick_t DEFAULT_MIN_BUFFERING;
                 static const vlc_tick_t DEFAULT_MAX_BUFFERING;
                 static const vlc_tick_t DEFAULT_LIVE_BUFFERING;
+                static const vlc_tick_t LOW_LATENCY_LOWEST_LIMIT;
+                static const vlc_tick_t DEFAULT_LOW_LATENCY_BUFFERING;
+                static const unsigned DEFAULT_LOOKAHEAD;
 
             protected:
                 vlc_tick_t userMinBuffering;
                 vlc_tick_t userMaxBuffering;
                 vlc_tick_t userLiveDelay;
+                unsigned userLookahead;
                 Undef<bool> userLowLatency;
         };
 
@@ -73,6 +80,7 @@ namespace adaptive
                 virtual vlc_tick_t getMaxBuffering(const BasePlaylist *) const override;
                 virtual vlc_tick_t getLiveDelay(const BasePlaylist *) const override;
                 virtual vlc_tick_t getStableBuffering(const BasePlaylist *) const override;
+                virtual unsigned getLookahead(const BasePlaylist *, vlc_tick_t, vlc_tick_t) const override;
                 static const unsigned SAFETY_BUFFERING_EDGE_OFFSET;
                 static const unsigned SAFETY_EXPURGING_OFFSET;
 
@@ -52,6 +52,7 @@ ISegment::ISegment(const ICanonicalUrl *parent):
     discontinuitySequenceNumber = std::numeric_limits<uint64_t>::max();
     templated = false;
     discontinuity = false;
+    partial = false;
     displayTime = VLC_TICK_INVALID;
 }
 
@@ -172,6 +173,8 @@ void ISegment::debug(vlc_object_t *obj, int indent) const
         if(discontinuitySequenceNumber != std::numeric_limits<uint64_t>::max())
             ss << "#" << discontinuitySequenceNumber;
     }
+    if(partial)
+        ss << " partial";
     msg_Dbg(obj, "%s", ss.str().c_str());
 }
 
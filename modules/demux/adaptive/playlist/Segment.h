@@ -75,6 +75,7 @@ namespace adaptive
                 Property<stime_t>       startTime;
                 Property<stime_t>       duration;
                 bool                    discontinuity;
+                bool                    partial; /* still being produced, live edge */
 
             protected:
                 virtual bool                            prepareChunk    (SharedResources *,
@@ -112,11 +112,25 @@ void SegmentList::updateWith(AbstractMultipleSegmentBaseType *updated_,
     }
     else
     {
-        const Segment * prevSegment = segments.back();
+        /* number and start time expected for the next segment */
+        Segment *last = segments.back();
+        uint64_t nextNumber = last->getSequenceNumber() + 1;
+        stime_t nextStart = last->startTime.Get() + last->duration.Get();
+
+        /* the segment that was still being produced is superseded */
+        if(last->partial)
+        {
+            nextNumber = last->getSequenceNumber();
+            nextStart = last->startTime.Get();
+            totalLength -= last->duration.Get();
+            delete last;
+            segments.pop_back();
+        }
+
         const uint64_t oldest = updated->segments.front()->getSequenceNumber();
 
         /* filter out known segments from the update */
-        updated->pruneBySegmentNumber(prevSegment->getSequenceNumber() + 1);
+        updated->pruneBySegmentNumber(nextNumber);
 
         if(updated->segments.empty())
             return;
@@ -125,16 +139,17 @@ void SegmentList::updateWith(AbstractMultipleSegmentBaseType *updated_,
         for(auto it = updated->segments.begin(); it != updated->segments.end(); ++it)
         {
             Segment *cur = *it;
-            cur->startTime.Set(prevSegment->startTime.Get() + prevSegment->duration.Get());
+            cur->startTime.Set(nextStart);
             /* not continuous */
-            if(cur->getSequenceNumber() != prevSegment->getSequenceNumber() + 1)
+            if(cur->getSequenceNumber() != nextNumber)
             {
-                assert(prevSegment->getSequenceNumber() < cur->getSequenceNumber());
+                assert(nextNumber < cur->getSequenceNumber());
                 assert(duration);
-                uint64_t gap = cur->getSequenceNumber() - prevSegment->getSequenceNumber() - 1;
+                uint64_t gap = cur->getSequenceNumber() - nextNumber;
                 cur->startTime.Set(cur->startTime.Get() + duration * gap);
             }
-            prevSegment = cur;
+            nextNumber = cur->getSequenceNumber() + 1;
+            nextStart = cur->startTime.Get() + cur->duration.Get();
             addSegment(cur);
         }
         updated->segments.clear();
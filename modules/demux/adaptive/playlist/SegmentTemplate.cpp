@@ -135,7 +135,9 @@ vlc_tick_t SegmentTemplate::getMinAheadTime(uint64_t number) const
     else
     {
         const Timescale timescale = inheritTimescale();
-        uint64_t current = getLiveTemplateNumber(vlc_tick_from_sec(time(nullptr)));
+        /* chunked segments are available before their completion */
+        vlc_tick_t now = vlc_tick_from_sec(time(nullptr)) + inheritAvailabilityTimeOffset();
+        uint64_t current = getLiveTemplateNumber(now);
         stime_t i_length = (current - number) * inheritDuration();
         return timescale.ToTime(i_length);
     }
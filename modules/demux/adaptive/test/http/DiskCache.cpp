@@ -0,0 +1,234 @@
+/*****************************************************************************
+ *
+ *****************************************************************************
+ * Copyright (C) 2026 - VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "../../http/DiskCache.hpp"
+
+#include "../test.hpp"
+
+#include <vlc_block.h>
+#include <vlc_fs.h>
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+
+using namespace adaptive::http;
+
+static block_t * makeChain(size_t size, uint8_t fill)
+{
+    /* split in two so that put() has to walk the chain */
+    block_t *p_head = block_Alloc(size / 2);
+    block_t *p_tail = block_Alloc(size - size / 2);
+    if(!p_head || !p_tail)
+    {
+        if(p_head)
+            block_Release(p_head);
+        if(p_tail)
+            block_Release(p_tail);
+        return nullptr;
+    }
+    memset(p_head->p_buffer, fill, p_head->i_buffer);
+    memset(p_tail->p_buffer, fill + 1, p_tail->i_buffer);
+    p_head->p_next = p_tail;
+    return p_head;
+}
+
+static std::vector<std::string> listFiles(const std::string &dir)
+{
+    std::vector<std::string> paths;
+    vlc_DIR *d = vlc_opendir(dir.c_str());
+    if(!d)
+        return paths;
+    const char *psz;
+    while((psz = vlc_readdir(d)))
+    {
+        if(strcmp(psz, ".") && strcmp(psz, ".."))
+            paths.push_back(dir + DIR_SEP + psz);
+    }
+    vlc_closedir(d);
+    return paths;
+}
+
+static void setAge(const std::string &path, time_t age)
+{
+    struct utimbuf times;
+    times.actime = times.modtime = time(nullptr) - age;
+    utime(path.c_str(), &times);
+}
+
+static void cleanup(const std::string &dir)
+{
+    for(const std::string &path : listFiles(dir))
+        vlc_unlink(path.c_str());
+    rmdir(dir.c_str());
+}
+
+static int DiskCache_test(const std::string &dir)
+{
+    const size_t maxsize = 1 << 20;
+    DiskCache cache(nullptr, dir, maxsize);
+    std::string type;
+
+    /* miss */
+    Expect(cache.get("http://foo/unknown", &type) == nullptr);
+
+    /* round trip, type included */
+    block_t *p_chain = makeChain(1000, 0x40);
+    Expect(p_chain);
+    cache.put("http://foo/seg1", "video/mp2t", p_chain);
+    block_ChainRelease(p_chain);
+    block_t *p_block = cache.get("http://foo/seg1", &type);
+    Expect(p_block);
+    Expect(type == "video/mp2t");
+    Expect(p_block->i_buffer == 1000);
+    bool b_match = p_block->p_buffer[0] == 0x40 &&
+                   p_block->p_buffer[499] == 0x40 &&
+                   p_block->p_buffer[500] == 0x41 &&
+                   p_block->p_buffer[999] == 0x41;
+    block_Release(p_block);
+    Expect(b_match);
+
+    /* empty type */
+    p_chain = makeChain(10, 0x00);
+    Expect(p_chain);
+    cache.put("http://foo/seg2", "", p_chain);
+    block_ChainRelease(p_chain);
+    p_block = cache.get("http://foo/seg2", &type);
+    Expect(p_block);
+    block_Release(p_block);
+    Expect(type.empty());
+
+#ifndef _WIN32
+    /* a hit refreshes the file mtime, shared with the other players */
+    for(const std::string &path : listFiles(dir))
+        setAge(path, 3600);
+    p_block = cache.get("http://foo/seg2", &type);
+    Expect(p_block);
+    block_Release(p_block);
+    size_t fresh = 0;
+    for(const std::string &path : listFiles(dir))
+    {
+        struct stat st;
+        if(!vlc_stat(path.c_str(), &st) && time(nullptr) - st.st_mtime < 600)
+            fresh++;
+    }
+    Expect(fresh == 1);
+#endif
+
+    /* temporary files left over by a crashed writer are removed */
+    {
+        const std::string stale = dir + DIR_SEP "0123456789abcdef.chunk.a1b2c3";
+        const std::string writing = dir + DIR_SEP "fedcba9876543210.chunk.d4e5f6";
+        FILE *f = vlc_fopen(stale.c_str(), "wb");
+        Expect(f);
+        fclose(f);
+        setAge(stale, 3600);
+        f = vlc_fopen(writing.c_str(), "wb");
+        Expect(f);
+        fclose(f);
+
+        DiskCache other(nullptr, dir, maxsize);
+        struct stat st;
+        Expect(vlc_stat(stale.c_str(), &st) != 0);
+        Expect(vlc_stat(writing.c_str(), &st) == 0);
+        vlc_unlink(writing.c_str());
+    }
+
+    /* another ID must not read the same file */
+    Expect(cache.get("http://foo/seg10", &type) == nullptr);
+
+    /* a foreign or corrupted file at the entry path is rejected */
+    {
+        DiskCache other(nullptr, dir, maxsize);
+        p_chain = makeChain(100, 0x10);
+        Expect(p_chain);
+        other.put("http://foo/seg3", "video/mp4", p_chain);
+        block_ChainRelease(p_chain);
+    }
+    for(const std::string &path : listFiles(dir))
+    {
+        FILE *f = vlc_fopen(path.c_str(), "r+b");
+        Expect(f);
+        fputc('X', f); /* breaks the magic of every entry */
+        fclose(f);
+    }
+    Expect(cache.get("http://foo/seg1", &type) == nullptr);
+    Expect(cache.get("http://foo/seg3", &type) == nullptr);
+
+    /* too large for the cache */
+    p_chain = makeChain(maxsize / 4, 0x20);
+    Expect(p_chain);
+    cache.put("http://foo/large", "video/mp2t", p_chain);
+    block_ChainRelease(p_chain);
+    Expect(cache.get("http://foo/large", &type) == nullptr);
+
+    /* stays within budget, keeping the most recent ones */
+    const size_t entrysize = maxsize / 16;
+    for(int i = 0; i < 64; i++)
+    {
+        p_chain = makeChain(entrysize, i);
+        Expect(p_chain);
+        cache.put("http://foo/many" + std::to_string(i), "video/mp2t", p_chain);
+        block_ChainRelease(p_chain);
+    }
+    size_t total = 0;
+    for(const std::string &path : listFiles(dir))
+    {
+        struct stat st;
+        if(!vlc_stat(path.c_str(), &st))
+            total += st.st_size;
+    }
+    Expect(total <= maxsize);
+    p_block = cache.get("http://foo/many63", &type);
+    Expect(p_block);
+    block_Release(p_block);
+    Expect(cache.get("http://foo/many0", &type) == nullptr);
+
+    return 0;
+}
+
+int DiskCache_test()
+{
+    char tmpl[] = "adaptive_test_cache.XXXXXX";
+    int fd = vlc_mkstemp(tmpl);
+    if(fd == -1)
+        return 1;
+    vlc_close(fd);
+    vlc_unlink(tmpl);
+    if(vlc_mkdir(tmpl, 0700))
+        return 1;
+
+    const std::string dir(tmpl);
+    int ret;
+    try
+    {
+        ret = DiskCache_test(dir);
+    } catch (...) {
+        ret = 1;
+    }
+    cleanup(dir);
+    return ret;
+}
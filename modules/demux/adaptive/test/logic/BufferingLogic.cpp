@@ -110,6 +110,16 @@ int BufferingLogic_test()
         Expect(bufferinglogic.getStableBuffering(playlist) <= bufferinglogic.getMaxBuffering(playlist));
         Expect(bufferinglogic.getStableBuffering(playlist) >= bufferinglogic.getMinBuffering(playlist));
 
+        const vlc_tick_t duration = VLC_TICK_FROM_SEC(2);
+        Expect(bufferinglogic.getLookahead(playlist, VLC_TICK_INVALID, duration) == 0);
+        Expect(bufferinglogic.getLookahead(playlist, 0, 0) == 0);
+        Expect(bufferinglogic.getLookahead(playlist, 0, duration) == DefaultBufferingLogic::DEFAULT_LOOKAHEAD);
+        Expect(bufferinglogic.getLookahead(playlist, DefaultBufferingLogic::DEFAULT_MAX_BUFFERING - duration,
+                                           duration) == 0);
+        bufferinglogic.setUserLookahead(0);
+        Expect(bufferinglogic.getLookahead(playlist, 0, duration) == 0);
+        bufferinglogic.setUserLookahead(DefaultBufferingLogic::DEFAULT_LOOKAHEAD);
+
         bufferinglogic.setUserMinBuffering(DefaultBufferingLogic::DEFAULT_MIN_BUFFERING / 2);
         Expect(bufferinglogic.getMinBuffering(playlist) == std::max(DefaultBufferingLogic::DEFAULT_MIN_BUFFERING / 2,
                                                                     DefaultBufferingLogic::BUFFERING_LOWEST_LIMIT));
@@ -141,8 +151,17 @@ int BufferingLogic_test()
         if(DefaultBufferingLogic::DEFAULT_MIN_BUFFERING > DefaultBufferingLogic::BUFFERING_LOWEST_LIMIT)
             Expect(bufferinglogic.getMinBuffering(playlist) < DefaultBufferingLogic::DEFAULT_MIN_BUFFERING);
         Expect(bufferinglogic.getMaxBuffering(playlist) < DefaultBufferingLogic::DEFAULT_MAX_BUFFERING);
-        Expect(bufferinglogic.getMinBuffering(playlist) >= DefaultBufferingLogic::BUFFERING_LOWEST_LIMIT);
-        Expect(bufferinglogic.getLiveDelay(playlist) >= DefaultBufferingLogic::BUFFERING_LOWEST_LIMIT);
+        Expect(bufferinglogic.getMinBuffering(playlist) >= DefaultBufferingLogic::LOW_LATENCY_LOWEST_LIMIT);
+        Expect(bufferinglogic.getLiveDelay(playlist) >= DefaultBufferingLogic::LOW_LATENCY_LOWEST_LIMIT);
+        Expect(bufferinglogic.getLiveDelay(playlist) < VLC_TICK_FROM_SEC(2));
+        Expect(bufferinglogic.getLookahead(playlist, 0, duration) == 0);
+
+        playlist->targetLatency.Set(VLC_TICK_FROM_MS(800));
+        Expect(bufferinglogic.getLiveDelay(playlist) == VLC_TICK_FROM_MS(800));
+        Expect(bufferinglogic.getMaxBuffering(playlist) == VLC_TICK_FROM_MS(800));
+        playlist->targetLatency.Set(DefaultBufferingLogic::LOW_LATENCY_LOWEST_LIMIT / 2);
+        Expect(bufferinglogic.getLiveDelay(playlist) == DefaultBufferingLogic::LOW_LATENCY_LOWEST_LIMIT);
+        playlist->targetLatency.Set(0);
 
         playlist->b_lowlatency = false;
         Expect(bufferinglogic.getStartSegmentNumber(rep) == number);
@@ -543,5 +543,164 @@ int M3U8Playlist_test()
         return 1;
     }
 
+    /* Manifest 6: low latency, parts are byte ranges of the same resource */
+    const char manifest6[] =
+    "#EXTM3U\n"
+    "#EXT-X-TARGETDURATION:4\n"
+    "#EXT-X-SERVER-CONTROL:CAN-BLOCK-RELOAD=YES,PART-HOLD-BACK=3.0\n"
+    "#EXT-X-PART-INF:PART-TARGET=1.0\n"
+    "#EXT-X-MEDIA-SEQUENCE:10\n"
+    "#EXTINF:4\n"
+    "foobar10.mp4\n"
+    "#EXT-X-PART:DURATION=1.0,URI=\"foobar11.mp4\",BYTERANGE=\"1000@0\"\n"
+    "#EXT-X-PART:DURATION=1.0,URI=\"foobar11.mp4\",BYTERANGE=\"1000\"\n"
+    "#EXTINF:2\n"
+    "foobar11.mp4\n"
+    "#EXT-X-PART:DURATION=1.0,URI=\"foobar12.mp4\",BYTERANGE=\"1000@0\"\n"
+    "#EXT-X-PART:DURATION=1.0,URI=\"foobar12.mp4\",BYTERANGE=\"1200\"\n"
+    "#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"foobar12.mp4\",BYTERANGE-START=2200\n";
+
+    m3u = ParseM3U8(obj, manifest6, sizeof(manifest6));
+    try
+    {
+        Expect(m3u);
+        Expect(m3u->isLive() == true);
+        Expect(m3u->isLowLatency() == true);
+        Expect(m3u->targetLatency.Get() == vlc_tick_from_sec(3));
+        HLSRepresentation *rep = static_cast<HLSRepresentation *>(
+                    m3u->getFirstPeriod()->getAdaptationSets().front()->
+                    getRepresentations().front());
+
+        /* complete segments, including the one described by parts */
+        Segment *seg = rep->getMediaSegment(11);
+        Expect(seg);
+        Expect(seg->partial == false);
+
+        /* the segment being produced is exposed as a partial segment */
+        seg = rep->getMediaSegment(12);
+        Expect(seg);
+        Expect(seg->partial == true);
+        Expect(seg->getSequenceNumber() == 12);
+        vlc_tick_t mediatime, duration;
+        Expect(rep->getPlaybackTimeDurationBySegmentNumber(12, &mediatime, &duration));
+        Expect(mediatime == vlc_tick_from_sec(6));
+        Expect(duration == vlc_tick_from_sec(2));
+        Expect(rep->getMediaSegment(13) == nullptr);
+
+        /* blocking reload waits for the next segment */
+        Expect(rep->getPlaylistUpdateUrl().find("_HLS_msn=13&_HLS_part=0")
+               != std::string::npos);
+
+        delete m3u;
+    }
+    catch (...)
+    {
+        delete m3u;
+        return 1;
+    }
+
+    /* Manifest 7: low latency, parts are separate resources */
+    const char manifest7[] =
+    "#EXTM3U\n"
+    "#EXT-X-TARGETDURATION:4\n"
+    "#EXT-X-PART-INF:PART-TARGET=1.0\n"
+    "#EXT-X-MEDIA-SEQUENCE:10\n"
+    "#EXTINF:4\n"
+    "foobar10.mp4\n"
+    "#EXT-X-PART:DURATION=1.0,URI=\"foobar11.0.mp4\"\n"
+    "#EXT-X-PART:DURATION=1.0,URI=\"foobar11.1.mp4\"\n"
+    "#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"foobar11.2.mp4\"\n";
+
+    m3u = ParseM3U8(obj, manifest7, sizeof(manifest7));
+    try
+    {
+        Expect(m3u);
+        Expect(m3u->isLowLatency() == true);
+        /* PART-HOLD-BACK defaults to 3 part targets */
+        Expect(m3u->targetLatency.Get() == vlc_tick_from_sec(3));
+        HLSRepresentation *rep = static_cast<HLSRepresentation *>(
+                    m3u->getFirstPeriod()->getAdaptationSets().front()->
+                    getRepresentations().front());
+        Expect(rep->getMediaSegment(10));
+        Expect(rep->getMediaSegment(11) == nullptr);
+        /* no blocking reload without CAN-BLOCK-RELOAD */
+        Expect(rep->getPlaylistUpdateUrl().find("_HLS_msn") == std::string::npos);
+
+        delete m3u;
+    }
+    catch (...)
+    {
+        delete m3u;
+        return 1;
+    }
+
+    /* Manifest 8: low latency, only a preload hint for the next segment */
+    const char manifest8[] =
+    "#EXTM3U\n"
+    "#EXT-X-TARGETDURATION:4\n"
+    "#EXT-X-SERVER-CONTROL:CAN-BLOCK-RELOAD=YES\n"
+    "#EXT-X-PART-INF:PART-TARGET=0.5\n"
+    "#EXT-X-MEDIA-SEQUENCE:10\n"
+    "#EXTINF:4\n"
+    "foobar10.mp4\n"
+    "#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"foobar11.mp4\"\n";
+
+    m3u = ParseM3U8(obj, manifest8, sizeof(manifest8));
+    try
+    {
+        Expect(m3u);
+        Expect(m3u->isLowLatency() == true);
+        HLSRepresentation *rep = static_cast<HLSRepresentation *>(
+                    m3u->getFirstPeriod()->getAdaptationSets().front()->
+                    getRepresentations().front());
+        Segment *seg = rep->getMediaSegment(11);
+        Expect(seg);
+        Expect(seg->partial == true);
+        vlc_tick_t mediatime, duration;
+        Expect(rep->getPlaybackTimeDurationBySegmentNumber(11, &mediatime, &duration));
+        Expect(mediatime == vlc_tick_from_sec(4));
+        /* one part target when nothing is known yet */
+        Expect(duration == VLC_TICK_FROM_MS(500));
+        Expect(rep->getPlaylistUpdateUrl().find("_HLS_msn=12&_HLS_part=0")
+               != std::string::npos);
+
+        delete m3u;
+    }
+    catch (...)
+    {
+        delete m3u;
+        return 1;
+    }
+
+    /* Manifest 9: parts are ignored when the playlist is complete */
+    const char manifest9[] =
+    "#EXTM3U\n"
+    "#EXT-X-TARGETDURATION:4\n"
+    "#EXT-X-PART-INF:PART-TARGET=1.0\n"
+    "#EXT-X-MEDIA-SEQUENCE:10\n"
+    "#EXTINF:4\n"
+    "foobar10.mp4\n"
+    "#EXT-X-PART:DURATION=1.0,URI=\"foobar11.mp4\",BYTERANGE=\"1000@0\"\n"
+    "#EXT-X-ENDLIST\n";
+
+    m3u = ParseM3U8(obj, manifest9, sizeof(manifest9));
+    try
+    {
+        Expect(m3u);
+        Expect(m3u->isLive() == false);
+        Expect(m3u->isLowLatency() == false);
+        BaseRepresentation *rep = m3u->getFirstPeriod()->getAdaptationSets().front()->
+                                  getRepresentations().front();
+        Expect(rep->getMediaSegment(10));
+        Expect(rep->getMediaSegment(11) == nullptr);
+
+        delete m3u;
+    }
+    catch (...)
+    {
+        delete m3u;
+        return 1;
+    }
+
     return 0;
 }
@@ -167,6 +167,48 @@ int SegmentList_test() try
     segmentList.reset();
     segmentList2.reset();
 
+    /* partial segment at the live edge is superseded by the update */
+    for(int count=1; count<3; count++)
+    {
+        segmentList = std::make_unique<SegmentList>(nullptr, true);
+        segmentList->addAttribute(new TimescaleAttr(timescale));
+        segmentList->addAttribute(new DurationAttr(100));
+        for(int i=0; i<count; i++)
+        {
+            seg = std::make_unique<Segment>(nullptr);
+            seg->setSequenceNumber(123 + i);
+            seg->startTime.Set(START + 100 * i);
+            seg->duration.Set(100);
+            seg->partial = (i == count - 1);
+            if(seg->partial)
+                seg->duration.Set(30);
+            segmentList->addSegment(seg.release());
+        }
+        segmentList2 = std::make_unique<SegmentList>(nullptr, true);
+        for(int i=0; i<count+1; i++)
+        {
+            seg = std::make_unique<Segment>(nullptr);
+            seg->setSequenceNumber(123 + i);
+            seg->startTime.Set(100 * i);
+            seg->duration.Set(100);
+            segmentList2->addSegment(seg.release());
+        }
+        segmentList->updateWith(segmentList2.get());
+        Expect(segmentList->getSegments().size() == (size_t)count + 1);
+        Expect(segmentList->getTotalLength() == 100 * (count + 1));
+        for(int i=0; i<count+1; i++)
+        {
+            const Segment *cur = segmentList->getSegments().at(i);
+            Expect(cur->getSequenceNumber() == (uint64_t)123 + i);
+            Expect(cur->startTime.Get() == START + 100 * i);
+            Expect(cur->duration.Get() == 100);
+            Expect(!cur->partial);
+        }
+
+        segmentList.reset();
+        segmentList2.reset();
+    }
+
     /* gap updates, relative timings */
     segmentList = std::make_unique<SegmentList>(nullptr, true);
     segmentList->addAttribute(new TimescaleAttr(timescale));
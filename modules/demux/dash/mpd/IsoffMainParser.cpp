@@ -98,6 +98,7 @@ MPD * IsoffMainParser::parse()
     {
         parseMPDAttributes(mpd, root);
         parseProgramInformation(DOMHelper::getFirstChildElementByName(root, "ProgramInformation"), mpd);
+        parseServiceDescription(DOMHelper::getFirstChildElementByName(root, "ServiceDescription"), mpd);
         parseMPDBaseUrl(mpd, root);
         parsePeriods(mpd, root);
         mpd->addAttribute(new StartnumberAttr(1));
@@ -580,6 +581,21 @@ void IsoffMainParser::parseProgramInformation(Node * node, MPD *mpd)
     }
 }
 
+void IsoffMainParser::parseServiceDescription(Node * node, MPD *mpd)
+{
+    if(!node)
+        return;
+
+    /* Latency@target is in milliseconds */
+    Node *latency = DOMHelper::getFirstChildElementByName(node, "Latency");
+    if(latency && latency->hasAttribute("target"))
+    {
+        int64_t target = strtoll(latency->getAttributeValue("target").c_str(), nullptr, 10);
+        if(target > 0)
+            mpd->targetLatency.Set(VLC_TICK_FROM_MS(target));
+    }
+}
+
 Profile IsoffMainParser::getProfile() const
 {
     Profile res(Profile::Name::Unknown);
@@ -44,6 +44,9 @@ HLSRepresentation::HLSRepresentation  ( BaseAdaptationSet *set ) :
     updateFailureCount = 0;
     lastUpdateTime = 0;
     targetDuration = 0;
+    partTarget = 0;
+    b_blockingReload = false;
+    nextPartialSequence = 0;
     streamFormat = StreamFormat::Type::Unknown;
     channels = 0;
 }
@@ -87,6 +90,19 @@ Url HLSRepresentation::getPlaylistUrl() const
     }
 }
 
+std::string HLSRepresentation::getPlaylistUpdateUrl() const
+{
+    std::string url = getPlaylistUrl().toString();
+    /* Low latency delivery directive: the server holds the request
+     * until the next segment has started being produced */
+    if(b_loaded && isLive() && partTarget && b_blockingReload)
+    {
+        url += (url.find('?') == std::string::npos) ? '?' : '&';
+        url += "_HLS_msn=" + std::to_string(nextPartialSequence) + "&_HLS_part=0";
+    }
+    return url;
+}
+
 void HLSRepresentation::debug(vlc_object_t *obj, int indent) const
 {
     BaseRepresentation::debug(obj, indent);
@@ -136,6 +152,9 @@ bool HLSRepresentation::needsUpdate(uint64_t number) const
         vlc_tick_t duration = targetDuration
                             ? vlc_tick_from_sec(targetDuration)
                             : VLC_TICK_FROM_SEC(2);
+        /* parts are published at part target pace */
+        if(partTarget && getPlaylist()->isLowLatency())
+            duration = partTarget;
         if(updateFailureCount)
             duration /= 2;
         if(elapsed < duration)
@@ -45,6 +45,7 @@ namespace hls
 
                 void setPlaylistUrl(const std::string &);
                 Url getPlaylistUrl() const;
+                std::string getPlaylistUpdateUrl() const;
                 bool isLive() const;
                 bool initialized() const;
                 virtual void scheduleNextUpdate(uint64_t, bool) override;
@@ -60,6 +61,9 @@ namespace hls
 
             protected:
                 time_t targetDuration;
+                vlc_tick_t partTarget; /* low latency parts, 0 if none */
+                bool b_blockingReload;
+                uint64_t nextPartialSequence; /* segment to wait for on reload */
                 Url playlistUrl;
 
             private:
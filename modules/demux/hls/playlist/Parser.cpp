@@ -224,7 +224,7 @@ void M3U8Parser::fillAdaptsetFromMediainfo(const AttributesTag *mediatag,
 
 bool M3U8Parser::appendSegmentsFromPlaylistURI(vlc_object_t *p_obj, HLSRepresentation *rep)
 {
-    block_t *p_block = Retrieve::HTTP(resources, ChunkType::Playlist, rep->getPlaylistUrl().toString());
+    block_t *p_block = Retrieve::HTTP(resources, ChunkType::Playlist, rep->getPlaylistUpdateUrl());
     if(p_block)
     {
         stream_t *substream = vlc_stream_MemoryNew(p_obj, p_block->p_buffer, p_block->i_buffer, true);
@@ -278,6 +278,52 @@ static bool parseEncryption(const AttributesTag *keytag, const Url &playlistUrl,
     }
 }
 
+/* Low latency parts can only be read as one growing segment when they
+ * are contiguous byte ranges of a single resource, starting at 0 */
+static bool getPartialSegmentUri(const std::list<const AttributesTag *> &parts,
+                                 const AttributesTag *hint,
+                                 std::string &uri, vlc_tick_t &duration)
+{
+    std::size_t expected = 0;
+    uri.clear();
+    duration = 0;
+    for(const AttributesTag *part : parts)
+    {
+        const Attribute *uriAttr = part->getAttributeByName("URI");
+        const Attribute *rangeAttr = part->getAttributeByName("BYTERANGE");
+        const Attribute *gapAttr = part->getAttributeByName("GAP");
+        if(!uriAttr || !rangeAttr || (gapAttr && gapAttr->value == "YES"))
+            return false;
+        if(uri.empty())
+            uri = uriAttr->quotedString();
+        else if(uri != uriAttr->quotedString())
+            return false;
+        const Attribute range = rangeAttr->unescapeQuotes();
+        std::pair<std::size_t,std::size_t> offlen = range.getByteRange();
+        if(range.value.find('@') == std::string::npos)
+            offlen.first = expected;
+        if(offlen.first != expected)
+            return false;
+        expected += offlen.second;
+        const Attribute *durAttr = part->getAttributeByName("DURATION");
+        if(durAttr)
+            duration += vlc_tick_from_sec(durAttr->floatingPoint());
+    }
+
+    if(hint)
+    {
+        const Attribute *typeAttr = hint->getAttributeByName("TYPE");
+        const Attribute *uriAttr = hint->getAttributeByName("URI");
+        const Attribute *startAttr = hint->getAttributeByName("BYTERANGE-START");
+        if(typeAttr && typeAttr->value == "PART" && uriAttr &&
+           (uri.empty() || uri == uriAttr->quotedString()) &&
+           (startAttr ? startAttr->decimal() : 0) == expected)
+            uri = uriAttr->quotedString();
+    }
+
+    return !uri.empty();
+}
+
 void M3U8Parser::parseSegments(vlc_object_t *, HLSRepresentation *rep, const std::list<Tag *> &tagslist)
 {
     bool b_pdt = tagslist.cend() != std::find_if(tagslist.cbegin(), tagslist.cend(),
@@ -300,6 +346,8 @@ void M3U8Parser::parseSegments(vlc_object_t *, HLSRepresentation *rep, const std
     const SingleValueTag *ctx_byterange = nullptr;
     CommonEncryption encryption;
     const ValuesListTag *ctx_extinf = nullptr;
+    std::list<const AttributesTag *> ctx_parts;
+    const AttributesTag *ctx_preloadhint = nullptr;
 
     std::list<HLSSegment *> segmentstoappend;
 
@@ -374,9 +422,42 @@ void M3U8Parser::parseSegments(vlc_object_t *, HLSRepresentation *rep, const std
 
                 if(encryption.method != CommonEncryption::Method::None)
                     segment->setEncryption(encryption);
+
+                /* parts listed so far belonged to that segment */
+                ctx_parts.clear();
+            }
+            break;
+
+            case AttributesTag::EXTXSERVERCONTROL:
+            {
+                const AttributesTag *ctrltag = static_cast<const AttributesTag *>(tag);
+                const Attribute *attr = ctrltag->getAttributeByName("PART-HOLD-BACK");
+                if(attr)
+                    rep->getPlaylist()->targetLatency.Set(vlc_tick_from_sec(attr->floatingPoint()));
+                attr = ctrltag->getAttributeByName("HOLD-BACK");
+                if(attr)
+                    rep->getPlaylist()->suggestedPresentationDelay.Set(vlc_tick_from_sec(attr->floatingPoint()));
+                attr = ctrltag->getAttributeByName("CAN-BLOCK-RELOAD");
+                rep->b_blockingReload = attr && attr->value == "YES";
+            }
+            break;
+
+            case AttributesTag::EXTXPARTINF:
+            {
+                const Attribute *attr = static_cast<const AttributesTag *>(tag)->getAttributeByName("PART-TARGET");
+                if(attr)
+                    rep->partTarget = vlc_tick_from_sec(attr->floatingPoint());
             }
             break;
 
+            case AttributesTag::EXTXPART:
+                ctx_parts.push_back(static_cast<const AttributesTag *>(tag));
+                break;
+
+            case AttributesTag::EXTXPRELOADHINT:
+                ctx_preloadhint = static_cast<const AttributesTag *>(tag);
+                break;
+
             case SingleValueTag::EXTXTARGETDURATION:
                 rep->targetDuration = static_cast<const SingleValueTag *>(tag)->getValue().decimal();
                 break;
@@ -450,6 +531,43 @@ void M3U8Parser::parseSegments(vlc_object_t *, HLSRepresentation *rep, const std
         }
     }
 
+    /* Low latency: expose the segment still being produced, so that it
+     * can be demuxed while its bytes arrive */
+    std::string partialuri;
+    vlc_tick_t partialduration;
+    if(!b_vod && rep->partTarget &&
+       getPartialSegmentUri(ctx_parts, ctx_preloadhint, partialuri, partialduration))
+    {
+        HLSSegment *segment = new (std::nothrow) HLSSegment(rep, sequenceNumber);
+        if(segment)
+        {
+            segment->setSourceUrl(partialuri);
+            if(!partialduration)
+                partialduration = rep->partTarget;
+            segment->duration.Set(timescale.ToScaled(partialduration));
+            segment->startTime.Set(timescale.ToScaled(nzStartTime));
+            if(absReferenceTime != VLC_TICK_INVALID)
+                segment->setDisplayTime(absReferenceTime);
+            segment->setDiscontinuitySequenceNumber(discontinuitySequence);
+            segment->discontinuity = discontinuity;
+            if(encryption.method != CommonEncryption::Method::None)
+                segment->setEncryption(encryption);
+            segment->partial = true;
+            segmentstoappend.push_back(segment);
+            sequenceNumber++;
+        }
+    }
+
+    if(rep->partTarget)
+    {
+        M3U8 *m3u8 = static_cast<M3U8 *>(rep->getPlaylist());
+        m3u8->setLowLatency(!b_vod);
+        /* spec minimum when the server does not advertise it */
+        if(!m3u8->targetLatency.Get())
+            m3u8->targetLatency.Set(rep->partTarget * 3);
+        rep->nextPartialSequence = sequenceNumber;
+    }
+
     for(HLSSegment *seg : segmentstoappend)
         segmentList->addSegment(seg);
     segmentstoappend.clear();
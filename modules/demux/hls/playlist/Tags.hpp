@@ -99,6 +99,10 @@ namespace hls
                     EXTXSTART,
                     EXTXSTREAMINF,
                     EXTXSESSIONKEY,
+                    EXTXSERVERCONTROL,
+                    EXTXPARTINF,
+                    EXTXPART,
+                    EXTXPRELOADHINT,
                 };
                 AttributesTag(int, const std::string &);
                 virtual ~AttributesTag();
@@ -44,6 +44,7 @@
 #include "ts_psip.h"
 
 #include "ts_hotfixes.h"
+#include "ts_sync.h"
 #include "ts_sl.h"
 #include "ts_metadata.h"
 #include "sections.h"
@@ -194,6 +195,9 @@ static bool GatherPESData( demux_t *p_demux, ts_pid_t *, block_t *, size_t );
 static void ProgramSetPCR( demux_t *p_demux, ts_pmt_t *p_prg, stime_t i_pcr );
 
 static block_t* ReadTSPacket( demux_t *p_demux );
+static block_t* ReadTSPacketInChunk( demux_t *p_demux );
+static block_t* MaterializeTSPacket( block_t *p_pkt );
+static uint64_t TSStreamTell( demux_t *p_demux );
 static int SeekToTime( demux_t *p_demux, const ts_pmt_t *, stime_t time );
 static void ReadyQueuesPostSeek( demux_t *p_demux );
 static void PCRHandle( demux_t *p_demux, ts_pid_t *, stime_t );
@@ -205,6 +209,9 @@ static void PCRFixHandle( demux_t *, ts_pmt_t *, block_t * );
 #define TS_PACKET_SIZE_MAX 204
 #define TS_HEADER_SIZE 4
 
+/* Packets read from the stream at once while demuxing */
+#define TS_READ_CHUNK_PACKETS 256
+
 #define PROBE_CHUNK_COUNT 500
 #define PROBE_MAX         (PROBE_CHUNK_COUNT * 10)
 
@@ -212,44 +219,39 @@ static int DetectPacketSize( demux_t *p_demux, unsigned *pi_header_size, int i_o
 {
     const uint8_t *p_peek;
 
-    if( vlc_stream_Peek( p_demux->s,
-                     &p_peek, i_offset + TS_PACKET_SIZE_MAX ) < i_offset + TS_PACKET_SIZE_MAX )
+    /* Enough data to check 3 more sync bytes for any sync candidate */
+    ssize_t i_peek = vlc_stream_Peek( p_demux->s, &p_peek,
+                                      i_offset + TS_PACKET_SIZE_MAX * 4 );
+    if( i_peek < i_offset + TS_PACKET_SIZE_MAX )
         return -1;
 
-    for( int i_sync = 0; i_sync < TS_PACKET_SIZE_MAX; i_sync++ )
-    {
-        if( p_peek[i_offset + i_sync] != 0x47 )
-            continue;
+    p_peek += i_offset;
+    i_peek -= i_offset;
 
-        /* Check next 3 sync bytes */
-        int i_peek = i_offset + TS_PACKET_SIZE_MAX * 3 + i_sync + 1;
-        if( ( vlc_stream_Peek( p_demux->s, &p_peek, i_peek ) ) < i_peek )
-            return -1;
+    /* Smallest sync offset wins, then the smallest packet size */
+    static const unsigned sizes[] = { TS_PACKET_SIZE_188,
+                                      TS_PACKET_SIZE_192,
+                                      TS_PACKET_SIZE_204 };
+    size_t i_sync = TS_PACKET_SIZE_MAX;
+    int i_packet_size = -1;
 
-        if( p_peek[i_offset + i_sync + 1 * TS_PACKET_SIZE_188] == 0x47 &&
-            p_peek[i_offset + i_sync + 2 * TS_PACKET_SIZE_188] == 0x47 &&
-            p_peek[i_offset + i_sync + 3 * TS_PACKET_SIZE_188] == 0x47 )
-        {
-            return TS_PACKET_SIZE_188;
-        }
-        else if( p_peek[i_offset + i_sync + 1 * TS_PACKET_SIZE_192] == 0x47 &&
-                 p_peek[i_offset + i_sync + 2 * TS_PACKET_SIZE_192] == 0x47 &&
-                 p_peek[i_offset + i_sync + 3 * TS_PACKET_SIZE_192] == 0x47 )
-        {
-            if( i_sync == 4 )
-            {
-                *pi_header_size = 4; /* BluRay TS packets have 4-byte header */
-            }
-            return TS_PACKET_SIZE_192;
-        }
-        else if( p_peek[i_offset + i_sync + 1 * TS_PACKET_SIZE_204] == 0x47 &&
-                 p_peek[i_offset + i_sync + 2 * TS_PACKET_SIZE_204] == 0x47 &&
-                 p_peek[i_offset + i_sync + 3 * TS_PACKET_SIZE_204] == 0x47 )
+    for( size_t i = 0; i < ARRAY_SIZE(sizes); i++ )
+    {
+        size_t i_found = ts_sync_Find( p_peek, i_peek, sizes[i], 4 );
+        if( i_found < i_sync )
         {
-            return TS_PACKET_SIZE_204;
+            i_sync = i_found;
+            i_packet_size = sizes[i];
         }
     }
 
+    if( i_packet_size != -1 )
+    {
+        if( i_packet_size == TS_PACKET_SIZE_192 && i_sync == 4 )
+            *pi_header_size = 4; /* BluRay TS packets have 4-byte header */
+        return i_packet_size;
+    }
+
     if( p_demux->obj.force )
     {
         msg_Warn( p_demux, "this does not look like a TS stream, continuing" );
@@ -597,6 +599,7 @@ static void Close( vlc_object_t *p_this )
     /* Clear up attachments */
     vlc_dictionary_clear( &p_sys->attachments, FreeDictAttachment, NULL );
 
+    free( p_sys->chunk.p_buf );
     free( p_sys->record_dir_path );
     free( p_sys );
 }
@@ -646,7 +649,7 @@ static int Demux( demux_t *p_demux )
         bool         b_frame = false;
         int          i_header = 0;
         block_t     *p_pkt;
-        if( !(p_pkt = ReadTSPacket( p_demux )) )
+        if( !(p_pkt = ReadTSPacketInChunk( p_demux )) )
         {
             return VLC_DEMUXER_EOF;
         }
@@ -739,6 +742,10 @@ static int Demux( demux_t *p_demux )
 
             if( p_pid->u.p_stream->transport == TS_TRANSPORT_PES )
             {
+                /* PES gathering keeps the packet, move it out of the chunk */
+                p_pkt = MaterializeTSPacket( p_pkt );
+                if( unlikely(p_pkt == NULL) )
+                    continue;
                 b_frame = GatherPESData( p_demux, p_pid, p_pkt, i_header );
             }
             else if( p_pid->u.p_stream->transport == TS_TRANSPORT_SECTIONS )
@@ -960,7 +967,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
 
         if( (i64 = stream_Size( p_sys->stream) ) > 0 )
         {
-            uint64_t offset = vlc_stream_Tell( p_sys->stream );
+            uint64_t offset = TSStreamTell( p_demux );
             *pf = (double)offset / (double)i64;
             return VLC_SUCCESS;
         }
@@ -1836,35 +1843,34 @@ static block_t* ReadTSPacket( demux_t *p_demux )
         for( ;; )
         {
             const uint8_t *p_peek;
-            int i_peek = 0;
-            unsigned i_skip = 0;
+            ssize_t i_peek = 0;
 
             i_peek = vlc_stream_Peek( p_sys->stream, &p_peek,
                     p_sys->i_packet_size * 10 );
-            if( i_peek < 0 || (unsigned)i_peek < p_sys->i_packet_size + 1 )
+            if( i_peek < 0 || (size_t)i_peek < p_sys->i_packet_size +
+                                               p_sys->i_packet_header_size + 1 )
             {
                 msg_Dbg( p_demux, "eof ?" );
                 return NULL;
             }
 
-            while( i_skip < i_peek - p_sys->i_packet_size )
-            {
-                if( p_peek[i_skip + p_sys->i_packet_header_size] == 0x47 &&
-                        p_peek[i_skip + p_sys->i_packet_header_size + p_sys->i_packet_size] == 0x47 )
-                {
-                    break;
-                }
-                i_skip++;
-            }
-            msg_Dbg( p_demux, "skipping %d bytes of garbage at %"PRIu64,
+            /* Look for 2 consecutive sync bytes */
+            const size_t i_last = i_peek - p_sys->i_packet_header_size
+                                         - p_sys->i_packet_size;
+            size_t i_skip = ts_sync_Find( &p_peek[p_sys->i_packet_header_size],
+                                          i_peek - p_sys->i_packet_header_size,
+                                          p_sys->i_packet_size, 2 );
+            const bool b_synced = i_skip < i_last;
+            if( !b_synced )
+                i_skip = i_last;
+
+            msg_Dbg( p_demux, "skipping %zu bytes of garbage at %"PRIu64,
                      i_skip, vlc_stream_Tell( p_sys->stream ) );
-            if (vlc_stream_Read( p_sys->stream, NULL, i_skip ) != i_skip)
+            if( vlc_stream_Read( p_sys->stream, NULL, i_skip ) != (ssize_t) i_skip )
                 return NULL;
 
-            if( i_skip < i_peek - p_sys->i_packet_size )
-            {
+            if( b_synced )
                 break;
-            }
         }
         msg_Dbg( p_demux, "resynced at %" PRIu64, vlc_stream_Tell( p_sys->stream ) );
         if( !( p_pkt = vlc_stream_Block( p_sys->stream, p_sys->i_packet_size ) ) )
@@ -1876,6 +1882,168 @@ static block_t* ReadTSPacket( demux_t *p_demux )
     return p_pkt;
 }
 
+static void TSPacketViewRelease( block_t *p_pkt )
+{
+    /* The packet data belongs to the chunk */
+    VLC_UNUSED(p_pkt);
+}
+
+static const struct vlc_block_callbacks TSPacketViewCbs =
+{
+    TSPacketViewRelease,
+};
+
+/* Returns the position of the next packet to demux */
+static uint64_t TSStreamTell( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    return vlc_stream_Tell( p_sys->stream ) - p_sys->chunk.i_length;
+}
+
+/* Appends stream data to the chunk until at least i_min bytes are available.
+ * Never waits for more data than needed, so live streams are not delayed. */
+static bool FillTSChunk( demux_t *p_demux, size_t i_min )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( p_sys->chunk.p_buf == NULL )
+    {
+        p_sys->chunk.i_size = (size_t)p_sys->i_packet_size * TS_READ_CHUNK_PACKETS;
+        p_sys->chunk.p_buf = malloc( p_sys->chunk.i_size );
+        if( unlikely(p_sys->chunk.p_buf == NULL) )
+            return false;
+    }
+
+    if( p_sys->chunk.i_offset > 0 )
+    {
+        memmove( p_sys->chunk.p_buf, &p_sys->chunk.p_buf[p_sys->chunk.i_offset],
+                 p_sys->chunk.i_length );
+        p_sys->chunk.i_offset = 0;
+    }
+
+    /* The ARIB CAM filter can be inserted on the fly, and must then see
+     * all the following packets: do not read ahead in that case. Data
+     * read ahead before the standard was known is fed to the filter when
+     * it is inserted, see TsCopyReadAhead(). */
+    size_t i_max = p_sys->standard == TS_STANDARD_ARIB ? i_min : p_sys->chunk.i_size;
+
+    while( p_sys->chunk.i_length < i_min )
+    {
+        ssize_t i_read = vlc_stream_ReadPartial( p_sys->stream,
+                                &p_sys->chunk.p_buf[p_sys->chunk.i_length],
+                                i_max - p_sys->chunk.i_length );
+        if( i_read <= 0 )
+            return false;
+        p_sys->chunk.i_length += i_read;
+    }
+    return true;
+}
+
+/* Returns a copy of the data read ahead but not demuxed yet, so that it can
+ * be fed again through a stream filter inserted on the fly */
+block_t * TsCopyReadAhead( demux_sys_t *p_sys )
+{
+    if( p_sys->chunk.i_length == 0 )
+        return NULL;
+
+    block_t *p_block = block_Alloc( p_sys->chunk.i_length );
+    if( likely(p_block != NULL) )
+        memcpy( p_block->p_buffer, &p_sys->chunk.p_buf[p_sys->chunk.i_offset],
+                p_sys->chunk.i_length );
+    return p_block;
+}
+
+/* Discards the data read ahead. The current packet view stays valid. */
+void TsDropReadAhead( demux_sys_t *p_sys )
+{
+    p_sys->chunk.i_offset = 0;
+    p_sys->chunk.i_length = 0;
+}
+
+/* Same as ReadTSPacket(), but without per packet allocation: the stream is
+ * read by chunks of packets and the returned block is only a view on the
+ * chunk, valid until the next call. It must be materialized if kept. */
+static block_t* ReadTSPacketInChunk( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    const size_t i_packet_size = p_sys->i_packet_size;
+    const size_t i_header_size = p_sys->i_packet_header_size;
+
+    if( p_sys->chunk.i_length < i_packet_size &&
+        !FillTSChunk( p_demux, i_packet_size ) )
+    {
+        msg_Dbg( p_demux, "EOF or can't read TS packet at %"PRIu64,
+                 TSStreamTell( p_demux ) );
+        return NULL;
+    }
+
+    const uint8_t *p = &p_sys->chunk.p_buf[p_sys->chunk.i_offset];
+
+    /* Check sync byte and re-sync if needed */
+    if( p[i_header_size] != 0x47 )
+    {
+        msg_Warn( p_demux, "lost synchro" );
+        for( ;; )
+        {
+            /* A packet is assumed valid if the next one is also synced */
+            if( !FillTSChunk( p_demux, i_header_size + i_packet_size + 1 ) )
+            {
+                msg_Dbg( p_demux, "eof ?" );
+                return NULL;
+            }
+
+            p = &p_sys->chunk.p_buf[p_sys->chunk.i_offset];
+            const size_t i_last = p_sys->chunk.i_length - i_header_size - i_packet_size;
+            size_t i_skip = ts_sync_Find( &p[i_header_size],
+                                          p_sys->chunk.i_length - i_header_size,
+                                          i_packet_size, 2 );
+            const bool b_synced = i_skip < i_last;
+            if( !b_synced )
+                i_skip = i_last;
+
+            msg_Dbg( p_demux, "skipping %zu bytes of garbage at %"PRIu64,
+                     i_skip, TSStreamTell( p_demux ) );
+            p_sys->chunk.i_offset += i_skip;
+            p_sys->chunk.i_length -= i_skip;
+
+            if( b_synced )
+                break;
+        }
+        msg_Dbg( p_demux, "resynced at %" PRIu64, TSStreamTell( p_demux ) );
+
+        if( p_sys->chunk.i_length < i_packet_size &&
+            !FillTSChunk( p_demux, i_packet_size ) )
+        {
+            msg_Dbg( p_demux, "eof ?" );
+            return NULL;
+        }
+        p = &p_sys->chunk.p_buf[p_sys->chunk.i_offset];
+    }
+
+    p_sys->chunk.i_offset += i_packet_size;
+    p_sys->chunk.i_length -= i_packet_size;
+
+    /* Skip header (BluRay streams), see ReadTSPacket() */
+    return block_Init( &p_sys->chunk.view, &TSPacketViewCbs,
+                       (uint8_t *) &p[i_header_size], i_packet_size - i_header_size );
+}
+
+/* Copies a packet view out of the chunk */
+static block_t* MaterializeTSPacket( block_t *p_pkt )
+{
+    if( p_pkt->cbs != &TSPacketViewCbs )
+        return p_pkt;
+
+    block_t *p_copy = block_Alloc( p_pkt->i_buffer );
+    if( likely(p_copy != NULL) )
+    {
+        memcpy( p_copy->p_buffer, p_pkt->p_buffer, p_pkt->i_buffer );
+        block_CopyProperties( p_copy, p_pkt );
+    }
+    block_Release( p_pkt );
+    return p_copy;
+}
+
 static stime_t GetPCR( const block_t *p_pkt )
 {
     const uint8_t *p = p_pkt->p_buffer;
@@ -1949,6 +2117,9 @@ static void ReadyQueuesPostSeek( demux_t *p_demux )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
 
+    /* Data read ahead belongs to the previous position */
+    TsDropReadAhead( p_sys );
+
     ts_pat_t *p_pat = GetPID(p_sys, 0)->u.p_pat;
     for( int i=0; i< p_pat->programs.i_size; i++ )
     {
@@ -2309,14 +2480,14 @@ static void ProgramSetPCR( demux_t *p_demux, ts_pmt_t *p_pmt, stime_t i_pcr )
         es_out_Control( p_demux->out, ES_OUT_SET_GROUP_PCR, p_pmt->i_number, FROM_SCALE(i_pcr) );
         /* growing files/named fifo handling */
         if( p_sys->b_access_control == false &&
-            vlc_stream_Tell( p_sys->stream ) > p_pmt->i_last_dts_byte )
+            TSStreamTell( p_demux ) > p_pmt->i_last_dts_byte )
         {
             if( p_pmt->i_last_dts_byte == 0 ) /* first run */
                 p_pmt->i_last_dts_byte = stream_Size( p_sys->stream );
             else
             {
                 p_pmt->i_last_dts = i_pcr;
-                p_pmt->i_last_dts_byte = vlc_stream_Tell( p_sys->stream );
+                p_pmt->i_last_dts_byte = TSStreamTell( p_demux );
             }
         }
     }
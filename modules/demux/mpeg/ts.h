@@ -70,6 +70,16 @@ struct demux_sys_t
     /* how many TS packet we read at once */
     unsigned    i_ts_read;
 
+    /* Stream data read ahead, demuxed in place by ReadTSPacketInChunk() */
+    struct
+    {
+        uint8_t    *p_buf;
+        size_t      i_size;   /* allocated size */
+        size_t      i_offset; /* first byte not yet demuxed */
+        size_t      i_length; /* bytes not yet demuxed */
+        block_t     view;     /* current packet, pointing into p_buf */
+    } chunk;
+
     bool        b_cc_check;
     bool        b_ignore_time_for_positions;
 
@@ -146,6 +156,9 @@ struct demux_sys_t
 
 void TsChangeStandard( demux_sys_t *, ts_standards_e );
 
+block_t * TsCopyReadAhead( demux_sys_t * );
+void TsDropReadAhead( demux_sys_t * );
+
 bool ProgramIsSelected( demux_sys_t *, uint16_t i_pgrm );
 
 void UpdatePESFilters( demux_t *p_demux, bool b_all );
@@ -2110,7 +2110,9 @@ static void PMTCallBack( void *data, dvbpsi_pmt_t *p_dvbpsipmt )
                 en50221_capmt_Delete( p_en );
                 if ( p_sys->standard == TS_STANDARD_ARIB && p_sys->stream == p_demux->s )
                 {
-                    stream_t *wrapper = ts_stream_wrapper_New( p_demux->s );
+                    /* Packets already read ahead must be descrambled too */
+                    stream_t *wrapper = ts_stream_wrapper_New( p_demux->s,
+                                                    TsCopyReadAhead( p_sys ) );
                     if( wrapper )
                     {
                         p_sys->stream = vlc_stream_FilterNew( wrapper, "aribcam" );
@@ -2119,6 +2121,8 @@ static void PMTCallBack( void *data, dvbpsi_pmt_t *p_dvbpsipmt )
                             vlc_stream_Delete( wrapper );
                             p_sys->stream = p_demux->s;
                         }
+                        else
+                            TsDropReadAhead( p_sys );
                     }
                 }
             }
@@ -18,43 +18,91 @@
  * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
  *****************************************************************************/
 #include <vlc_stream.h>
+#include <vlc_block.h>
+
+typedef struct
+{
+    stream_t *demuxstream;
+    block_t *p_pending; /* data read from demuxstream before we existed */
+} ts_stream_wrapper_sys_t;
 
 static int ts_stream_wrapper_Control(stream_t *s, int i_query, va_list va)
 {
-    stream_t *demuxstream = s->p_sys;
-    return demuxstream->pf_control(demuxstream, i_query, va);
+    ts_stream_wrapper_sys_t *sys = s->p_sys;
+    return sys->demuxstream->pf_control(sys->demuxstream, i_query, va);
 }
 
 static ssize_t ts_stream_wrapper_Read(stream_t *s, void *buf, size_t len)
 {
-    stream_t *demuxstream = s->p_sys;
-    return demuxstream->pf_read(demuxstream, buf, len);
+    ts_stream_wrapper_sys_t *sys = s->p_sys;
+    block_t *p_pending = sys->p_pending;
+    if(p_pending)
+    {
+        if(len > p_pending->i_buffer)
+            len = p_pending->i_buffer;
+        if(buf)
+            memcpy(buf, p_pending->p_buffer, len);
+        p_pending->p_buffer += len;
+        p_pending->i_buffer -= len;
+        if(p_pending->i_buffer == 0)
+        {
+            block_Release(p_pending);
+            sys->p_pending = NULL;
+        }
+        return len;
+    }
+    return sys->demuxstream->pf_read(sys->demuxstream, buf, len);
 }
 
 static block_t * ts_stream_wrapper_ReadBlock(stream_t *s, bool *restrict eof)
 {
-    stream_t *demuxstream = s->p_sys;
-    return demuxstream->pf_block(demuxstream, eof);
+    ts_stream_wrapper_sys_t *sys = s->p_sys;
+    block_t *p_pending = sys->p_pending;
+    if(p_pending)
+    {
+        sys->p_pending = NULL;
+        return p_pending;
+    }
+    return sys->demuxstream->pf_block(sys->demuxstream, eof);
 }
 
 static int ts_stream_wrapper_Seek(stream_t *s, uint64_t pos)
 {
-    stream_t *demuxstream = s->p_sys;
-    return demuxstream->pf_seek(demuxstream, pos);
+    ts_stream_wrapper_sys_t *sys = s->p_sys;
+    if(sys->p_pending)
+    {
+        block_Release(sys->p_pending);
+        sys->p_pending = NULL;
+    }
+    return sys->demuxstream->pf_seek(sys->demuxstream, pos);
 }
 
 static void ts_stream_wrapper_Destroy(stream_t *s)
 {
-    VLC_UNUSED(s);
+    ts_stream_wrapper_sys_t *sys = s->p_sys;
+    if(sys->p_pending)
+        block_Release(sys->p_pending);
+    free(sys);
 }
 
-static stream_t * ts_stream_wrapper_New(stream_t *demuxstream)
+/* The pending block, if any, is read first. Takes ownership of it. */
+static stream_t * ts_stream_wrapper_New(stream_t *demuxstream, block_t *p_pending)
 {
+    ts_stream_wrapper_sys_t *sys = malloc(sizeof(*sys));
+    if(!sys)
+    {
+        if(p_pending)
+            block_Release(p_pending);
+        return NULL;
+    }
+    sys->demuxstream = demuxstream;
+    sys->p_pending = p_pending;
+
     stream_t *s = vlc_stream_CommonNew(VLC_OBJECT(demuxstream),
                                        ts_stream_wrapper_Destroy);
     if(s)
     {
-        s->p_sys = demuxstream;
+        s->p_sys = sys;
         s->s = s;
         if(demuxstream->pf_read)
             s->pf_read = ts_stream_wrapper_Read;
@@ -65,5 +113,11 @@ static stream_t * ts_stream_wrapper_New(stream_t *demuxstream)
         if(demuxstream->pf_block)
             s->pf_block = ts_stream_wrapper_ReadBlock;
     }
+    else
+    {
+        if(p_pending)
+            block_Release(p_pending);
+        free(sys);
+    }
     return s;
 }
@@ -0,0 +1,197 @@
+/*****************************************************************************
+ * ts_sync.c : MPEG TS sync bytes scanning
+ *****************************************************************************
+ * Copyright (C) 2026 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+
+#if defined(HAVE_SSE2_INTRINSICS) || defined(__SSE2__)
+# include <emmintrin.h>
+# define TS_SYNC_SSE2
+# if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#  include <immintrin.h>
+#  define TS_SYNC_AVX2
+# endif
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+# include <arm_neon.h>
+# define TS_SYNC_NEON
+#endif
+
+#include "ts_sync.h"
+
+/* Number of bytes needed after a candidate offset */
+static inline size_t SyncSpan( size_t i_packet_size, unsigned i_count )
+{
+    return (size_t)(i_count - 1) * i_packet_size;
+}
+
+size_t ts_sync_Find_C( const uint8_t *p_buf, size_t i_buf,
+                       size_t i_packet_size, unsigned i_count )
+{
+    const size_t i_span = SyncSpan( i_packet_size, i_count );
+    if( i_buf <= i_span )
+        return i_buf;
+
+    const uint8_t *p = p_buf;
+    const uint8_t *p_end = &p_buf[i_buf - i_span];
+
+    while( (p = memchr( p, TS_SYNC_BYTE, p_end - p )) != NULL )
+    {
+        unsigned k = 1;
+        while( k < i_count && p[k * i_packet_size] == TS_SYNC_BYTE )
+            k++;
+        if( k == i_count )
+            return p - p_buf;
+        if( ++p >= p_end )
+            break;
+    }
+    return i_buf;
+}
+
+#ifdef TS_SYNC_SSE2
+# ifdef __SSE2__
+#  define VLC_SSE2
+# else
+#  define VLC_SSE2 __attribute__ ((__target__ ("sse2")))
+# endif
+
+VLC_SSE2
+static size_t Find_SSE2( const uint8_t *p_buf, size_t i_buf,
+                         size_t i_packet_size, unsigned i_count )
+{
+    const size_t i_span = SyncSpan( i_packet_size, i_count );
+    if( i_buf <= i_span )
+        return i_buf;
+
+    const size_t i_end = i_buf - i_span;
+    const __m128i sync = _mm_set1_epi8( TS_SYNC_BYTE );
+    size_t i = 0;
+
+    /* Compare 16 candidate offsets at once against every following
+     * packet start */
+    for( ; i + 16 <= i_end; i += 16 )
+    {
+        const uint8_t *p = &p_buf[i];
+        __m128i m = _mm_cmpeq_epi8( _mm_loadu_si128( (const __m128i *)p ), sync );
+
+        for( unsigned k = 1; k < i_count; k++ )
+        {
+            p += i_packet_size;
+            m = _mm_and_si128( m, _mm_cmpeq_epi8(
+                                _mm_loadu_si128( (const __m128i *)p ), sync ) );
+        }
+
+        unsigned mask = _mm_movemask_epi8( m );
+        if( mask != 0 )
+            return i + ctz( mask );
+    }
+
+    return i + ts_sync_Find_C( &p_buf[i], i_buf - i, i_packet_size, i_count );
+}
+#endif
+
+#ifdef TS_SYNC_AVX2
+__attribute__ ((__target__ ("avx2")))
+static size_t Find_AVX2( const uint8_t *p_buf, size_t i_buf,
+                         size_t i_packet_size, unsigned i_count )
+{
+    const size_t i_span = SyncSpan( i_packet_size, i_count );
+    if( i_buf <= i_span )
+        return i_buf;
+
+    const size_t i_end = i_buf - i_span;
+    const __m256i sync = _mm256_set1_epi8( TS_SYNC_BYTE );
+    size_t i = 0;
+
+    for( ; i + 32 <= i_end; i += 32 )
+    {
+        const uint8_t *p = &p_buf[i];
+        __m256i m = _mm256_cmpeq_epi8( _mm256_loadu_si256( (const __m256i *)p ), sync );
+
+        for( unsigned k = 1; k < i_count; k++ )
+        {
+            p += i_packet_size;
+            m = _mm256_and_si256( m, _mm256_cmpeq_epi8(
+                                _mm256_loadu_si256( (const __m256i *)p ), sync ) );
+        }
+
+        uint32_t mask = _mm256_movemask_epi8( m );
+        if( mask != 0 )
+            return i + ctz( mask );
+    }
+
+    return i + Find_SSE2( &p_buf[i], i_buf - i, i_packet_size, i_count );
+}
+#endif
+
+#ifdef TS_SYNC_NEON
+static size_t Find_NEON( const uint8_t *p_buf, size_t i_buf,
+                         size_t i_packet_size, unsigned i_count )
+{
+    const size_t i_span = SyncSpan( i_packet_size, i_count );
+    if( i_buf <= i_span )
+        return i_buf;
+
+    const size_t i_end = i_buf - i_span;
+    const uint8x16_t sync = vdupq_n_u8( TS_SYNC_BYTE );
+    size_t i = 0;
+
+    for( ; i + 16 <= i_end; i += 16 )
+    {
+        const uint8_t *p = &p_buf[i];
+        uint8x16_t m = vceqq_u8( vld1q_u8( p ), sync );
+
+        for( unsigned k = 1; k < i_count; k++ )
+        {
+            p += i_packet_size;
+            m = vandq_u8( m, vceqq_u8( vld1q_u8( p ), sync ) );
+        }
+
+        /* No movemask: locate the match within the vector in C */
+        if( vmaxvq_u8( m ) != 0 )
+            break;
+    }
+
+    return i + ts_sync_Find_C( &p_buf[i], i_buf - i, i_packet_size, i_count );
+}
+#endif
+
+size_t ts_sync_Find( const uint8_t *p_buf, size_t i_buf,
+                     size_t i_packet_size, unsigned i_count )
+{
+    assert( i_count > 0 );
+#ifdef TS_SYNC_AVX2
+    if( vlc_CPU_AVX2() )
+        return Find_AVX2( p_buf, i_buf, i_packet_size, i_count );
+#endif
+#ifdef TS_SYNC_SSE2
+    if( vlc_CPU_SSE2() )
+        return Find_SSE2( p_buf, i_buf, i_packet_size, i_count );
+#endif
+#ifdef TS_SYNC_NEON
+    if( vlc_CPU_ARM_NEON() )
+        return Find_NEON( p_buf, i_buf, i_packet_size, i_count );
+#endif
+    return ts_sync_Find_C( p_buf, i_buf, i_packet_size, i_count );
+}
@@ -0,0 +1,44 @@
+/*****************************************************************************
+ * ts_sync.h : MPEG TS sync bytes scanning
+ *****************************************************************************
+ * Copyright (C) 2026 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef VLC_TS_SYNC_H
+#define VLC_TS_SYNC_H
+
+#define TS_SYNC_BYTE 0x47
+
+/**
+ * Finds the first offset of a sync byte repeated i_count times every
+ * i_packet_size bytes, using the best SIMD implementation available.
+ *
+ * \param p_buf data to scan
+ * \param i_buf data size
+ * \param i_packet_size distance between sync bytes
+ * \param i_count number of consecutive sync bytes required (at least 1)
+ * \return offset of the first sync byte or i_buf if none was found
+ */
+size_t ts_sync_Find( const uint8_t *p_buf, size_t i_buf,
+                     size_t i_packet_size, unsigned i_count );
+
+/**
+ * Same as ts_sync_Find() without any SIMD code. Reference implementation.
+ */
+size_t ts_sync_Find_C( const uint8_t *p_buf, size_t i_buf,
+                       size_t i_packet_size, unsigned i_count );
+
+#endif
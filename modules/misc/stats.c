@@ -219,6 +219,12 @@ static void CloseDemux ( vlc_object_t *p_this )
 
     msg_Dbg( p_demux, "Closing Stat demux" );
 
+    struct vlc_frame_cache_stats stats;
+    vlc_frame_GetCacheStats( &stats );
+    msg_Dbg( p_demux, "frame cache: %"PRIu64" allocated, %"PRIu64" freed, "
+             "%"PRIu64" refills, %"PRIu64" spills", stats.allocated,
+             stats.freed, stats.refills, stats.spills );
+
     free( p_demux->p_sys );
 }
 
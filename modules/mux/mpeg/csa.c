@@ -28,6 +28,7 @@
 
 #include <assert.h>
 #include <vlc_common.h>
+#include <vlc_cpu.h>
 
 #include "csa.h"
 
@@ -222,48 +223,53 @@ void csa_Decrypt( csa_t *c, uint8_t *pkt, int i_pkt_size )
 }
 
 /*****************************************************************************
- * csa_Encrypt:
+ * csa_ScrambleHeader: set the transport scrambling control
+ *****************************************************************************
+ * Returns the header length of the packet, or -1 if there is no block to
+ * scramble, in which case the packet is left in clear.
  *****************************************************************************/
-void csa_Encrypt( csa_t *c, uint8_t *pkt, int i_pkt_size )
+static int csa_ScrambleHeader( csa_t *c, uint8_t *pkt, int i_pkt_size )
 {
-    uint8_t *ck;
-    uint8_t *kk;
-
-    int i, j;
-    int i_hdr = 4; /* hdr len */
-    uint8_t  ib[184/8+2][8], stream[8], block[8];
-    int n, i_residue;
+    int i_hdr = 4;
 
-    /* set transport scrambling control */
     pkt[3] |= 0x80;
-
     if( c->use_odd )
-    {
         pkt[3] |= 0x40;
-        ck = c->o_ck;
-        kk = c->o_kk;
-    }
-    else
-    {
-        ck = c->e_ck;
-        kk = c->e_kk;
-    }
 
-    /* hdr len */
-    i_hdr = 4;
     if( pkt[3]&0x20 )
     {
         /* skip adaption field */
         i_hdr += pkt[4] + 1;
     }
-    n = (i_pkt_size - i_hdr) / 8;
-    i_residue = (i_pkt_size - i_hdr) % 8;
-
-    if( n <= 0 )
+    if( (i_pkt_size - i_hdr) / 8 <= 0 )
     {
         pkt[3] &= 0x3f;
-        return;
+        return -1;
     }
+    return i_hdr;
+}
+
+/*****************************************************************************
+ * csa_Encrypt:
+ *****************************************************************************/
+void csa_Encrypt( csa_t *c, uint8_t *pkt, int i_pkt_size )
+{
+    uint8_t *ck;
+    uint8_t *kk;
+
+    int i, j;
+    int i_hdr;
+    uint8_t  ib[184/8+2][8], stream[8], block[8];
+    int n, i_residue;
+
+    ck = c->use_odd ? c->o_ck : c->e_ck;
+    kk = c->use_odd ? c->o_kk : c->e_kk;
+
+    i_hdr = csa_ScrambleHeader( c, pkt, i_pkt_size );
+    if( i_hdr < 0 )
+        return;
+    n = (i_pkt_size - i_hdr) / 8;
+    i_residue = (i_pkt_size - i_hdr) % 8;
 
     /* */
     for( i = 0; i < 8; i++ )
@@ -607,3 +613,224 @@ static void csa_BlockCypher( uint8_t kk[57], uint8_t bd[8], uint8_t ib[8] )
     }
 }
 
+/*****************************************************************************
+ * Batch scrambling
+ *****************************************************************************
+ * The block cypher runs round by round over all the packets of a batch, so
+ * that the lookups of independent packets overlap, and the stream cypher is
+ * bitsliced (see csa_bs.h) over as many packets as a word has bits.
+ *****************************************************************************/
+#if defined(__has_attribute)
+# if __has_attribute(__vector_size__)
+#  define CSA_BS_VECTOR
+# endif
+#endif
+
+/* Below this count of packets, the scalar path is faster */
+#define CSA_BATCH_MIN 8
+#define CSA_BATCH_LANES 256
+
+#define CSA_BS_MUX(a, b, s) ( (a) ^ ( ( (a) ^ (b) ) & (s) ) )
+
+/* Transposes a 64x64 bits matrix: bit c of a[r] becomes bit r of a[c] */
+static void csa_Transpose64( uint64_t a[64] )
+{
+    uint64_t m = UINT64_C(0x00000000ffffffff);
+
+    for( int j = 32; j != 0; j >>= 1, m ^= m << j )
+    {
+        for( int k = 0; k < 64; k = ((k | j) + 1) & ~j )
+        {
+            const uint64_t t = ( ( a[k] >> j ) ^ a[k | j] ) & m;
+
+            a[k | j] ^= t;
+            a[k] ^= t << j;
+        }
+    }
+}
+
+/* The portable version is always built, so that it can be tested */
+#define CSA_BS(name) csa_##name##_64
+#define CSA_BS_WORDS 1
+#define CSA_BS_TARGET
+#include "csa_bs.h"
+
+#ifdef CSA_BS_VECTOR
+# define CSA_BS(name) csa_##name##_128
+# define CSA_BS_WORDS 2
+# define CSA_BS_TARGET
+# include "csa_bs.h"
+
+# ifdef CAN_COMPILE_AVX2
+#  define CSA_BS(name) csa_##name##_256
+#  define CSA_BS_WORDS 4
+#  define CSA_BS_TARGET __attribute__ ((__target__ ("avx2")))
+#  include "csa_bs.h"
+# endif
+#endif
+
+/* One round of csa_BlockCypher() over all the packets, with R[1]..R[8]
+ * stored in the rows r1..r8 of R. The registers shift by renaming: the
+ * next round has R[1] in row r2, and so on. Only the table lookups are done
+ * per packet, the rest runs over whole rows and is left to vectorize. */
+#define CSA_BLOCK_ROUND(key, r1, r2, r3, r4, r5, r6, r7, r8) \
+    do { \
+        for( unsigned l = 0; l < count; l++ ) \
+        { \
+            const uint8_t sbox_out = block_sbox[ (key)^R[r8][l] ]; \
+            S[l] = sbox_out; \
+            P[l] = block_perm[sbox_out]; \
+        } \
+        for( unsigned l = 0; l < CSA_BATCH_LANES; l++ ) \
+        { \
+            R[r3][l] ^= R[r1][l]; \
+            R[r4][l] ^= R[r1][l]; \
+            R[r5][l] ^= R[r1][l]; \
+            R[r7][l] ^= P[l]; \
+            R[r1][l] ^= S[l]; \
+        } \
+    } while( 0 )
+
+/* Runs csa_BlockCypher() over the blocks of the packets in reverse chain
+ * order, the output of each block replacing its input in the packet. */
+static void csa_BlockCypherBatch( const uint8_t kk[57], uint8_t *const *pkts,
+                                  const int *hdr, const int *n,
+                                  unsigned count )
+{
+    uint8_t R[8][CSA_BATCH_LANES];
+    uint8_t S[CSA_BATCH_LANES], P[CSA_BATCH_LANES];
+    int n_max = 0;
+
+    assert( count <= CSA_BATCH_LANES );
+    memset( R, 0, sizeof(R) );
+    memset( S, 0, sizeof(S) );
+    memset( P, 0, sizeof(P) );
+
+    for( unsigned l = 0; l < count; l++ )
+    {
+        if( n[l] > n_max )
+            n_max = n[l];
+    }
+
+    for( int i_step = 0; i_step < n_max; i_step++ )
+    {
+        /* block n - i_step, chained with the output of the next block.
+         * Packets with fewer blocks spin on stale data. */
+        for( unsigned l = 0; l < count; l++ )
+        {
+            if( i_step >= n[l] )
+                continue;
+
+            const uint8_t *p = &pkts[l][hdr[l] + 8 * (n[l] - i_step - 1)];
+            for( int k = 0; k < 8; k++ )
+                R[k][l] = p[k] ^ ( i_step > 0 ? p[8+k] : 0 );
+        }
+
+        /* 56 rounds rename the registers back to their initial rows */
+        for( int i = 1; i <= 56; i += 8 )
+        {
+            CSA_BLOCK_ROUND( kk[i+0], 0, 1, 2, 3, 4, 5, 6, 7 );
+            CSA_BLOCK_ROUND( kk[i+1], 1, 2, 3, 4, 5, 6, 7, 0 );
+            CSA_BLOCK_ROUND( kk[i+2], 2, 3, 4, 5, 6, 7, 0, 1 );
+            CSA_BLOCK_ROUND( kk[i+3], 3, 4, 5, 6, 7, 0, 1, 2 );
+            CSA_BLOCK_ROUND( kk[i+4], 4, 5, 6, 7, 0, 1, 2, 3 );
+            CSA_BLOCK_ROUND( kk[i+5], 5, 6, 7, 0, 1, 2, 3, 4 );
+            CSA_BLOCK_ROUND( kk[i+6], 6, 7, 0, 1, 2, 3, 4, 5 );
+            CSA_BLOCK_ROUND( kk[i+7], 7, 0, 1, 2, 3, 4, 5, 6 );
+        }
+
+        for( unsigned l = 0; l < count; l++ )
+        {
+            if( i_step >= n[l] )
+                continue;
+
+            uint8_t *p = &pkts[l][hdr[l] + 8 * (n[l] - i_step - 1)];
+            for( int k = 0; k < 8; k++ )
+                p[k] = R[k][l];
+        }
+    }
+}
+
+/*****************************************************************************
+ * csa_EncryptBatchLanes:
+ *****************************************************************************/
+int csa_EncryptBatchLanes( csa_t *c, uint8_t *const *pkts, size_t count,
+                           int i_pkt_size, unsigned i_lanes )
+{
+    const uint8_t *ck = c->use_odd ? c->o_ck : c->e_ck;
+    const uint8_t *kk = c->use_odd ? c->o_kk : c->e_kk;
+    void (*stream)( const uint8_t *, uint8_t *const *, const int *,
+                    const int *, unsigned, int );
+
+    switch( i_lanes )
+    {
+        case 64:
+            stream = csa_Stream_64;
+            break;
+#ifdef CSA_BS_VECTOR
+        case 128:
+            stream = csa_Stream_128;
+            break;
+# ifdef CAN_COMPILE_AVX2
+        case 256:
+            if( !vlc_CPU_AVX2() )
+                return VLC_EGENERIC;
+            stream = csa_Stream_256;
+            break;
+# endif
+#endif
+        default:
+            return VLC_EGENERIC;
+    }
+
+    while( count > 0 )
+    {
+        uint8_t *group[CSA_BATCH_LANES];
+        int hdr[CSA_BATCH_LANES], n[CSA_BATCH_LANES];
+        unsigned i_group = 0;
+
+        for( ; count > 0 && i_group < i_lanes; pkts++, count-- )
+        {
+            const int i_hdr = csa_ScrambleHeader( c, *pkts, i_pkt_size );
+            if( i_hdr < 0 )
+                continue;
+
+            group[i_group] = *pkts;
+            hdr[i_group] = i_hdr;
+            n[i_group] = (i_pkt_size - i_hdr) / 8;
+            i_group++;
+        }
+
+        if( i_group < CSA_BATCH_MIN )
+        {
+            for( unsigned l = 0; l < i_group; l++ )
+                csa_Encrypt( c, group[l], i_pkt_size );
+            continue;
+        }
+
+        csa_BlockCypherBatch( kk, group, hdr, n, i_group );
+        stream( ck, group, hdr, n, i_group, i_pkt_size );
+    }
+    return VLC_SUCCESS;
+}
+
+/*****************************************************************************
+ * csa_EncryptBatch:
+ *****************************************************************************/
+void csa_EncryptBatch( csa_t *c, uint8_t *const *pkts, size_t count,
+                       int i_pkt_size )
+{
+    unsigned i_lanes = 64;
+
+#ifdef CSA_BS_VECTOR
+    i_lanes = 128;
+# ifdef CAN_COMPILE_AVX2
+    if( vlc_CPU_AVX2() )
+        i_lanes = 256;
+# endif
+#endif
+
+    int ret = csa_EncryptBatchLanes( c, pkts, count, i_pkt_size, i_lanes );
+    assert( ret == VLC_SUCCESS );
+    (void) ret;
+}
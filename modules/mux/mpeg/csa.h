@@ -30,6 +30,8 @@ typedef struct csa_t csa_t;
 #define csa_UseKey  __csa_UseKey
 #define csa_Decrypt __csa_decrypt
 #define csa_Encrypt __csa_encrypt
+#define csa_EncryptBatch __csa_encrypt_batch
+#define csa_EncryptBatchLanes __csa_encrypt_batch_lanes
 
 csa_t *csa_New( void );
 void   csa_Delete( csa_t * );
@@ -39,5 +41,13 @@ void   csa_UseKey( vlc_object_t *p_caller, csa_t *, bool use_odd );
 
 void   csa_Decrypt( csa_t *, uint8_t *pkt, int i_pkt_size );
 void   csa_Encrypt( csa_t *, uint8_t *pkt, int i_pkt_size );
+/* Scrambles count packets at once, as many csa_Encrypt() calls would */
+void   csa_EncryptBatch( csa_t *, uint8_t *const *pkts, size_t count,
+                         int i_pkt_size );
+/* Same as csa_EncryptBatch(), bitslicing the stream cypher over i_lanes
+ * packets (64, 128 or 256). Fails if that is not supported on this build
+ * or CPU. */
+int    csa_EncryptBatchLanes( csa_t *, uint8_t *const *pkts, size_t count,
+                              int i_pkt_size, unsigned i_lanes );
 
 #endif /* _CSA_H */
@@ -0,0 +1,264 @@
+/*****************************************************************************
+ * csa_bs.h: bitsliced CSA stream cypher
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* This file is included by csa.c once per word size, with:
+ *  - CSA_BS_WORDS: number of 64-bits elements in a word (1, 2 or 4),
+ *  - CSA_BS(name): name decorated with the word size,
+ *  - CSA_BS_TARGET: function attributes required by the word type.
+ *
+ * Every bit of the csa_StreamCypher() state is held in one word, where bit l
+ * belongs to packet l: the cypher then runs CSA_BS_WORDS * 64 packets at
+ * once using only logical operations. The 7 s-boxes are evaluated as mux
+ * trees of their truth tables, and the shift registers are kept in a window
+ * of one block worth of iterations so that shifting costs nothing. */
+
+#if CSA_BS_WORDS == 1
+typedef uint64_t CSA_BS(word_t);
+# define CSA_BS_ELEM(w, g) (w)
+#else
+typedef uint64_t CSA_BS(word_t) __attribute__((__vector_size__(8 * CSA_BS_WORDS)));
+# define CSA_BS_ELEM(w, g) (w)[g]
+#endif
+
+#define CSA_BS_LANES (64 * CSA_BS_WORDS)
+
+typedef struct
+{
+    /* A[k] and B[k] of iteration j are at [j + 10 - k] */
+    CSA_BS(word_t) A[10 + 32][4];
+    CSA_BS(word_t) B[10 + 32][4];
+    CSA_BS(word_t) X[4], Y[4], Z[4];
+    CSA_BS(word_t) D[4], E[4], F[4];
+    CSA_BS(word_t) p, q, r;
+} CSA_BS(state_t);
+
+/* Evaluates one output bit of a 5 to 1 bit s-box, tt being its truth
+ * table indexed by (x4 x3 x2 x1 x0). Once inlined, tt is a constant and
+ * the leaves fold to 0, 1, x0 or ~x0. */
+CSA_BS_TARGET
+static inline CSA_BS(word_t) CSA_BS(Sbox)( uint32_t tt,
+                                          CSA_BS(word_t) x4, CSA_BS(word_t) x3,
+                                          CSA_BS(word_t) x2, CSA_BS(word_t) x1,
+                                          CSA_BS(word_t) x0 )
+{
+    const CSA_BS(word_t) zero = { 0 };
+#define LEAF(i) ( ( zero - ( ( tt >> (2*(i)) ) & 1 ) ) ^ \
+                  ( x0 & ( zero - ( ( ( tt >> (2*(i)) ) ^ ( tt >> (2*(i)+1) ) ) & 1 ) ) ) )
+    const CSA_BS(word_t) v0 = CSA_BS_MUX( LEAF(0), LEAF(1), x1 );
+    const CSA_BS(word_t) v1 = CSA_BS_MUX( LEAF(2), LEAF(3), x1 );
+    const CSA_BS(word_t) v2 = CSA_BS_MUX( LEAF(4), LEAF(5), x1 );
+    const CSA_BS(word_t) v3 = CSA_BS_MUX( LEAF(6), LEAF(7), x1 );
+    const CSA_BS(word_t) v4 = CSA_BS_MUX( LEAF(8), LEAF(9), x1 );
+    const CSA_BS(word_t) v5 = CSA_BS_MUX( LEAF(10), LEAF(11), x1 );
+    const CSA_BS(word_t) v6 = CSA_BS_MUX( LEAF(12), LEAF(13), x1 );
+    const CSA_BS(word_t) v7 = CSA_BS_MUX( LEAF(14), LEAF(15), x1 );
+#undef LEAF
+    const CSA_BS(word_t) w0 = CSA_BS_MUX( v0, v1, x2 );
+    const CSA_BS(word_t) w1 = CSA_BS_MUX( v2, v3, x2 );
+    const CSA_BS(word_t) w2 = CSA_BS_MUX( v4, v5, x2 );
+    const CSA_BS(word_t) w3 = CSA_BS_MUX( v6, v7, x2 );
+
+    return CSA_BS_MUX( CSA_BS_MUX( w0, w1, x3 ), CSA_BS_MUX( w2, w3, x3 ), x4 );
+}
+
+/* Loads the key into the registers, like csa_StreamCypher() with b_init */
+CSA_BS_TARGET
+static void CSA_BS(Init)( CSA_BS(state_t) *s, const uint8_t ck[8] )
+{
+    const CSA_BS(word_t) zero = { 0 };
+
+    memset( s, 0, sizeof(*s) );
+    for( int i = 0; i < 8; i++ )
+    {
+        for( int b = 0; b < 4; b++ )
+        {
+            /* A[1+2*i] is the high nibble of ck[i], A[2+2*i] the low one */
+            s->A[9 - i][b] = ( ck[i/2] >> ( (i & 1 ? 0 : 4) + b ) ) & 1 ? ~zero : zero;
+            s->B[9 - i][b] = ( ck[4+i/2] >> ( (i & 1 ? 0 : 4) + b ) ) & 1 ? ~zero : zero;
+        }
+    }
+}
+
+/* Runs the cypher over 8 bytes. in holds the bitplanes of the
+ * initialisation bytes (bit b of byte i at in[8*i+b]), or is NULL when
+ * generating. The bitplanes of the output are stored to out likewise,
+ * unless it is NULL. */
+CSA_BS_TARGET
+static void CSA_BS(Block)( CSA_BS(state_t) *s, const CSA_BS(word_t) *in,
+                           CSA_BS(word_t) *out )
+{
+    for( int j = 0; j < 32; j++ )
+    {
+#define A(k, b) s->A[j + 10 - (k)][b]
+#define B(k, b) s->B[j + 10 - (k)][b]
+        const CSA_BS(word_t) s1_0 = CSA_BS(Sbox)( 0x78c6b16c, A(4,0), A(1,2), A(6,1), A(7,3), A(9,0) );
+        const CSA_BS(word_t) s1_1 = CSA_BS(Sbox)( 0x4b368771, A(4,0), A(1,2), A(6,1), A(7,3), A(9,0) );
+        const CSA_BS(word_t) s2_0 = CSA_BS(Sbox)( 0xe41b4b63, A(2,1), A(3,2), A(6,3), A(7,0), A(9,1) );
+        const CSA_BS(word_t) s2_1 = CSA_BS(Sbox)( 0x58b98679, A(2,1), A(3,2), A(6,3), A(7,0), A(9,1) );
+        const CSA_BS(word_t) s3_0 = CSA_BS(Sbox)( 0xe41b1be4, A(1,3), A(2,0), A(5,1), A(5,3), A(6,2) );
+        const CSA_BS(word_t) s3_1 = CSA_BS(Sbox)( 0x69d25879, A(1,3), A(2,0), A(5,1), A(5,3), A(6,2) );
+        const CSA_BS(word_t) s4_0 = CSA_BS(Sbox)( 0x92ad994b, A(3,3), A(1,1), A(2,3), A(4,2), A(8,0) );
+        const CSA_BS(word_t) s4_1 = CSA_BS(Sbox)( 0x66b492ad, A(3,3), A(1,1), A(2,3), A(4,2), A(8,0) );
+        const CSA_BS(word_t) s5_0 = CSA_BS(Sbox)( 0x35e29e58, A(5,2), A(4,3), A(6,0), A(8,1), A(9,2) );
+        const CSA_BS(word_t) s5_1 = CSA_BS(Sbox)( 0x9c274cf1, A(5,2), A(4,3), A(6,0), A(8,1), A(9,2) );
+        const CSA_BS(word_t) s6_0 = CSA_BS(Sbox)( 0x66d2e61a, A(3,1), A(4,1), A(5,0), A(7,2), A(9,3) );
+        const CSA_BS(word_t) s6_1 = CSA_BS(Sbox)( 0x691bb46c, A(3,1), A(4,1), A(5,0), A(7,2), A(9,3) );
+        const CSA_BS(word_t) s7_0 = CSA_BS(Sbox)( 0x266d9d92, A(2,2), A(3,0), A(7,1), A(8,2), A(8,3) );
+        const CSA_BS(word_t) s7_1 = CSA_BS(Sbox)( 0xb38c691e, A(2,2), A(3,0), A(7,1), A(8,2), A(8,3) );
+
+        CSA_BS(word_t) extra_B[4], next_A1[4], next_B1[4], next_F[4];
+
+        extra_B[3] = B(3,0) ^ B(6,1) ^ B(7,2) ^ B(9,3);
+        extra_B[2] = B(6,0) ^ B(8,1) ^ B(3,3) ^ B(4,2);
+        extra_B[1] = B(5,3) ^ B(8,2) ^ B(4,0) ^ B(5,1);
+        extra_B[0] = B(9,2) ^ B(6,3) ^ B(3,1) ^ B(8,0);
+
+        for( int b = 0; b < 4; b++ )
+        {
+            next_A1[b] = A(10,b) ^ s->X[b];
+            next_B1[b] = B(7,b) ^ B(10,b) ^ s->Y[b];
+        }
+        if( in != NULL )
+        {
+            /* in1 is the high nibble, in2 the low one */
+            const CSA_BS(word_t) *in1 = &in[8 * (j / 4) + 4];
+            const CSA_BS(word_t) *in2 = &in[8 * (j / 4)];
+
+            for( int b = 0; b < 4; b++ )
+            {
+                next_A1[b] ^= s->D[b] ^ ( j & 1 ? in2[b] : in1[b] );
+                next_B1[b] ^= j & 1 ? in1[b] : in2[b];
+            }
+        }
+
+        for( int b = 0; b < 4; b++ )
+            A(0,b) = next_A1[b];
+        /* if p=1, rotate next_B1 left */
+        for( int b = 0; b < 4; b++ )
+            B(0,b) = CSA_BS_MUX( next_B1[b], next_B1[(b + 3) & 3], s->p );
+
+        /* T4: if q=1, F = Z + E + r and r is the carry, otherwise F = E */
+        CSA_BS(word_t) carry = s->r;
+        for( int b = 0; b < 4; b++ )
+        {
+            const CSA_BS(word_t) half = s->Z[b] ^ s->E[b];
+
+            next_F[b] = CSA_BS_MUX( s->E[b], half ^ carry, s->q );
+            carry = ( s->Z[b] & s->E[b] ) | ( carry & half );
+        }
+        s->r = CSA_BS_MUX( s->r, carry, s->q );
+
+        for( int b = 0; b < 4; b++ )
+        {
+            /* T3 */
+            s->D[b] = s->E[b] ^ s->Z[b] ^ extra_B[b];
+            s->E[b] = s->F[b];
+            s->F[b] = next_F[b];
+        }
+
+        s->X[0] = s1_1; s->X[1] = s2_1; s->X[2] = s3_0; s->X[3] = s4_0;
+        s->Y[0] = s3_1; s->Y[1] = s4_1; s->Y[2] = s5_0; s->Y[3] = s6_0;
+        s->Z[0] = s5_1; s->Z[1] = s6_1; s->Z[2] = s1_0; s->Z[3] = s2_0;
+        s->p = s7_1;
+        s->q = s7_0;
+
+        /* 2 output bits per iteration, most significant first */
+        if( out != NULL )
+        {
+            out[8 * (j / 4) + 7 - 2 * (j & 3)] = s->D[2] ^ s->D[3];
+            out[8 * (j / 4) + 6 - 2 * (j & 3)] = s->D[0] ^ s->D[1];
+        }
+#undef A
+#undef B
+    }
+
+    /* slide the window */
+    memcpy( s->A, s->A[32], sizeof(s->A[0]) * 10 );
+    memcpy( s->B, s->B[32], sizeof(s->B[0]) * 10 );
+}
+
+/* Scrambles up to CSA_BS_LANES packets whose blocks already went through
+ * the block cypher (see csa_EncryptBatch()) */
+CSA_BS_TARGET
+static void CSA_BS(Stream)( const uint8_t ck[8], uint8_t *const *pkts,
+                            const int *hdr, const int *n, unsigned count,
+                            int i_pkt_size )
+{
+    CSA_BS(state_t) s;
+    CSA_BS(word_t) planes[64];
+    uint64_t rows[64];
+    int i_blocks = 0;
+
+    assert( count <= CSA_BS_LANES );
+
+    /* the first block of each packet initialises its cypher */
+    for( unsigned g = 0; g < CSA_BS_WORDS; g++ )
+    {
+        for( unsigned l = 0; l < 64; l++ )
+        {
+            rows[l] = 0;
+            if( 64 * g + l < count )
+                rows[l] = GetQWLE( &pkts[64 * g + l][hdr[64 * g + l]] );
+        }
+        csa_Transpose64( rows );
+        for( int i = 0; i < 64; i++ )
+            CSA_BS_ELEM( planes[i], g ) = rows[i];
+    }
+    CSA_BS(Init)( &s, ck );
+    CSA_BS(Block)( &s, planes, NULL );
+
+    for( unsigned l = 0; l < count; l++ )
+    {
+        const int i_total = n[l] + ( ( i_pkt_size - hdr[l] ) % 8 ? 1 : 0 );
+        if( i_total > i_blocks )
+            i_blocks = i_total;
+    }
+
+    for( int i = 2; i <= i_blocks; i++ )
+    {
+        CSA_BS(Block)( &s, NULL, planes );
+
+        for( unsigned g = 0; g < CSA_BS_WORDS && 64 * g < count; g++ )
+        {
+            for( int k = 0; k < 64; k++ )
+                rows[k] = CSA_BS_ELEM( planes[k], g );
+            csa_Transpose64( rows );
+
+            for( unsigned l = 64 * g; l < count && l < 64 * (g + 1); l++ )
+            {
+                if( i > n[l] + 1 )
+                    continue;
+
+                /* the last block may be a residue */
+                uint8_t *p = &pkts[l][hdr[l] + 8 * (i - 1)];
+                int i_len = i <= n[l] ? 8 : i_pkt_size - hdr[l] - 8 * n[l];
+
+                for( int k = 0; k < i_len; k++ )
+                    p[k] ^= rows[l - 64 * g] >> ( 8 * k );
+            }
+        }
+    }
+}
+
+#undef CSA_BS_LANES
+#undef CSA_BS_ELEM
+#undef CSA_BS_TARGET
+#undef CSA_BS_WORDS
+#undef CSA_BS
@@ -1712,6 +1712,13 @@ static void TSDate( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
     /* msg_Dbg( p_mux, "real pck=%d", i_packet_count ); */
     block_t *p_list = NULL;
     block_t **pp_last = &p_list;
+
+    /* scrambled together once they are all dated */
+    uint8_t **pp_csa = NULL;
+    size_t i_csa = 0;
+    if( p_sys->csa != NULL )
+        pp_csa = vlc_alloc( i_packet_count, sizeof(*pp_csa) );
+
     for (int i = 0; i < i_packet_count; i++ )
     {
         block_t *p_ts = BufferChainGet( p_chain_ts );
@@ -1727,9 +1734,14 @@ static void TSDate( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
         }
         if( p_ts->i_flags & BLOCK_FLAG_SCRAMBLED )
         {
-            vlc_mutex_lock( &p_sys->csa_lock );
-            csa_Encrypt( p_sys->csa, p_ts->p_buffer, p_sys->i_csa_pkt_size );
-            vlc_mutex_unlock( &p_sys->csa_lock );
+            if( pp_csa != NULL )
+                pp_csa[i_csa++] = p_ts->p_buffer;
+            else
+            {
+                vlc_mutex_lock( &p_sys->csa_lock );
+                csa_Encrypt( p_sys->csa, p_ts->p_buffer, p_sys->i_csa_pkt_size );
+                vlc_mutex_unlock( &p_sys->csa_lock );
+            }
         }
 
         /* latency */
@@ -1737,6 +1749,15 @@ static void TSDate( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
 
         block_ChainLastAppend( &pp_last, p_ts );
     }
+
+    if( i_csa > 0 )
+    {
+        vlc_mutex_lock( &p_sys->csa_lock );
+        csa_EncryptBatch( p_sys->csa, pp_csa, i_csa, p_sys->i_csa_pkt_size );
+        vlc_mutex_unlock( &p_sys->csa_lock );
+    }
+    free( pp_csa );
+
     if ( p_list != NULL )
         sout_AccessOutWrite( p_mux->p_access, p_list );
 }
@@ -49,6 +49,15 @@ struct stream_ctrl
     };
 };
 
+/* Copy of buffered data retained across seeks */
+struct prefetch_window
+{
+    uint64_t     offset;
+    size_t       length;
+    uint64_t     stamp;
+    char        *data;
+};
+
 typedef struct
 {
     vlc_mutex_t  lock;
@@ -75,9 +84,103 @@ typedef struct
     char        *buffer;
     size_t       seek_threshold;
 
+    struct prefetch_window *windows;
+    unsigned     window_count;
+    size_t       window_size;
+    uint64_t     window_clock;
+
+    struct
+    {
+        uint64_t hits;
+        uint64_t window_hits;
+        uint64_t misses;
+    } stats;
+
     struct stream_ctrl *controls;
 } stream_sys_t;
 
+static struct prefetch_window *WindowFind(stream_sys_t *sys, uint64_t offset)
+{
+    for (unsigned i = 0; i < sys->window_count; i++)
+    {
+        struct prefetch_window *w = &sys->windows[i];
+
+        if (w->data != NULL && offset >= w->offset
+         && offset - w->offset < w->length)
+            return w;
+    }
+    return NULL;
+}
+
+/**
+ * Copies data out of the circular buffer.
+ */
+static void BufferCopy(const stream_sys_t *sys, void *buf, uint64_t offset,
+                       size_t length)
+{
+    size_t pos = offset % sys->buffer_size;
+    size_t first = sys->buffer_size - pos;
+
+    if (first > length)
+        first = length;
+    memcpy(buf, sys->buffer + pos, first);
+    memcpy((char *)buf + first, sys->buffer, length - first);
+}
+
+/**
+ * Retains the buffered data around a given offset before a seek discards it.
+ * Demuxers of indexed formats tend to come back to the same places (index,
+ * headers, interleaving of distant tracks).
+ */
+static void WindowSave(stream_t *stream, uint64_t center)
+{
+    stream_sys_t *sys = stream->p_sys;
+    uint64_t end = sys->buffer_offset + sys->buffer_length;
+
+    if (sys->window_count == 0
+     || center < sys->buffer_offset || center >= end)
+        return;
+
+    uint64_t start = sys->buffer_offset;
+    if (center - start > sys->window_size / 2)
+        start = center - sys->window_size / 2;
+
+    size_t length = end - start;
+    if (length > sys->window_size)
+        length = sys->window_size;
+
+    /* Drop overlapped windows, then reuse a free or the oldest slot */
+    struct prefetch_window *slot = NULL;
+
+    for (unsigned i = 0; i < sys->window_count; i++)
+    {
+        struct prefetch_window *w = &sys->windows[i];
+
+        if (w->data != NULL && w->offset < start + length
+         && start < w->offset + w->length)
+        {
+            free(w->data);
+            w->data = NULL;
+        }
+
+        if (slot == NULL || (slot->data != NULL
+                          && (w->data == NULL || w->stamp < slot->stamp)))
+            slot = w;
+    }
+
+    char *data = malloc(length);
+    if (unlikely(data == NULL))
+        return;
+
+    free(slot->data);
+    BufferCopy(sys, data, start, length);
+    slot->offset = start;
+    slot->length = length;
+    slot->stamp = ++sys->window_clock;
+    slot->data = data;
+    msg_Dbg(stream, "retaining %zu bytes at offset %"PRIu64, length, start);
+}
+
 static ssize_t ThreadRead(stream_t *stream, void *buf, size_t length)
 {
     stream_sys_t *sys = stream->p_sys;
@@ -163,6 +266,12 @@ static void *Thread(void *data)
 
         uint_fast64_t stream_offset = sys->stream_offset;
 
+        /* Data in a retained window does not need fetching: read ahead of
+         * its end instead */
+        const struct prefetch_window *w = WindowFind(sys, stream_offset);
+        if (w != NULL)
+            stream_offset = w->offset + w->length;
+
         if (stream_offset < sys->buffer_offset)
         {   /* Need to seek backward */
             if (ThreadSeek(stream, stream_offset) == 0)
@@ -273,6 +382,10 @@ static int Seek(stream_t *stream, uint64_t offset)
     stream_sys_t *sys = stream->p_sys;
 
     vlc_mutex_lock(&sys->lock);
+    /* Keep what would otherwise be discarded by the upstream seek */
+    if (offset < sys->buffer_offset
+     || offset - sys->buffer_offset > sys->buffer_length + sys->seek_threshold)
+        WindowSave(stream, sys->stream_offset);
     sys->stream_offset = offset;
     sys->error = false;
     vlc_cond_signal(&sys->wait_space);
@@ -313,6 +426,32 @@ static ssize_t Read(stream_t *stream, void *buf, size_t buflen)
         vlc_cond_signal(&sys->wait_space);
     }
 
+    copy = BufferLevel(stream, &eof);
+    if (copy == 0)
+    {
+        struct prefetch_window *w = WindowFind(sys, sys->stream_offset);
+
+        if (w != NULL)
+        {
+            copy = w->offset + w->length - sys->stream_offset;
+            if (copy > buflen)
+                copy = buflen;
+
+            memcpy(buf, w->data + (sys->stream_offset - w->offset), copy);
+            w->stamp = ++sys->window_clock;
+            sys->stream_offset += copy;
+            sys->stats.window_hits++;
+            vlc_cond_signal(&sys->wait_space);
+            vlc_mutex_unlock(&sys->lock);
+            return copy;
+        }
+
+        if (!eof)
+            sys->stats.misses++;
+    }
+    else
+        sys->stats.hits++;
+
     while ((copy = BufferLevel(stream, &eof)) == 0 && !eof)
     {
         void *data[2];
@@ -467,6 +606,13 @@ static int Open(vlc_object_t *obj)
     sys->buffer_length = 0;
     sys->buffer_size = var_InheritInteger(obj, "prefetch-buffer-size") << 10u;
     sys->seek_threshold = var_InheritInteger(obj, "prefetch-seek-threshold");
+    sys->window_count = sys->can_seek ? var_InheritInteger(obj, "prefetch-windows") : 0;
+    sys->window_size = var_InheritInteger(obj, "prefetch-window-size") << 10u;
+    sys->window_clock = 0;
+    sys->windows = NULL;
+    sys->stats.hits = 0;
+    sys->stats.window_hits = 0;
+    sys->stats.misses = 0;
     sys->controls = NULL;
 
     uint64_t size = stream_Size(stream->s);
@@ -476,10 +622,20 @@ static int Open(vlc_object_t *obj)
             sys->buffer_size = size;
     }
 
+    if (sys->window_size > sys->buffer_size)
+        sys->window_size = sys->buffer_size;
+
     sys->buffer = malloc(sys->buffer_size);
     if (sys->buffer == NULL)
         goto error;
 
+    if (sys->window_count > 0)
+    {
+        sys->windows = calloc(sys->window_count, sizeof (*sys->windows));
+        if (unlikely(sys->windows == NULL))
+            goto error;
+    }
+
     sys->interrupt = vlc_interrupt_create();
     if (unlikely(sys->interrupt == NULL))
         goto error;
@@ -496,13 +652,15 @@ static int Open(vlc_object_t *obj)
         goto error;
     }
 
-    msg_Dbg(stream, "using %zu bytes buffer", sys->buffer_size);
+    msg_Dbg(stream, "using %zu bytes buffer, %u windows of %zu bytes",
+            sys->buffer_size, sys->window_count, sys->window_size);
     stream->pf_read = Read;
     stream->pf_seek = Seek;
     stream->pf_control = Control;
     return VLC_SUCCESS;
 
 error:
+    free(sys->windows);
     free(sys->buffer);
     free(sys->content_type);
     free(sys);
@@ -532,6 +690,13 @@ static void Close (vlc_object_t *obj)
         sys->controls = ctrl->next;
         free(ctrl);
     }
+
+    msg_Dbg(stream, "reads: %"PRIu64" buffered, %"PRIu64" from retained "
+            "windows, %"PRIu64" waited", sys->stats.hits,
+            sys->stats.window_hits, sys->stats.misses);
+    for (unsigned i = 0; i < sys->window_count; i++)
+        free(sys->windows[i].data);
+    free(sys->windows);
     free(sys->buffer);
     free(sys->content_type);
     free(sys);
@@ -551,4 +716,10 @@ vlc_module_begin()
     add_integer("prefetch-seek-threshold", 1 << 14, N_("Seek threshold"),
                 N_("Prefetch forward seek threshold (bytes)"))
         change_integer_range(0, UINT64_C(1) << 60)
+    add_integer("prefetch-windows", 4, N_("Retained windows"),
+                N_("Number of buffered ranges kept across seeks"))
+        change_integer_range(0, 64)
+    add_integer("prefetch-window-size", 1 << 10, N_("Retained window size"),
+                N_("Size of each buffered range kept across seeks (KiB)"))
+        change_integer_range(4, 1 << 16)
 vlc_module_end()
@@ -0,0 +1,140 @@
+/*****************************************************************************
+ * dgram.c: batched and paced datagram output
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <errno.h>
+#include <limits.h>
+
+#include <vlc_common.h>
+#include <vlc_tick.h>
+#include <vlc_network.h>
+
+#include "dgram.h"
+
+/* Room for a few full size datagrams, or 10 ms worth of data */
+#define PACER_MIN_BURST_PACKETS 4
+#define PACER_BURST_PERIOD      VLC_TICK_FROM_MS(10)
+
+void vlc_pacer_Init(struct vlc_pacer *pacer, uint64_t bitrate, size_t mtu)
+{
+    pacer->rate = __MIN(bitrate / 8, UINT_MAX);
+    pacer->burst = __MAX((uint64_t)samples_from_vlc_tick(PACER_BURST_PERIOD,
+                                                         pacer->rate),
+                         PACER_MIN_BURST_PACKETS * (uint64_t)mtu);
+    pacer->tokens = pacer->burst;
+    pacer->date = VLC_TICK_INVALID;
+}
+
+static void vlc_pacer_Refill(struct vlc_pacer *pacer, vlc_tick_t now)
+{
+    if (pacer->date == VLC_TICK_INVALID || now <= pacer->date) {
+        if (pacer->date == VLC_TICK_INVALID)
+            pacer->date = now;
+        return;
+    }
+
+    uint64_t credit = samples_from_vlc_tick(now - pacer->date, pacer->rate);
+
+    if (pacer->tokens + credit >= pacer->burst) {
+        pacer->tokens = pacer->burst;
+        pacer->date = now;
+    } else {
+        /* Only account for the time actually converted into bytes, so that
+         * frequent refills do not lose the remainders */
+        pacer->tokens += credit;
+        pacer->date += vlc_tick_from_samples(credit, pacer->rate);
+    }
+}
+
+unsigned vlc_pacer_Take(struct vlc_pacer *pacer, const size_t *sizes,
+                        unsigned count)
+{
+    assert(count > 0);
+
+    if (pacer->rate == 0)
+        return count;
+
+    for (;;) {
+        vlc_tick_t now = vlc_tick_now();
+        unsigned n = 0;
+        uint64_t total = 0;
+
+        vlc_pacer_Refill(pacer, now);
+
+        while (n < count && total + sizes[n] <= pacer->tokens)
+            total += sizes[n++];
+
+        if (n > 0) {
+            pacer->tokens -= total;
+            return n;
+        }
+
+        if (sizes[0] > pacer->burst) {
+            /* Cannot ever fit: send it as soon as the bucket is full */
+            if (pacer->tokens == pacer->burst) {
+                pacer->tokens = 0;
+                return 1;
+            }
+            vlc_tick_wait(now + vlc_tick_from_samples(pacer->burst - pacer->tokens,
+                                                      pacer->rate));
+            continue;
+        }
+
+        vlc_tick_wait(now + vlc_tick_from_samples(sizes[0] - pacer->tokens,
+                                                  pacer->rate));
+    }
+}
+
+unsigned vlc_dgram_Send(int fd, const struct msghdr *msgv, unsigned count)
+{
+    unsigned sent = 0;
+
+#ifdef HAVE_SENDMMSG
+    while (sent < count) {
+        struct mmsghdr msgs[VLC_DGRAM_BATCH];
+        unsigned n = __MIN(count - sent, ARRAY_SIZE(msgs));
+
+        for (unsigned i = 0; i < n; i++) {
+            msgs[i].msg_hdr = msgv[sent + i];
+            msgs[i].msg_len = 0;
+        }
+
+        int val = sendmmsg(fd, msgs, n, 0);
+        if (val <= 0) {
+            if (val == 0)
+                errno = EAGAIN;
+            break;
+        }
+        /* On a partial send, the next call reports the error */
+        sent += val;
+    }
+#else
+    while (sent < count) {
+        if (sendmsg(fd, &msgv[sent], 0) < 0)
+            break;
+        sent++;
+    }
+#endif
+    return sent;
+}
@@ -0,0 +1,80 @@
+/*****************************************************************************
+ * dgram.h: batched and paced datagram output
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_SOUT_DGRAM_H
+#define VLC_SOUT_DGRAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct msghdr;
+
+/** Maximum number of datagrams handed to the kernel at once */
+#define VLC_DGRAM_BATCH 64
+
+/**
+ * Token bucket limiting the output rate.
+ *
+ * The bucket is refilled at the configured rate and holds at most one burst
+ * worth of bytes, so that a whole video frame packetized at once is spread
+ * over time instead of leaving the host as a single burst.
+ */
+struct vlc_pacer
+{
+    unsigned   rate;   /**< Bytes per second, 0 for unlimited */
+    uint64_t   burst;  /**< Bucket depth in bytes */
+    uint64_t   tokens; /**< Bytes that can be sent right now */
+    vlc_tick_t date;   /**< Date of the last refill */
+};
+
+/**
+ * Initializes a pacer.
+ *
+ * \param bitrate maximum rate in bits per second (0 disables pacing)
+ * \param mtu largest datagram size, the burst is never smaller than a few
+ *            of these
+ */
+void vlc_pacer_Init(struct vlc_pacer *, uint64_t bitrate, size_t mtu);
+
+/**
+ * Takes credit for a run of datagrams.
+ *
+ * Waits until at least the first datagram can be sent, then consumes the
+ * credit for as many of the following ones as the bucket allows.
+ *
+ * \param sizes size in bytes of each datagram
+ * \param count number of datagrams (must be non-zero)
+ * \return number of datagrams that can be sent now (between 1 and count)
+ */
+unsigned vlc_pacer_Take(struct vlc_pacer *, const size_t *sizes,
+                        unsigned count);
+
+/**
+ * Sends datagrams on a connected socket.
+ *
+ * The datagrams are passed to the kernel in as few system calls as
+ * possible, with sendmmsg() where available.
+ *
+ * \return the number of datagrams sent, which is less than count only if
+ *         sending the next one failed (the error is then in errno)
+ */
+unsigned vlc_dgram_Send(int fd, const struct msghdr *msgv, unsigned count);
+
+#endif
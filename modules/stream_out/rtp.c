@@ -51,6 +51,7 @@
 
 #include "rtp.h"
 #include "sdp_helper.h"
+#include "dgram.h"
 
 #include <sys/types.h>
 #include <unistd.h>
@@ -139,6 +140,11 @@
     "with this Secure RTP master shared secret key. "\
     "This must be a 32-character-long hexadecimal string.")
 
+#define MAX_RATE_TEXT N_("Maximum rate (kb/s)")
+#define MAX_RATE_LONGTEXT N_( \
+    "Packets are paced so that the output of each stream never exceeds " \
+    "this rate, even for short bursts (0 = unlimited)." )
+
 #define SRTP_SALT_TEXT N_("SRTP salt (hexadecimal)")
 #define SRTP_SALT_LONGTEXT N_( \
     "Secure RTP requires a (non-secret) master salt value. " \
@@ -215,6 +221,8 @@ vlc_module_begin ()
               RTCP_MUX_TEXT, RTCP_MUX_LONGTEXT )
     add_integer( SOUT_CFG_PREFIX "caching", MS_FROM_VLC_TICK(DEFAULT_PTS_DELAY),
                  CACHING_TEXT, CACHING_LONGTEXT )
+    add_integer_with_range( SOUT_CFG_PREFIX "max-rate", 0, 0, 100000000,
+                            MAX_RATE_TEXT, MAX_RATE_LONGTEXT )
     add_integer( "rtsp-timeout", 60, RTSP_TIMEOUT_TEXT,
                  RTSP_TIMEOUT_LONGTEXT )
     add_string( "sout-rtsp-user", "",
@@ -239,7 +247,7 @@ vlc_module_end ()
  *****************************************************************************/
 static const char *const ppsz_sout_options[] = {
     "dst", "name", "cat", "port", "port-audio", "port-video", "*sdp", "ttl",
-    "mux", "sap", "description", "proto", "rtcp-mux", "caching",
+    "mux", "sap", "description", "proto", "rtcp-mux", "caching", "max-rate",
 #ifdef HAVE_SRTP
     "key", "salt",
 #endif
@@ -354,6 +362,12 @@ struct sout_stream_id_sys_t
     } listen;
 
     vlc_tick_t        i_caching;
+
+    /* Output pacing and statistics, owned by the sending thread */
+    struct vlc_pacer  pacer;
+    uint64_t          i_sent;
+    uint64_t          i_late;
+    uint64_t          i_dropped;
 };
 
 static int Control(sout_stream_t *stream, int query, va_list args)
@@ -945,6 +959,10 @@ static void *Add( sout_stream_t *p_stream, const es_format_t *p_fmt )
     id->b_first_packet = true;
     id->i_caching =
         VLC_TICK_FROM_MS(var_GetInteger( p_stream, SOUT_CFG_PREFIX "caching"));
+    vlc_pacer_Init( &id->pacer,
+                    var_GetInteger( p_stream, SOUT_CFG_PREFIX "max-rate" ) * 1000,
+                    id->i_mtu );
+    id->i_sent = id->i_late = id->i_dropped = 0;
 
     vlc_rand_bytes (&id->i_sequence, sizeof (id->i_sequence));
     vlc_rand_bytes (id->ssrc, sizeof (id->ssrc));
@@ -1168,6 +1186,8 @@ static void Del( sout_stream_t *p_stream, void *_id )
     {
         vlc_queue_Kill(&id->queue, &id->dead);
         vlc_join( id->thread, NULL );
+        msg_Dbg( p_stream, "sent %"PRIu64" packets, %"PRIu64" late, "
+                 "%"PRIu64" dropped", id->i_sent, id->i_late, id->i_dropped );
      }
     free( id->rtp_fmt.fmtp );
 
@@ -1324,10 +1344,6 @@ static int  HttpCallback( httpd_file_sys_t *p_args,
 /****************************************************************************
  * RTP send
  ****************************************************************************/
-static void* ThreadSend( void *data )
-{
-    vlc_thread_set_name("vlc-rt-send");
-
 #ifdef _WIN32
 # undef ENOBUFS
 # define ENOBUFS      WSAENOBUFS
@@ -1336,69 +1352,184 @@ static void* ThreadSend( void *data )
 # undef EWOULDBLOCK
 # define EWOULDBLOCK  WSAEWOULDBLOCK
 #endif
-    sout_stream_id_sys_t *id = data;
-    vlc_tick_t i_caching = id->i_caching;
-    block_t *out;
 
-    while ((out = vlc_queue_DequeueKillable(&id->queue, &id->dead)) != NULL)
-    {
+/* Packets sent later than this after their date are accounted as late */
+#define RTP_LATE_TOLERANCE VLC_TICK_FROM_MS(20)
+
+static block_t *SendProtect( sout_stream_id_sys_t *id, block_t *out )
+{
 #ifdef HAVE_SRTP
-        if( id->srtp )
-        {   /* FIXME: this is awfully inefficient */
-            size_t len = out->i_buffer;
-            out = block_Realloc( out, 0, len + 10 );
-            out->i_buffer = len;
-
-            int val = srtp_send( id->srtp, out->p_buffer, &len, len + 10 );
-            if( val )
-            {
-                msg_Dbg( id->p_stream, "SRTP sending error: %s",
-                         vlc_strerror_c(val) );
-                block_Release( out );
+    if( id->srtp )
+    {   /* FIXME: this is awfully inefficient */
+        size_t len = out->i_buffer;
+        out = block_Realloc( out, 0, len + 10 );
+        out->i_buffer = len;
+
+        int val = srtp_send( id->srtp, out->p_buffer, &len, len + 10 );
+        if( val )
+        {
+            msg_Dbg( id->p_stream, "SRTP sending error: %s",
+                     vlc_strerror_c(val) );
+            block_Release( out );
+            id->i_dropped++;
+            return NULL;
+        }
+        out->i_buffer = len;
+    }
+#else
+    VLC_UNUSED(id);
+#endif
+    return out;
+}
+
+/* Returns -1 if the connection is broken */
+static int SendSink( sout_stream_id_sys_t *id, int fd,
+                     const struct msghdr *msgv, unsigned count )
+{
+    bool retried = false;
+
+    for( unsigned i = 0; i < count; )
+    {
+        i += vlc_dgram_Send( fd, &msgv[i], count - i );
+        if( i == count )
+            break;
+
+        int error = net_errno;
+        bool transient = error == EAGAIN || error == ENOBUFS || error == ENOMEM;
+#if EWOULDBLOCK != EAGAIN
+        transient = transient || error == EWOULDBLOCK;
+#endif
+        if( !transient )
+        {
+            int type;
+            getsockopt( fd, SOL_SOCKET, SO_TYPE,
+                        &type, &(socklen_t){ sizeof(type) });
+            if( type != SOCK_DGRAM )
+                /* Broken connection */
+                return -1;
+            if( !retried )
+            {   /* ICMP soft error: ignore and retry */
+                retried = true;
                 continue;
             }
-            out->i_buffer = len;
         }
-#endif
-        vlc_tick_wait (out->i_dts + i_caching);
+        /* Give up on this packet */
+        id->i_dropped++;
+        retried = false;
+        i++;
+    }
+    return 0;
+}
+
+static void SendBatch( sout_stream_id_sys_t *id, block_t **batch,
+                       unsigned count )
+{
+    struct iovec iov[VLC_DGRAM_BATCH];
+    struct msghdr msgv[VLC_DGRAM_BATCH];
+    size_t sizes[VLC_DGRAM_BATCH];
+
+    assert( count <= VLC_DGRAM_BATCH );
+    for( unsigned i = 0; i < count; i++ )
+    {
+        iov[i].iov_base = batch[i]->p_buffer;
+        iov[i].iov_len = batch[i]->i_buffer;
+        msgv[i] = (struct msghdr){ .msg_iov = &iov[i], .msg_iovlen = 1 };
+        sizes[i] = batch[i]->i_buffer;
+    }
+
+    for( unsigned i = 0; i < count; )
+    {
+        unsigned n = vlc_pacer_Take( &id->pacer, &sizes[i], count - i );
+        vlc_tick_t now = vlc_tick_now();
 
-        ssize_t len = out->i_buffer;
+        for( unsigned j = i; j < i + n; j++ )
+            if( now > batch[j]->i_dts + id->i_caching + RTP_LATE_TOLERANCE )
+                id->i_late++;
 
         vlc_mutex_lock( &id->lock_sink );
         unsigned deadc = 0; /* How many dead sockets? */
         int deadv[id->sinkc ? id->sinkc : 1]; /* Dead sockets list */
 
-        for( int i = 0; i < id->sinkc; i++ )
+        for( int s = 0; s < id->sinkc; s++ )
         {
 #ifdef HAVE_SRTP
             if( !id->srtp ) /* FIXME: SRTCP support */
 #endif
-                SendRTCP( id->sinkv[i].rtcp, out );
+                for( unsigned j = i; j < i + n; j++ )
+                    SendRTCP( id->sinkv[s].rtcp, batch[j] );
+
+            if( SendSink( id, id->sinkv[s].rtp_fd, &msgv[i], n ) )
+                deadv[deadc++] = id->sinkv[s].rtp_fd;
+        }
+        id->i_seq_sent_next =
+            ntohs(((uint16_t *) batch[i + n - 1]->p_buffer)[1]) + 1;
+        vlc_mutex_unlock( &id->lock_sink );
+        id->i_sent += n;
+        i += n;
+
+        for( unsigned j = 0; j < deadc; j++ )
+        {
+            msg_Dbg( id->p_stream, "removing socket %d", deadv[j] );
+            rtp_del_sink( id, deadv[j] );
+        }
+    }
+
+    for( unsigned i = 0; i < count; i++ )
+        block_Release( batch[i] );
+}
+
+static void* ThreadSend( void *data )
+{
+    vlc_thread_set_name("vlc-rt-send");
+
+    sout_stream_id_sys_t *id = data;
+    vlc_tick_t i_caching = id->i_caching;
+    block_t *next = NULL;
+
+    for( ;; )
+    {
+        block_t *batch[VLC_DGRAM_BATCH];
+        unsigned count = 0;
+        block_t *out = next;
+
+        next = NULL;
+        if( out == NULL )
+            out = vlc_queue_DequeueKillable(&id->queue, &id->dead);
+        if( out == NULL )
+            break;
 
-            if( send( id->sinkv[i].rtp_fd, out->p_buffer, len, 0 ) == -1
-             && net_errno != EAGAIN && net_errno != EWOULDBLOCK
-             && net_errno != ENOBUFS && net_errno != ENOMEM )
+        vlc_tick_wait (out->i_dts + i_caching);
+        batch[count++] = out;
+
+        /* Send the packets that are already due along with this one, they
+         * typically belong to the same frame */
+        const vlc_tick_t now = vlc_tick_now();
+
+        while( count < ARRAY_SIZE(batch) )
+        {
+            vlc_queue_Lock( &id->queue );
+            out = vlc_queue_DequeueUnlocked( &id->queue );
+            vlc_queue_Unlock( &id->queue );
+            if( out == NULL )
+                break;
+
+            if( out->i_dts + i_caching > now )
             {
-                int type;
-                getsockopt( id->sinkv[i].rtp_fd, SOL_SOCKET, SO_TYPE,
-                            &type, &(socklen_t){ sizeof(type) });
-                if( type == SOCK_DGRAM )
-                    /* ICMP soft error: ignore and retry */
-                    send( id->sinkv[i].rtp_fd, out->p_buffer, len, 0 );
-                else
-                    /* Broken connection */
-                    deadv[deadc++] = id->sinkv[i].rtp_fd;
+                next = out;
+                break;
             }
+            batch[count++] = out;
         }
-        id->i_seq_sent_next = ntohs(((uint16_t *) out->p_buffer)[1]) + 1;
-        vlc_mutex_unlock( &id->lock_sink );
-        block_Release( out );
 
-        for( unsigned i = 0; i < deadc; i++ )
+        /* Protect only the packets actually sent, exactly once */
+        unsigned sendc = 0;
+        for( unsigned i = 0; i < count; i++ )
         {
-            msg_Dbg( id->p_stream, "removing socket %d", deadv[i] );
-            rtp_del_sink( id, deadv[i] );
+            out = SendProtect( id, batch[i] );
+            if( out != NULL )
+                batch[sendc++] = out;
         }
+        SendBatch( id, batch, sendc );
     }
     return NULL;
 }
@@ -38,6 +38,7 @@
 #include <vlc_network.h>
 #include <vlc_memstream.h>
 #include "sdp_helper.h"
+#include "dgram.h"
 
 struct sout_stream_udp
 {
@@ -46,6 +47,9 @@ struct sout_stream_udp
     session_descriptor_t *sap;
     int fd;
     uint_fast16_t mtu;
+    struct vlc_pacer pacer;
+    uint64_t sent;
+    uint64_t dropped;
 };
 
 static void *Add(sout_stream_t *stream, const es_format_t *fmt)
@@ -151,33 +155,56 @@ static ssize_t AccessOutWrite(sout_access_out_t *access, block_t *block)
     ssize_t total = 0;
 
     while (block != NULL) {
-        struct iovec iov[16];
+        struct iovec iov[VLC_DGRAM_BATCH][16];
+        struct msghdr msgv[VLC_DGRAM_BATCH];
+        size_t sizes[VLC_DGRAM_BATCH];
         block_t *unsent = block;
-        unsigned iovlen = 0;
-        size_t tosend = 0;
-
-        /* Count how many blocks to gather */
-        do {
-            if (iovlen >= ARRAY_SIZE(iov))
-                break;
-            if (unsent->i_buffer + tosend > sys->mtu && likely(iovlen > 0))
-                break;
-
-            iov[iovlen].iov_base = unsent->p_buffer;
-            iov[iovlen].iov_len = unsent->i_buffer;
-            iovlen++;
-            tosend += unsent->i_buffer;
-            unsent = unsent->p_next;
-        } while (unsent != NULL);
+        unsigned count = 0;
+
+        /* Gather blocks into datagrams, and datagrams into a batch */
+        while (unsent != NULL && count < VLC_DGRAM_BATCH) {
+            unsigned iovlen = 0;
+            size_t tosend = 0;
+
+            do {
+                if (iovlen >= ARRAY_SIZE(iov[count]))
+                    break;
+                if (unsent->i_buffer + tosend > sys->mtu && likely(iovlen > 0))
+                    break;
+
+                iov[count][iovlen].iov_base = unsent->p_buffer;
+                iov[count][iovlen].iov_len = unsent->i_buffer;
+                iovlen++;
+                tosend += unsent->i_buffer;
+                unsent = unsent->p_next;
+            } while (unsent != NULL);
+
+            msgv[count] = (struct msghdr){
+                .msg_iov = iov[count], .msg_iovlen = iovlen };
+            sizes[count] = tosend;
+            count++;
+        }
 
         /* Send */
-        struct msghdr hdr = { .msg_iov = iov, .msg_iovlen = iovlen };
-        ssize_t val = sendmsg(sys->fd, &hdr, 0);
-
-        if (val < 0)
-            msg_Err(access, "send error: %s", vlc_strerror_c(errno));
-        else
-            total += val;
+        for (unsigned i = 0; i < count;) {
+            unsigned n = vlc_pacer_Take(&sys->pacer, &sizes[i], count - i);
+            unsigned end = i + n;
+
+            while (i < end) {
+                unsigned val = vlc_dgram_Send(sys->fd, &msgv[i], end - i);
+
+                for (unsigned j = i; j < i + val; j++)
+                    total += sizes[j];
+                sys->sent += val;
+                i += val;
+
+                if (i < end) {
+                    msg_Err(access, "send error: %s", vlc_strerror_c(errno));
+                    sys->dropped++;
+                    i++;
+                }
+            }
+        }
 
         /* Free */
         do {
@@ -199,6 +226,9 @@ static void Close(vlc_object_t *obj)
     if (sys->sap != NULL)
         sout_AnnounceUnRegister(stream, sys->sap);
 
+    msg_Dbg(stream, "sent %"PRIu64" datagrams, %"PRIu64" dropped",
+            sys->sent, sys->dropped);
+
     sout_MuxDelete(sys->mux);
     sout_AccessOutDelete(sys->access);
     net_Close(sys->fd);
@@ -210,7 +240,7 @@ static const struct sout_stream_operations ops = {
 };
 
 static const char *const chain_options[] = {
-    "avformat", "dst", "sap", "name", "description", NULL
+    "avformat", "dst", "sap", "name", "description", "max-rate", NULL
 };
 
 #define DEFAULT_PORT 1234
@@ -308,6 +338,11 @@ static int Open(vlc_object_t *obj)
     sys->access = access;
     sys->fd = fd;
     sys->mtu = var_InheritInteger(stream, "mtu");
+    vlc_pacer_Init(&sys->pacer,
+                   var_GetInteger(stream, SOUT_CFG_PREFIX "max-rate") * 1000,
+                   sys->mtu);
+    sys->sent = 0;
+    sys->dropped = 0;
 
     sout_mux_t *mux = sout_MuxNew(access, muxmod);
     if (mux == NULL) {
@@ -346,6 +381,10 @@ error:
 #define DESC_TEXT N_("SAP description")
 #define DESC_LONGTEXT N_( \
     "Short description of the stream that will be announced with SAP.")
+#define MAX_RATE_TEXT N_("Maximum rate (kb/s)")
+#define MAX_RATE_LONGTEXT N_( \
+    "Datagrams are paced so that the output never exceeds this rate, " \
+    "even for short bursts (0 = unlimited).")
 
 vlc_module_begin()
     set_shortname(N_("UDP"))
@@ -359,6 +398,8 @@ vlc_module_begin()
     add_bool(SOUT_CFG_PREFIX "sap", false, SAP_TEXT, SAP_LONGTEXT)
     add_string(SOUT_CFG_PREFIX "name", "", NAME_TEXT, NAME_LONGTEXT)
     add_string(SOUT_CFG_PREFIX "description", "", DESC_TEXT, DESC_LONGTEXT)
+    add_integer_with_range(SOUT_CFG_PREFIX "max-rate", 0, 0, 100000000,
+                           MAX_RATE_TEXT, MAX_RATE_LONGTEXT)
 
     set_callbacks(Open, Close)
 vlc_module_end()
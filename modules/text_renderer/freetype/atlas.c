@@ -0,0 +1,287 @@
+/*****************************************************************************
+ * atlas.c : Rasterized glyphs atlas for freetype2
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_arrays.h>
+#include <vlc_vector.h>
+
+/* Freetype */
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_GLYPH_H
+
+#include "ftcache.h"
+#include "atlas.h"
+
+#include <assert.h>
+
+#define FTATLAS_PAGE_SIZE 1024
+
+/* Glyphs are packed in rows (shelves) of 8 bits coverage pages */
+typedef struct
+{
+    uint8_t *p_pixels;
+    unsigned i_width;
+    unsigned i_height;
+    unsigned i_shelf_x;
+    unsigned i_shelf_y;
+    unsigned i_shelf_height;
+} vlc_ftatlas_page_t;
+
+typedef struct
+{
+    FT_BitmapGlyphRec glyph; /* rendered at the origin subpixel position */
+    size_t i_page;
+    size_t i_offset;
+} vlc_ftatlas_entry_t;
+
+typedef struct
+{
+    FT_BitmapGlyphRec glyph; /* must be first */
+    vlc_ftatlas_t *atlas;
+    FT_Glyph owned; /* rendered outside of the atlas, or NULL */
+} vlc_ftatlas_view_t;
+
+struct vlc_ftatlas_t
+{
+    vlc_object_t *obj;
+    vlc_dictionary_t entries;
+    struct VLC_VECTOR(vlc_ftatlas_page_t) pages;
+    unsigned maxpages;
+    unsigned views;
+};
+
+static void FreeEntry( void *p_entry, void *p_obj )
+{
+    VLC_UNUSED(p_obj);
+    free( p_entry );
+}
+
+static void vlc_ftatlas_Clean( vlc_ftatlas_t *atlas )
+{
+    assert( atlas->views == 0 );
+    vlc_dictionary_clear( &atlas->entries, FreeEntry, NULL );
+    for( size_t i = 0; i < atlas->pages.size; i++ )
+        free( atlas->pages.data[i].p_pixels );
+    vlc_vector_clear( &atlas->pages );
+}
+
+vlc_ftatlas_t * vlc_ftatlas_New( vlc_object_t *obj, unsigned maxpages )
+{
+    vlc_ftatlas_t *atlas = malloc( sizeof(*atlas) );
+    if( !atlas )
+        return NULL;
+    atlas->obj = obj;
+    atlas->maxpages = maxpages;
+    atlas->views = 0;
+    vlc_dictionary_init( &atlas->entries, 1024 );
+    vlc_vector_init( &atlas->pages );
+    return atlas;
+}
+
+void vlc_ftatlas_Delete( vlc_ftatlas_t *atlas )
+{
+    vlc_ftatlas_Clean( atlas );
+    vlc_vector_destroy( &atlas->pages );
+    free( atlas );
+}
+
+static int vlc_ftatlas_Alloc( vlc_ftatlas_t *atlas, unsigned w, unsigned h,
+                              size_t *pi_page, size_t *pi_offset )
+{
+    if( atlas->pages.size > 0 )
+    {
+        vlc_ftatlas_page_t *page = &atlas->pages.data[atlas->pages.size - 1];
+        if( page->i_shelf_x + w > page->i_width )
+        {
+            page->i_shelf_y += page->i_shelf_height;
+            page->i_shelf_x = 0;
+            page->i_shelf_height = 0;
+        }
+        if( page->i_shelf_x + w <= page->i_width &&
+            page->i_shelf_y + h <= page->i_height )
+        {
+            *pi_page = atlas->pages.size - 1;
+            *pi_offset = (size_t) page->i_shelf_y * page->i_width + page->i_shelf_x;
+            page->i_shelf_x += w;
+            page->i_shelf_height = __MAX( page->i_shelf_height, h );
+            return VLC_SUCCESS;
+        }
+    }
+
+    /* oversized glyphs get their own page */
+    vlc_ftatlas_page_t page = {
+        .i_width = __MAX( w, FTATLAS_PAGE_SIZE ),
+        .i_height = __MAX( h, FTATLAS_PAGE_SIZE ),
+        .i_shelf_x = w,
+        .i_shelf_y = 0,
+        .i_shelf_height = h,
+    };
+    page.p_pixels = malloc( (size_t) page.i_width * page.i_height );
+    if( !page.p_pixels )
+        return VLC_ENOMEM;
+    if( !vlc_vector_push( &atlas->pages, page ) )
+    {
+        free( page.p_pixels );
+        return VLC_ENOMEM;
+    }
+    *pi_page = atlas->pages.size - 1;
+    *pi_offset = 0;
+    return VLC_SUCCESS;
+}
+
+static vlc_ftatlas_entry_t * vlc_ftatlas_Add( vlc_ftatlas_t *atlas, const char *psz_key,
+                                              FT_Glyph source, FT_Vector *origin )
+{
+    FT_Glyph glyph = source;
+    if( FT_Glyph_To_Bitmap( &glyph, FT_RENDER_MODE_NORMAL, origin, 0 ) )
+        return NULL;
+
+    vlc_ftatlas_entry_t *entry = NULL;
+    const FT_BitmapGlyph bitmap = (FT_BitmapGlyph) glyph;
+    /* the blenders only handle 8 bits coverage */
+    if( bitmap->bitmap.pixel_mode != FT_PIXEL_MODE_GRAY )
+        goto end;
+
+    entry = malloc( sizeof(*entry) );
+    if( !entry )
+        goto end;
+
+    const unsigned w = bitmap->bitmap.width, h = bitmap->bitmap.rows;
+    entry->glyph = *bitmap;
+    entry->glyph.bitmap.buffer = NULL;
+    entry->i_page = 0;
+    entry->i_offset = 0;
+    if( w > 0 && h > 0 )
+    {
+        if( vlc_ftatlas_Alloc( atlas, w, h, &entry->i_page, &entry->i_offset ) )
+        {
+            free( entry );
+            entry = NULL;
+            goto end;
+        }
+        const vlc_ftatlas_page_t *page = &atlas->pages.data[entry->i_page];
+        for( unsigned y = 0; y < h; y++ )
+            memcpy( &page->p_pixels[entry->i_offset + (size_t) y * page->i_width],
+                    &bitmap->bitmap.buffer[(ptrdiff_t) y * bitmap->bitmap.pitch], w );
+        entry->glyph.bitmap.pitch = page->i_width;
+    }
+    vlc_dictionary_insert( &atlas->entries, psz_key, entry );
+
+end:
+    if( glyph != source )
+        FT_Done_Glyph( glyph );
+    return entry;
+}
+
+static vlc_ftatlas_view_t * vlc_ftatlas_NewView( vlc_ftatlas_t *atlas )
+{
+    vlc_ftatlas_view_t *view = malloc( sizeof(*view) );
+    if( !view )
+        return NULL;
+    view->atlas = atlas;
+    view->owned = NULL;
+    atlas->views++;
+    return view;
+}
+
+/* Bitmap sources (embedded strikes, color glyphs) are not positioned by
+ * FT_Glyph_To_Bitmap and are kept in their own format */
+static FT_BitmapGlyph vlc_ftatlas_GetBitmap( vlc_ftatlas_t *atlas, FT_Glyph source,
+                                             const FT_Vector *pen )
+{
+    FT_Glyph glyph;
+    if( FT_Glyph_Copy( source, &glyph ) )
+        return NULL;
+    if( FT_Glyph_To_Bitmap( &glyph, FT_RENDER_MODE_NORMAL, pen, 1 ) )
+    {
+        FT_Done_Glyph( glyph );
+        return NULL;
+    }
+
+    vlc_ftatlas_view_t *view = vlc_ftatlas_NewView( atlas );
+    if( !view )
+    {
+        FT_Done_Glyph( glyph );
+        return NULL;
+    }
+    view->glyph = *(FT_BitmapGlyph) glyph;
+    view->owned = glyph;
+    return &view->glyph;
+}
+
+FT_BitmapGlyph vlc_ftatlas_GetGlyph( vlc_ftatlas_t *atlas, const vlc_ftatlas_key_t *key,
+                                     FT_Glyph source, const FT_Vector *pen )
+{
+    if( source->format != FT_GLYPH_FORMAT_OUTLINE )
+        return vlc_ftatlas_GetBitmap( atlas, source, pen );
+
+    /* Pages can only be recycled when no glyph points to them anymore */
+    if( atlas->views == 0 && atlas->pages.size > atlas->maxpages )
+    {
+        msg_Dbg( atlas->obj, "flushing glyph atlas (%zu pages)", atlas->pages.size );
+        vlc_ftatlas_Clean( atlas );
+        vlc_dictionary_init( &atlas->entries, 1024 );
+    }
+
+    /* Only the subpixel part of the pen changes the rasterization */
+    FT_Vector origin = { .x = pen->x & 63, .y = pen->y & 63 };
+
+    char psz_key[128];
+    snprintf( psz_key, sizeof(psz_key), "%p#%d,%d#%u#%x#%d#%ld,%ld",
+              (const void *) key->faceid, key->metrics.width_px,
+              key->metrics.height_px, key->index, key->flags, key->radius,
+              (long) origin.x, (long) origin.y );
+
+    vlc_ftatlas_entry_t *entry = vlc_dictionary_value_for_key( &atlas->entries, psz_key );
+    if( !entry )
+    {
+        entry = vlc_ftatlas_Add( atlas, psz_key, source, &origin );
+        if( !entry )
+            return NULL;
+    }
+
+    vlc_ftatlas_view_t *view = vlc_ftatlas_NewView( atlas );
+    if( !view )
+        return NULL;
+    view->glyph = entry->glyph;
+    /* empty bitmaps are not positioned */
+    if( view->glyph.bitmap.width > 0 && view->glyph.bitmap.rows > 0 )
+    {
+        view->glyph.left += (pen->x - origin.x) / 64;
+        view->glyph.top  += (pen->y - origin.y) / 64;
+        view->glyph.bitmap.buffer =
+            &atlas->pages.data[entry->i_page].p_pixels[entry->i_offset];
+    }
+    return &view->glyph;
+}
+
+void vlc_ftatlas_ReleaseGlyph( FT_BitmapGlyph glyph )
+{
+    vlc_ftatlas_view_t *view = container_of( glyph, vlc_ftatlas_view_t, glyph );
+    assert( view->atlas->views > 0 );
+    view->atlas->views--;
+    if( view->owned )
+        FT_Done_Glyph( view->owned );
+    free( view );
+}
@@ -0,0 +1,61 @@
+/*****************************************************************************
+ * atlas.h : Rasterized glyphs atlas for freetype2
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef FTATLAS_H
+#define FTATLAS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct vlc_ftatlas_t vlc_ftatlas_t;
+
+vlc_ftatlas_t * vlc_ftatlas_New( vlc_object_t *, unsigned maxpages );
+void vlc_ftatlas_Delete( vlc_ftatlas_t * );
+
+/* Source glyph modifications, part of the key */
+#define VLC_FTATLAS_EMBOLDEN   0x1
+#define VLC_FTATLAS_OBLIQUE    0x2
+#define VLC_FTATLAS_OUTLINE    0x4
+
+/* Identifies the source glyph of a rasterization */
+typedef struct
+{
+    const vlc_face_id_t *faceid;
+    vlc_ftcache_metrics_t metrics;
+    FT_UInt index;
+    unsigned flags;
+    int radius;
+} vlc_ftatlas_key_t;
+
+/* Returns the bitmap of the source glyph rendered at pen, as
+ * FT_Glyph_To_Bitmap would. Outlines are rasterized once per subpixel
+ * position into the atlas pages, other sources are only copied.
+ * The result must never be passed to FT_Done_Glyph: always use
+ * vlc_ftatlas_ReleaseGlyph. Pages are only recycled once all the returned
+ * glyphs are released. */
+FT_BitmapGlyph vlc_ftatlas_GetGlyph( vlc_ftatlas_t *, const vlc_ftatlas_key_t *,
+                                     FT_Glyph source, const FT_Vector *pen );
+void vlc_ftatlas_ReleaseGlyph( FT_BitmapGlyph );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,194 @@
+/*****************************************************************************
+ * atlas_test.c: glyph atlas tests
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#undef NDEBUG
+#include <assert.h>
+
+#include <vlc_common.h>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_GLYPH_H
+#include FT_OUTLINE_H
+#include FT_STROKER_H
+
+#include "ftcache.h"
+#include "atlas.h"
+
+const char vlc_module_name[] = "test_ftatlas";
+
+#define FONT_SIZE 32
+
+/* Pen positions in 26.6, including negative and subpixel ones */
+static const FT_Vector pens[] = {
+    { 0, 0 }, { 1, 0 }, { 31, 17 }, { 63, 63 }, { 64, 64 },
+    { 100 * 64 + 13, 20 * 64 + 40 }, { -1, -1 }, { -64, -64 },
+    { -100, -63 }, { -3 * 64 - 13, 2 * 64 + 40 }, { 7 * 64 + 5, -9 * 64 - 1 },
+};
+
+/* Shadow offsets, as a fraction of the font size (see freetype.c) */
+static const double shadows[][2] = {
+    { 0.0, 0.0 }, { 0.06, -0.06 }, { -0.03, 0.045 },
+};
+
+static const char chars[] = "gAW.i ";
+
+/* The atlas view must match what FT_Glyph_To_Bitmap() renders at pen */
+static void check(vlc_ftatlas_t *atlas, const vlc_ftatlas_key_t *key,
+                  FT_Glyph source, const FT_Vector *pen)
+{
+    FT_Glyph ref = source;
+    FT_Vector origin = *pen;
+    int ret = FT_Glyph_To_Bitmap(&ref, FT_RENDER_MODE_NORMAL, &origin, 0);
+    assert(ret == 0);
+    const FT_BitmapGlyph bref = (FT_BitmapGlyph) ref;
+
+    /* Twice, so that the second time comes from the atlas */
+    for (int i = 0; i < 2; i++)
+    {
+        FT_BitmapGlyph view = vlc_ftatlas_GetGlyph(atlas, key, source, pen);
+        assert(view != NULL);
+
+        if (view->left != bref->left || view->top != bref->top
+         || view->bitmap.width != bref->bitmap.width
+         || view->bitmap.rows != bref->bitmap.rows)
+            fprintf(stderr, "glyph %u flags %x at %ld,%ld: got %dx%d at "
+                    "%d,%d, expected %dx%d at %d,%d\n", key->index,
+                    key->flags, (long) pen->x, (long) pen->y,
+                    view->bitmap.width, view->bitmap.rows, view->left,
+                    view->top, bref->bitmap.width, bref->bitmap.rows,
+                    bref->left, bref->top);
+        assert(view->left == bref->left);
+        assert(view->top == bref->top);
+        assert(view->bitmap.width == bref->bitmap.width);
+        assert(view->bitmap.rows == bref->bitmap.rows);
+        assert(view->bitmap.pixel_mode == bref->bitmap.pixel_mode);
+        assert(view->root.advance.x == bref->root.advance.x);
+        assert(view->root.advance.y == bref->root.advance.y);
+
+        for (unsigned y = 0; y < bref->bitmap.rows; y++)
+            assert(!memcmp(&view->bitmap.buffer[(ptrdiff_t) y * view->bitmap.pitch],
+                           &bref->bitmap.buffer[(ptrdiff_t) y * bref->bitmap.pitch],
+                           bref->bitmap.width));
+
+        vlc_ftatlas_ReleaseGlyph(view);
+    }
+
+    FT_Done_Glyph(ref);
+}
+
+static void check_glyph(vlc_ftatlas_t *atlas, FT_Stroker stroker,
+                        vlc_ftatlas_key_t *key, FT_Glyph glyph)
+{
+    FT_Glyph stroked = glyph;
+    int ret = FT_Glyph_Stroke(&stroked, stroker, 0);
+    assert(ret == 0);
+
+    vlc_ftatlas_key_t outline_key = *key;
+    outline_key.flags |= VLC_FTATLAS_OUTLINE;
+    outline_key.radius = FONT_SIZE << 3;
+
+    for (size_t i = 0; i < ARRAY_SIZE(pens); i++)
+        for (size_t j = 0; j < ARRAY_SIZE(shadows); j++)
+        {
+            FT_Vector pen = {
+                .x = pens[i].x + shadows[j][0] * (FONT_SIZE << 6),
+                .y = pens[i].y + shadows[j][1] * (FONT_SIZE << 6),
+            };
+
+            check(atlas, key, glyph, &pen);
+            check(atlas, &outline_key, stroked, &pen);
+        }
+
+    FT_Done_Glyph(stroked);
+}
+
+static void test(FT_Face face, FT_Stroker stroker, unsigned maxpages)
+{
+    vlc_ftatlas_t *atlas = vlc_ftatlas_New(NULL, maxpages);
+    assert(atlas != NULL);
+
+    const vlc_face_id_t faceid = { 0 };
+    vlc_ftatlas_key_t key = {
+        .faceid = &faceid,
+        .metrics = { .width_px = FONT_SIZE, .height_px = FONT_SIZE },
+    };
+
+    for (const char *c = chars; *c; c++)
+    {
+        key.index = FT_Get_Char_Index(face, (unsigned char) *c);
+        assert(key.index != 0);
+
+        int ret = FT_Load_Glyph(face, key.index, FT_LOAD_NO_BITMAP);
+        assert(ret == 0);
+
+        FT_Glyph glyph;
+        ret = FT_Get_Glyph(face->glyph, &glyph);
+        assert(ret == 0);
+        assert(glyph->format == FT_GLYPH_FORMAT_OUTLINE);
+
+        key.flags = 0;
+        check_glyph(atlas, stroker, &key, glyph);
+
+        /* Synthetic bold, as text_layout.c does it */
+        FT_Outline_Embolden(&((FT_OutlineGlyph) glyph)->outline, 1 << 6);
+        key.flags = VLC_FTATLAS_EMBOLDEN;
+        check_glyph(atlas, stroker, &key, glyph);
+
+        FT_Done_Glyph(glyph);
+    }
+
+    vlc_ftatlas_Delete(atlas);
+}
+
+int main(void)
+{
+    FT_Library lib;
+    FT_Face face;
+    FT_Stroker stroker;
+
+    int ret = FT_Init_FreeType(&lib);
+    assert(ret == 0);
+    ret = FT_New_Face(lib, FONT_DIR "/FreeSans.ttf", 0, &face);
+    if (ret)
+    {
+        fprintf(stderr, "cannot open %s, skipping\n", FONT_DIR "/FreeSans.ttf");
+        FT_Done_FreeType(lib);
+        return 77;
+    }
+    ret = FT_Set_Pixel_Sizes(face, FONT_SIZE, FONT_SIZE);
+    assert(ret == 0);
+    ret = FT_Stroker_New(lib, &stroker);
+    assert(ret == 0);
+    FT_Stroker_Set(stroker, FONT_SIZE << 3, FT_STROKER_LINECAP_ROUND,
+                   FT_STROKER_LINEJOIN_ROUND, 0);
+
+    /* With a large budget, and with the atlas flushed at every glyph */
+    test(face, stroker, 16);
+    test(face, stroker, 0);
+
+    FT_Stroker_Done(stroker);
+    FT_Done_Face(face);
+    FT_Done_FreeType(lib);
+    return 0;
+}
@@ -50,6 +50,9 @@
 #include "blend/rgb.h"
 #include "blend/yuv.h"
 
+/* Rasterized glyphs atlas budget, in 1 MiB pages */
+#define FT_ATLAS_MAX_PAGES 4
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
@@ -1231,6 +1234,10 @@ static int Create( filter_t *p_filter )
     if( !p_sys->ftcache )
         goto error;
 
+    p_sys->atlas = vlc_ftatlas_New( VLC_OBJECT(p_filter), FT_ATLAS_MAX_PAGES );
+    if( !p_sys->atlas )
+        goto error;
+
     p_sys->i_scale = 100;
 
     /* default style to apply to incomplete segments styles */
@@ -1297,6 +1304,9 @@ static void Destroy( filter_t *p_filter )
         DumpFamilies( p_sys->fs );
 #endif
 
+    if( p_sys->atlas )
+        vlc_ftatlas_Delete( p_sys->atlas );
+
     if( p_sys->ftcache )
         vlc_ftcache_Delete( p_sys->ftcache );
 
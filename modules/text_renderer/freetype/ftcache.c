@@ -45,6 +45,8 @@ struct vlc_ftcache_t
     FTC_CMapCache     charmap_cache;
     /* Derived glyph cache */
     vlc_lru *         glyphs_lrucache;
+    /* Shaped runs cache */
+    vlc_lru *         shaped_lrucache;
     /* current face properties */
     FT_Long           style_flags;
 };
@@ -187,6 +189,12 @@ static void LRUGlyphRefRelease( void *priv, void *v )
     }
 }
 
+static void LRUShapedRunRelease( void *priv, void *v )
+{
+    VLC_UNUSED(priv);
+    vlc_ftcache_ShapedRun_Release( v );
+}
+
 static void FreeFaceID( void *p_faceid, void *p_obj )
 {
     VLC_UNUSED(p_obj);
@@ -200,6 +208,9 @@ void vlc_ftcache_Delete( vlc_ftcache_t *ftcache )
     if( ftcache->glyphs_lrucache )
         vlc_lru_Release( ftcache->glyphs_lrucache );
 
+    if( ftcache->shaped_lrucache )
+        vlc_lru_Release( ftcache->shaped_lrucache );
+
     if( ftcache->cachemanager )
         FTC_Manager_Done( ftcache->cachemanager );
 
@@ -221,8 +232,9 @@ vlc_ftcache_t * vlc_ftcache_New( vlc_object_t *obj, FT_Library p_library,
     vlc_dictionary_init( &ftcache->face_ids, 50 );
 
     ftcache->glyphs_lrucache = vlc_lru_New( 128, LRUGlyphRefRelease, ftcache );
+    ftcache->shaped_lrucache = vlc_lru_New( 256, LRUShapedRunRelease, ftcache );
 
-    if(!ftcache->glyphs_lrucache ||
+    if(!ftcache->glyphs_lrucache || !ftcache->shaped_lrucache ||
        FTC_Manager_New( p_library, 4, 8, maxkb << 10,
                         RequestFace, ftcache, &ftcache->cachemanager ) ||
        FTC_ImageCache_New( ftcache->cachemanager, &ftcache->image_cache ) ||
@@ -339,3 +351,38 @@ FT_Glyph vlc_ftcache_GetOutlinedGlyph( vlc_ftcache_t *ftcache, const vlc_face_id
     free( psz_key );
     return glyph;
 }
+
+vlc_ftcache_shaped_run_t * vlc_ftcache_ShapedRun_New( unsigned count )
+{
+    vlc_ftcache_shaped_run_t *run = malloc( sizeof(*run) + count * sizeof(*run->p_glyphs) );
+    if( run )
+    {
+        run->refcount = 1;
+        run->count = count;
+        run->p_glyphs = (vlc_ftcache_shaped_glyph_t *) &run[1];
+    }
+    return run;
+}
+
+void vlc_ftcache_ShapedRun_Release( vlc_ftcache_shaped_run_t *run )
+{
+    assert(run->refcount);
+    if( --run->refcount == 0 )
+        free( run );
+}
+
+vlc_ftcache_shaped_run_t * vlc_ftcache_GetShapedRun( vlc_ftcache_t *ftcache, const char *psz_key )
+{
+    vlc_ftcache_shaped_run_t *run = vlc_lru_Get( ftcache->shaped_lrucache, psz_key );
+    if( run )
+        run->refcount++;
+    return run;
+}
+
+void vlc_ftcache_AddShapedRun( vlc_ftcache_t *ftcache, const char *psz_key,
+                               vlc_ftcache_shaped_run_t *run )
+{
+    assert(!vlc_lru_Get( ftcache->shaped_lrucache, psz_key ));
+    run->refcount++;
+    vlc_lru_Insert( ftcache->shaped_lrucache, psz_key, run );
+}
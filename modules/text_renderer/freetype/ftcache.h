@@ -85,6 +85,34 @@ FT_Glyph vlc_ftcache_GetOutlinedGlyph( vlc_ftcache_t *ftcache, const vlc_face_id
 void vlc_ftcache_Custom_Glyph_Init( vlc_ftcache_custom_glyph_t * );
 void vlc_ftcache_Custom_Glyph_Release( vlc_ftcache_custom_glyph_t * );
 
+/* Shaped runs cache. Glyphs are stored in the shaper output order,
+ * with clusters relative to the start of the run. */
+typedef struct
+{
+    FT_UInt  index;
+    unsigned cluster;
+    int      x_offset;
+    int      y_offset;
+    int      x_advance;
+    int      y_advance;
+} vlc_ftcache_shaped_glyph_t;
+
+typedef struct
+{
+    unsigned refcount;
+    unsigned count;
+    vlc_ftcache_shaped_glyph_t *p_glyphs;
+} vlc_ftcache_shaped_run_t;
+
+vlc_ftcache_shaped_run_t * vlc_ftcache_ShapedRun_New( unsigned count );
+void vlc_ftcache_ShapedRun_Release( vlc_ftcache_shaped_run_t * );
+
+/* Returns a new reference to the cached run, or NULL */
+vlc_ftcache_shaped_run_t * vlc_ftcache_GetShapedRun( vlc_ftcache_t *, const char *psz_key );
+/* Adds a reference to the run to the cache */
+void vlc_ftcache_AddShapedRun( vlc_ftcache_t *, const char *psz_key,
+                               vlc_ftcache_shaped_run_t * );
+
 #ifdef __cplusplus
 }
 #endif
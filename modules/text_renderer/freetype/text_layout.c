@@ -41,6 +41,7 @@
 #include <vlc_common.h>
 #include <vlc_filter.h>
 #include <vlc_text_style.h>
+#include <vlc_memstream.h>
 
 /* Freetype */
 #include <ft2build.h>
@@ -107,7 +108,7 @@ typedef struct run_desc_t
 #ifdef HAVE_HARFBUZZ
     hb_script_t                 script;
     hb_direction_t              direction;
-    hb_buffer_t                *p_buffer;
+    vlc_ftcache_shaped_run_t   *p_shaped;
 #endif
 
 } run_desc_t;
@@ -120,6 +121,7 @@ typedef struct glyph_bitmaps_t
     vlc_ftcache_glyph_t cglyph;
     vlc_ftcache_custom_glyph_t coutline;
     FT_Glyph p_shadow;
+    vlc_ftatlas_key_t key;
     FT_BBox  glyph_bbox;
     FT_BBox  outline_bbox;
     FT_BBox  shadow_bbox;
@@ -164,11 +166,11 @@ static void FreeLine( line_desc_t *p_line )
     for( int i = 0; i < p_line->i_character_count; i++ )
     {
         line_character_t *ch = &p_line->p_character[i];
-        FT_Done_Glyph( (FT_Glyph)ch->p_glyph );
+        vlc_ftatlas_ReleaseGlyph( ch->p_glyph );
         if( ch->p_outline )
-            FT_Done_Glyph( (FT_Glyph)ch->p_outline );
-        if( ch->p_shadow && ch->p_shadow != ch->p_glyph )
-            FT_Done_Glyph( (FT_Glyph)ch->p_shadow );
+            vlc_ftatlas_ReleaseGlyph( ch->p_outline );
+        if( ch->p_shadow )
+            vlc_ftatlas_ReleaseGlyph( ch->p_shadow );
     }
 
 //    if( p_line->p_ruby )
@@ -686,6 +688,142 @@ static int ItemizeParagraph( filter_t *p_filter, paragraph_t *p_paragraph )
  * Glyph substitutions of base glyphs and diacritics may take place,
  * so the paragraph size may change.
  */
+/**
+ * Returns the shaped runs cache key of a run, or NULL if it can't be cached.
+ * Code points are encoded as UTF-8, with NUL over two bytes.
+ */
+static char *ShapedRunKey( const run_desc_t *p_run,
+                           const vlc_ftcache_metrics_t *p_metrics,
+                           const uni_char_t *p_code_points )
+{
+    struct vlc_memstream stream;
+    if( vlc_memstream_open( &stream ) )
+        return NULL;
+
+    vlc_memstream_printf( &stream, "%p#%d,%d#%d#%"PRIx32"#",
+                          (void *) p_run->p_faceid,
+                          p_metrics->width_px, p_metrics->height_px,
+                          (int) p_run->direction, (uint32_t) p_run->script );
+
+    for( int i = p_run->i_start_offset; i < p_run->i_end_offset; ++i )
+    {
+        const uni_char_t c = p_code_points[ i ];
+        unsigned char buf[4];
+        size_t i_len;
+        if( c == 0 )
+        {
+            buf[0] = 0xC0;
+            buf[1] = 0x80;
+            i_len = 2;
+        }
+        else if( c < 0x80 )
+        {
+            buf[0] = c;
+            i_len = 1;
+        }
+        else if( c < 0x800 )
+        {
+            buf[0] = 0xC0 | (c >> 6);
+            buf[1] = 0x80 | (c & 0x3F);
+            i_len = 2;
+        }
+        else if( c < 0x10000 )
+        {
+            buf[0] = 0xE0 | (c >> 12);
+            buf[1] = 0x80 | ((c >> 6) & 0x3F);
+            buf[2] = 0x80 | (c & 0x3F);
+            i_len = 3;
+        }
+        else if( c < 0x110000 )
+        {
+            buf[0] = 0xF0 | (c >> 18);
+            buf[1] = 0x80 | ((c >> 12) & 0x3F);
+            buf[2] = 0x80 | ((c >> 6) & 0x3F);
+            buf[3] = 0x80 | (c & 0x3F);
+            i_len = 4;
+        }
+        else
+        {
+            if( !vlc_memstream_close( &stream ) )
+                free( stream.ptr );
+            return NULL;
+        }
+        vlc_memstream_write( &stream, buf, i_len );
+    }
+
+    if( vlc_memstream_close( &stream ) )
+        return NULL;
+    return stream.ptr;
+}
+
+static vlc_ftcache_shaped_run_t *ShapeRunHarfBuzz( filter_t *p_filter,
+                                                   const run_desc_t *p_run,
+                                                   const vlc_ftcache_metrics_t *p_metrics,
+                                                   const uni_char_t *p_code_points )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    FT_Face p_face = vlc_ftcache_LoadFaceByID( p_sys->ftcache, p_run->p_faceid, p_metrics );
+    if(!p_face)
+        return NULL;
+
+    hb_font_t *p_hb_font = hb_ft_font_create( p_face, 0 );
+    if( !p_hb_font )
+    {
+        msg_Err( p_filter,
+                 "ShapeRunHarfBuzz(): hb_ft_font_create() error" );
+        return NULL;
+    }
+
+    hb_buffer_t *p_buffer = hb_buffer_create();
+    if( !p_buffer )
+    {
+        msg_Err( p_filter,
+                 "ShapeRunHarfBuzz(): hb_buffer_create() error" );
+        hb_font_destroy( p_hb_font );
+        return NULL;
+    }
+
+    hb_buffer_set_direction( p_buffer, p_run->direction );
+    hb_buffer_set_script( p_buffer, p_run->script );
+    hb_buffer_add_utf32( p_buffer,
+                         p_code_points + p_run->i_start_offset,
+                         p_run->i_end_offset - p_run->i_start_offset, 0,
+                         p_run->i_end_offset - p_run->i_start_offset );
+    hb_shape( p_hb_font, p_buffer, 0, 0 );
+
+    hb_font_destroy( p_hb_font );
+
+    unsigned int i_glyph_count;
+    const hb_glyph_info_t *p_infos =
+            hb_buffer_get_glyph_infos( p_buffer, &i_glyph_count );
+    const hb_glyph_position_t *p_positions =
+            hb_buffer_get_glyph_positions( p_buffer, &i_glyph_count );
+    if( i_glyph_count == 0 )
+    {
+        msg_Err( p_filter,
+                 "ShapeRunHarfBuzz() invalid glyph count in shaped run" );
+        hb_buffer_destroy( p_buffer );
+        return NULL;
+    }
+
+    vlc_ftcache_shaped_run_t *p_shaped = vlc_ftcache_ShapedRun_New( i_glyph_count );
+    if( p_shaped )
+    {
+        for( unsigned int i = 0; i < i_glyph_count; ++i )
+        {
+            vlc_ftcache_shaped_glyph_t *p_glyph = &p_shaped->p_glyphs[ i ];
+            p_glyph->index = p_infos[ i ].codepoint;
+            p_glyph->cluster = p_infos[ i ].cluster;
+            p_glyph->x_offset = p_positions[ i ].x_offset;
+            p_glyph->y_offset = p_positions[ i ].y_offset;
+            p_glyph->x_advance = p_positions[ i ].x_advance;
+            p_glyph->y_advance = p_positions[ i ].y_advance;
+        }
+    }
+    hb_buffer_destroy( p_buffer );
+    return p_shaped;
+}
+
 static int ShapeParagraphHarfBuzz( filter_t *p_filter,
                                    paragraph_t **p_old_paragraph )
 {
@@ -737,47 +875,21 @@ static int ShapeParagraphHarfBuzz( filter_t *p_filter,
         metrics.height_px = ConvertToLiveSize( p_filter, p_style );
         metrics.width_px = GetFontWidthForStyle( p_style, metrics.height_px );
 
-        FT_Face p_face = vlc_ftcache_LoadFaceByID( p_sys->ftcache, p_faceid, &metrics );
-        if(!p_face)
-            goto error;
-
-        hb_font_t *p_hb_font = hb_ft_font_create( p_face, 0 );
-        if( !p_hb_font )
+        char *psz_key = ShapedRunKey( p_run, &metrics, p_paragraph->p_code_points );
+        if( psz_key )
+            p_run->p_shaped = vlc_ftcache_GetShapedRun( p_sys->ftcache, psz_key );
+        if( !p_run->p_shaped )
         {
-            msg_Err( p_filter,
-                     "ShapeParagraphHarfBuzz(): hb_ft_font_create() error" );
-            goto error;
+            p_run->p_shaped = ShapeRunHarfBuzz( p_filter, p_run, &metrics,
+                                                p_paragraph->p_code_points );
+            if( p_run->p_shaped && psz_key )
+                vlc_ftcache_AddShapedRun( p_sys->ftcache, psz_key, p_run->p_shaped );
         }
-
-        p_run->p_buffer = hb_buffer_create();
-        if( !p_run->p_buffer )
-        {
-            msg_Err( p_filter,
-                     "ShapeParagraphHarfBuzz(): hb_buffer_create() error" );
-            hb_font_destroy( p_hb_font );
+        free( psz_key );
+        if( !p_run->p_shaped )
             goto error;
-        }
-
-        hb_buffer_set_direction( p_run->p_buffer, p_run->direction );
-        hb_buffer_set_script( p_run->p_buffer, p_run->script );
-        hb_buffer_add_utf32( p_run->p_buffer,
-                             p_paragraph->p_code_points + p_run->i_start_offset,
-                             p_run->i_end_offset - p_run->i_start_offset, 0,
-                             p_run->i_end_offset - p_run->i_start_offset );
-        hb_shape( p_hb_font, p_run->p_buffer, 0, 0 );
 
-        hb_font_destroy( p_hb_font );
-        p_hb_font = 0;
-
-        const unsigned length = hb_buffer_get_length( p_run->p_buffer );
-        if( length == 0 )
-        {
-            msg_Err( p_filter,
-                     "ShapeParagraphHarfBuzz() invalid glyph count in shaped run" );
-            goto error;
-        }
-
-        i_total_glyphs += length;
+        i_total_glyphs += p_run->p_shaped->count;
     }
 
     p_new_paragraph = NewParagraph( p_filter, i_total_glyphs,
@@ -800,11 +912,8 @@ static int ShapeParagraphHarfBuzz( filter_t *p_filter,
     for( int i = 0; i < p_paragraph->i_runs_count; ++i )
     {
         run_desc_t *p_run = p_paragraph->p_runs + i;
-        unsigned int i_glyph_count;
-        const hb_glyph_info_t *p_infos =
-                hb_buffer_get_glyph_infos( p_run->p_buffer, &i_glyph_count );;
-        const hb_glyph_position_t *p_positions =
-                hb_buffer_get_glyph_positions( p_run->p_buffer, &i_glyph_count );
+        const unsigned int i_glyph_count = p_run->p_shaped->count;
+        const vlc_ftcache_shaped_glyph_t *p_glyphs = p_run->p_shaped->p_glyphs;
         for( unsigned int j = 0; j < i_glyph_count; ++j )
         {
             /*
@@ -817,11 +926,11 @@ static int ShapeParagraphHarfBuzz( filter_t *p_filter,
             int i_run_index = p_run->direction == HB_DIRECTION_LTR ?
                     j : i_glyph_count - 1 - j;
             int i_source_index =
-                    p_infos[ i_run_index ].cluster + p_run->i_start_offset;
+                    p_glyphs[ i_run_index ].cluster + p_run->i_start_offset;
 
             p_new_paragraph->p_code_points[ i_index ] = 0;
             p_new_paragraph->pi_glyph_indices[ i_index ] =
-                p_infos[ i_run_index ].codepoint;
+                p_glyphs[ i_run_index ].index;
             p_new_paragraph->p_scripts[ i_index ] =
                 p_paragraph->p_scripts[ i_source_index ];
             p_new_paragraph->p_types[ i_index ] =
@@ -834,13 +943,13 @@ static int ShapeParagraphHarfBuzz( filter_t *p_filter,
                 p_new_paragraph->pp_ruby[ i_index ] =
                     p_paragraph->pp_ruby[ i_source_index ];
             p_new_paragraph->p_glyph_bitmaps[ i_index ].i_x_offset =
-                p_positions[ i_run_index ].x_offset;
+                p_glyphs[ i_run_index ].x_offset;
             p_new_paragraph->p_glyph_bitmaps[ i_index ].i_y_offset =
-                p_positions[ i_run_index ].y_offset;
+                p_glyphs[ i_run_index ].y_offset;
             p_new_paragraph->p_glyph_bitmaps[ i_index ].i_x_advance =
-                p_positions[ i_run_index ].x_advance;
+                p_glyphs[ i_run_index ].x_advance;
             p_new_paragraph->p_glyph_bitmaps[ i_index ].i_y_advance =
-                p_positions[ i_run_index ].y_advance;
+                p_glyphs[ i_run_index ].y_advance;
 
             ++i_index;
         }
@@ -851,7 +960,8 @@ static int ShapeParagraphHarfBuzz( filter_t *p_filter,
 
     for( int i = 0; i < p_paragraph->i_runs_count; ++i )
     {
-        hb_buffer_destroy( p_paragraph->p_runs[ i ].p_buffer );
+        vlc_ftcache_ShapedRun_Release( p_paragraph->p_runs[ i ].p_shaped );
+        p_paragraph->p_runs[ i ].p_shaped = NULL;
     }
     FreeParagraph( *p_old_paragraph );
     *p_old_paragraph = p_new_paragraph;
@@ -861,8 +971,11 @@ static int ShapeParagraphHarfBuzz( filter_t *p_filter,
 error:
     for( int i = 0; i < p_paragraph->i_runs_count; ++i )
     {
-        if( p_paragraph->p_runs[ i ].p_buffer )
-            hb_buffer_destroy( p_paragraph->p_runs[ i ].p_buffer );
+        if( p_paragraph->p_runs[ i ].p_shaped )
+        {
+            vlc_ftcache_ShapedRun_Release( p_paragraph->p_runs[ i ].p_shaped );
+            p_paragraph->p_runs[ i ].p_shaped = NULL;
+        }
     }
 
     if( p_new_paragraph )
@@ -966,6 +1079,7 @@ static void ReleaseGlyphBitMaps(filter_t *p_filter, glyph_bitmaps_t *p_bitmaps)
         p_bitmaps->p_shadow != p_bitmaps->cglyph.p_glyph &&
         p_bitmaps->p_shadow != p_bitmaps->coutline.p_glyph )
         FT_Done_Glyph( p_bitmaps->p_shadow );
+    p_bitmaps->p_shadow = NULL;
     vlc_ftcache_Custom_Glyph_Release( &p_bitmaps->coutline );
     vlc_ftcache_Glyph_Release( p_sys->ftcache, &p_bitmaps->cglyph );
 }
@@ -1099,6 +1213,12 @@ static int LoadGlyphs( filter_t *p_filter, paragraph_t *p_paragraph,
 
 #undef SKIP_GLYPH
 
+            p_bitmaps->key.faceid = p_run->p_faceid;
+            p_bitmaps->key.metrics = metrics;
+            p_bitmaps->key.index = i_glyph_index;
+            p_bitmaps->key.flags = 0;
+            p_bitmaps->key.radius = i_stroker_radius;
+
             const bool b_embolden = ( p_style->i_style_flags & STYLE_BOLD ) &&
                                    !( style_flags & FT_STYLE_FLAG_BOLD );
             const bool b_oblique = ( p_style->i_style_flags & STYLE_ITALIC ) &&
@@ -1121,6 +1241,10 @@ static int LoadGlyphs( filter_t *p_filter, paragraph_t *p_paragraph,
                         FT_Outline_Embolden( &((FT_OutlineGlyph)transformed)->outline, 1<<6 );
                     vlc_ftcache_Glyph_Release( p_sys->ftcache, &p_bitmaps->cglyph );
                     p_bitmaps->cglyph.p_glyph = transformed;
+                    if( b_embolden )
+                        p_bitmaps->key.flags |= VLC_FTATLAS_EMBOLDEN;
+                    if( b_oblique )
+                        p_bitmaps->key.flags |= VLC_FTATLAS_OBLIQUE;
                 }
             }
 
@@ -1244,57 +1368,54 @@ static int LayoutLine( filter_t *p_filter,
             .y = pen_new.y + p_sys->f_shadow_vector_y * ( metrics.height_px << 6 )
         };
 
-        /* Shadow being a reference to main glyph, it must be processed first */
-        if( p_bitmaps->p_shadow &&
-            FT_Glyph_To_Bitmap( &p_bitmaps->p_shadow, FT_RENDER_MODE_NORMAL,
-                                &pen_shadow, 0 ) )
-        {
-            p_bitmaps->p_shadow = 0;
-        }
+        /* Rasterizations are shared through the glyph atlas */
+        vlc_ftatlas_key_t key = p_bitmaps->key;
+        vlc_ftatlas_key_t outline_key = key;
+        key.radius = 0;
+        outline_key.flags |= VLC_FTATLAS_OUTLINE;
 
-        /* Ensure we don't release reference */
-        FT_Glyph bitmapglyph = p_bitmaps->cglyph.p_glyph;
-        if( FT_Glyph_To_Bitmap( &bitmapglyph,
-                                FT_RENDER_MODE_NORMAL,
-                                &pen_new, 0 ) )
+        FT_BitmapGlyph p_glyph =
+            vlc_ftatlas_GetGlyph( p_sys->atlas, &key, p_bitmaps->cglyph.p_glyph,
+                                  &pen_new );
+        if( !p_glyph )
         {
             ReleaseGlyphBitMaps( p_filter, p_bitmaps );
             continue;
         }
 
-        /* release the source glyph or reference */
-        vlc_ftcache_Glyph_Release( p_sys->ftcache, &p_bitmaps->cglyph );
-        p_bitmaps->cglyph.p_glyph = bitmapglyph;
-
+        FT_BitmapGlyph p_outline = NULL;
         if( p_bitmaps->coutline.p_glyph )
-        {
-            bitmapglyph = p_bitmaps->coutline.p_glyph;
-            if( FT_Glyph_To_Bitmap( &bitmapglyph,
-                                    FT_RENDER_MODE_NORMAL,
-                                    &pen_new, 0 ) )
-                bitmapglyph = NULL;
-            vlc_ftcache_Custom_Glyph_Release( &p_bitmaps->coutline );
-            p_bitmaps->coutline.p_glyph = bitmapglyph;
-        }
+            p_outline = vlc_ftatlas_GetGlyph( p_sys->atlas, &outline_key,
+                                              p_bitmaps->coutline.p_glyph, &pen_new );
+
+        /* The shadow is a reference to either the main or the outline glyph */
+        FT_BitmapGlyph p_shadow = NULL;
+        if( p_bitmaps->p_shadow )
+            p_shadow = vlc_ftatlas_GetGlyph( p_sys->atlas,
+                            p_bitmaps->p_shadow == p_bitmaps->coutline.p_glyph ?
+                            &outline_key : &key, p_bitmaps->p_shadow, &pen_shadow );
 
-        FT_Glyph_Get_CBox( p_bitmaps->cglyph.p_glyph, FT_GLYPH_BBOX_PIXELS,
+        /* release the source glyphs or references */
+        ReleaseGlyphBitMaps( p_filter, p_bitmaps );
+
+        FT_Glyph_Get_CBox( (FT_Glyph) p_glyph, FT_GLYPH_BBOX_PIXELS,
                            &p_bitmaps->glyph_bbox );
-        FixGlyph( p_bitmaps->cglyph.p_glyph, &p_bitmaps->glyph_bbox,
+        FixGlyph( (FT_Glyph) p_glyph, &p_bitmaps->glyph_bbox,
                   p_bitmaps->i_x_advance, p_bitmaps->i_y_advance,
                   &pen_new );
-        if( p_bitmaps->coutline.p_glyph )
+        if( p_outline )
         {
-            FT_Glyph_Get_CBox( p_bitmaps->coutline.p_glyph, FT_GLYPH_BBOX_PIXELS,
+            FT_Glyph_Get_CBox( (FT_Glyph) p_outline, FT_GLYPH_BBOX_PIXELS,
                                &p_bitmaps->outline_bbox );
-            FixGlyph( p_bitmaps->coutline.p_glyph, &p_bitmaps->outline_bbox,
+            FixGlyph( (FT_Glyph) p_outline, &p_bitmaps->outline_bbox,
                       p_bitmaps->i_x_advance, p_bitmaps->i_y_advance,
                       &pen_new );
         }
-        if( p_bitmaps->p_shadow )
+        if( p_shadow )
         {
-            FT_Glyph_Get_CBox( p_bitmaps->p_shadow, FT_GLYPH_BBOX_PIXELS,
+            FT_Glyph_Get_CBox( (FT_Glyph) p_shadow, FT_GLYPH_BBOX_PIXELS,
                                &p_bitmaps->shadow_bbox );
-            FixGlyph( p_bitmaps->p_shadow, &p_bitmaps->shadow_bbox,
+            FixGlyph( (FT_Glyph) p_shadow, &p_bitmaps->shadow_bbox,
                       p_bitmaps->i_x_advance, p_bitmaps->i_y_advance,
                       &pen_shadow );
         }
@@ -1341,18 +1462,18 @@ static int LayoutLine( filter_t *p_filter,
             }
         }
 
-        p_ch->p_glyph = ( FT_BitmapGlyph ) p_bitmaps->cglyph.p_glyph;
-        p_ch->p_outline = ( FT_BitmapGlyph ) p_bitmaps->coutline.p_glyph;
-        p_ch->p_shadow = ( FT_BitmapGlyph ) p_bitmaps->p_shadow;
+        p_ch->p_glyph = p_glyph;
+        p_ch->p_outline = p_outline;
+        p_ch->p_shadow = p_shadow;
 
         p_ch->i_line_thickness = i_line_thickness;
         p_ch->i_line_offset = i_line_offset;
 
         /* Compute bounding box for all glyphs */
         p_ch->bbox = p_bitmaps->glyph_bbox;
-        if( p_bitmaps->coutline.p_glyph )
+        if( p_outline )
             BBoxEnlarge( &p_ch->bbox, &p_bitmaps->outline_bbox );
-        if( p_bitmaps->p_shadow )
+        if( p_shadow )
             BBoxEnlarge( &p_ch->bbox, &p_bitmaps->shadow_bbox );
 
         BBoxEnlarge( &p_line->bbox, &p_ch->bbox );
@@ -121,7 +121,23 @@ void CopyCleanCache(copy_cache_t *cache)
 #define COPY64(dstp, srcp, load, store) \
     COPY64_S(dstp, srcp, load, store, "")
 
+#if defined (COPY_TEST) && !defined (COPY_TEST_NOOPTIM)
+/* Capabilities used by the tests, to check every code path */
+static unsigned copy_test_cpu = ~0u;
+# define COPY_TEST_CPU(cap) ((vlc_CPU() & copy_test_cpu & VLC_CPU_##cap) != 0)
+# undef vlc_CPU_AVX2
+# define vlc_CPU_AVX2() COPY_TEST_CPU(AVX2)
+# undef vlc_CPU_SSE4_1
+# define vlc_CPU_SSE4_1() COPY_TEST_CPU(SSE4_1)
+# undef vlc_CPU_SSSE3
+# define vlc_CPU_SSSE3() COPY_TEST_CPU(SSSE3)
+# undef vlc_CPU_SSE2
+# define vlc_CPU_SSE2() COPY_TEST_CPU(SSE2)
+#endif
+
 #ifdef COPY_TEST_NOOPTIM
+# undef vlc_CPU_AVX2
+# define vlc_CPU_AVX2() (0)
 # undef vlc_CPU_SSE4_1
 # define vlc_CPU_SSE4_1() (0)
 # undef vlc_CPU_SSE3
@@ -606,6 +622,425 @@ static void SSE_Copy420_P_to_SP(picture_t *dst, const uint8_t *src[static 3],
                          src[V_PLANE], src_pitch[V_PLANE],
                          cache->buffer, cache->size, (height+1) / 2, pixel_size, bitshift);
 }
+#ifdef CAN_COMPILE_AVX2
+/* Copy 32/128 bytes from srcp to dstp loading data with the AVX2 instruction
+ * load and storing data with the AVX2 instruction store.
+ */
+
+#define COPY32_SHIFTR(x) \
+    "vpsrlw "x", %%ymm1, %%ymm1\n"
+#define COPY32_SHIFTL(x) \
+    "vpsllw "x", %%ymm1, %%ymm1\n"
+
+#define COPY32_S(dstp, srcp, load, store, shiftstr) \
+    asm volatile (                      \
+        load "  0(%[src]), %%ymm1\n"    \
+        shiftstr                        \
+        store " %%ymm1,    0(%[dst])\n" \
+        : : [dst]"r"(dstp), [src]"r"(srcp) : "memory", "xmm1")
+
+#define COPY128_SHIFTR(x) \
+    "vpsrlw "x", %%ymm1, %%ymm1\n" \
+    "vpsrlw "x", %%ymm2, %%ymm2\n" \
+    "vpsrlw "x", %%ymm3, %%ymm3\n" \
+    "vpsrlw "x", %%ymm4, %%ymm4\n"
+#define COPY128_SHIFTL(x) \
+    "vpsllw "x", %%ymm1, %%ymm1\n" \
+    "vpsllw "x", %%ymm2, %%ymm2\n" \
+    "vpsllw "x", %%ymm3, %%ymm3\n" \
+    "vpsllw "x", %%ymm4, %%ymm4\n"
+
+#define COPY128_S(dstp, srcp, load, store, shiftstr) \
+    asm volatile (                      \
+        load "  0(%[src]), %%ymm1\n"    \
+        load " 32(%[src]), %%ymm2\n"    \
+        load " 64(%[src]), %%ymm3\n"    \
+        load " 96(%[src]), %%ymm4\n"    \
+        shiftstr                        \
+        store " %%ymm1,    0(%[dst])\n" \
+        store " %%ymm2,   32(%[dst])\n" \
+        store " %%ymm3,   64(%[dst])\n" \
+        store " %%ymm4,   96(%[dst])\n" \
+        : : [dst]"r"(dstp), [src]"r"(srcp) : "memory", "xmm1", "xmm2", "xmm3", "xmm4")
+
+#define COPY128(dstp, srcp, load, store) \
+    COPY128_S(dstp, srcp, load, store, "")
+
+/* Planes larger than this are written with non-temporal stores: they would
+ * evict most of the cache before being read back by the next filter. */
+#define AVX2_NT_THRESHOLD (1 << 20)
+
+VLC_AVX
+static void AVX2_CopyFromUswc(uint8_t *dst, size_t dst_pitch,
+                              const uint8_t *src, size_t src_pitch,
+                              unsigned width, unsigned height, int bitshift)
+{
+    assert(((intptr_t)dst & 0x1f) == 0 && (dst_pitch & 0x1f) == 0);
+
+    asm volatile ("mfence");
+
+#define AVX2_USWC_COPY(shiftstr32, shiftstr128) \
+    for (unsigned y = 0; y < height; y++) { \
+        const unsigned unaligned = (-(uintptr_t)src) & 0x1f; \
+        unsigned x = 0; \
+        if (width >= 128) { \
+            x = unaligned; \
+            if (!unaligned) { \
+                for (; x+127 < width; x += 128) \
+                    COPY128_S(&dst[x], &src[x], "vmovntdqa", "vmovdqa", shiftstr128); \
+            } else { \
+                COPY32_S(dst, src, "vmovdqu", "vmovdqa", shiftstr32); \
+                for (; x+127 < width; x += 128) \
+                    COPY128_S(&dst[x], &src[x], "vmovntdqa", "vmovdqu", shiftstr128); \
+            } \
+        } \
+        if (x < width) \
+            CopyPlane(&dst[x], dst_pitch - x, &src[x], src_pitch - x, 1, bitshift); \
+        src += src_pitch; \
+        dst += dst_pitch; \
+    }
+
+    switch (bitshift)
+    {
+        case 0:
+            AVX2_USWC_COPY("", "")
+            break;
+        case -6:
+            AVX2_USWC_COPY(COPY32_SHIFTL("$6"), COPY128_SHIFTL("$6"))
+            break;
+        case 6:
+            AVX2_USWC_COPY(COPY32_SHIFTR("$6"), COPY128_SHIFTR("$6"))
+            break;
+        case 2:
+            AVX2_USWC_COPY(COPY32_SHIFTR("$2"), COPY128_SHIFTR("$2"))
+            break;
+        case -2:
+            AVX2_USWC_COPY(COPY32_SHIFTL("$2"), COPY128_SHIFTL("$2"))
+            break;
+        case 4:
+            AVX2_USWC_COPY(COPY32_SHIFTR("$4"), COPY128_SHIFTR("$4"))
+            break;
+        case -4:
+            AVX2_USWC_COPY(COPY32_SHIFTL("$4"), COPY128_SHIFTL("$4"))
+            break;
+        default:
+            vlc_assert_unreachable();
+    }
+#undef AVX2_USWC_COPY
+
+    asm volatile ("mfence\n"
+                  "vzeroupper");
+}
+
+VLC_AVX
+static void AVX2_Copy2d(uint8_t *dst, size_t dst_pitch,
+                        const uint8_t *src, size_t src_pitch,
+                        unsigned width, unsigned height, bool nt)
+{
+    assert(((intptr_t)src & 0x1f) == 0 && (src_pitch & 0x1f) == 0);
+
+    for (unsigned y = 0; y < height; y++) {
+        unsigned x = 0;
+
+        bool unaligned = ((intptr_t)dst & 0x1f) != 0;
+        if (nt && !unaligned) {
+            for (; x+127 < width; x += 128)
+                COPY128(&dst[x], &src[x], "vmovdqa", "vmovntdq");
+        } else {
+            for (; x+127 < width; x += 128)
+                COPY128(&dst[x], &src[x], "vmovdqa", "vmovdqu");
+        }
+
+        for (; x < width; x++)
+            dst[x] = src[x];
+
+        src += src_pitch;
+        dst += dst_pitch;
+    }
+
+    if (nt)
+        asm volatile ("sfence");
+    asm volatile ("vzeroupper");
+}
+
+VLC_AVX
+static void
+AVX2_InterleaveUV(uint8_t *dst, size_t dst_pitch,
+                  uint8_t *srcu, size_t srcu_pitch,
+                  uint8_t *srcv, size_t srcv_pitch,
+                  unsigned int width, unsigned int height, uint8_t pixel_size)
+{
+    assert(!((intptr_t)srcu & 0x1f) && !(srcu_pitch & 0x1f) &&
+           !((intptr_t)srcv & 0x1f) && !(srcv_pitch & 0x1f));
+
+    /* The unpack instructions work within each 128-bits lane: the halves
+     * are put back in order with vperm2i128. */
+#define LOAD2X32                            \
+    "vmovdqa   (%[src1]), %%ymm0\n"         \
+    "vmovdqa   (%[src2]), %%ymm1\n"
+
+#define STORE64                             \
+    "vperm2i128 $0x20, %%ymm3, %%ymm2, %%ymm0\n" \
+    "vperm2i128 $0x31, %%ymm3, %%ymm2, %%ymm1\n" \
+    "vmovdqu   %%ymm0, 0x00(%[dst])\n"      \
+    "vmovdqu   %%ymm1, 0x20(%[dst])\n"
+
+    for (unsigned int y = 0; y < height; ++y)
+    {
+        unsigned int    x;
+
+        if (pixel_size == 1)
+            for (x = 0; x < (width & ~31); x += 32)
+                asm volatile
+                    (
+                        LOAD2X32
+                        "vpunpcklbw %%ymm1, %%ymm0, %%ymm2\n"
+                        "vpunpckhbw %%ymm1, %%ymm0, %%ymm3\n"
+                        STORE64
+                        : : [dst]"r"(dst+2*x),
+                            [src1]"r"(srcu+x), [src2]"r"(srcv+x)
+                        : "memory", "xmm0", "xmm1", "xmm2", "xmm3"
+                    );
+        else
+            for (x = 0; x < (width & ~31); x += 32)
+                asm volatile
+                    (
+                        LOAD2X32
+                        "vpunpcklwd %%ymm1, %%ymm0, %%ymm2\n"
+                        "vpunpckhwd %%ymm1, %%ymm0, %%ymm3\n"
+                        STORE64
+                        : : [dst]"r"(dst+2*x),
+                            [src1]"r"(srcu+x), [src2]"r"(srcv+x)
+                        : "memory", "xmm0", "xmm1", "xmm2", "xmm3"
+                    );
+#undef LOAD2X32
+#undef STORE64
+
+        if (pixel_size == 1)
+        {
+            for (; x < width; x++) {
+                dst[2*x+0] = srcu[x];
+                dst[2*x+1] = srcv[x];
+            }
+        }
+        else
+        {
+            for (; x < width; x+= 2) {
+                dst[2*x+0] = srcu[x];
+                dst[2*x+1] = srcu[x + 1];
+                dst[2*x+2] = srcv[x];
+                dst[2*x+3] = srcv[x + 1];
+            }
+        }
+        srcu += srcu_pitch;
+        srcv += srcv_pitch;
+        dst += dst_pitch;
+    }
+    asm volatile ("vzeroupper");
+}
+
+VLC_AVX
+static void AVX2_SplitUV(uint8_t *dstu, size_t dstu_pitch,
+                         uint8_t *dstv, size_t dstv_pitch,
+                         const uint8_t *src, size_t src_pitch,
+                         unsigned width, unsigned height, uint8_t pixel_size)
+{
+    assert(pixel_size == 1 || pixel_size == 2);
+    assert(((intptr_t)src & 0x1f) == 0 && (src_pitch & 0x1f) == 0);
+
+    static const uint8_t shuffle_8[] = { 0, 2, 4, 6, 8, 10, 12, 14,
+                                         1, 3, 5, 7, 9, 11, 13, 15 };
+    static const uint8_t shuffle_16[] = {  0,  1,  4,  5,  8,  9, 12, 13,
+                                           2,  3,  6,  7, 10, 11, 14, 15 };
+    const uint8_t *shuffle = pixel_size == 1 ? shuffle_8 : shuffle_16;
+
+    for (unsigned y = 0; y < height; y++) {
+        unsigned x = 0;
+        /* Each lane is split in its U and V halves, then the quadwords
+         * are gathered by plane */
+        for (; x < (width & ~31); x += 32) {
+            asm volatile (
+                "vbroadcasti128 (%[shuffle]), %%ymm7\n"
+                "vmovdqa  0(%[src]), %%ymm0\n"
+                "vmovdqa 32(%[src]), %%ymm1\n"
+                "vpshufb %%ymm7, %%ymm0, %%ymm0\n"
+                "vpshufb %%ymm7, %%ymm1, %%ymm1\n"
+                "vpermq  $0xd8, %%ymm0, %%ymm0\n"
+                "vpermq  $0xd8, %%ymm1, %%ymm1\n"
+                "vperm2i128 $0x20, %%ymm1, %%ymm0, %%ymm2\n"
+                "vperm2i128 $0x31, %%ymm1, %%ymm0, %%ymm3\n"
+                "vmovdqu %%ymm2, (%[dst1])\n"
+                "vmovdqu %%ymm3, (%[dst2])\n"
+                : : [dst1]"r"(&dstu[x]), [dst2]"r"(&dstv[x]), [src]"r"(&src[2*x]), [shuffle]"r"(shuffle) : "memory", "xmm0", "xmm1", "xmm2", "xmm3", "xmm7");
+        }
+        if (pixel_size == 1)
+        {
+            for (; x < width; x++) {
+                dstu[x] = src[2*x+0];
+                dstv[x] = src[2*x+1];
+            }
+        }
+        else
+        {
+            for (; x < width; x+= 2) {
+                dstu[x] = src[2*x+0];
+                dstu[x+1] = src[2*x+1];
+                dstv[x] = src[2*x+2];
+                dstv[x+1] = src[2*x+3];
+            }
+        }
+        src  += src_pitch;
+        dstu += dstu_pitch;
+        dstv += dstv_pitch;
+    }
+    asm volatile ("vzeroupper");
+}
+
+static void AVX2_CopyPlane(uint8_t *dst, size_t dst_pitch,
+                           const uint8_t *src, size_t src_pitch,
+                           uint8_t *cache, size_t cache_size,
+                           unsigned height, int bitshift)
+{
+    const size_t copy_pitch = __MIN(src_pitch, dst_pitch);
+    assert(copy_pitch > 0);
+    const unsigned w32 = (copy_pitch+31) & ~31;
+    const unsigned hstep = cache_size / w32;
+    const unsigned cache_width = __MIN(src_pitch, cache_size);
+    const bool nt = copy_pitch * height >= AVX2_NT_THRESHOLD;
+    assert(hstep > 0);
+
+    for (unsigned y = 0; y < height; y += hstep) {
+        const unsigned hblock =  __MIN(hstep, height - y);
+
+        /* Copy a bunch of line into our cache */
+        AVX2_CopyFromUswc(cache, w32, src, src_pitch, cache_width, hblock, bitshift);
+
+        /* Copy from our cache to the destination */
+        AVX2_Copy2d(dst, dst_pitch, cache, w32, copy_pitch, hblock, nt);
+
+        /* */
+        src += src_pitch * hblock;
+        dst += dst_pitch * hblock;
+    }
+}
+
+static void
+AVX2_InterleavePlanes(uint8_t *dst, size_t dst_pitch,
+                      const uint8_t *srcu, size_t srcu_pitch,
+                      const uint8_t *srcv, size_t srcv_pitch,
+                      uint8_t *cache, size_t cache_size,
+                      unsigned int height, uint8_t pixel_size, int bitshift)
+{
+    assert(srcu_pitch == srcv_pitch);
+    size_t copy_pitch = __MIN(dst_pitch / 2, srcu_pitch);
+    unsigned int const  w32 = (srcu_pitch+31) & ~31;
+    unsigned int const  hstep = (cache_size) / (2*w32);
+    const unsigned cacheu_width = __MIN(srcu_pitch, cache_size);
+    const unsigned cachev_width = __MIN(srcv_pitch, cache_size);
+    assert(hstep > 0);
+
+    for (unsigned int y = 0; y < height; y += hstep)
+    {
+        unsigned int const      hblock = __MIN(hstep, height - y);
+
+        /* Copy a bunch of line into our cache */
+        AVX2_CopyFromUswc(cache, w32, srcu, srcu_pitch, cacheu_width, hblock, bitshift);
+        AVX2_CopyFromUswc(cache+w32*hblock, w32, srcv, srcv_pitch,
+                          cachev_width, hblock, bitshift);
+
+        /* Copy from our cache to the destination */
+        AVX2_InterleaveUV(dst, dst_pitch, cache, w32,
+                          cache + w32 * hblock, w32,
+                          copy_pitch, hblock, pixel_size);
+
+        /* */
+        srcu += hblock * srcu_pitch;
+        srcv += hblock * srcv_pitch;
+        dst += hblock * dst_pitch;
+    }
+}
+
+static void AVX2_SplitPlanes(uint8_t *dstu, size_t dstu_pitch,
+                             uint8_t *dstv, size_t dstv_pitch,
+                             const uint8_t *src, size_t src_pitch,
+                             uint8_t *cache, size_t cache_size,
+                             unsigned height, uint8_t pixel_size, int bitshift)
+{
+    size_t copy_pitch = __MIN(__MIN(src_pitch / 2, dstu_pitch), dstv_pitch);
+    const unsigned w32 = (src_pitch+31) & ~31;
+    const unsigned hstep = cache_size / w32;
+    const unsigned cache_width = __MIN(src_pitch, cache_size);
+    assert(hstep > 0);
+
+    for (unsigned y = 0; y < height; y += hstep) {
+        const unsigned hblock =  __MIN(hstep, height - y);
+
+        /* Copy a bunch of line into our cache */
+        AVX2_CopyFromUswc(cache, w32, src, src_pitch, cache_width, hblock, bitshift);
+
+        /* Copy from our cache to the destination */
+        AVX2_SplitUV(dstu, dstu_pitch, dstv, dstv_pitch,
+                     cache, w32, copy_pitch, hblock, pixel_size);
+
+        /* */
+        src  += src_pitch  * hblock;
+        dstu += dstu_pitch * hblock;
+        dstv += dstv_pitch * hblock;
+    }
+}
+
+static void AVX2_Copy420_P_to_P(picture_t *dst, const uint8_t *src[static 3],
+                                const size_t src_pitch[static 3], unsigned height,
+                                const copy_cache_t *cache)
+{
+    for (unsigned n = 0; n < 3; n++) {
+        const unsigned d = n > 0 ? 2 : 1;
+        AVX2_CopyPlane(dst->p[n].p_pixels, dst->p[n].i_pitch,
+                       src[n], src_pitch[n],
+                       cache->buffer, cache->size,
+                       (height+d-1)/d, 0);
+    }
+}
+
+static void AVX2_Copy420_SP_to_SP(picture_t *dst, const uint8_t *src[static 2],
+                                  const size_t src_pitch[static 2], unsigned height,
+                                  const copy_cache_t *cache)
+{
+    AVX2_CopyPlane(dst->p[0].p_pixels, dst->p[0].i_pitch, src[0], src_pitch[0],
+                   cache->buffer, cache->size, height, 0);
+    AVX2_CopyPlane(dst->p[1].p_pixels, dst->p[1].i_pitch, src[1], src_pitch[1],
+                   cache->buffer, cache->size, (height+1) / 2, 0);
+}
+
+static void
+AVX2_Copy420_SP_to_P(picture_t *dest, const uint8_t *src[static 2],
+                     const size_t src_pitch[static 2], unsigned int height,
+                     uint8_t pixel_size, int bitshift, const copy_cache_t *cache)
+{
+    AVX2_CopyPlane(dest->p[0].p_pixels, dest->p[0].i_pitch,
+                   src[0], src_pitch[0], cache->buffer, cache->size, height, bitshift);
+
+    AVX2_SplitPlanes(dest->p[1].p_pixels, dest->p[1].i_pitch,
+                     dest->p[2].p_pixels, dest->p[2].i_pitch,
+                     src[1], src_pitch[1], cache->buffer, cache->size,
+                     (height+1) / 2, pixel_size, bitshift);
+}
+
+static void AVX2_Copy420_P_to_SP(picture_t *dst, const uint8_t *src[static 3],
+                                 const size_t src_pitch[static 3],
+                                 unsigned height, uint8_t pixel_size,
+                                 int bitshift, const copy_cache_t *cache)
+{
+    AVX2_CopyPlane(dst->p[0].p_pixels, dst->p[0].i_pitch, src[0], src_pitch[0],
+                   cache->buffer, cache->size, height, bitshift);
+    AVX2_InterleavePlanes(dst->p[1].p_pixels, dst->p[1].i_pitch,
+                          src[U_PLANE], src_pitch[U_PLANE],
+                          src[V_PLANE], src_pitch[V_PLANE],
+                          cache->buffer, cache->size, (height+1) / 2, pixel_size, bitshift);
+}
+#undef COPY128
+#endif /* CAN_COMPILE_AVX2 */
+
 #undef COPY64
 #endif /* CAN_COMPILE_SSE2 */
 
@@ -649,6 +1084,11 @@ void CopyPacked(picture_t *dst, const uint8_t *src, const size_t src_pitch,
     assert(height);
 
 #ifdef CAN_COMPILE_SSE2
+# ifdef CAN_COMPILE_AVX2
+    if (vlc_CPU_AVX2())
+        return AVX2_CopyPlane(dst->p[0].p_pixels, dst->p[0].i_pitch, src, src_pitch,
+                              cache->buffer, cache->size, height, 0);
+# endif
     if (vlc_CPU_SSE4_1())
         return SSE_CopyPlane(dst->p[0].p_pixels, dst->p[0].i_pitch, src, src_pitch,
                              cache->buffer, cache->size, height, 0);
@@ -665,6 +1105,10 @@ void Copy420_SP_to_SP(picture_t *dst, const uint8_t *src[static 2],
 {
     ASSERT_2PLANES;
 #ifdef CAN_COMPILE_SSE2
+# ifdef CAN_COMPILE_AVX2
+    if (vlc_CPU_AVX2())
+        return AVX2_Copy420_SP_to_SP(dst, src, src_pitch, height, cache);
+# endif
     if (vlc_CPU_SSE2())
         return SSE_Copy420_SP_to_SP(dst, src, src_pitch, height, cache);
 #else
@@ -742,6 +1186,10 @@ void Copy420_SP_to_P(picture_t *dst, const uint8_t *src[static 2],
 {
     ASSERT_2PLANES;
 #ifdef CAN_COMPILE_SSE2
+# ifdef CAN_COMPILE_AVX2
+    if (vlc_CPU_AVX2())
+        return AVX2_Copy420_SP_to_P(dst, src, src_pitch, height, 1, 0, cache);
+# endif
     if (vlc_CPU_SSE2())
         return SSE_Copy420_SP_to_P(dst, src, src_pitch, height, 1, 0, cache);
 #else
@@ -763,6 +1211,10 @@ void Copy420_16_SP_to_P(picture_t *dst, const uint8_t *src[static 2],
     assert(bitshift >= -6 && bitshift <= 6 && (bitshift % 2 == 0));
 
 #ifdef CAN_COMPILE_SSE3
+# ifdef CAN_COMPILE_AVX2
+    if (vlc_CPU_AVX2())
+        return AVX2_Copy420_SP_to_P(dst, src, src_pitch, height, 2, bitshift, cache);
+# endif
     if (vlc_CPU_SSSE3())
         return SSE_Copy420_SP_to_P(dst, src, src_pitch, height, 2, bitshift, cache);
 #else
@@ -818,6 +1270,10 @@ void Copy420_P_to_SP(picture_t *dst, const uint8_t *src[static 3],
 {
     ASSERT_3PLANES;
 #ifdef CAN_COMPILE_SSE2
+# ifdef CAN_COMPILE_AVX2
+    if (vlc_CPU_AVX2())
+        return AVX2_Copy420_P_to_SP(dst, src, src_pitch, height, 1, 0, cache);
+# endif
     if (vlc_CPU_SSE2())
         return SSE_Copy420_P_to_SP(dst, src, src_pitch, height, 1, 0, cache);
 #else
@@ -849,6 +1305,10 @@ void Copy420_16_P_to_SP(picture_t *dst, const uint8_t *src[static 3],
     ASSERT_3PLANES;
     assert(bitshift >= -6 && bitshift <= 6 && (bitshift % 2 == 0));
 #ifdef CAN_COMPILE_SSE2
+# ifdef CAN_COMPILE_AVX2
+    if (vlc_CPU_AVX2())
+        return AVX2_Copy420_P_to_SP(dst, src, src_pitch, height, 2, bitshift, cache);
+# endif
     if (vlc_CPU_SSSE3())
         return SSE_Copy420_P_to_SP(dst, src, src_pitch, height, 2, bitshift, cache);
 #else
@@ -883,6 +1343,10 @@ void Copy420_P_to_P(picture_t *dst, const uint8_t *src[static 3],
 {
     ASSERT_3PLANES;
 #ifdef CAN_COMPILE_SSE2
+# ifdef CAN_COMPILE_AVX2
+    if (vlc_CPU_AVX2())
+        return AVX2_Copy420_P_to_P(dst, src, src_pitch, height, cache);
+# endif
     if (vlc_CPU_SSE2())
         return SSE_Copy420_P_to_P(dst, src, src_pitch, height, cache);
 #else
@@ -1102,20 +1566,8 @@ static picture_t *pic_new_unaligned(const video_format_t *fmt)
     return picture_NewFromResource(fmt, &rsc);
 }
 
-int main(void)
+static void test_convs(void)
 {
-    alarm(10);
-
-#ifndef COPY_TEST_NOOPTIM
-#ifdef CAN_COMPILE_SSE2
-    if (!vlc_CPU_SSE2())
-#endif
-    {
-        fprintf(stderr, "WARNING: could not test SSE\n");
-        return 77;
-    }
-#endif
-
     for (size_t i = 0; i < NB_CONVS; ++i)
     {
         const struct test_conv *conv = &convs[i];
@@ -1180,6 +1632,122 @@ int main(void)
             CopyCleanCache(&cache);
         }
     }
+}
+
+#ifdef COPY_BENCH
+#include <inttypes.h>
+
+#define BENCH_RUNS 50
+
+static void bench_convs(const char *name)
+{
+    static const struct test_size bench_sizes[] = {
+        { 1920, 1088, 1920, 1080 },
+        { 3840, 2160, 3840, 2160 },
+    };
+
+    for (size_t i = 0; i < NB_CONVS; ++i)
+    {
+        const struct test_conv *conv = &convs[i];
+        const vlc_chroma_description_t *src_dsc =
+            vlc_fourcc_GetChromaDescription(conv->src_chroma);
+
+        for (size_t j = 0; j < ARRAY_SIZE(bench_sizes); ++j)
+        {
+            const struct test_size *size = &bench_sizes[j];
+
+            video_format_t fmt;
+            video_format_Init(&fmt, 0);
+            video_format_Setup(&fmt, conv->src_chroma,
+                               size->i_width, size->i_height,
+                               size->i_visible_width, size->i_visible_height,
+                               1, 1);
+            picture_t *src = picture_NewFromFormat(&fmt);
+            assert(src);
+
+            copy_cache_t cache;
+            int ret = CopyInitCache(&cache, src->format.i_width
+                                    * src_dsc->pixel_size);
+            assert(ret == VLC_SUCCESS);
+
+            for (size_t f = 0; conv->dsts[f].chroma != 0; ++f)
+            {
+                const struct test_dst *test_dst= &conv->dsts[f];
+
+                fmt.i_chroma = test_dst->chroma;
+                picture_t *dst = picture_NewFromFormat(&fmt);
+                assert(dst);
+
+                const uint8_t * src_planes[3] = { src->p[Y_PLANE].p_pixels,
+                                                  src->p[U_PLANE].p_pixels,
+                                                  src->p[V_PLANE].p_pixels };
+                const size_t    src_pitches[3] = { src->p[Y_PLANE].i_pitch,
+                                                   src->p[U_PLANE].i_pitch,
+                                                   src->p[V_PLANE].i_pitch };
+
+                vlc_tick_t start = vlc_tick_now();
+                for (unsigned n = 0; n < BENCH_RUNS; n++)
+                {
+                    if (test_dst->bitshift == 0)
+                        test_dst->conv(dst, src_planes, src_pitches,
+                                       src->format.i_visible_height, &cache);
+                    else
+                        test_dst->conv16(dst, src_planes, src_pitches,
+                                         src->format.i_visible_height,
+                                         test_dst->bitshift, &cache);
+                }
+                vlc_tick_t duration = (vlc_tick_now() - start) / BENCH_RUNS;
+
+                printf("%-7s %4u x %4u %4.4s -> %4.4s: %6"PRId64" us/frame\n",
+                       name, size->i_visible_width, size->i_visible_height,
+                       (const char *) &src->format.i_chroma,
+                       (const char *) &dst->format.i_chroma,
+                       US_FROM_VLC_TICK(duration));
+                picture_Release(dst);
+            }
+            picture_Release(src);
+            CopyCleanCache(&cache);
+        }
+    }
+}
+#endif
+
+int main(void)
+{
+#ifndef COPY_BENCH
+    alarm(10);
+#endif
+
+#ifndef COPY_TEST_NOOPTIM
+#ifdef CAN_COMPILE_SSE2
+    if (!vlc_CPU_SSE2())
+#endif
+    {
+        fprintf(stderr, "WARNING: could not test SSE\n");
+        return 77;
+    }
+#endif
+
+#if defined (CAN_COMPILE_AVX2) && !defined (COPY_TEST_NOOPTIM)
+    if (vlc_CPU_AVX2())
+    {
+        fprintf(stderr, "testing with AVX2\n");
+        test_convs();
+# ifdef COPY_BENCH
+        bench_convs("AVX2");
+# endif
+        copy_test_cpu &= ~VLC_CPU_AVX2;
+    }
+#endif
+
+    test_convs();
+#ifdef COPY_BENCH
+# if defined (CAN_COMPILE_SSE2) && !defined (COPY_TEST_NOOPTIM)
+    bench_convs("SSE");
+    copy_test_cpu = 0;
+# endif
+    bench_convs("C");
+#endif
     return 0;
 }
 
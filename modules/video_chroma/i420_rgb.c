@@ -36,6 +36,7 @@
 #include <vlc_cpu.h>
 
 #include "i420_rgb.h"
+#include "slice.h"
 #ifdef PLUGIN_PLAIN
 # include "i420_rgb_c.h"
 
@@ -71,17 +72,23 @@ vlc_module_begin ()
 #endif
 vlc_module_end ()
 
+static inline chroma_slicer_t *GetSlicer( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    return p_sys->slicer;
+}
+
 #ifndef PLUGIN_PLAIN
-VIDEO_FILTER_WRAPPER_CLOSE_EXT( I420_R5G5B5, Deactivate )
-VIDEO_FILTER_WRAPPER_CLOSE_EXT( I420_R5G6B5, Deactivate )
-VIDEO_FILTER_WRAPPER_CLOSE_EXT( I420_A8R8G8B8, Deactivate )
-VIDEO_FILTER_WRAPPER_CLOSE_EXT( I420_R8G8B8A8, Deactivate )
-VIDEO_FILTER_WRAPPER_CLOSE_EXT( I420_B8G8R8A8, Deactivate )
-VIDEO_FILTER_WRAPPER_CLOSE_EXT( I420_A8B8G8R8, Deactivate )
+VIDEO_FILTER_WRAPPER_SLICED( I420_R5G5B5, GetSlicer, Deactivate )
+VIDEO_FILTER_WRAPPER_SLICED( I420_R5G6B5, GetSlicer, Deactivate )
+VIDEO_FILTER_WRAPPER_SLICED( I420_A8R8G8B8, GetSlicer, Deactivate )
+VIDEO_FILTER_WRAPPER_SLICED( I420_R8G8B8A8, GetSlicer, Deactivate )
+VIDEO_FILTER_WRAPPER_SLICED( I420_B8G8R8A8, GetSlicer, Deactivate )
+VIDEO_FILTER_WRAPPER_SLICED( I420_A8B8G8R8, GetSlicer, Deactivate )
 #else
-VIDEO_FILTER_WRAPPER_CLOSE_EXT( I420_RGB8, Deactivate )
-VIDEO_FILTER_WRAPPER_CLOSE_EXT( I420_RGB16, Deactivate )
-VIDEO_FILTER_WRAPPER_CLOSE_EXT( I420_RGB32, Deactivate )
+VIDEO_FILTER_WRAPPER_SLICED( I420_RGB8, GetSlicer, Deactivate )
+VIDEO_FILTER_WRAPPER_SLICED( I420_RGB16, GetSlicer, Deactivate )
+VIDEO_FILTER_WRAPPER_SLICED( I420_RGB32, GetSlicer, Deactivate )
 #endif
 
 /*****************************************************************************
@@ -265,6 +272,8 @@ static int Activate( filter_t *p_filter )
     video_format_Clean( &vfmt );
 #endif
 
+    /* Bands of 4 lines keep the RGB8 dithering pattern continuous */
+    p_sys->slicer = chroma_slicer_Create( p_filter, 4 );
     return 0;
 }
 
@@ -280,6 +289,7 @@ static void Deactivate( filter_t *p_filter )
 #ifdef PLUGIN_PLAIN
     free( p_sys->p_base );
 #endif
+    chroma_slicer_Delete( p_sys->slicer );
     free( p_sys->p_offset );
     free( p_sys->p_buffer );
     free( p_sys );
@@ -40,6 +40,7 @@ typedef struct
     size_t    i_buffer_size;
     uint8_t   i_bytespp;
     int *p_offset;
+    struct chroma_slicer *slicer;
 
 #ifdef PLUGIN_PLAIN
     /**< Pre-calculated conversion tables */
@@ -40,6 +40,7 @@
 #endif
 
 #include "i420_yuy2.h"
+#include "slice.h"
 
 #define SRC_FOURCC  "I420,IYUV,YV12"
 
@@ -58,6 +59,7 @@
  * Local and extern prototypes.
  *****************************************************************************/
 static int  Activate ( filter_t * );
+static void Deactivate ( filter_t * );
 
 /*****************************************************************************
  * Module descriptor.
@@ -78,11 +80,20 @@ vlc_module_begin ()
 #endif
 vlc_module_end ()
 
-VIDEO_FILTER_WRAPPER( I420_YUY2 )
-VIDEO_FILTER_WRAPPER( I420_YVYU )
-VIDEO_FILTER_WRAPPER( I420_UYVY )
+static void I420_YUY2( filter_t *, picture_t *, picture_t * );
+static void I420_YVYU( filter_t *, picture_t *, picture_t * );
+static void I420_UYVY( filter_t *, picture_t *, picture_t * );
 #if defined (PLUGIN_PLAIN)
-VIDEO_FILTER_WRAPPER( I420_Y211 )
+static void I420_Y211( filter_t *, picture_t *, picture_t * );
+#endif
+
+#define GetSlicer( p_filter ) ((chroma_slicer_t *)(p_filter)->p_sys)
+
+VIDEO_FILTER_WRAPPER_SLICED( I420_YUY2, GetSlicer, Deactivate )
+VIDEO_FILTER_WRAPPER_SLICED( I420_YVYU, GetSlicer, Deactivate )
+VIDEO_FILTER_WRAPPER_SLICED( I420_UYVY, GetSlicer, Deactivate )
+#if defined (PLUGIN_PLAIN)
+VIDEO_FILTER_WRAPPER_SLICED( I420_Y211, GetSlicer, Deactivate )
 #endif
 
 static const struct vlc_filter_operations *
@@ -138,9 +149,16 @@ static int Activate( filter_t *p_filter )
     if( p_filter->ops == NULL )
         return VLC_EGENERIC;
 
+    /* The vectorized loops convert 4 lines at a time */
+    p_filter->p_sys = chroma_slicer_Create( p_filter, 4 );
     return VLC_SUCCESS;
 }
 
+static void Deactivate( filter_t *p_filter )
+{
+    chroma_slicer_Delete( p_filter->p_sys );
+}
+
 #if 0
 static inline unsigned long long read_cycles(void)
 {
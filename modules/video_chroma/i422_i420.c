@@ -34,6 +34,8 @@
 #include <vlc_filter.h>
 #include <vlc_picture.h>
 
+#include "slice.h"
+
 #define SRC_FOURCC  "I422,J422"
 #define DEST_FOURCC "I420,IYUV,J420,YV12,YUVA"
 
@@ -41,6 +43,7 @@
  * Local and extern prototypes.
  *****************************************************************************/
 static int  Activate ( filter_t * );
+static void Deactivate ( filter_t * );
 
 /*****************************************************************************
  * Module descriptor
@@ -50,9 +53,15 @@ vlc_module_begin ()
     set_callback_video_converter( Activate, 60 )
 vlc_module_end ()
 
-VIDEO_FILTER_WRAPPER( I422_I420 )
-VIDEO_FILTER_WRAPPER( I422_YV12 )
-VIDEO_FILTER_WRAPPER( I422_YUVA )
+static void I422_I420( filter_t *, picture_t *, picture_t * );
+static void I422_YV12( filter_t *, picture_t *, picture_t * );
+static void I422_YUVA( filter_t *, picture_t *, picture_t * );
+
+#define GetSlicer( p_filter ) ((chroma_slicer_t *)(p_filter)->p_sys)
+
+VIDEO_FILTER_WRAPPER_SLICED( I422_I420, GetSlicer, Deactivate )
+VIDEO_FILTER_WRAPPER_SLICED( I422_YV12, GetSlicer, Deactivate )
+VIDEO_FILTER_WRAPPER_SLICED( I422_YUVA, GetSlicer, Deactivate )
 
 /*****************************************************************************
  * Activate: allocate a chroma function
@@ -99,9 +108,16 @@ static int Activate( filter_t *p_filter )
         default:
             return -1;
     }
+
+    p_filter->p_sys = chroma_slicer_Create( p_filter, 2 );
     return 0;
 }
 
+static void Deactivate( filter_t *p_filter )
+{
+    chroma_slicer_Delete( p_filter->p_sys );
+}
+
 /* Following functions are local */
 
 /*****************************************************************************
@@ -0,0 +1,357 @@
+/*****************************************************************************
+ * slice.c: Row-band parallel execution of chroma converters
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef SLICE_TEST
+# undef NDEBUG
+#endif
+
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_filter.h>
+#include <vlc_picture.h>
+
+#include "slice.h"
+
+/** Minimum band height, in luma lines, worth a thread */
+#define SLICE_MIN_LINES 64
+/** Maximum number of bands */
+#define SLICE_MAX_THREADS 16
+
+struct chroma_slice_worker
+{
+    chroma_slicer_t *slicer;
+    unsigned index;
+    vlc_thread_t thread;
+};
+
+struct chroma_slicer
+{
+    vlc_mutex_t lock;
+    vlc_cond_t wait_work;
+    vlc_cond_t wait_done;
+    unsigned threads;
+    unsigned align;
+    unsigned height; /**< luma lines to split */
+
+    /* Current job, protected by lock */
+    uint64_t generation;
+    unsigned pending;
+    bool closing;
+    filter_t *filter;
+    chroma_slice_cb cb;
+    picture_t *src;
+    picture_t *dst;
+
+    struct chroma_slice_worker workers[];
+};
+
+static void BandPicture(picture_t *band, const picture_t *pic,
+                        unsigned y, unsigned lines, unsigned height)
+{
+    *band = *pic;
+
+    for (int i = 0; i < pic->i_planes; i++)
+    {
+        plane_t *p = &band->p[i];
+        /* Lines of this plane per luma line (e.g. half for 4:2:0 chroma) */
+        unsigned first = y * pic->p[i].i_visible_lines / height;
+        unsigned count = (y + lines == height)
+                       ? pic->p[i].i_visible_lines - first
+                       : lines * pic->p[i].i_visible_lines / height;
+
+        p->p_pixels += (size_t)first * p->i_pitch;
+        p->i_lines = count;
+        p->i_visible_lines = count;
+    }
+}
+
+static void BandFormat(video_format_t *fmt, unsigned lines)
+{
+    fmt->i_height = lines;
+    fmt->i_visible_height = lines;
+}
+
+static void RunBand(chroma_slicer_t *slicer, unsigned index)
+{
+    /* Split in bands of aligned heights, the last one taking the rest */
+    unsigned band = slicer->height / slicer->threads;
+    band -= band % slicer->align;
+
+    unsigned y = index * band;
+    unsigned lines = (index + 1 == slicer->threads) ? slicer->height - y
+                                                    : band;
+
+    filter_t filter = *slicer->filter;
+    picture_t src, dst;
+
+    BandFormat(&filter.fmt_in.video, lines);
+    BandFormat(&filter.fmt_out.video, lines);
+    BandPicture(&src, slicer->src, y, lines, slicer->height);
+    BandPicture(&dst, slicer->dst, y, lines, slicer->height);
+
+    slicer->cb(&filter, &src, &dst);
+}
+
+static void *WorkerThread(void *data)
+{
+    struct chroma_slice_worker *worker = data;
+    chroma_slicer_t *slicer = worker->slicer;
+    uint64_t generation = 0;
+
+    vlc_thread_set_name("vlc-chroma");
+
+    vlc_mutex_lock(&slicer->lock);
+    for (;;)
+    {
+        while (!slicer->closing && slicer->generation == generation)
+            vlc_cond_wait(&slicer->wait_work, &slicer->lock);
+        if (slicer->closing)
+            break;
+
+        generation = slicer->generation;
+        vlc_mutex_unlock(&slicer->lock);
+
+        RunBand(slicer, worker->index);
+
+        vlc_mutex_lock(&slicer->lock);
+        assert(slicer->pending > 0);
+        if (--slicer->pending == 0)
+            vlc_cond_signal(&slicer->wait_done);
+    }
+    vlc_mutex_unlock(&slicer->lock);
+    return NULL;
+}
+
+chroma_slicer_t *chroma_slicer_New(filter_t *filter, unsigned threads,
+                                   unsigned align)
+{
+    const video_format_t *in = &filter->fmt_in.video;
+    const video_format_t *out = &filter->fmt_out.video;
+
+    /* Bands are cut from the top, in both pictures alike, and the
+     * converters may only use their shared state when scaling: the offset
+     * and line buffers of i420_rgb are written whenever the input and output
+     * widths, counted from the left edge, differ */
+    if (in->i_y_offset != 0 || out->i_y_offset != 0
+     || in->i_x_offset != out->i_x_offset
+     || in->i_visible_width != out->i_visible_width
+     || in->i_visible_height != out->i_visible_height)
+        return NULL;
+
+    unsigned height = in->i_visible_height;
+
+    if (threads > SLICE_MAX_THREADS)
+        threads = SLICE_MAX_THREADS;
+    if (threads > height / SLICE_MIN_LINES)
+        threads = height / SLICE_MIN_LINES;
+    if (threads <= 1 || align == 0)
+        return NULL;
+
+    chroma_slicer_t *slicer = malloc(sizeof (*slicer)
+                                     + threads * sizeof (slicer->workers[0]));
+    if (unlikely(slicer == NULL))
+        return NULL;
+
+    vlc_mutex_init(&slicer->lock);
+    vlc_cond_init(&slicer->wait_work);
+    vlc_cond_init(&slicer->wait_done);
+    slicer->threads = threads;
+    slicer->align = align;
+    slicer->height = height;
+    slicer->generation = 0;
+    slicer->pending = 0;
+    slicer->closing = false;
+
+    /* Band 0 is converted by the calling thread */
+    for (unsigned i = 1; i < threads; i++)
+    {
+        struct chroma_slice_worker *worker = &slicer->workers[i];
+
+        worker->slicer = slicer;
+        worker->index = i;
+        if (vlc_clone(&worker->thread, WorkerThread, worker))
+        {
+            slicer->threads = i;
+            chroma_slicer_Delete(slicer);
+            return NULL;
+        }
+    }
+
+    return slicer;
+}
+
+chroma_slicer_t *chroma_slicer_Create(filter_t *filter, unsigned align)
+{
+    int64_t threads = var_InheritInteger(filter, CHROMA_THREADS_VAR);
+
+    if (threads <= 0)
+        threads = vlc_GetCPUCount();
+    if (threads > SLICE_MAX_THREADS)
+        threads = SLICE_MAX_THREADS;
+
+    chroma_slicer_t *slicer = chroma_slicer_New(filter, threads, align);
+    if (slicer != NULL)
+        msg_Dbg(filter, "converting in %u bands", slicer->threads);
+    return slicer;
+}
+
+void chroma_slicer_Delete(chroma_slicer_t *slicer)
+{
+    if (slicer == NULL)
+        return;
+
+    vlc_mutex_lock(&slicer->lock);
+    slicer->closing = true;
+    vlc_cond_broadcast(&slicer->wait_work);
+    vlc_mutex_unlock(&slicer->lock);
+
+    for (unsigned i = 1; i < slicer->threads; i++)
+        vlc_join(slicer->workers[i].thread, NULL);
+    free(slicer);
+}
+
+void chroma_slicer_Run(chroma_slicer_t *slicer, filter_t *filter,
+                       chroma_slice_cb cb, picture_t *src, picture_t *dst)
+{
+    if (slicer == NULL
+     || filter->fmt_in.video.i_visible_height != slicer->height)
+    {
+        cb(filter, src, dst);
+        return;
+    }
+
+    vlc_mutex_lock(&slicer->lock);
+    slicer->filter = filter;
+    slicer->cb = cb;
+    slicer->src = src;
+    slicer->dst = dst;
+    slicer->pending = slicer->threads - 1;
+    slicer->generation++;
+    vlc_cond_broadcast(&slicer->wait_work);
+    vlc_mutex_unlock(&slicer->lock);
+
+    RunBand(slicer, 0);
+
+    vlc_mutex_lock(&slicer->lock);
+    while (slicer->pending > 0)
+        vlc_cond_wait(&slicer->wait_done, &slicer->lock);
+    vlc_mutex_unlock(&slicer->lock);
+}
+
+#ifdef SLICE_TEST
+#include <stdio.h>
+#include <inttypes.h>
+
+#define TEST_RUNS 20
+
+/* Stand-in for a converter: a few arithmetic operations per pixel, and a
+ * check that every line is written exactly once */
+static void TestConvert(filter_t *filter, picture_t *src, picture_t *dst)
+{
+    assert(src->p[0].i_visible_lines
+           == (int)filter->fmt_in.video.i_visible_height);
+
+    for (int i = 0; i < src->i_planes; i++)
+    {
+        unsigned lines = src->p[i].i_visible_lines;
+        unsigned width = src->p[i].i_visible_pitch;
+
+        for (unsigned y = 0; y < lines; y++)
+        {
+            const uint8_t *in = src->p[i].p_pixels + y * src->p[i].i_pitch;
+            uint8_t *out = dst->p[i].p_pixels + y * dst->p[i].i_pitch;
+
+            for (unsigned x = 0; x < width; x++)
+                out[x] += (in[x] * 77 + 128) >> 8;
+        }
+    }
+}
+
+static vlc_tick_t TestRun(chroma_slicer_t *slicer, filter_t *filter,
+                          picture_t *src, picture_t *dst)
+{
+    vlc_tick_t start = vlc_tick_now();
+
+    for (unsigned i = 0; i < TEST_RUNS; i++)
+        chroma_slicer_Run(slicer, filter, TestConvert, src, dst);
+    return (vlc_tick_now() - start) / TEST_RUNS;
+}
+
+int main(void)
+{
+    filter_t filter = { 0 };
+    video_format_t *fmt = &filter.fmt_in.video;
+
+    video_format_Setup(fmt, VLC_CODEC_I420, 3840, 2160, 3840, 2160, 1, 1);
+    filter.fmt_out.video = *fmt;
+
+    picture_t *src = picture_NewFromFormat(fmt);
+    picture_t *dst = picture_NewFromFormat(fmt);
+    assert(src != NULL && dst != NULL);
+
+    for (int i = 0; i < src->i_planes; i++)
+    {
+        memset(src->p[i].p_pixels, 0xff,
+               src->p[i].i_pitch * src->p[i].i_lines);
+        memset(dst->p[i].p_pixels, 0,
+               dst->p[i].i_pitch * dst->p[i].i_lines);
+    }
+
+    vlc_tick_t ref = TestRun(NULL, &filter, src, dst);
+    printf("1 band: %"PRId64" us/frame\n", US_FROM_VLC_TICK(ref));
+
+    for (unsigned threads = 2; threads <= 8; threads *= 2)
+    {
+        chroma_slicer_t *slicer = chroma_slicer_New(&filter, threads, 2);
+        assert(slicer != NULL);
+
+        vlc_tick_t t = TestRun(slicer, &filter, src, dst);
+        printf("%u bands: %"PRId64" us/frame\n", threads, US_FROM_VLC_TICK(t));
+        chroma_slicer_Delete(slicer);
+    }
+
+    /* Every visible pixel was converted once per run */
+    const uint8_t expected = (uint8_t)(((0xff * 77 + 128) >> 8) * 4 * TEST_RUNS);
+    for (int i = 0; i < dst->i_planes; i++)
+        for (int y = 0; y < dst->p[i].i_visible_lines; y++)
+            for (int x = 0; x < dst->p[i].i_visible_pitch; x++)
+                assert(dst->p[i].p_pixels[y * dst->p[i].i_pitch + x]
+                       == expected);
+
+    /* Cropped differently on the left: the converter would scale */
+    filter.fmt_out.video.i_x_offset = 16;
+    filter.fmt_out.video.i_visible_width -= 16;
+    assert(chroma_slicer_New(&filter, 4, 2) == NULL);
+
+    /* Too small to be split */
+    video_format_Setup(fmt, VLC_CODEC_I420, 176, 96, 176, 96, 1, 1);
+    filter.fmt_out.video = *fmt;
+    assert(chroma_slicer_New(&filter, 4, 2) == NULL);
+
+    picture_Release(src);
+    picture_Release(dst);
+    return 0;
+}
+#endif
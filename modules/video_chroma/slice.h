@@ -0,0 +1,98 @@
+/*****************************************************************************
+ * slice.h: Row-band parallel execution of chroma converters
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_VIDEOCHROMA_SLICE_H_
+#define VLC_VIDEOCHROMA_SLICE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Splits the conversion of a picture in horizontal bands, converted in
+ * parallel by a set of worker threads.
+ *
+ * Each band is converted by the unmodified converter callback, called with a
+ * copy of the filter whose formats are restricted to the band height, and
+ * with pictures whose planes start at the band. This only works for
+ * converters that do not scale vertically and that derive their geometry
+ * from the filter formats and the picture planes.
+ */
+typedef struct chroma_slicer chroma_slicer_t;
+
+typedef void (*chroma_slice_cb)(filter_t *, picture_t *src, picture_t *dst);
+
+/* Core option setting the number of threads of chroma_slicer_Create() */
+#define CHROMA_THREADS_VAR "chroma-threads"
+
+/**
+ * Creates a slicer.
+ *
+ * \param filter converter, whose input and output formats are used
+ * \param threads number of bands (including the calling thread)
+ * \param align band height alignment in luma lines (e.g. 2 for 4:2:0)
+ * \return a slicer, or NULL if the conversion cannot or should not be split
+ */
+chroma_slicer_t *chroma_slicer_New(filter_t *filter, unsigned threads,
+                                   unsigned align);
+
+/**
+ * Creates a slicer with the number of threads set by "chroma-threads", if
+ * more than one.
+ */
+chroma_slicer_t *chroma_slicer_Create(filter_t *filter, unsigned align);
+
+void chroma_slicer_Delete(chroma_slicer_t *);
+
+/**
+ * Converts a picture, band by band.
+ *
+ * If slicer is NULL, the callback is simply called for the whole picture.
+ */
+void chroma_slicer_Run(chroma_slicer_t *slicer, filter_t *filter,
+                       chroma_slice_cb cb, picture_t *src, picture_t *dst);
+
+/**
+ * Same as VIDEO_FILTER_WRAPPER_CLOSE_FILT(), converting through the slicer
+ * returned by get_slicer(p_filter).
+ */
+#define VIDEO_FILTER_WRAPPER_SLICED( name, get_slicer, close_cb )       \
+    static picture_t *name ## _Filter ( filter_t *p_filter,             \
+                                        picture_t *p_pic )              \
+    {                                                                   \
+        picture_t *p_outpic = filter_NewPicture( p_filter );            \
+        if( p_outpic )                                                  \
+        {                                                               \
+            chroma_slicer_Run( get_slicer( p_filter ), p_filter, name,  \
+                               p_pic, p_outpic );                       \
+            picture_CopyProperties( p_outpic, p_pic );                  \
+        }                                                               \
+        picture_Release( p_pic );                                       \
+        return p_outpic;                                                \
+    }                                                                   \
+    static const struct vlc_filter_operations name ## _ops = {          \
+        .filter_video = name ## _Filter, .close = close_cb,             \
+    };
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
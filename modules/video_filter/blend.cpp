@@ -31,7 +31,9 @@
 #include <vlc_plugin.h>
 #include <vlc_filter.h>
 #include <vlc_picture.h>
+#include <vlc_cpu.h>
 #include "filter_picture.h"
+#include "blend_kernels.h"
 
 /*****************************************************************************
  * Module descriptor
@@ -79,6 +81,18 @@ public:
     {
         return fmt;
     }
+    const picture_t *getPicture() const
+    {
+        return picture;
+    }
+    unsigned getX() const
+    {
+        return x;
+    }
+    unsigned getY() const
+    {
+        return y;
+    }
     bool isFull(unsigned) const
     {
         return true;
@@ -560,6 +574,80 @@ void Blend(const CPicture &dst_data, const CPicture &src_data,
 typedef void (*blend_function_t)(const CPicture &dst_data, const CPicture &src_data,
                                  unsigned width, unsigned height, int alpha);
 
+/* Line based versions of the most common combinations, running the vector
+ * kernels of the CPU. They give the same results as Blend(). */
+typedef void (*blend_lines_function_t)(const struct blend_kernels *kernels,
+                                       const CPicture &dst_data, const CPicture &src_data,
+                                       unsigned width, unsigned height, int alpha);
+
+template <bool semiplanar, bool swap_uv>
+void BlendYUVAToYUV420(const struct blend_kernels *kernels,
+                       const CPicture &dst_data, const CPicture &src_data,
+                       unsigned width, unsigned height, int alpha)
+{
+    const picture_t *dst = dst_data.getPicture();
+    const picture_t *src = src_data.getPicture();
+    const unsigned dx = dst_data.getX();
+    const unsigned dy = dst_data.getY();
+    const unsigned sx = src_data.getX();
+    const unsigned sy = src_data.getY();
+
+    /* Only the source pixels on a chroma sample of the destination are
+     * blended into the chroma planes */
+    const unsigned skip = dx % 2;
+    const unsigned count = width > skip ? (width - skip + 1) / 2 : 0;
+
+    for (unsigned y = 0; y < height; y++) {
+        const uint8_t *s[4];
+        for (unsigned i = 0; i < 4; i++)
+            s[i] = &src->p[i].p_pixels[(sy + y) * src->p[i].i_pitch + sx];
+
+        kernels->plane(&dst->p[0].p_pixels[(dy + y) * dst->p[0].i_pitch + dx],
+                       s[0], s[3], alpha, width);
+
+        if ((dy + y) % 2 != 0 || count == 0)
+            continue;
+
+        const unsigned line = (dy + y) / 2;
+        const uint8_t *src_u = &s[swap_uv ? 2 : 1][skip];
+        const uint8_t *src_v = &s[swap_uv ? 1 : 2][skip];
+        if (semiplanar)
+            kernels->chroma_packed(&dst->p[1].p_pixels[line * dst->p[1].i_pitch + dx + skip],
+                                   src_u, src_v, &s[3][skip], alpha, count);
+        else
+            kernels->chroma_planar(&dst->p[1].p_pixels[line * dst->p[1].i_pitch + (dx + skip) / 2],
+                                   &dst->p[2].p_pixels[line * dst->p[2].i_pitch + (dx + skip) / 2],
+                                   src_u, src_v, &s[3][skip], alpha, count);
+    }
+}
+
+void BlendRGBAToRGB32(const struct blend_kernels *kernels,
+                      const CPicture &dst_data, const CPicture &src_data,
+                      unsigned width, unsigned height, int alpha)
+{
+    const picture_t *dst = dst_data.getPicture();
+    const picture_t *src = src_data.getPicture();
+    const unsigned dx = dst_data.getX();
+    const unsigned dy = dst_data.getY();
+    const unsigned sx = src_data.getX();
+    const unsigned sy = src_data.getY();
+
+    int offset_r, offset_g, offset_b;
+    if (GetPackedRgbIndexes(dst_data.getFormat(), &offset_r, &offset_g, &offset_b) != VLC_SUCCESS) {
+        offset_r = 0;
+        offset_g = 1;
+        offset_b = 2;
+    }
+    const unsigned offsets[3] = {
+        (unsigned)offset_r, (unsigned)offset_g, (unsigned)offset_b
+    };
+
+    for (unsigned y = 0; y < height; y++)
+        kernels->rgbx(&dst->p[0].p_pixels[(dy + y) * dst->p[0].i_pitch + dx * 4],
+                      &src->p[0].p_pixels[(sy + y) * src->p[0].i_pitch + sx * 4],
+                      alpha, width, offsets);
+}
+
 namespace {
 
 static const struct {
@@ -636,11 +724,26 @@ static const struct {
 #undef YUV
 };
 
+static const struct {
+    vlc_fourcc_t           dst;
+    vlc_fourcc_t           src;
+    blend_lines_function_t blend;
+} line_blends[] = {
+    { VLC_CODEC_I420,  VLC_CODEC_YUVA, BlendYUVAToYUV420<false, false> },
+    { VLC_CODEC_J420,  VLC_CODEC_YUVA, BlendYUVAToYUV420<false, false> },
+    { VLC_CODEC_YV12,  VLC_CODEC_YUVA, BlendYUVAToYUV420<false, true> },
+    { VLC_CODEC_NV12,  VLC_CODEC_YUVA, BlendYUVAToYUV420<true,  false> },
+    { VLC_CODEC_NV21,  VLC_CODEC_YUVA, BlendYUVAToYUV420<true,  true> },
+    { VLC_CODEC_RGB32, VLC_CODEC_RGBA, BlendRGBAToRGB32 },
+};
+
 struct filter_sys_t {
-    filter_sys_t() : blend(NULL)
+    filter_sys_t() : blend(NULL), blend_lines(NULL), kernels(NULL)
     {
     }
     blend_function_t blend;
+    blend_lines_function_t blend_lines;
+    const struct blend_kernels *kernels;
 };
 
 } // namespace
@@ -670,13 +773,17 @@ static void DoBlend(filter_t *filter,
     video_format_FixRgb(&filter->fmt_out.video);
     video_format_FixRgb(&filter->fmt_in.video);
 
-    sys->blend(CPicture(dst, &filter->fmt_out.video,
-                        filter->fmt_out.video.i_x_offset + x_offset,
-                        filter->fmt_out.video.i_y_offset + y_offset),
-               CPicture(src, &filter->fmt_in.video,
-                        filter->fmt_in.video.i_x_offset,
-                        filter->fmt_in.video.i_y_offset),
-               width, height, alpha);
+    const CPicture dst_data(dst, &filter->fmt_out.video,
+                            filter->fmt_out.video.i_x_offset + x_offset,
+                            filter->fmt_out.video.i_y_offset + y_offset);
+    const CPicture src_data(src, &filter->fmt_in.video,
+                            filter->fmt_in.video.i_x_offset,
+                            filter->fmt_in.video.i_y_offset);
+
+    if (sys->blend_lines)
+        sys->blend_lines(sys->kernels, dst_data, src_data, width, height, alpha);
+    else
+        sys->blend(dst_data, src_data, width, height, alpha);
 }
 
 static const struct FilterOperationInitializer {
@@ -706,6 +813,14 @@ static int Open(filter_t *filter)
         return VLC_EGENERIC;
     }
 
+    for (size_t i = 0; i < sizeof(line_blends) / sizeof(*line_blends); i++) {
+        if (line_blends[i].src == src && line_blends[i].dst == dst) {
+            sys->blend_lines = line_blends[i].blend;
+            sys->kernels     = blend_kernels_Get(vlc_CPU());
+            msg_Dbg(filter, "using %s blending kernels", sys->kernels->name);
+        }
+    }
+
     filter->ops = &filter_ops.ops;
     filter->p_sys          = sys;
     return VLC_SUCCESS;
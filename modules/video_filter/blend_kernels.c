@@ -0,0 +1,650 @@
+/*****************************************************************************
+ * blend_kernels.c: line blending kernels
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(HAVE_SSE2_INTRINSICS) || defined(__SSE2__))
+# include <immintrin.h>
+# define BLEND_SSE4_1
+# define BLEND_AVX2
+# define VLC_SSE4_1 __attribute__ ((__target__ ("sse4.1")))
+# define VLC_AVX2 __attribute__ ((__target__ ("avx2")))
+#elif defined(__ARM_NEON)
+# include <arm_neon.h>
+# define BLEND_NEON
+#endif
+
+#include "blend_kernels.h"
+
+static inline unsigned Div255(unsigned v)
+{
+    /* Exact for products of 8-bit values */
+    return ((v >> 8) + v + 1) >> 8;
+}
+
+static inline void Merge(uint8_t *dst, unsigned src, unsigned a)
+{
+    *dst = Div255((255 - a) * *dst + src * a);
+}
+
+static void Plane_C(uint8_t *dst, const uint8_t *src, const uint8_t *src_a,
+                    unsigned alpha, unsigned n)
+{
+    for (unsigned i = 0; i < n; i++)
+    {
+        const unsigned a = Div255(alpha * src_a[i]);
+        if (a > 0)
+            Merge(&dst[i], src[i], a);
+    }
+}
+
+static void ChromaPlanar_C(uint8_t *dst_u, uint8_t *dst_v,
+                           const uint8_t *src_u, const uint8_t *src_v,
+                           const uint8_t *src_a, unsigned alpha, unsigned n)
+{
+    for (unsigned i = 0; i < n; i++)
+    {
+        const unsigned a = Div255(alpha * src_a[2 * i]);
+        if (a > 0)
+        {
+            Merge(&dst_u[i], src_u[2 * i], a);
+            Merge(&dst_v[i], src_v[2 * i], a);
+        }
+    }
+}
+
+static void ChromaPacked_C(uint8_t *dst_uv,
+                           const uint8_t *src_u, const uint8_t *src_v,
+                           const uint8_t *src_a, unsigned alpha, unsigned n)
+{
+    for (unsigned i = 0; i < n; i++)
+    {
+        const unsigned a = Div255(alpha * src_a[2 * i]);
+        if (a > 0)
+        {
+            Merge(&dst_uv[2 * i    ], src_u[2 * i], a);
+            Merge(&dst_uv[2 * i + 1], src_v[2 * i], a);
+        }
+    }
+}
+
+static void Rgbx_C(uint8_t *dst, const uint8_t *src, unsigned alpha,
+                   unsigned n, const unsigned offsets[3])
+{
+    for (unsigned i = 0; i < n; i++)
+    {
+        const uint8_t *s = &src[4 * i];
+        const unsigned a = Div255(alpha * s[3]);
+        if (a > 0)
+        {
+            uint8_t *d = &dst[4 * i];
+            Merge(&d[offsets[0]], s[0], a);
+            Merge(&d[offsets[1]], s[1], a);
+            Merge(&d[offsets[2]], s[2], a);
+        }
+    }
+}
+
+const struct blend_kernels blend_kernels_c =
+{
+    "C", Plane_C, ChromaPlanar_C, ChromaPacked_C, Rgbx_C,
+};
+
+/* The vector versions compute the same formulas on 16-bit lanes: neither
+ * alpha * sa nor (255 - a) * d + s * a can exceed 255 * 255, and the
+ * division never needs more than 16 bits either.
+ *
+ * The chroma kernels read 2 * n - 1 source samples, so their main loops
+ * stop one iteration early rather than read past the end of the line. */
+
+#if defined(BLEND_SSE4_1) || defined(BLEND_AVX2)
+/* Builds pshufb masks moving the RGB bytes of RGBA pixels, and their alpha,
+ * to the bytes of the destination pixels. The fourth destination byte gets
+ * a null alpha, and thus keeps its value. */
+static void RgbxShuffles(const unsigned offsets[3],
+                         uint8_t *rgb, uint8_t *a, size_t size)
+{
+    memset(rgb, 0x80, size);
+    memset(a, 0x80, size);
+    for (size_t p = 0; p < size; p += 4)
+    {
+        /* Shuffles do not cross 128-bit lanes */
+        for (unsigned c = 0; c < 3; c++)
+        {
+            rgb[p + offsets[c]] = (p % 16) + c;
+            a[p + offsets[c]] = (p % 16) + 3;
+        }
+    }
+}
+#endif
+
+#ifdef BLEND_SSE4_1
+VLC_SSE4_1
+static inline __m128i Div255_SSE4_1(__m128i v)
+{
+    v = _mm_add_epi16(v, _mm_srli_epi16(v, 8));
+    return _mm_srli_epi16(_mm_add_epi16(v, _mm_set1_epi16(1)), 8);
+}
+
+VLC_SSE4_1
+static inline __m128i Alpha_SSE4_1(__m128i sa, __m128i alpha)
+{
+    return Div255_SSE4_1(_mm_mullo_epi16(sa, alpha));
+}
+
+VLC_SSE4_1
+static inline __m128i Blend_SSE4_1(__m128i d, __m128i s, __m128i a)
+{
+    const __m128i ia = _mm_sub_epi16(_mm_set1_epi16(255), a);
+    return Div255_SSE4_1(_mm_add_epi16(_mm_mullo_epi16(ia, d),
+                                       _mm_mullo_epi16(a, s)));
+}
+
+VLC_SSE4_1
+static void Plane_SSE4_1(uint8_t *dst, const uint8_t *src,
+                         const uint8_t *src_a, unsigned alpha, unsigned n)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i va = _mm_set1_epi16(alpha);
+    unsigned i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        const __m128i sa = _mm_loadu_si128((const __m128i *)&src_a[i]);
+        /* Overlays are mostly transparent */
+        if (_mm_testz_si128(sa, sa))
+            continue;
+
+        const __m128i s = _mm_loadu_si128((const __m128i *)&src[i]);
+        const __m128i d = _mm_loadu_si128((const __m128i *)&dst[i]);
+        const __m128i lo =
+            Blend_SSE4_1(_mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi8(s, zero),
+                         Alpha_SSE4_1(_mm_unpacklo_epi8(sa, zero), va));
+        const __m128i hi =
+            Blend_SSE4_1(_mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi8(s, zero),
+                         Alpha_SSE4_1(_mm_unpackhi_epi8(sa, zero), va));
+        _mm_storeu_si128((__m128i *)&dst[i], _mm_packus_epi16(lo, hi));
+    }
+
+    Plane_C(&dst[i], &src[i], &src_a[i], alpha, n - i);
+}
+
+VLC_SSE4_1
+static inline void ChromaLine_SSE4_1(uint8_t *dst, const uint8_t *src,
+                                     __m128i a_lo, __m128i a_hi)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i even = _mm_set1_epi16(0x00ff);
+    const __m128i d = _mm_loadu_si128((const __m128i *)dst);
+    const __m128i s_lo = _mm_and_si128(_mm_loadu_si128((const __m128i *)&src[0]), even);
+    const __m128i s_hi = _mm_and_si128(_mm_loadu_si128((const __m128i *)&src[16]), even);
+
+    _mm_storeu_si128((__m128i *)dst,
+        _mm_packus_epi16(Blend_SSE4_1(_mm_unpacklo_epi8(d, zero), s_lo, a_lo),
+                         Blend_SSE4_1(_mm_unpackhi_epi8(d, zero), s_hi, a_hi)));
+}
+
+VLC_SSE4_1
+static void ChromaPlanar_SSE4_1(uint8_t *dst_u, uint8_t *dst_v,
+                                const uint8_t *src_u, const uint8_t *src_v,
+                                const uint8_t *src_a, unsigned alpha, unsigned n)
+{
+    const __m128i even = _mm_set1_epi16(0x00ff);
+    const __m128i va = _mm_set1_epi16(alpha);
+    unsigned i = 0;
+
+    for (; i + 16 < n; i += 16)
+    {
+        const __m128i sa_lo = _mm_and_si128(
+            _mm_loadu_si128((const __m128i *)&src_a[2 * i]), even);
+        const __m128i sa_hi = _mm_and_si128(
+            _mm_loadu_si128((const __m128i *)&src_a[2 * i + 16]), even);
+        const __m128i sa = _mm_or_si128(sa_lo, sa_hi);
+        if (_mm_testz_si128(sa, sa))
+            continue;
+
+        const __m128i a_lo = Alpha_SSE4_1(sa_lo, va);
+        const __m128i a_hi = Alpha_SSE4_1(sa_hi, va);
+        ChromaLine_SSE4_1(&dst_u[i], &src_u[2 * i], a_lo, a_hi);
+        ChromaLine_SSE4_1(&dst_v[i], &src_v[2 * i], a_lo, a_hi);
+    }
+
+    ChromaPlanar_C(&dst_u[i], &dst_v[i], &src_u[2 * i], &src_v[2 * i],
+                   &src_a[2 * i], alpha, n - i);
+}
+
+VLC_SSE4_1
+static void ChromaPacked_SSE4_1(uint8_t *dst_uv,
+                                const uint8_t *src_u, const uint8_t *src_v,
+                                const uint8_t *src_a, unsigned alpha, unsigned n)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i even = _mm_set1_epi16(0x00ff);
+    const __m128i va = _mm_set1_epi16(alpha);
+    unsigned i = 0;
+
+    for (; i + 8 < n; i += 8)
+    {
+        const __m128i sa = _mm_and_si128(
+            _mm_loadu_si128((const __m128i *)&src_a[2 * i]), even);
+        if (_mm_testz_si128(sa, sa))
+            continue;
+
+        const __m128i su = _mm_and_si128(
+            _mm_loadu_si128((const __m128i *)&src_u[2 * i]), even);
+        const __m128i sv = _mm_and_si128(
+            _mm_loadu_si128((const __m128i *)&src_v[2 * i]), even);
+        const __m128i a = Alpha_SSE4_1(sa, va);
+        const __m128i d = _mm_loadu_si128((const __m128i *)&dst_uv[2 * i]);
+        const __m128i lo =
+            Blend_SSE4_1(_mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi16(su, sv),
+                         _mm_unpacklo_epi16(a, a));
+        const __m128i hi =
+            Blend_SSE4_1(_mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi16(su, sv),
+                         _mm_unpackhi_epi16(a, a));
+        _mm_storeu_si128((__m128i *)&dst_uv[2 * i], _mm_packus_epi16(lo, hi));
+    }
+
+    ChromaPacked_C(&dst_uv[2 * i], &src_u[2 * i], &src_v[2 * i],
+                   &src_a[2 * i], alpha, n - i);
+}
+
+VLC_SSE4_1
+static void Rgbx_SSE4_1(uint8_t *dst, const uint8_t *src, unsigned alpha,
+                        unsigned n, const unsigned offsets[3])
+{
+    uint8_t shuf_rgb[16], shuf_a[16];
+    RgbxShuffles(offsets, shuf_rgb, shuf_a, 16);
+
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i va = _mm_set1_epi16(alpha);
+    const __m128i mrgb = _mm_loadu_si128((const __m128i *)shuf_rgb);
+    const __m128i ma = _mm_loadu_si128((const __m128i *)shuf_a);
+    unsigned i = 0;
+
+    for (; i + 4 <= n; i += 4)
+    {
+        const __m128i px = _mm_loadu_si128((const __m128i *)&src[4 * i]);
+        const __m128i sa = _mm_shuffle_epi8(px, ma);
+        if (_mm_testz_si128(sa, sa))
+            continue;
+
+        const __m128i s = _mm_shuffle_epi8(px, mrgb);
+        const __m128i d = _mm_loadu_si128((const __m128i *)&dst[4 * i]);
+        const __m128i lo =
+            Blend_SSE4_1(_mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi8(s, zero),
+                         Alpha_SSE4_1(_mm_unpacklo_epi8(sa, zero), va));
+        const __m128i hi =
+            Blend_SSE4_1(_mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi8(s, zero),
+                         Alpha_SSE4_1(_mm_unpackhi_epi8(sa, zero), va));
+        _mm_storeu_si128((__m128i *)&dst[4 * i], _mm_packus_epi16(lo, hi));
+    }
+
+    Rgbx_C(&dst[4 * i], &src[4 * i], alpha, n - i, offsets);
+}
+
+static const struct blend_kernels kernels_sse4_1 =
+{
+    "SSE4.1", Plane_SSE4_1, ChromaPlanar_SSE4_1, ChromaPacked_SSE4_1,
+    Rgbx_SSE4_1,
+};
+#endif
+
+#ifdef BLEND_AVX2
+VLC_AVX2
+static inline __m256i Div255_AVX2(__m256i v)
+{
+    v = _mm256_add_epi16(v, _mm256_srli_epi16(v, 8));
+    return _mm256_srli_epi16(_mm256_add_epi16(v, _mm256_set1_epi16(1)), 8);
+}
+
+VLC_AVX2
+static inline __m256i Alpha_AVX2(__m256i sa, __m256i alpha)
+{
+    return Div255_AVX2(_mm256_mullo_epi16(sa, alpha));
+}
+
+VLC_AVX2
+static inline __m256i Blend_AVX2(__m256i d, __m256i s, __m256i a)
+{
+    const __m256i ia = _mm256_sub_epi16(_mm256_set1_epi16(255), a);
+    return Div255_AVX2(_mm256_add_epi16(_mm256_mullo_epi16(ia, d),
+                                        _mm256_mullo_epi16(a, s)));
+}
+
+/* Packs 16 lanes to 16 bytes, in order */
+VLC_AVX2
+static inline __m128i Pack_AVX2(__m256i v)
+{
+    return _mm256_castsi256_si128(
+        _mm256_permute4x64_epi64(_mm256_packus_epi16(v, v), 0x08));
+}
+
+VLC_AVX2
+static void Plane_AVX2(uint8_t *dst, const uint8_t *src,
+                       const uint8_t *src_a, unsigned alpha, unsigned n)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i va = _mm256_set1_epi16(alpha);
+    unsigned i = 0;
+
+    for (; i + 32 <= n; i += 32)
+    {
+        const __m256i sa = _mm256_loadu_si256((const __m256i *)&src_a[i]);
+        if (_mm256_testz_si256(sa, sa))
+            continue;
+
+        /* unpack and pack both work within 128-bit lanes, so the samples
+         * come back in order */
+        const __m256i s = _mm256_loadu_si256((const __m256i *)&src[i]);
+        const __m256i d = _mm256_loadu_si256((const __m256i *)&dst[i]);
+        const __m256i lo =
+            Blend_AVX2(_mm256_unpacklo_epi8(d, zero), _mm256_unpacklo_epi8(s, zero),
+                       Alpha_AVX2(_mm256_unpacklo_epi8(sa, zero), va));
+        const __m256i hi =
+            Blend_AVX2(_mm256_unpackhi_epi8(d, zero), _mm256_unpackhi_epi8(s, zero),
+                       Alpha_AVX2(_mm256_unpackhi_epi8(sa, zero), va));
+        _mm256_storeu_si256((__m256i *)&dst[i], _mm256_packus_epi16(lo, hi));
+    }
+
+    Plane_SSE4_1(&dst[i], &src[i], &src_a[i], alpha, n - i);
+}
+
+VLC_AVX2
+static inline void ChromaLine_AVX2(uint8_t *dst, const uint8_t *src, __m256i a)
+{
+    const __m256i even = _mm256_set1_epi16(0x00ff);
+    const __m256i d = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)dst));
+    const __m256i s = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)src), even);
+
+    _mm_storeu_si128((__m128i *)dst, Pack_AVX2(Blend_AVX2(d, s, a)));
+}
+
+VLC_AVX2
+static void ChromaPlanar_AVX2(uint8_t *dst_u, uint8_t *dst_v,
+                              const uint8_t *src_u, const uint8_t *src_v,
+                              const uint8_t *src_a, unsigned alpha, unsigned n)
+{
+    const __m256i even = _mm256_set1_epi16(0x00ff);
+    const __m256i va = _mm256_set1_epi16(alpha);
+    unsigned i = 0;
+
+    for (; i + 16 < n; i += 16)
+    {
+        const __m256i sa = _mm256_and_si256(
+            _mm256_loadu_si256((const __m256i *)&src_a[2 * i]), even);
+        if (_mm256_testz_si256(sa, sa))
+            continue;
+
+        const __m256i a = Alpha_AVX2(sa, va);
+        ChromaLine_AVX2(&dst_u[i], &src_u[2 * i], a);
+        ChromaLine_AVX2(&dst_v[i], &src_v[2 * i], a);
+    }
+
+    ChromaPlanar_SSE4_1(&dst_u[i], &dst_v[i], &src_u[2 * i], &src_v[2 * i],
+                        &src_a[2 * i], alpha, n - i);
+}
+
+VLC_AVX2
+static void ChromaPacked_AVX2(uint8_t *dst_uv,
+                              const uint8_t *src_u, const uint8_t *src_v,
+                              const uint8_t *src_a, unsigned alpha, unsigned n)
+{
+    const __m256i even = _mm256_set1_epi16(0x00ff);
+    const __m256i va = _mm256_set1_epi16(alpha);
+    unsigned i = 0;
+
+    for (; i + 16 < n; i += 16)
+    {
+        const __m256i sa = _mm256_and_si256(
+            _mm256_loadu_si256((const __m256i *)&src_a[2 * i]), even);
+        if (_mm256_testz_si256(sa, sa))
+            continue;
+
+        const __m256i su = _mm256_and_si256(
+            _mm256_loadu_si256((const __m256i *)&src_u[2 * i]), even);
+        const __m256i sv = _mm256_and_si256(
+            _mm256_loadu_si256((const __m256i *)&src_v[2 * i]), even);
+        const __m256i a = Alpha_AVX2(sa, va);
+
+        /* Interleave within lanes, then put the pairs back in order */
+        const __m256i uv_lo = _mm256_unpacklo_epi16(su, sv);
+        const __m256i uv_hi = _mm256_unpackhi_epi16(su, sv);
+        const __m256i aa_lo = _mm256_unpacklo_epi16(a, a);
+        const __m256i aa_hi = _mm256_unpackhi_epi16(a, a);
+        const __m256i s0 = _mm256_permute2x128_si256(uv_lo, uv_hi, 0x20);
+        const __m256i s1 = _mm256_permute2x128_si256(uv_lo, uv_hi, 0x31);
+        const __m256i a0 = _mm256_permute2x128_si256(aa_lo, aa_hi, 0x20);
+        const __m256i a1 = _mm256_permute2x128_si256(aa_lo, aa_hi, 0x31);
+
+        const __m256i d0 = _mm256_cvtepu8_epi16(
+            _mm_loadu_si128((const __m128i *)&dst_uv[2 * i]));
+        const __m256i d1 = _mm256_cvtepu8_epi16(
+            _mm_loadu_si128((const __m128i *)&dst_uv[2 * i + 16]));
+        const __m256i r = _mm256_packus_epi16(Blend_AVX2(d0, s0, a0),
+                                              Blend_AVX2(d1, s1, a1));
+        _mm256_storeu_si256((__m256i *)&dst_uv[2 * i],
+                            _mm256_permute4x64_epi64(r, 0xD8));
+    }
+
+    ChromaPacked_SSE4_1(&dst_uv[2 * i], &src_u[2 * i], &src_v[2 * i],
+                        &src_a[2 * i], alpha, n - i);
+}
+
+VLC_AVX2
+static void Rgbx_AVX2(uint8_t *dst, const uint8_t *src, unsigned alpha,
+                      unsigned n, const unsigned offsets[3])
+{
+    uint8_t shuf_rgb[32], shuf_a[32];
+    RgbxShuffles(offsets, shuf_rgb, shuf_a, 32);
+
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i va = _mm256_set1_epi16(alpha);
+    const __m256i mrgb = _mm256_loadu_si256((const __m256i *)shuf_rgb);
+    const __m256i ma = _mm256_loadu_si256((const __m256i *)shuf_a);
+    unsigned i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        const __m256i px = _mm256_loadu_si256((const __m256i *)&src[4 * i]);
+        const __m256i sa = _mm256_shuffle_epi8(px, ma);
+        if (_mm256_testz_si256(sa, sa))
+            continue;
+
+        const __m256i s = _mm256_shuffle_epi8(px, mrgb);
+        const __m256i d = _mm256_loadu_si256((const __m256i *)&dst[4 * i]);
+        const __m256i lo =
+            Blend_AVX2(_mm256_unpacklo_epi8(d, zero), _mm256_unpacklo_epi8(s, zero),
+                       Alpha_AVX2(_mm256_unpacklo_epi8(sa, zero), va));
+        const __m256i hi =
+            Blend_AVX2(_mm256_unpackhi_epi8(d, zero), _mm256_unpackhi_epi8(s, zero),
+                       Alpha_AVX2(_mm256_unpackhi_epi8(sa, zero), va));
+        _mm256_storeu_si256((__m256i *)&dst[4 * i], _mm256_packus_epi16(lo, hi));
+    }
+
+    Rgbx_SSE4_1(&dst[4 * i], &src[4 * i], alpha, n - i, offsets);
+}
+
+static const struct blend_kernels kernels_avx2 =
+{
+    "AVX2", Plane_AVX2, ChromaPlanar_AVX2, ChromaPacked_AVX2, Rgbx_AVX2,
+};
+#endif
+
+#ifdef BLEND_NEON
+static inline uint16x8_t Div255_NEON(uint16x8_t v)
+{
+    v = vaddq_u16(v, vshrq_n_u16(v, 8));
+    return vshrq_n_u16(vaddq_u16(v, vdupq_n_u16(1)), 8);
+}
+
+static inline uint16x8_t Alpha_NEON(uint8x8_t sa, uint16x8_t alpha)
+{
+    return Div255_NEON(vmulq_u16(vmovl_u8(sa), alpha));
+}
+
+static inline uint8x8_t Blend_NEON(uint8x8_t d, uint8x8_t s, uint16x8_t a)
+{
+    const uint16x8_t ia = vsubq_u16(vdupq_n_u16(255), a);
+    const uint16x8_t v = vmlaq_u16(vmulq_u16(vmovl_u8(s), a), vmovl_u8(d), ia);
+    return vmovn_u16(Div255_NEON(v));
+}
+
+static inline uint8x16_t Blend16_NEON(uint8x16_t d, uint8x16_t s,
+                                      uint16x8_t a_lo, uint16x8_t a_hi)
+{
+    return vcombine_u8(Blend_NEON(vget_low_u8(d), vget_low_u8(s), a_lo),
+                       Blend_NEON(vget_high_u8(d), vget_high_u8(s), a_hi));
+}
+
+static inline bool IsZero_NEON(uint8x16_t v)
+{
+    const uint64x2_t v64 = vreinterpretq_u64_u8(v);
+    return (vgetq_lane_u64(v64, 0) | vgetq_lane_u64(v64, 1)) == 0;
+}
+
+static void Plane_NEON(uint8_t *dst, const uint8_t *src,
+                       const uint8_t *src_a, unsigned alpha, unsigned n)
+{
+    const uint16x8_t va = vdupq_n_u16(alpha);
+    unsigned i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        const uint8x16_t sa = vld1q_u8(&src_a[i]);
+        if (IsZero_NEON(sa))
+            continue;
+
+        const uint16x8_t a_lo = Alpha_NEON(vget_low_u8(sa), va);
+        const uint16x8_t a_hi = Alpha_NEON(vget_high_u8(sa), va);
+        vst1q_u8(&dst[i], Blend16_NEON(vld1q_u8(&dst[i]), vld1q_u8(&src[i]),
+                                       a_lo, a_hi));
+    }
+
+    Plane_C(&dst[i], &src[i], &src_a[i], alpha, n - i);
+}
+
+static void ChromaPlanar_NEON(uint8_t *dst_u, uint8_t *dst_v,
+                              const uint8_t *src_u, const uint8_t *src_v,
+                              const uint8_t *src_a, unsigned alpha, unsigned n)
+{
+    const uint16x8_t va = vdupq_n_u16(alpha);
+    unsigned i = 0;
+
+    for (; i + 16 < n; i += 16)
+    {
+        const uint8x16_t sa = vld2q_u8(&src_a[2 * i]).val[0];
+        if (IsZero_NEON(sa))
+            continue;
+
+        const uint16x8_t a_lo = Alpha_NEON(vget_low_u8(sa), va);
+        const uint16x8_t a_hi = Alpha_NEON(vget_high_u8(sa), va);
+        vst1q_u8(&dst_u[i], Blend16_NEON(vld1q_u8(&dst_u[i]),
+                                         vld2q_u8(&src_u[2 * i]).val[0],
+                                         a_lo, a_hi));
+        vst1q_u8(&dst_v[i], Blend16_NEON(vld1q_u8(&dst_v[i]),
+                                         vld2q_u8(&src_v[2 * i]).val[0],
+                                         a_lo, a_hi));
+    }
+
+    ChromaPlanar_C(&dst_u[i], &dst_v[i], &src_u[2 * i], &src_v[2 * i],
+                   &src_a[2 * i], alpha, n - i);
+}
+
+static void ChromaPacked_NEON(uint8_t *dst_uv,
+                              const uint8_t *src_u, const uint8_t *src_v,
+                              const uint8_t *src_a, unsigned alpha, unsigned n)
+{
+    const uint16x8_t va = vdupq_n_u16(alpha);
+    unsigned i = 0;
+
+    for (; i + 16 < n; i += 16)
+    {
+        const uint8x16_t sa = vld2q_u8(&src_a[2 * i]).val[0];
+        if (IsZero_NEON(sa))
+            continue;
+
+        const uint16x8_t a_lo = Alpha_NEON(vget_low_u8(sa), va);
+        const uint16x8_t a_hi = Alpha_NEON(vget_high_u8(sa), va);
+        uint8x16x2_t d = vld2q_u8(&dst_uv[2 * i]);
+        d.val[0] = Blend16_NEON(d.val[0], vld2q_u8(&src_u[2 * i]).val[0],
+                                a_lo, a_hi);
+        d.val[1] = Blend16_NEON(d.val[1], vld2q_u8(&src_v[2 * i]).val[0],
+                                a_lo, a_hi);
+        vst2q_u8(&dst_uv[2 * i], d);
+    }
+
+    ChromaPacked_C(&dst_uv[2 * i], &src_u[2 * i], &src_v[2 * i],
+                   &src_a[2 * i], alpha, n - i);
+}
+
+static void Rgbx_NEON(uint8_t *dst, const uint8_t *src, unsigned alpha,
+                      unsigned n, const unsigned offsets[3])
+{
+    const uint16x8_t va = vdupq_n_u16(alpha);
+    unsigned i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        /* Structure loads split the channels, whatever their order */
+        const uint8x16x4_t s = vld4q_u8(&src[4 * i]);
+        if (IsZero_NEON(s.val[3]))
+            continue;
+
+        const uint16x8_t a_lo = Alpha_NEON(vget_low_u8(s.val[3]), va);
+        const uint16x8_t a_hi = Alpha_NEON(vget_high_u8(s.val[3]), va);
+        uint8x16x4_t d = vld4q_u8(&dst[4 * i]);
+        for (unsigned c = 0; c < 3; c++)
+            d.val[offsets[c]] = Blend16_NEON(d.val[offsets[c]], s.val[c],
+                                             a_lo, a_hi);
+        vst4q_u8(&dst[4 * i], d);
+    }
+
+    Rgbx_C(&dst[4 * i], &src[4 * i], alpha, n - i, offsets);
+}
+
+static const struct blend_kernels kernels_neon =
+{
+    "NEON", Plane_NEON, ChromaPlanar_NEON, ChromaPacked_NEON, Rgbx_NEON,
+};
+#endif
+
+const struct blend_kernels *blend_kernels_Get(unsigned cpu)
+{
+#ifdef BLEND_AVX2
+    if (cpu & VLC_CPU_AVX2)
+        return &kernels_avx2;
+#endif
+#ifdef BLEND_SSE4_1
+    if (cpu & VLC_CPU_SSE4_1)
+        return &kernels_sse4_1;
+#endif
+#ifdef BLEND_NEON
+    if (cpu & VLC_CPU_ARM_NEON)
+        return &kernels_neon;
+#endif
+    VLC_UNUSED(cpu);
+    return &blend_kernels_c;
+}
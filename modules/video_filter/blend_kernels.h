@@ -0,0 +1,68 @@
+/*****************************************************************************
+ * blend_kernels.h: line blending kernels
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef VLC_BLEND_KERNELS_H
+#define VLC_BLEND_KERNELS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Kernels blending one line of 8-bit samples with a per sample alpha.
+ *
+ * Each destination sample d is replaced by
+ * div255((255 - a) * d + s * a) with a = div255(alpha * sa), which is the
+ * exact result of the generic blender, so every implementation produces
+ * the same pictures.
+ */
+struct blend_kernels
+{
+    const char *name;
+
+    /** Blends n samples of src onto dst */
+    void (*plane)(uint8_t *dst, const uint8_t *src, const uint8_t *src_a,
+                  unsigned alpha, unsigned n);
+    /** Blends every other sample of src_u/src_v onto n samples of the
+     * horizontally subsampled dst_u/dst_v planes */
+    void (*chroma_planar)(uint8_t *dst_u, uint8_t *dst_v,
+                          const uint8_t *src_u, const uint8_t *src_v,
+                          const uint8_t *src_a, unsigned alpha, unsigned n);
+    /** Same as chroma_planar, with dst_uv holding n interleaved U/V pairs */
+    void (*chroma_packed)(uint8_t *dst_uv,
+                          const uint8_t *src_u, const uint8_t *src_v,
+                          const uint8_t *src_a, unsigned alpha, unsigned n);
+    /** Blends n RGBA pixels onto 32-bit pixels whose R, G and B bytes are
+     * at the given offsets, leaving the fourth byte untouched */
+    void (*rgbx)(uint8_t *dst, const uint8_t *src, unsigned alpha,
+                 unsigned n, const unsigned offsets[3]);
+};
+
+extern const struct blend_kernels blend_kernels_c;
+
+/**
+ * Returns the fastest kernels usable with the given VLC_CPU_* capabilities.
+ */
+const struct blend_kernels *blend_kernels_Get(unsigned cpu);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
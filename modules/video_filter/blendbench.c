@@ -55,18 +55,31 @@ static picture_t *Filter( filter_t *, picture_t * );
 #define ALPHA_TEXT N_("Alpha of the blended image")
 #define ALPHA_LONGTEXT N_("Alpha with which the blend image is blended")
 
+#define WIDTH_TEXT N_("Width of the generated images")
+#define WIDTH_LONGTEXT N_("Width of the images generated when no image " \
+                          "file is given")
+
+#define HEIGHT_TEXT N_("Height of the generated images")
+#define HEIGHT_LONGTEXT N_("Height of the images generated when no image " \
+                           "file is given")
+
 #define BASE_IMAGE_TEXT N_("Image to be blended onto")
-#define BASE_IMAGE_LONGTEXT N_("The image which will be used to blend onto")
+#define BASE_IMAGE_LONGTEXT N_("The image which will be used to blend onto. " \
+                               "A test pattern is generated if none is given")
 
-#define BASE_CHROMA_TEXT N_("Chroma for the base image")
-#define BASE_CHROMA_LONGTEXT N_("Chroma which the base image will be loaded in")
+#define BASE_CHROMA_TEXT N_("Chromas for the base image")
+#define BASE_CHROMA_LONGTEXT N_("Comma separated list of chromas which the " \
+                                "base image will be loaded in")
 
 #define BLEND_IMAGE_TEXT N_("Image which will be blended")
-#define BLEND_IMAGE_LONGTEXT N_("The image blended onto the base image")
+#define BLEND_IMAGE_LONGTEXT N_("The image blended onto the base image. " \
+                                "A subtitle like overlay is generated if " \
+                                "none is given")
 
-#define BLEND_CHROMA_TEXT N_("Chroma for the blend image")
-#define BLEND_CHROMA_LONGTEXT N_("Chroma which the blend image will be loaded" \
-                                 " in")
+#define BLEND_CHROMA_TEXT N_("Chromas for the blend image")
+#define BLEND_CHROMA_LONGTEXT N_("Comma separated list of chromas which the " \
+                                 "blend image will be loaded in. Each one is " \
+                                 "benchmarked onto every base chroma")
 
 #define CFG_PREFIX "blendbench-"
 
@@ -80,40 +93,44 @@ vlc_module_begin ()
               LOOPS_LONGTEXT )
     add_integer_with_range( CFG_PREFIX "alpha", 128, 0, 255, ALPHA_TEXT,
               ALPHA_LONGTEXT )
+    add_integer_with_range( CFG_PREFIX "width", 1920, 16, 8192, WIDTH_TEXT,
+              WIDTH_LONGTEXT )
+    add_integer_with_range( CFG_PREFIX "height", 1080, 16, 8192, HEIGHT_TEXT,
+              HEIGHT_LONGTEXT )
 
     set_section( N_("Base image"), NULL )
     add_loadfile(CFG_PREFIX "base-image", NULL,
                  BASE_IMAGE_TEXT, BASE_IMAGE_LONGTEXT)
-    add_string( CFG_PREFIX "base-chroma", "I420", BASE_CHROMA_TEXT,
+    add_string( CFG_PREFIX "base-chroma", "I420,NV12,RV32", BASE_CHROMA_TEXT,
               BASE_CHROMA_LONGTEXT )
 
     set_section( N_("Blend image"), NULL )
     add_loadfile(CFG_PREFIX "blend-image", NULL,
                  BLEND_IMAGE_TEXT, BLEND_IMAGE_LONGTEXT)
-    add_string( CFG_PREFIX "blend-chroma", "YUVA", BLEND_CHROMA_TEXT,
+    add_string( CFG_PREFIX "blend-chroma", "YUVA,RGBA", BLEND_CHROMA_TEXT,
               BLEND_CHROMA_LONGTEXT )
 
     set_callback_video_filter( Create )
 vlc_module_end ()
 
 static const char *const ppsz_filter_options[] = {
-    "loops", "alpha", "base-image", "base-chroma", "blend-image",
-    "blend-chroma", NULL
+    "loops", "alpha", "width", "height", "base-image", "base-chroma",
+    "blend-image", "blend-chroma", NULL
 };
 
 /*****************************************************************************
  * filter_sys_t: filter method descriptor
  *****************************************************************************/
+#define BLENDBENCH_MAX_CHROMAS 16
+
 typedef struct
 {
     bool b_done;
     int i_loops, i_alpha;
 
-    picture_t *p_base_image;
-    picture_t *p_blend_image;
-
-    vlc_fourcc_t i_base_chroma;
-    vlc_fourcc_t i_blend_chroma;
+    size_t i_base, i_blend;
+    picture_t *pp_base_images[BLENDBENCH_MAX_CHROMAS];
+    picture_t *pp_blend_images[BLENDBENCH_MAX_CHROMAS];
 } filter_sys_t;
 
 static int blendbench_LoadImage( vlc_object_t *p_this, picture_t **pp_pic,
@@ -142,6 +159,136 @@ static int blendbench_LoadImage( vlc_object_t *p_this, picture_t **pp_pic,
     return VLC_SUCCESS;
 }
 
+static int blendbench_GenerateImage( vlc_object_t *p_this, picture_t **pp_pic,
+                                     vlc_fourcc_t i_chroma, unsigned i_width,
+                                     unsigned i_height, const char *psz_name,
+                                     bool b_overlay )
+{
+    video_format_t fmt;
+    plane_t *p_alpha = NULL;
+    unsigned i_alpha_step = 1, i_alpha_offset = 0;
+
+    video_format_Init( &fmt, i_chroma );
+    video_format_Setup( &fmt, i_chroma, i_width, i_height,
+                        i_width, i_height, 1, 1 );
+    *pp_pic = picture_NewFromFormat( &fmt );
+    video_format_Clean( &fmt );
+    if( *pp_pic == NULL )
+        return VLC_ENOMEM;
+
+    picture_t *p_pic = *pp_pic;
+    if( b_overlay )
+    {
+        switch( i_chroma )
+        {
+            case VLC_CODEC_YUVA:
+                p_alpha = &p_pic->p[A_PLANE];
+                break;
+            case VLC_CODEC_RGBA:
+            case VLC_CODEC_BGRA:
+                p_alpha = &p_pic->p[0];
+                i_alpha_step = 4;
+                i_alpha_offset = 3;
+                break;
+            default:
+                msg_Err( p_this, "Unable to generate a %4.4s %s image",
+                         (const char *)&i_chroma, psz_name );
+                picture_Release( p_pic );
+                *pp_pic = NULL;
+                return VLC_EGENERIC;
+        }
+    }
+
+    /* Fixed patterns, so that the results of different runs compare */
+    for( int i = 0; i < p_pic->i_planes; i++ )
+    {
+        plane_t *p = &p_pic->p[i];
+        for( int y = 0; y < p->i_lines; y++ )
+            for( int x = 0; x < p->i_pitch; x++ )
+                p->p_pixels[y * p->i_pitch + x] = x * 7 + y * 3 + i * 64;
+    }
+
+    /* Mostly transparent, with text like lines at the bottom */
+    if( p_alpha != NULL )
+    {
+        for( unsigned y = 0; y < i_height; y++ )
+        {
+            uint8_t *p_line = &p_alpha->p_pixels[y * p_alpha->i_pitch];
+            for( unsigned x = 0; x < i_width; x++ )
+            {
+                uint8_t i_a = 0;
+                if( y >= i_height * 3 / 4 )
+                {
+                    const unsigned i_cell = ( x / 8 + y / 8 ) % 4;
+                    i_a = i_cell == 0 ? 255 : i_cell == 1 ? 128 : 0;
+                }
+                p_line[x * i_alpha_step + i_alpha_offset] = i_a;
+            }
+        }
+    }
+
+    msg_Dbg( p_this, "%s image generated with dim %u x %u", psz_name,
+             i_width, i_height );
+    return VLC_SUCCESS;
+}
+
+static int blendbench_LoadImages( filter_t *p_filter, picture_t **pp_pics,
+                                  size_t *pi_count, const char *psz_var,
+                                  const char *psz_file_var,
+                                  const char *psz_name, bool b_overlay )
+{
+    char *psz_chromas = var_CreateGetStringCommand( p_filter, psz_var );
+    char *psz_file = var_CreateGetStringCommand( p_filter, psz_file_var );
+    const unsigned i_width = var_CreateGetIntegerCommand( p_filter,
+                                                          CFG_PREFIX "width" );
+    const unsigned i_height = var_CreateGetIntegerCommand( p_filter,
+                                                           CFG_PREFIX "height" );
+    char *psz_save;
+    int i_ret = VLC_SUCCESS;
+
+    *pi_count = 0;
+    for( char *psz_chroma = strtok_r( psz_chromas, ",", &psz_save );
+         psz_chroma != NULL && i_ret == VLC_SUCCESS;
+         psz_chroma = strtok_r( NULL, ",", &psz_save ) )
+    {
+        if( strlen( psz_chroma ) != 4 || *pi_count == BLENDBENCH_MAX_CHROMAS )
+        {
+            msg_Err( p_filter, "Invalid %s chroma %s", psz_name, psz_chroma );
+            i_ret = VLC_EGENERIC;
+            break;
+        }
+
+        const vlc_fourcc_t i_chroma = VLC_FOURCC( psz_chroma[0], psz_chroma[1],
+                                                  psz_chroma[2], psz_chroma[3] );
+        if( psz_file != NULL && *psz_file != '\0' )
+            i_ret = blendbench_LoadImage( VLC_OBJECT(p_filter),
+                                          &pp_pics[*pi_count], i_chroma,
+                                          psz_file, psz_name );
+        else
+            i_ret = blendbench_GenerateImage( VLC_OBJECT(p_filter),
+                                              &pp_pics[*pi_count], i_chroma,
+                                              i_width, i_height, psz_name,
+                                              b_overlay );
+        if( i_ret == VLC_SUCCESS )
+            (*pi_count)++;
+    }
+    free( psz_chromas );
+    free( psz_file );
+
+    if( i_ret == VLC_SUCCESS && *pi_count == 0 )
+    {
+        msg_Err( p_filter, "No %s chroma", psz_name );
+        i_ret = VLC_EGENERIC;
+    }
+    if( i_ret != VLC_SUCCESS )
+    {
+        for( size_t i = 0; i < *pi_count; i++ )
+            picture_Release( pp_pics[i] );
+        *pi_count = 0;
+    }
+    return i_ret;
+}
+
 static const struct vlc_filter_operations filter_ops =
 {
     .filter_video = Filter, .close = Destroy,
@@ -153,7 +300,6 @@ static const struct vlc_filter_operations filter_ops =
 static int Create( filter_t *p_filter )
 {
     filter_sys_t *p_sys;
-    char *psz_temp, *psz_cmd;
     int i_ret;
 
     /* Allocate structure */
@@ -176,34 +322,22 @@ static int Create( filter_t *p_filter )
     p_sys->i_alpha = var_CreateGetIntegerCommand( p_filter,
                                                   CFG_PREFIX "alpha" );
 
-    psz_temp = var_CreateGetStringCommand( p_filter, CFG_PREFIX "base-chroma" );
-    p_sys->i_base_chroma = !psz_temp || strlen( psz_temp ) != 4 ? 0 :
-        VLC_FOURCC( psz_temp[0], psz_temp[1], psz_temp[2], psz_temp[3] );
-    psz_cmd = var_CreateGetStringCommand( p_filter, CFG_PREFIX "base-image" );
-    i_ret = blendbench_LoadImage( VLC_OBJECT(p_filter), &p_sys->p_base_image,
-                                  p_sys->i_base_chroma, psz_cmd, "Base" );
-    free( psz_temp );
-    free( psz_cmd );
+    i_ret = blendbench_LoadImages( p_filter, p_sys->pp_base_images,
+                                   &p_sys->i_base, CFG_PREFIX "base-chroma",
+                                   CFG_PREFIX "base-image", "Base", false );
     if( i_ret != VLC_SUCCESS )
     {
         free( p_sys );
         return i_ret;
     }
 
-    psz_temp = var_CreateGetStringCommand( p_filter,
-                                           CFG_PREFIX "blend-chroma" );
-    p_sys->i_blend_chroma = !psz_temp || strlen( psz_temp ) != 4
-        ? 0 : VLC_FOURCC( psz_temp[0], psz_temp[1], psz_temp[2], psz_temp[3] );
-    psz_cmd = var_CreateGetStringCommand( p_filter, CFG_PREFIX "blend-image" );
-    i_ret = blendbench_LoadImage( VLC_OBJECT(p_filter), &p_sys->p_blend_image, p_sys->i_blend_chroma,
-                                  psz_cmd, "Blend" );
-
-    free( psz_temp );
-    free( psz_cmd );
-
+    i_ret = blendbench_LoadImages( p_filter, p_sys->pp_blend_images,
+                                   &p_sys->i_blend, CFG_PREFIX "blend-chroma",
+                                   CFG_PREFIX "blend-image", "Blend", true );
     if( i_ret != VLC_SUCCESS )
     {
-        picture_Release( p_sys->p_base_image );
+        for( size_t i = 0; i < p_sys->i_base; i++ )
+            picture_Release( p_sys->pp_base_images[i] );
         free( p_sys );
 
         return VLC_EGENERIC;
@@ -219,58 +353,81 @@ static void Destroy( filter_t *p_filter )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
 
-    picture_Release( p_sys->p_base_image );
-    picture_Release( p_sys->p_blend_image );
+    for( size_t i = 0; i < p_sys->i_base; i++ )
+        picture_Release( p_sys->pp_base_images[i] );
+    for( size_t i = 0; i < p_sys->i_blend; i++ )
+        picture_Release( p_sys->pp_blend_images[i] );
+    free( p_sys );
 }
 
 /*****************************************************************************
- * Render: displays previously rendered output
+ * blendbench_Run: benchmarks one combination of chromas
  *****************************************************************************/
-static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+static void blendbench_Run( filter_t *p_filter, picture_t *p_base,
+                            picture_t *p_blend_image )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
+    const vlc_fourcc_t i_base_chroma = p_base->format.i_chroma;
+    const vlc_fourcc_t i_blend_chroma = p_blend_image->format.i_chroma;
     filter_t *p_blend;
 
-    if( p_sys->b_done )
-        return p_pic;
-
     p_blend = vlc_object_create( p_filter, sizeof(filter_t) );
     if( !p_blend )
-    {
-        picture_Release( p_pic );
-        return NULL;
-    }
-    p_blend->fmt_out.video = p_sys->p_base_image->format;
-    p_blend->fmt_in.video = p_sys->p_blend_image->format;
+        return;
+    p_blend->fmt_out.video = p_base->format;
+    p_blend->fmt_in.video = p_blend_image->format;
     p_blend->p_module = module_need( p_blend, "video blending", NULL, false );
     if( !p_blend->p_module )
     {
-        picture_Release( p_pic );
+        msg_Warn( p_filter, "%4.4s onto %4.4s: no blending module",
+                  (const char *)&i_blend_chroma, (const char *)&i_base_chroma );
         vlc_object_delete(p_blend);
-        return NULL;
+        return;
     }
     assert( p_blend->ops != NULL );
 
     vlc_tick_t time = vlc_tick_now();
     for( int i_iter = 0; i_iter < p_sys->i_loops; ++i_iter )
     {
-        filter_Blend( p_blend, p_sys->p_base_image,
-                      0, 0, p_sys->p_blend_image, p_sys->i_alpha );
+        filter_Blend( p_blend, p_base, 0, 0, p_blend_image, p_sys->i_alpha );
     }
     time = vlc_tick_now() - time;
-
-    msg_Info( p_filter, "Blended %d images in %f sec", p_sys->i_loops,
-              secf_from_vlc_tick(time) );
-    msg_Info( p_filter, "Speed is: %f images/second, %f pixels/second",
-              (float) p_sys->i_loops / time * CLOCK_FREQ,
-              (float) p_sys->i_loops / time * CLOCK_FREQ *
-                  p_sys->p_blend_image->p[Y_PLANE].i_visible_pitch *
-                  p_sys->p_blend_image->p[Y_PLANE].i_visible_lines );
+    if( time <= 0 )
+        time = 1;
+
+    const double f_pixels =
+        (double) __MIN( p_base->format.i_visible_width,
+                        p_blend_image->format.i_visible_width ) *
+                 __MIN( p_base->format.i_visible_height,
+                        p_blend_image->format.i_visible_height );
+    const double f_rate = (double) p_sys->i_loops / time * CLOCK_FREQ;
+
+    msg_Info( p_filter, "%4.4s onto %4.4s: blended %d images in %f sec, "
+              "%f images/second, %f Mpixels/second",
+              (const char *)&i_blend_chroma, (const char *)&i_base_chroma,
+              p_sys->i_loops, secf_from_vlc_tick(time), f_rate,
+              f_rate * f_pixels / 1000000. );
 
     filter_Close( p_blend );
     module_unneed( p_blend, p_blend->p_module );
 
     vlc_object_delete(p_blend);
+}
+
+/*****************************************************************************
+ * Render: displays previously rendered output
+ *****************************************************************************/
+static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    if( p_sys->b_done )
+        return p_pic;
+
+    for( size_t i = 0; i < p_sys->i_base; i++ )
+        for( size_t j = 0; j < p_sys->i_blend; j++ )
+            blendbench_Run( p_filter, p_sys->pp_base_images[i],
+                            p_sys->pp_blend_images[j] );
 
     p_sys->b_done = true;
     return p_pic;
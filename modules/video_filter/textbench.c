@@ -0,0 +1,415 @@
+/*****************************************************************************
+ * textbench.c : text rendering benchmark plugin for vlc
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*****************************************************************************
+ * Preamble
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_modules.h>
+#include <vlc_fs.h>
+#include <vlc_memstream.h>
+#include <vlc_vector.h>
+
+#include <vlc_filter.h>
+#include <vlc_subpicture.h>
+#include <vlc_text_style.h>
+
+#include <assert.h>
+#include <ctype.h>
+
+/*****************************************************************************
+ * Local prototypes
+ *****************************************************************************/
+static int Create( filter_t * );
+static void Destroy( filter_t * );
+
+static picture_t *Filter( filter_t *, picture_t * );
+
+/*****************************************************************************
+ * Module descriptor
+ *****************************************************************************/
+
+#define LOOPS_TEXT N_("Number of passes")
+#define LOOPS_LONGTEXT N_("The number of times every subtitle event will " \
+                          "be rendered")
+
+#define WIDTH_TEXT N_("Width of the video")
+#define WIDTH_LONGTEXT N_("Width of the video the subtitles are rendered for")
+
+#define HEIGHT_TEXT N_("Height of the video")
+#define HEIGHT_LONGTEXT N_("Height of the video the subtitles are rendered for")
+
+#define FILE_TEXT N_("Subtitles file")
+#define FILE_LONGTEXT N_("SubRip file whose events will be rendered. " \
+                         "Generated events are used if none is given")
+
+#define KARAOKE_TEXT N_("Karaoke updates")
+#define KARAOKE_LONGTEXT N_("Render every event once per word, with the " \
+                            "text growing word by word, as rapidly updating " \
+                            "subtitles do")
+
+#define CFG_PREFIX "textbench-"
+
+#define TEXTBENCH_GENERATED_EVENTS 1000
+
+vlc_module_begin ()
+    set_description( N_("Text rendering benchmark filter") )
+    set_shortname( N_("Textbench" ))
+    set_subcategory( SUBCAT_VIDEO_VFILTER )
+
+    set_section( N_("Benchmarking"), NULL )
+    add_integer( CFG_PREFIX "loops", 3, LOOPS_TEXT,
+              LOOPS_LONGTEXT )
+    add_integer_with_range( CFG_PREFIX "width", 1920, 16, 8192, WIDTH_TEXT,
+              WIDTH_LONGTEXT )
+    add_integer_with_range( CFG_PREFIX "height", 1080, 16, 8192, HEIGHT_TEXT,
+              HEIGHT_LONGTEXT )
+    add_loadfile(CFG_PREFIX "file", NULL, FILE_TEXT, FILE_LONGTEXT)
+    add_bool( CFG_PREFIX "karaoke", false, KARAOKE_TEXT, KARAOKE_LONGTEXT )
+
+    set_callback_video_filter( Create )
+vlc_module_end ()
+
+static const char *const ppsz_filter_options[] = {
+    "loops", "width", "height", "file", "karaoke", NULL
+};
+
+/*****************************************************************************
+ * filter_sys_t: filter method descriptor
+ *****************************************************************************/
+typedef struct
+{
+    bool b_done;
+    bool b_karaoke;
+    int i_loops;
+    unsigned i_width, i_height;
+
+    struct VLC_VECTOR(char *) events;
+} filter_sys_t;
+
+static void textbench_Clean( filter_sys_t *p_sys )
+{
+    for( size_t i = 0; i < p_sys->events.size; i++ )
+        free( p_sys->events.data[i] );
+    vlc_vector_destroy( &p_sys->events );
+}
+
+static int textbench_AddEvent( filter_sys_t *p_sys, struct vlc_memstream *p_ms )
+{
+    if( vlc_memstream_close( p_ms ) )
+        return VLC_ENOMEM;
+    if( !vlc_vector_push( &p_sys->events, p_ms->ptr ) )
+    {
+        free( p_ms->ptr );
+        return VLC_ENOMEM;
+    }
+    return VLC_SUCCESS;
+}
+
+/* Only the SubRip layout is understood: an index line, a timing line and
+ * the text lines, up to an empty line. Markup is rendered as is. */
+static int textbench_LoadFile( filter_t *p_filter, const char *psz_file )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    FILE *p_file = vlc_fopen( psz_file, "rt" );
+    if( !p_file )
+    {
+        msg_Err( p_filter, "Unable to open %s", psz_file );
+        return VLC_EGENERIC;
+    }
+
+    struct vlc_memstream ms;
+    bool b_event = false;
+    char *psz_line = NULL;
+    size_t i_size = 0;
+    ssize_t i_len;
+    int i_ret = VLC_SUCCESS;
+
+    while( i_ret == VLC_SUCCESS &&
+           ( i_len = getline( &psz_line, &i_size, p_file ) ) != -1 )
+    {
+        while( i_len > 0 && ( psz_line[i_len - 1] == '\n' ||
+                              psz_line[i_len - 1] == '\r' ) )
+            psz_line[--i_len] = '\0';
+
+        if( i_len == 0 )
+        {
+            if( b_event )
+                i_ret = textbench_AddEvent( p_sys, &ms );
+            b_event = false;
+            continue;
+        }
+
+        if( strstr( psz_line, "-->" ) )
+            continue;
+        if( !b_event && strspn( psz_line, "0123456789" ) == (size_t) i_len )
+            continue;
+
+        if( !b_event )
+        {
+            vlc_memstream_open( &ms );
+            b_event = true;
+        }
+        else
+            vlc_memstream_putc( &ms, '\n' );
+        vlc_memstream_write( &ms, psz_line, i_len );
+    }
+    if( b_event )
+        i_ret = textbench_AddEvent( p_sys, &ms );
+
+    free( psz_line );
+    fclose( p_file );
+
+    if( i_ret == VLC_SUCCESS && p_sys->events.size == 0 )
+    {
+        msg_Err( p_filter, "No subtitle event in %s", psz_file );
+        i_ret = VLC_EGENERIC;
+    }
+    return i_ret;
+}
+
+/* Fixed events, so that the results of different runs compare */
+static int textbench_GenerateEvents( filter_t *p_filter )
+{
+    static const char *const ppsz_words[] = {
+        "the", "subtitles", "are", "rendered", "again", "for", "every",
+        "event", "while", "karaoke", "lines", "keep", "changing", "quickly",
+        "on", "small", "boxes", "with", "slow", "processors",
+    };
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    for( unsigned i = 0; i < TEXTBENCH_GENERATED_EVENTS; i++ )
+    {
+        struct vlc_memstream ms;
+        vlc_memstream_open( &ms );
+
+        const unsigned i_words = 4 + i % 9;
+        for( unsigned j = 0; j < i_words; j++ )
+        {
+            if( j > 0 )
+                vlc_memstream_putc( &ms, j == i_words / 2 && i % 3 == 0
+                                         ? '\n' : ' ' );
+            vlc_memstream_puts( &ms,
+                ppsz_words[( i * 7 + j * 3 ) % ARRAY_SIZE(ppsz_words)] );
+        }
+
+        if( textbench_AddEvent( p_sys, &ms ) )
+            return VLC_ENOMEM;
+    }
+
+    msg_Dbg( p_filter, "%zu subtitle events generated", p_sys->events.size );
+    return VLC_SUCCESS;
+}
+
+static const struct vlc_filter_operations filter_ops =
+{
+    .filter_video = Filter, .close = Destroy,
+};
+
+/*****************************************************************************
+ * Create: allocates video thread output method
+ *****************************************************************************/
+static int Create( filter_t *p_filter )
+{
+    filter_sys_t *p_sys;
+    int i_ret;
+
+    /* Allocate structure */
+    p_filter->p_sys = malloc( sizeof( filter_sys_t ) );
+    if( p_filter->p_sys == NULL )
+        return VLC_ENOMEM;
+
+    p_sys = p_filter->p_sys;
+    p_sys->b_done = false;
+    vlc_vector_init( &p_sys->events );
+
+    p_filter->ops = &filter_ops;
+
+    /* needed to get options passed in transcode using the
+     * adjust{name=value} syntax */
+    config_ChainParse( p_filter, CFG_PREFIX, ppsz_filter_options,
+                       p_filter->p_cfg );
+
+    p_sys->i_loops = var_CreateGetIntegerCommand( p_filter,
+                                                  CFG_PREFIX "loops" );
+    p_sys->i_width = var_CreateGetIntegerCommand( p_filter,
+                                                  CFG_PREFIX "width" );
+    p_sys->i_height = var_CreateGetIntegerCommand( p_filter,
+                                                   CFG_PREFIX "height" );
+    p_sys->b_karaoke = var_CreateGetBoolCommand( p_filter,
+                                                 CFG_PREFIX "karaoke" );
+
+    char *psz_file = var_CreateGetStringCommand( p_filter, CFG_PREFIX "file" );
+    if( psz_file != NULL && *psz_file != '\0' )
+        i_ret = textbench_LoadFile( p_filter, psz_file );
+    else
+        i_ret = textbench_GenerateEvents( p_filter );
+    free( psz_file );
+
+    if( i_ret != VLC_SUCCESS )
+    {
+        textbench_Clean( p_sys );
+        free( p_sys );
+        return i_ret;
+    }
+
+    return VLC_SUCCESS;
+}
+
+/*****************************************************************************
+ * Destroy: destroy video thread output method
+ *****************************************************************************/
+static void Destroy( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    textbench_Clean( p_sys );
+    free( p_sys );
+}
+
+/*****************************************************************************
+ * textbench_RenderText: renders the first i_len bytes of one event
+ *****************************************************************************/
+static int textbench_RenderText( filter_t *p_text, const char *psz_event,
+                                 size_t i_len )
+{
+    static const vlc_fourcc_t p_chroma_list[] = { VLC_CODEC_YUVA, 0 };
+    video_format_t fmt;
+
+    video_format_Init( &fmt, VLC_CODEC_TEXT );
+    subpicture_region_t *p_region = subpicture_region_New( &fmt );
+    video_format_Clean( &fmt );
+    if( !p_region )
+        return VLC_ENOMEM;
+
+    char *psz_text = strndup( psz_event, i_len );
+    if( psz_text )
+    {
+        p_region->p_text = text_segment_New( psz_text );
+        free( psz_text );
+    }
+    if( !p_region->p_text )
+    {
+        subpicture_region_Delete( p_region );
+        return VLC_ENOMEM;
+    }
+    p_region->i_align = SUBPICTURE_ALIGN_BOTTOM;
+
+    int i_ret = p_text->ops->render( p_text, p_region, p_region,
+                                     p_chroma_list );
+    subpicture_region_Delete( p_region );
+    return i_ret;
+}
+
+/*****************************************************************************
+ * textbench_Run: renders every event once, or once per word
+ *****************************************************************************/
+static void textbench_Run( filter_t *p_filter, filter_t *p_text, int i_pass )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    size_t i_renders = 0, i_chars = 0, i_errors = 0;
+
+    vlc_tick_t time = vlc_tick_now();
+    for( size_t i = 0; i < p_sys->events.size; i++ )
+    {
+        const char *psz_event = p_sys->events.data[i];
+        const size_t i_event_len = strlen( psz_event );
+
+        for( size_t i_len = 0; i_len < i_event_len; )
+        {
+            if( p_sys->b_karaoke )
+            {
+                /* up to the end of the next word */
+                while( i_len < i_event_len && isspace( (unsigned char) psz_event[i_len] ) )
+                    i_len++;
+                while( i_len < i_event_len && !isspace( (unsigned char) psz_event[i_len] ) )
+                    i_len++;
+            }
+            else
+                i_len = i_event_len;
+
+            if( textbench_RenderText( p_text, psz_event, i_len ) )
+                i_errors++;
+            i_renders++;
+            i_chars += i_len;
+        }
+    }
+    time = vlc_tick_now() - time;
+    if( time <= 0 )
+        time = 1;
+
+    const double f_rate = (double) i_renders / time * CLOCK_FREQ;
+    msg_Info( p_filter, "pass %d: rendered %zu texts (%zu failed) in %f sec, "
+              "%f texts/second, %f characters/second", i_pass, i_renders,
+              i_errors, secf_from_vlc_tick(time), f_rate,
+              (double) i_chars / time * CLOCK_FREQ );
+}
+
+/*****************************************************************************
+ * Filter: runs the benchmark on the first picture
+ *****************************************************************************/
+static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    if( p_sys->b_done )
+        return p_pic;
+    p_sys->b_done = true;
+
+    filter_t *p_text = vlc_object_create( p_filter, sizeof(filter_t) );
+    if( !p_text )
+        return p_pic;
+
+    es_format_Init( &p_text->fmt_in, VIDEO_ES, 0 );
+    es_format_Init( &p_text->fmt_out, VIDEO_ES, 0 );
+    p_text->fmt_out.video.i_width =
+    p_text->fmt_out.video.i_visible_width = p_sys->i_width;
+    p_text->fmt_out.video.i_height =
+    p_text->fmt_out.video.i_visible_height = p_sys->i_height;
+
+    p_text->p_module = module_need_var( p_text, "text renderer",
+                                        "text-renderer" );
+    if( !p_text->p_module )
+    {
+        msg_Warn( p_filter, "no text renderer module" );
+        vlc_object_delete(p_text);
+        return p_pic;
+    }
+    assert( p_text->ops != NULL );
+
+    msg_Info( p_filter, "rendering %zu subtitle events for %ux%u",
+              p_sys->events.size, p_sys->i_width, p_sys->i_height );
+    /* The first pass runs with cold caches */
+    for( int i_pass = 0; i_pass < p_sys->i_loops; i_pass++ )
+        textbench_Run( p_filter, p_text, i_pass );
+
+    filter_Close( p_text );
+    module_unneed( p_text, p_text->p_module );
+
+    vlc_object_delete(p_text);
+    return p_pic;
+}
@@ -44,6 +44,7 @@
 #include <vlc_decoder.h>
 #include <vlc_picture_pool.h>
 #include <vlc_tracer.h>
+#include <vlc_executor.h>
 
 #include "audio_output/aout_internal.h"
 #include "stream_output/stream_output.h"
@@ -228,8 +229,86 @@ struct vlc_input_decoder_t
     vlc_mutex_t     mouse_lock;
     vlc_mouse_event mouse_event;
     void           *mouse_opaque;
+
+    /* Output stage: if depth is not 0, decoded audio or video buffers are
+     * handed over to the OutputThread through this queue, so that a slow
+     * output does not stall the decoding. */
+    struct
+    {
+        vlc_thread_t thread;
+        vlc_mutex_t lock;
+        vlc_cond_t wait;
+        struct decoder_out_item
+        {
+            void *buf; /* picture_t or vlc_frame_t */
+            unsigned gen;
+        } *items;
+        enum es_format_category_e cat;
+        size_t depth;
+        size_t limit; /* queued buffers allowed, at most depth */
+        size_t head;
+        size_t count;
+        bool busy;
+        bool aborting;
+    } out;
+    /* Incremented on flush: queued buffers from an older generation are
+     * stale */
+    atomic_uint out_gen;
+
+    /* Decoding from the shared worker pool, instead of a DecoderThread */
+    struct
+    {
+        vlc_executor_t *executor; /* NULL if using a DecoderThread */
+        struct vlc_runnable runnable;
+        bool scheduled;
+        vlc_tick_t submitted;
+        /* Output held while buffering, played once it ends */
+        vlc_frame_t *held_audio;
+        subpicture_t *held_spu;
+        /* statistics */
+        uint64_t runs;
+        vlc_tick_t latency_total;
+        vlc_tick_t latency_max;
+    } pool;
 };
 
+/* Worker pool shared by all the pooled decoders */
+static struct
+{
+    vlc_mutex_t lock;
+    vlc_executor_t *executor;
+    unsigned refs;
+} decoder_pool = { VLC_STATIC_MUTEX, NULL, 0 };
+
+static vlc_executor_t *DecoderPoolHold( unsigned threads )
+{
+    vlc_mutex_lock( &decoder_pool.lock );
+    if( decoder_pool.executor == NULL )
+        decoder_pool.executor = vlc_executor_New( threads );
+    if( decoder_pool.executor != NULL )
+        decoder_pool.refs++;
+    vlc_executor_t *executor = decoder_pool.executor;
+    vlc_mutex_unlock( &decoder_pool.lock );
+    return executor;
+}
+
+static void DecoderPoolRelease( void )
+{
+    vlc_executor_t *executor = NULL;
+
+    vlc_mutex_lock( &decoder_pool.lock );
+    assert( decoder_pool.refs > 0 );
+    if( --decoder_pool.refs == 0 )
+    {
+        executor = decoder_pool.executor;
+        decoder_pool.executor = NULL;
+    }
+    vlc_mutex_unlock( &decoder_pool.lock );
+
+    if( executor != NULL )
+        vlc_executor_Delete( executor );
+}
+
 /* Pictures which are DECODER_BOGUS_VIDEO_DELAY or more in advance probably have
  * a bogus PTS and won't be displayed */
 #define DECODER_BOGUS_VIDEO_DELAY                ((vlc_tick_t)(DEFAULT_PTS_DELAY * 30))
@@ -393,6 +472,42 @@ static int LoadDecoder( decoder_t *p_dec, bool b_packetizer, es_format_t *fmt_in
     return 0;
 }
 
+static void DecoderOutputRelease( vlc_input_decoder_t *p_owner, void *buf )
+{
+    if( p_owner->out.cat == VIDEO_ES )
+        picture_Release( buf );
+    else
+        block_Release( buf );
+}
+
+/* Drops the buffers waiting for the output stage */
+static void DecoderOutputPurge( vlc_input_decoder_t *p_owner )
+{
+    vlc_mutex_lock( &p_owner->out.lock );
+    while( p_owner->out.count > 0 )
+    {
+        DecoderOutputRelease( p_owner, p_owner->out.items[p_owner->out.head].buf );
+        p_owner->out.head = (p_owner->out.head + 1) % p_owner->out.depth;
+        p_owner->out.count--;
+    }
+    vlc_cond_broadcast( &p_owner->out.wait );
+    vlc_mutex_unlock( &p_owner->out.lock );
+}
+
+/* Waits until the output stage played all the decoded buffers, before
+ * changing or draining the output */
+static void ModuleThread_WaitOutput( vlc_input_decoder_t *p_owner )
+{
+    if( p_owner->out.depth == 0 )
+        return;
+
+    vlc_mutex_lock( &p_owner->out.lock );
+    while( ( p_owner->out.count > 0 || p_owner->out.busy )
+        && !p_owner->out.aborting )
+        vlc_cond_wait( &p_owner->out.wait, &p_owner->out.lock );
+    vlc_mutex_unlock( &p_owner->out.lock );
+}
+
 static int DecoderThread_Reload( vlc_input_decoder_t *p_owner,
                                  const es_format_t *restrict p_fmt,
                                  enum reload reload )
@@ -400,6 +515,10 @@ static int DecoderThread_Reload( vlc_input_decoder_t *p_owner,
     /* Copy p_fmt since it can be destroyed by decoder_Clean */
     decoder_t *p_dec = &p_owner->dec;
     es_format_t fmt_in;
+
+    /* The output stage may still be using the audio output */
+    ModuleThread_WaitOutput( p_owner );
+
     if( es_format_Copy( &fmt_in, p_fmt ) != VLC_SUCCESS )
     {
         p_owner->error = true;
@@ -500,6 +619,9 @@ static int ModuleThread_UpdateAudioFormat( decoder_t *p_dec )
         audio_output_t *p_aout = p_owner->p_aout;
         vlc_aout_stream *p_astream = p_owner->p_astream;
 
+        /* The output stage may still be playing into the old aout */
+        ModuleThread_WaitOutput( p_owner );
+
         /* Parameters changed, restart the aout */
         vlc_fifo_Lock(p_owner->p_fifo);
         p_owner->p_astream = NULL;
@@ -590,6 +712,9 @@ static int ModuleThread_UpdateAudioFormat( decoder_t *p_dec )
 
 static int CreateVoutIfNeeded(vlc_input_decoder_t *);
 
+/* Pictures of hardware decoders that can wait for the output stage */
+#define DECODER_OUT_HW_LIMIT 1
+
 
 static int ModuleThread_UpdateVideoFormat( decoder_t *p_dec, vlc_video_context *vctx )
 {
@@ -603,6 +728,7 @@ static int ModuleThread_UpdateVideoFormat( decoder_t *p_dec, vlc_video_context *
         // video context didn't change
         if (vctx != NULL && p_owner->vctx == vctx)
             return 0;
+        ModuleThread_WaitOutput( p_owner );
     }
     assert(p_owner->p_vout);
 
@@ -610,6 +736,19 @@ static int ModuleThread_UpdateVideoFormat( decoder_t *p_dec, vlc_video_context *
         vlc_video_context_Release(p_owner->vctx);
     p_owner->vctx = vctx ? vlc_video_context_Hold(vctx) : NULL;
 
+    if( p_owner->out.depth > 0 )
+    {
+        /* Hardware decoders allocate their surfaces themselves, and unlike
+         * out_pool below, their pools are not enlarged for the output queue:
+         * only let as many surfaces wait as a slow display would hold. */
+        vlc_mutex_lock( &p_owner->out.lock );
+        p_owner->out.limit = vctx != NULL
+                           ? __MIN( p_owner->out.depth, DECODER_OUT_HW_LIMIT )
+                           : p_owner->out.depth;
+        vlc_cond_broadcast( &p_owner->out.wait );
+        vlc_mutex_unlock( &p_owner->out.lock );
+    }
+
     // configure the new vout
     vlc_fifo_Lock(p_owner->p_fifo);
     if ( p_owner->out_pool == NULL )
@@ -636,6 +775,8 @@ static int ModuleThread_UpdateVideoFormat( decoder_t *p_dec, vlc_video_context *
             dpb_size = 2;
             break;
         }
+        /* pictures waiting for the output stage are not free either */
+        dpb_size += p_owner->out.depth;
         picture_pool_t *pool = picture_pool_NewFromFormat( &p_dec->fmt_out.video,
                             dpb_size + p_dec->i_extra_picture_buffers + 1 );
 
@@ -760,6 +901,11 @@ static int CreateVoutIfNeeded(vlc_input_decoder_t *p_owner)
         return 0; // vout unchanged
     }
 
+    /* Pictures still queued were meant for the old vout */
+    vlc_fifo_Unlock( p_owner->p_fifo );
+    ModuleThread_WaitOutput( p_owner );
+    vlc_fifo_Lock( p_owner->p_fifo );
+
     vout_thread_t *p_vout = p_owner->p_vout;
     p_owner->p_vout = NULL; // the DecoderThread should not use the old vout anymore
     p_owner->vout_started = false;
@@ -1024,6 +1170,28 @@ static void DecoderWaitUnblock( vlc_input_decoder_t *p_owner )
         vlc_fifo_WaitCond(p_owner->p_fifo, &p_owner->wait_request);
 }
 
+/**
+ * Pooled decoders cannot wait in DecoderWaitUnblock(), they would hold a
+ * worker that another decoder may need to end the buffering. Their output is
+ * held instead, and played by DecoderThread_Step() once the buffering ends.
+ *
+ * \return true if the output must be held
+ */
+static bool DecoderHoldOutput( vlc_input_decoder_t *p_owner )
+{
+    vlc_fifo_Assert(p_owner->p_fifo);
+
+    if( p_owner->pool.executor == NULL || !p_owner->b_waiting )
+        return false;
+
+    if( !p_owner->b_has_data )
+    {
+        p_owner->b_has_data = true;
+        vlc_cond_signal( &p_owner->wait_acknowledge );
+    }
+    return true;
+}
+
 static inline void DecoderUpdatePreroll( vlc_tick_t *pi_preroll, const vlc_frame_t *p )
 {
     if( p->i_flags & BLOCK_FLAG_PREROLL )
@@ -1155,6 +1323,19 @@ static void DecoderThread_ProcessSout( vlc_input_decoder_t *p_owner, vlc_frame_t
 }
 #endif
 
+static void DecoderSchedule( vlc_input_decoder_t *p_owner );
+
+static void DecoderQueueCc( vlc_input_decoder_t *p_ccowner, vlc_frame_t *p_cc )
+{
+    if( unlikely(p_cc == NULL) )
+        return;
+
+    vlc_fifo_Lock( p_ccowner->p_fifo );
+    vlc_fifo_QueueUnlocked( p_ccowner->p_fifo, p_cc );
+    DecoderSchedule( p_ccowner );
+    vlc_fifo_Unlock( p_ccowner->p_fifo );
+}
+
 static void DecoderPlayCc( vlc_input_decoder_t *p_owner, vlc_frame_t *p_cc,
                            const decoder_cc_desc_t *p_desc )
 {
@@ -1182,11 +1363,11 @@ static void DecoderPlayCc( vlc_input_decoder_t *p_owner, vlc_frame_t *p_cc,
 
         if( i_bitmap > 1 )
         {
-            block_FifoPut( p_ccowner->p_fifo, block_Duplicate(p_cc) );
+            DecoderQueueCc( p_ccowner, block_Duplicate(p_cc) );
         }
         else
         {
-            block_FifoPut( p_ccowner->p_fifo, p_cc );
+            DecoderQueueCc( p_ccowner, p_cc );
             p_cc = NULL; /* was last dec */
         }
     }
@@ -1300,21 +1481,22 @@ static int ModuleThread_PlayVideo( vlc_input_decoder_t *p_owner, picture_t *p_pi
     return VLC_SUCCESS;
 }
 
-static void ModuleThread_QueueVideo( decoder_t *p_dec, picture_t *p_pic )
-{
-    assert( p_pic );
-    vlc_input_decoder_t *p_owner = dec_get_owner( p_dec );
-    struct vlc_tracer *tracer = vlc_object_get_tracer( &p_dec->obj );
+static void ModuleThread_QueueOutput( vlc_input_decoder_t *p_owner, void *buf );
 
-    if ( tracer != NULL )
-    {
-        vlc_tracer_TraceStreamPTS( tracer, "DEC", p_owner->psz_id,
-                            "OUT", p_pic->date );
-    }
+static void DecoderOutputVideo( vlc_input_decoder_t *p_owner, picture_t *p_pic,
+                                unsigned gen )
+{
+    int success;
 
     vlc_fifo_Lock( p_owner->p_fifo );
 
-    int success = ModuleThread_PlayVideo( p_owner, p_pic );
+    if( gen != atomic_load_explicit( &p_owner->out_gen, memory_order_relaxed ) )
+    {   /* decoded before a flush */
+        picture_Release( p_pic );
+        success = VLC_SUCCESS;
+    }
+    else
+        success = ModuleThread_PlayVideo( p_owner, p_pic );
 
     unsigned displayed = 0;
     unsigned vout_lost = 0;
@@ -1331,6 +1513,24 @@ static void ModuleThread_QueueVideo( decoder_t *p_dec, picture_t *p_pic )
     decoder_Notify(p_owner, on_new_video_stats, 1, vout_lost, displayed, vout_late);
 }
 
+static void ModuleThread_QueueVideo( decoder_t *p_dec, picture_t *p_pic )
+{
+    assert( p_pic );
+    vlc_input_decoder_t *p_owner = dec_get_owner( p_dec );
+    struct vlc_tracer *tracer = vlc_object_get_tracer( &p_dec->obj );
+
+    if ( tracer != NULL )
+    {
+        vlc_tracer_TraceStreamPTS( tracer, "DEC", p_owner->psz_id,
+                            "OUT", p_pic->date );
+    }
+
+    if( p_owner->out.depth > 0 )
+        ModuleThread_QueueOutput( p_owner, p_pic );
+    else
+        DecoderOutputVideo( p_owner, p_pic, atomic_load( &p_owner->out_gen ) );
+}
+
 static vlc_decoder_device * thumbnailer_get_device( decoder_t *p_dec )
 {
     VLC_UNUSED(p_dec);
@@ -1414,6 +1614,11 @@ static int ModuleThread_PlayAudio( vlc_input_decoder_t *p_owner, vlc_frame_t *p_
         vlc_aout_stream_Flush( p_astream );
     }
 
+    if( DecoderHoldOutput( p_owner ) )
+    {
+        vlc_frame_ChainAppend( &p_owner->pool.held_audio, p_audio );
+        return VLC_SUCCESS;
+    }
     DecoderWaitUnblock( p_owner );
 
     int status = vlc_aout_stream_Play( p_astream, p_audio );
@@ -1433,20 +1638,20 @@ static int ModuleThread_PlayAudio( vlc_input_decoder_t *p_owner, vlc_frame_t *p_
     return VLC_SUCCESS;
 }
 
-static void ModuleThread_QueueAudio( decoder_t *p_dec, vlc_frame_t *p_aout_buf )
+static void DecoderOutputAudio( vlc_input_decoder_t *p_owner,
+                                vlc_frame_t *p_aout_buf, unsigned gen )
 {
-    vlc_input_decoder_t *p_owner = dec_get_owner( p_dec );
-    struct vlc_tracer *tracer = vlc_object_get_tracer( &p_dec->obj );
-
-    if ( tracer != NULL && p_aout_buf != NULL )
-    {
-        vlc_tracer_TraceStreamDTS( tracer, "DEC", p_owner->psz_id, "OUT",
-                            p_aout_buf->i_pts, p_aout_buf->i_dts );
-    }
+    int success;
 
     vlc_fifo_Lock(p_owner->p_fifo);
 
-    int success = ModuleThread_PlayAudio( p_owner, p_aout_buf );
+    if( gen != atomic_load_explicit( &p_owner->out_gen, memory_order_relaxed ) )
+    {   /* decoded before a flush */
+        block_Release( p_aout_buf );
+        success = VLC_SUCCESS;
+    }
+    else
+        success = ModuleThread_PlayAudio( p_owner, p_aout_buf );
 
     unsigned played = 0;
     unsigned aout_lost = 0;
@@ -1462,6 +1667,107 @@ static void ModuleThread_QueueAudio( decoder_t *p_dec, vlc_frame_t *p_aout_buf )
     decoder_Notify(p_owner, on_new_audio_stats, 1, aout_lost, played);
 }
 
+static void ModuleThread_QueueAudio( decoder_t *p_dec, vlc_frame_t *p_aout_buf )
+{
+    vlc_input_decoder_t *p_owner = dec_get_owner( p_dec );
+    struct vlc_tracer *tracer = vlc_object_get_tracer( &p_dec->obj );
+
+    if ( tracer != NULL && p_aout_buf != NULL )
+    {
+        vlc_tracer_TraceStreamDTS( tracer, "DEC", p_owner->psz_id, "OUT",
+                            p_aout_buf->i_pts, p_aout_buf->i_dts );
+    }
+
+    if( p_owner->out.depth > 0 )
+        ModuleThread_QueueOutput( p_owner, p_aout_buf );
+    else
+        DecoderOutputAudio( p_owner, p_aout_buf,
+                            atomic_load( &p_owner->out_gen ) );
+}
+
+/**
+ * Hands a decoded buffer over to the output stage. Blocks while the output
+ * queue is full.
+ */
+static void ModuleThread_QueueOutput( vlc_input_decoder_t *p_owner, void *buf )
+{
+    vlc_fifo_Lock( p_owner->p_fifo );
+    bool flushing = p_owner->flushing;
+    unsigned gen = atomic_load_explicit( &p_owner->out_gen,
+                                         memory_order_relaxed );
+    vlc_fifo_Unlock( p_owner->p_fifo );
+
+    if( flushing )
+    {   /* decoded before the decoder module was flushed */
+        DecoderOutputRelease( p_owner, buf );
+        return;
+    }
+
+    vlc_mutex_lock( &p_owner->out.lock );
+    while( p_owner->out.count >= p_owner->out.limit && !p_owner->out.aborting )
+        vlc_cond_wait( &p_owner->out.wait, &p_owner->out.lock );
+
+    if( p_owner->out.aborting )
+    {
+        vlc_mutex_unlock( &p_owner->out.lock );
+        DecoderOutputRelease( p_owner, buf );
+        return;
+    }
+
+    size_t i = (p_owner->out.head + p_owner->out.count) % p_owner->out.depth;
+    p_owner->out.items[i].buf = buf;
+    p_owner->out.items[i].gen = gen;
+    p_owner->out.count++;
+    vlc_cond_broadcast( &p_owner->out.wait );
+    vlc_mutex_unlock( &p_owner->out.lock );
+}
+
+/**
+ * The output stage main loop: plays the decoded buffers, including the waits
+ * on the audio or video output, while the DecoderThread keeps decoding.
+ */
+static void *OutputThread( void *p_data )
+{
+    vlc_input_decoder_t *p_owner = p_data;
+
+    vlc_thread_set_name( p_owner->out.cat == VIDEO_ES ? "vlc-dec-v-out"
+                                                      : "vlc-dec-a-out" );
+
+    vlc_mutex_lock( &p_owner->out.lock );
+    for( ;; )
+    {
+        while( p_owner->out.count == 0 && !p_owner->out.aborting )
+        {
+            if( p_owner->out.busy )
+            {   /* signal ModuleThread_WaitOutput() */
+                p_owner->out.busy = false;
+                vlc_cond_broadcast( &p_owner->out.wait );
+            }
+            vlc_cond_wait( &p_owner->out.wait, &p_owner->out.lock );
+        }
+
+        if( p_owner->out.aborting )
+            break;
+
+        struct decoder_out_item item = p_owner->out.items[p_owner->out.head];
+        p_owner->out.head = (p_owner->out.head + 1) % p_owner->out.depth;
+        p_owner->out.count--;
+        p_owner->out.busy = true;
+        vlc_cond_broadcast( &p_owner->out.wait );
+        vlc_mutex_unlock( &p_owner->out.lock );
+
+        if( p_owner->out.cat == VIDEO_ES )
+            DecoderOutputVideo( p_owner, item.buf, item.gen );
+        else
+            DecoderOutputAudio( p_owner, item.buf, item.gen );
+
+        vlc_mutex_lock( &p_owner->out.lock );
+    }
+    p_owner->out.busy = false;
+    vlc_mutex_unlock( &p_owner->out.lock );
+    return NULL;
+}
+
 static void ModuleThread_PlaySpu( vlc_input_decoder_t *p_owner, subpicture_t *p_subpic )
 {
     decoder_t *p_dec = &p_owner->dec;
@@ -1477,6 +1783,16 @@ static void ModuleThread_PlaySpu( vlc_input_decoder_t *p_owner, subpicture_t *p_
 
     /* */
     vlc_fifo_Lock(p_owner->p_fifo);
+    if( DecoderHoldOutput( p_owner ) )
+    {
+        subpicture_t **pp_last = &p_owner->pool.held_spu;
+        while( *pp_last != NULL )
+            pp_last = &(*pp_last)->p_next;
+        p_subpic->p_next = NULL;
+        *pp_last = p_subpic;
+        vlc_fifo_Unlock(p_owner->p_fifo);
+        return;
+    }
     DecoderWaitUnblock( p_owner );
     vlc_fifo_Unlock(p_owner->p_fifo);
 
@@ -1662,6 +1978,54 @@ error:
         block_Release( frame );
 }
 
+/* Releases the output held by a pooled decoder while buffering */
+static void DecoderReleaseHeld( vlc_input_decoder_t *p_owner )
+{
+    vlc_frame_ChainRelease( p_owner->pool.held_audio );
+    p_owner->pool.held_audio = NULL;
+
+    while( p_owner->pool.held_spu != NULL )
+    {
+        subpicture_t *p_next = p_owner->pool.held_spu->p_next;
+
+        subpicture_Delete( p_owner->pool.held_spu );
+        p_owner->pool.held_spu = p_next;
+    }
+}
+
+/* Plays the output held by a pooled decoder, once the buffering ended.
+ * Called with the decoder FIFO locked. */
+static void DecoderPlayHeld( vlc_input_decoder_t *p_owner )
+{
+    vlc_frame_t *p_audio = p_owner->pool.held_audio;
+    subpicture_t *p_spu = p_owner->pool.held_spu;
+
+    p_owner->pool.held_audio = NULL;
+    p_owner->pool.held_spu = NULL;
+    vlc_fifo_Unlock( p_owner->p_fifo );
+
+    while( p_audio != NULL )
+    {
+        vlc_frame_t *p_next = p_audio->p_next;
+
+        p_audio->p_next = NULL;
+        DecoderOutputAudio( p_owner, p_audio,
+                            atomic_load( &p_owner->out_gen ) );
+        p_audio = p_next;
+    }
+
+    while( p_spu != NULL )
+    {
+        subpicture_t *p_next = p_spu->p_next;
+
+        p_spu->p_next = NULL;
+        ModuleThread_PlaySpu( p_owner, p_spu );
+        p_spu = p_next;
+    }
+
+    vlc_fifo_Lock( p_owner->p_fifo );
+}
+
 static void DecoderThread_Flush( vlc_input_decoder_t *p_owner )
 {
     decoder_t *p_dec = &p_owner->dec;
@@ -1692,6 +2056,107 @@ static void DecoderThread_Flush( vlc_input_decoder_t *p_owner )
     vlc_mutex_unlock(&p_owner->cc.lock);
 }
 
+/**
+ * Runs one step of the decoding loop, with the decoder FIFO locked
+ *
+ * \param p_owner the decoder
+ * \return false if there is nothing to do until the next request, the
+ * decoder is then idle
+ */
+static bool DecoderThread_Step( vlc_input_decoder_t *p_owner )
+{
+    if( p_owner->flushing )
+    {   /* Flush before/regardless of pause. We do not want to resume just
+         * for the sake of flushing (glitches could otherwise happen). */
+        DecoderReleaseHeld( p_owner );
+        vlc_fifo_Unlock( p_owner->p_fifo );
+
+        /* Flush the decoder (and the output) */
+        DecoderThread_Flush( p_owner );
+
+        vlc_fifo_Lock( p_owner->p_fifo );
+
+        /* Reset flushing after DecoderThread_ProcessInput in case vlc_input_decoder_Flush
+         * is called again. This will avoid a second useless flush (but
+         * harmless). */
+        p_owner->flushing = false;
+        p_owner->i_preroll_end = PREROLL_NONE;
+        return true;
+    }
+
+    if( p_owner->paused != p_owner->output_paused )
+    {   /* Update playing/paused status of the output */
+        Decoder_ChangeOutputPause( p_owner, p_owner->paused, p_owner->pause_date );
+        return true;
+    }
+
+    if( p_owner->rate != p_owner->output_rate )
+    {
+        Decoder_ChangeOutputRate( p_owner, p_owner->rate );
+        return true;
+    }
+
+    if( p_owner->delay != p_owner->output_delay )
+    {
+        Decoder_ChangeOutputDelay( p_owner, p_owner->delay );
+        return true;
+    }
+
+    if( p_owner->paused && p_owner->frames_countdown == 0 )
+        goto idle; /* Wait for resumption from pause */
+
+    if( p_owner->pool.executor != NULL && p_owner->b_waiting )
+    {
+        /* Stop decoding once some output is held, see DecoderHoldOutput() */
+        if( p_owner->b_has_data )
+            goto idle;
+    }
+    else if( p_owner->pool.held_audio != NULL
+          || p_owner->pool.held_spu != NULL )
+    {   /* The buffering ended, play what was held during it */
+        DecoderPlayHeld( p_owner );
+        return true;
+    }
+
+    vlc_cond_signal( &p_owner->wait_fifo );
+
+    vlc_frame_t *frame = vlc_fifo_DequeueUnlocked( p_owner->p_fifo );
+    if( frame == NULL )
+    {
+        if( likely(!p_owner->b_draining) )
+            goto idle; /* Wait for a block to decode (or a request to drain) */
+        /* We have emptied the FIFO and there is a pending request to
+         * drain. Pass frame = NULL to decoder just once. */
+    }
+
+    vlc_fifo_Unlock( p_owner->p_fifo );
+
+    DecoderThread_ProcessInput( p_owner, frame );
+    if( frame == NULL )
+        /* Draining: let the output stage queue the last buffers */
+        ModuleThread_WaitOutput( p_owner );
+
+    vlc_fifo_Lock(p_owner->p_fifo);
+    if( p_owner->b_draining && frame == NULL )
+    {
+        p_owner->b_draining = false;
+
+        if( p_owner->dec.fmt_in->i_cat == AUDIO_ES && p_owner->p_astream != NULL )
+        {   /* Draining: the decoder is drained and all decoded buffers are
+             * queued to the output at this point. Now drain the output. */
+            vlc_aout_stream_Drain( p_owner->p_astream );
+        }
+    }
+
+    vlc_cond_signal( &p_owner->wait_acknowledge );
+    return true;
+
+idle:
+    p_owner->b_idle = true;
+    vlc_cond_signal( &p_owner->wait_acknowledge );
+    return false;
+}
+
 /**
  * The decoding main loop
  *
@@ -1718,89 +2183,74 @@ static void *DecoderThread( void *p_data )
 
     while( !p_owner->aborting )
     {
-        if( p_owner->flushing )
-        {   /* Flush before/regardless of pause. We do not want to resume just
-             * for the sake of flushing (glitches could otherwise happen). */
-            vlc_fifo_Unlock( p_owner->p_fifo );
-
-            /* Flush the decoder (and the output) */
-            DecoderThread_Flush( p_owner );
-
-            vlc_fifo_Lock( p_owner->p_fifo );
-
-            /* Reset flushing after DecoderThread_ProcessInput in case vlc_input_decoder_Flush
-             * is called again. This will avoid a second useless flush (but
-             * harmless). */
-            p_owner->flushing = false;
-            p_owner->i_preroll_end = PREROLL_NONE;
-            continue;
-        }
-
-        if( p_owner->paused != p_owner->output_paused )
-        {   /* Update playing/paused status of the output */
-            Decoder_ChangeOutputPause( p_owner, p_owner->paused, p_owner->pause_date );
-            continue;
-        }
-
-        if( p_owner->rate != p_owner->output_rate )
-        {
-            Decoder_ChangeOutputRate( p_owner, p_owner->rate );
-            continue;
-        }
-
-        if( p_owner->delay != p_owner->output_delay )
+        if( !DecoderThread_Step( p_owner ) )
         {
-            Decoder_ChangeOutputDelay( p_owner, p_owner->delay );
-            continue;
-        }
-
-        if( p_owner->paused && p_owner->frames_countdown == 0 )
-        {   /* Wait for resumption from pause */
-            p_owner->b_idle = true;
-            vlc_cond_signal( &p_owner->wait_acknowledge );
             vlc_fifo_Wait( p_owner->p_fifo );
             p_owner->b_idle = false;
-            continue;
         }
+    }
 
-        vlc_cond_signal( &p_owner->wait_fifo );
+    vlc_fifo_Unlock( p_owner->p_fifo );
+    return NULL;
+}
 
-        vlc_frame_t *frame = vlc_fifo_DequeueUnlocked( p_owner->p_fifo );
-        if( frame == NULL )
-        {
-            if( likely(!p_owner->b_draining) )
-            {   /* Wait for a block to decode (or a request to drain) */
-                p_owner->b_idle = true;
-                vlc_cond_signal( &p_owner->wait_acknowledge );
-                vlc_fifo_Wait( p_owner->p_fifo );
-                p_owner->b_idle = false;
-                continue;
-            }
-            /* We have emptied the FIFO and there is a pending request to
-             * drain. Pass frame = NULL to decoder just once. */
-        }
+/* Steps a pooled decoder runs before letting other decoders run */
+#define DECODER_POOL_QUANTUM 8
 
-        vlc_fifo_Unlock( p_owner->p_fifo );
+/**
+ * Schedules a pooled decoder, if not already, after a request.
+ * Called with the decoder FIFO locked.
+ */
+static void DecoderSchedule( vlc_input_decoder_t *p_owner )
+{
+    vlc_fifo_Assert( p_owner->p_fifo );
 
-        DecoderThread_ProcessInput( p_owner, frame );
+    if( p_owner->pool.executor == NULL || p_owner->pool.scheduled
+     || p_owner->aborting )
+        return;
 
-        vlc_fifo_Lock(p_owner->p_fifo);
-        if( p_owner->b_draining && frame == NULL )
-        {
-            p_owner->b_draining = false;
+    p_owner->pool.scheduled = true;
+    p_owner->b_idle = false;
+    p_owner->pool.submitted = vlc_tick_now();
+    vlc_executor_Submit( p_owner->pool.executor, &p_owner->pool.runnable );
+}
 
-            if( p_owner->dec.fmt_in->i_cat == AUDIO_ES && p_owner->p_astream != NULL )
-            {   /* Draining: the decoder is drained and all decoded buffers are
-                 * queued to the output at this point. Now drain the output. */
-                vlc_aout_stream_Drain( p_owner->p_astream );
-            }
+/**
+ * The decoding loop of a pooled decoder, run from a shared worker thread
+ * until it is idle or its quantum is over. At most one task is scheduled
+ * per decoder, so that its frames are decoded in order.
+ */
+static void DecoderTask( void *p_data )
+{
+    vlc_input_decoder_t *p_owner = p_data;
+
+    vlc_fifo_Lock( p_owner->p_fifo );
+
+    vlc_tick_t latency = vlc_tick_now() - p_owner->pool.submitted;
+    p_owner->pool.runs++;
+    p_owner->pool.latency_total += latency;
+    if( latency > p_owner->pool.latency_max )
+        p_owner->pool.latency_max = latency;
+
+    for( unsigned i = 0; !p_owner->aborting; i++ )
+    {
+        if( i == DECODER_POOL_QUANTUM )
+        {   /* Requeue behind the other decoders */
+            p_owner->pool.submitted = vlc_tick_now();
+            vlc_executor_Submit( p_owner->pool.executor,
+                                 &p_owner->pool.runnable );
+            vlc_fifo_Unlock( p_owner->p_fifo );
+            return;
         }
 
-        vlc_cond_signal( &p_owner->wait_acknowledge );
+        if( !DecoderThread_Step( p_owner ) )
+            break;
     }
 
+    p_owner->pool.scheduled = false;
+    /* signal vlc_input_decoder_Delete() */
+    vlc_cond_broadcast( &p_owner->wait_acknowledge );
     vlc_fifo_Unlock( p_owner->p_fifo );
-    return NULL;
 }
 
 static const struct decoder_owner_callbacks dec_video_cbs =
@@ -1906,6 +2356,28 @@ CreateDecoder( vlc_object_t *p_parent, const struct vlc_input_decoder_cfg *cfg )
     p_owner->mouse_event = NULL;
     p_owner->mouse_opaque = NULL;
 
+    vlc_mutex_init( &p_owner->out.lock );
+    vlc_cond_init( &p_owner->out.wait );
+    p_owner->out.items = NULL;
+    p_owner->out.cat = fmt->i_cat;
+    p_owner->out.depth = 0;
+    p_owner->out.limit = 0;
+    p_owner->out.head = 0;
+    p_owner->out.count = 0;
+    p_owner->out.busy = false;
+    p_owner->out.aborting = false;
+    atomic_init( &p_owner->out_gen, 0 );
+
+    p_owner->pool.executor = NULL;
+    p_owner->pool.runnable.run = DecoderTask;
+    p_owner->pool.runnable.userdata = p_owner;
+    p_owner->pool.scheduled = false;
+    p_owner->pool.held_audio = NULL;
+    p_owner->pool.held_spu = NULL;
+    p_owner->pool.runs = 0;
+    p_owner->pool.latency_total = 0;
+    p_owner->pool.latency_max = 0;
+
     es_format_Init( &p_owner->fmt, fmt->i_cat, 0 );
 
     /* decoder fifo */
@@ -1966,6 +2438,31 @@ CreateDecoder( vlc_object_t *p_parent, const struct vlc_input_decoder_cfg *cfg )
 
     assert( p_dec->fmt_in->i_cat == p_dec->fmt_out.i_cat && fmt->i_cat == p_dec->fmt_in->i_cat);
 
+    /* Decode lightweight streams from the shared worker pool. Video stays
+     * on its own thread: its decoders wait for free pictures from the
+     * output pool, and would hold a worker for as long. */
+    if( cfg->sout == NULL && cfg->input_type != INPUT_TYPE_THUMBNAILING
+     && fmt->i_cat != VIDEO_ES )
+    {
+        int64_t threads = var_InheritInteger( p_dec, "dec-pool-threads" );
+
+        if( threads > 0 )
+            p_owner->pool.executor = DecoderPoolHold( threads );
+    }
+
+    /* Decode ahead of the audio/video output, from a separate thread */
+    if( cfg->sout == NULL && p_owner->pool.executor == NULL
+     && ( p_dec->cbs == &dec_video_cbs || p_dec->cbs == &dec_audio_cbs ) )
+    {
+        int64_t depth = var_InheritInteger( p_dec, "dec-output-queue" );
+        if( depth > 0 )
+        {
+            p_owner->out.items = vlc_alloc( depth, sizeof( *p_owner->out.items ) );
+            if( p_owner->out.items != NULL )
+                p_owner->out.depth = p_owner->out.limit = depth;
+        }
+    }
+
     /* Copy ourself the input replay gain */
     if( fmt->i_cat == AUDIO_ES )
     {
@@ -2023,6 +2520,23 @@ static void DeleteDecoder( vlc_input_decoder_t *p_owner, enum es_format_category
     /* Free all packets still in the decoder fifo. */
     block_FifoEmpty( p_owner->p_fifo );
 
+    /* and all decoded buffers still waiting for the output */
+    if( p_owner->out.depth > 0 )
+        DecoderOutputPurge( p_owner );
+    free( p_owner->out.items );
+
+    if( p_owner->pool.executor != NULL )
+    {
+        if( p_owner->pool.runs > 0 )
+            msg_Dbg( p_dec, "pooled decoder ran %" PRIu64 " times, latency "
+                     "%" PRId64 " us average, %" PRId64 " us max",
+                     p_owner->pool.runs,
+                     US_FROM_VLC_TICK( p_owner->pool.latency_total )
+                        / (int64_t)p_owner->pool.runs,
+                     US_FROM_VLC_TICK( p_owner->pool.latency_max ) );
+        DecoderPoolRelease();
+    }
+
     /* Cleanup */
 #ifdef ENABLE_SOUT
     if( p_owner->p_sout_input )
@@ -2155,12 +2669,29 @@ decoder_New( vlc_object_t *p_parent, const struct vlc_input_decoder_cfg *cfg )
     }
 #endif
 
-    if( !vlc_input_decoder_IsSynchronous( p_owner ) )
+    if( !vlc_input_decoder_IsSynchronous( p_owner )
+     && p_owner->pool.executor == NULL )
     {
+        /* Spawn the output stage, if enabled for this decoder. */
+        if( p_owner->out.depth > 0
+         && vlc_clone( &p_owner->out.thread, OutputThread, p_owner ) )
+        {
+            msg_Warn( p_dec, "cannot spawn decoder output thread" );
+            p_owner->out.depth = 0;
+        }
+
         /* Spawn the decoder thread in asynchronous scenario. */
         if( vlc_clone( &p_owner->thread, DecoderThread, p_owner ) )
         {
             msg_Err( p_dec, "cannot spawn decoder thread" );
+            if( p_owner->out.depth > 0 )
+            {
+                vlc_mutex_lock( &p_owner->out.lock );
+                p_owner->out.aborting = true;
+                vlc_cond_signal( &p_owner->out.wait );
+                vlc_mutex_unlock( &p_owner->out.lock );
+                vlc_join( p_owner->out.thread, NULL );
+            }
             DeleteDecoder( p_owner, p_dec->fmt_in->i_cat );
             return NULL;
         }
@@ -2251,8 +2782,33 @@ void vlc_input_decoder_Delete( vlc_input_decoder_t *p_owner )
     }
     vlc_fifo_Unlock( p_owner->p_fifo );
 
-    if( !vlc_input_decoder_IsSynchronous( p_owner ) )
+    if( p_owner->out.depth > 0 )
+    {   /* Unblock the decoder if the output queue is full */
+        vlc_mutex_lock( &p_owner->out.lock );
+        p_owner->out.aborting = true;
+        vlc_cond_broadcast( &p_owner->out.wait );
+        vlc_mutex_unlock( &p_owner->out.lock );
+    }
+
+    if( p_owner->pool.executor != NULL )
+    {   /* Wait for the decoder task to be canceled or to complete */
+        vlc_fifo_Lock( p_owner->p_fifo );
+        while( p_owner->pool.scheduled )
+        {
+            if( vlc_executor_Cancel( p_owner->pool.executor,
+                                     &p_owner->pool.runnable ) )
+                p_owner->pool.scheduled = false;
+            else
+                vlc_fifo_WaitCond( p_owner->p_fifo,
+                                   &p_owner->wait_acknowledge );
+        }
+        DecoderReleaseHeld( p_owner );
+        vlc_fifo_Unlock( p_owner->p_fifo );
+    }
+    else if( !vlc_input_decoder_IsSynchronous( p_owner ) )
         vlc_join( p_owner->thread, NULL );
+    if( p_owner->out.depth > 0 )
+        vlc_join( p_owner->out.thread, NULL );
 
     /* */
     if( p_owner->cc.b_supported )
@@ -2307,6 +2863,7 @@ void vlc_input_decoder_Decode( vlc_input_decoder_t *p_owner, vlc_frame_t *frame,
     }
 
     vlc_fifo_QueueUnlocked( p_owner->p_fifo, frame );
+    DecoderSchedule( p_owner );
     vlc_fifo_Unlock( p_owner->p_fifo );
 }
 
@@ -2321,6 +2878,18 @@ bool vlc_input_decoder_IsEmpty( vlc_input_decoder_t * p_owner )
         return false;
     }
 
+    if( p_owner->out.depth > 0 )
+    {
+        vlc_mutex_lock( &p_owner->out.lock );
+        bool b_queued = p_owner->out.count > 0 || p_owner->out.busy;
+        vlc_mutex_unlock( &p_owner->out.lock );
+        if( b_queued )
+        {
+            vlc_fifo_Unlock( p_owner->p_fifo );
+            return false;
+        }
+    }
+
     bool b_empty;
 
 #ifdef ENABLE_SOUT
@@ -2359,6 +2928,7 @@ void vlc_input_decoder_Drain( vlc_input_decoder_t *p_owner )
     vlc_fifo_Lock( p_owner->p_fifo );
     p_owner->b_draining = true;
     vlc_fifo_Signal( p_owner->p_fifo );
+    DecoderSchedule( p_owner );
     vlc_fifo_Unlock( p_owner->p_fifo );
 }
 
@@ -2382,6 +2952,12 @@ void vlc_input_decoder_Flush( vlc_input_decoder_t *p_owner )
     p_owner->flushing = true;
     p_owner->b_draining = false;
 
+    /* Drop the decoded buffers waiting for the output stage, and the one it
+     * may be about to play */
+    atomic_fetch_add_explicit( &p_owner->out_gen, 1, memory_order_relaxed );
+    if( p_owner->out.depth > 0 )
+        DecoderOutputPurge( p_owner );
+
     /* Flush video/spu decoder when paused: increment frames_countdown in order
      * to display one frame/subtitle */
     if( p_owner->paused && ( cat == VIDEO_ES || cat == SPU_ES )
@@ -2413,6 +2989,7 @@ void vlc_input_decoder_Flush( vlc_input_decoder_t *p_owner )
         }
     }
     vlc_fifo_Signal( p_owner->p_fifo );
+    DecoderSchedule( p_owner );
     vlc_fifo_Unlock( p_owner->p_fifo );
 
     if (vlc_input_decoder_IsSynchronous(p_owner))
@@ -2542,6 +3119,7 @@ void vlc_input_decoder_ChangePause( vlc_input_decoder_t *p_owner,
     p_owner->pause_date = i_date;
     p_owner->frames_countdown = 0;
     vlc_fifo_Signal( p_owner->p_fifo );
+    DecoderSchedule( p_owner );
     vlc_fifo_Unlock( p_owner->p_fifo );
 }
 
@@ -2583,6 +3161,7 @@ void vlc_input_decoder_StopWait( vlc_input_decoder_t *p_owner )
     assert( p_owner->b_waiting );
     p_owner->b_waiting = false;
     vlc_cond_signal( &p_owner->wait_request );
+    DecoderSchedule( p_owner );
     vlc_fifo_Unlock(p_owner->p_fifo);
 }
 
@@ -2619,6 +3198,7 @@ void vlc_input_decoder_FrameNext( vlc_input_decoder_t *p_owner )
     vlc_fifo_Lock( p_owner->p_fifo );
     p_owner->frames_countdown++;
     vlc_fifo_Signal( p_owner->p_fifo );
+    DecoderSchedule( p_owner );
     vlc_fifo_Unlock( p_owner->p_fifo );
 
     vlc_fifo_Lock(p_owner->p_fifo);
@@ -3974,6 +3974,9 @@ static int EsOutVaPrivControlLocked( es_out_t *out, int query, va_list args )
         }
         return ret;
     }
+    case ES_OUT_PRIV_JUMP_TIMESHIFT:
+        /* Only the timeshift es_out buffers anything to jump over */
+        return VLC_EGENERIC;
     default: vlc_assert_unreachable();
     }
 
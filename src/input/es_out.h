@@ -96,7 +96,10 @@ enum es_out_query_private_e
     ES_OUT_PRIV_SET_VBI_PAGE,                       /* arg1=unsigned res=can fail */
 
     /* Set VBI/Teletext menu transparent */
-    ES_OUT_PRIV_SET_VBI_TRANSPARENCY                /* arg1=bool res=can fail */
+    ES_OUT_PRIV_SET_VBI_TRANSPARENCY,               /* arg1=bool res=can fail */
+
+    /* Jump forward or back in the timeshift buffer */
+    ES_OUT_PRIV_JUMP_TIMESHIFT                      /* arg1=vlc_tick_t res=can fail */
 };
 
 static inline int es_out_vaPrivControl( es_out_t *out, int query, va_list args )
@@ -241,6 +244,10 @@ static inline int es_out_SetVbiTransparency( es_out_t *p_out, vlc_es_id_t *id,
     return es_out_PrivControl( p_out, ES_OUT_PRIV_SET_VBI_TRANSPARENCY, id,
                                enabled );
 }
+static inline int es_out_JumpTimeshift( es_out_t *p_out, vlc_tick_t i_jump )
+{
+    return es_out_PrivControl( p_out, ES_OUT_PRIV_JUMP_TIMESHIFT, i_jump );
+}
 
 es_out_t  *input_EsOutNew( input_thread_t *, input_source_t *main_source, float rate,
                            enum input_type input_type );
@@ -36,6 +36,9 @@
 #endif
 #include <sys/stat.h>
 #include <unistd.h>
+#ifdef HAVE_MMAP
+#  include <sys/mman.h>
+#endif
 
 #include <vlc_common.h>
 #include <vlc_fs.h>
@@ -188,6 +191,13 @@ static_assert(offsetof(ts_cmd_t, header) == offsetof(ts_cmd_send_t, header), "in
 static_assert(offsetof(ts_cmd_t, header) == offsetof(ts_cmd_control_t, header), "invalid packing");
 static_assert(offsetof(ts_cmd_t, header) == offsetof(ts_cmd_privcontrol_t, header), "invalid packing");
 
+typedef struct
+{
+    vlc_tick_t i_date;  /* Date of the command */
+    size_t     i_cmd;   /* Offset of the command in p_cmd_buf */
+    size_t     i_state; /* Number of ES state commands before it */
+} ts_index_t;
+
 typedef struct ts_storage_t ts_storage_t;
 struct ts_storage_t
 {
@@ -201,12 +211,27 @@ struct ts_storage_t
     int64_t i_file_size;/* Current size in bytes */
     FILE    *p_filew;   /* FILE handle for data writing */
     FILE    *p_filer;   /* FILE handle for data reading */
+#ifdef HAVE_MMAP
+    uint8_t *p_map;     /* Read only mapping of the file once it is complete */
+    size_t  i_map;      /* Size of the mapping */
+    bool    b_cmd_map;  /* Commands are read from the mapping too */
+#endif
 
     /* */
     uint8_t *p_cmd_r;
     uint8_t *p_cmd_w;
     uint8_t *p_cmd_buf;
     size_t   i_cmd_buf;
+    size_t   i_cmd_done;    /* Commands before it were executed or skipped */
+    size_t   i_cmd_floor;   /* Commands before it cannot be replayed */
+    size_t   i_state_floor; /* Number of ES state commands before the floor */
+
+    /* Time index of the commands, sorted by date and offset */
+    ts_index_t *p_index;
+    size_t      i_index;
+    size_t      i_index_max;
+    size_t      i_state_r;
+    size_t      i_state_w;
 };
 
 typedef struct
@@ -237,10 +262,17 @@ typedef struct
     vlc_tick_t     i_buffering_delay;
 
     /* */
+    ts_storage_t   *p_storage_h; /* Oldest storage kept to jump back into */
     ts_storage_t   *p_storage_r;
     ts_storage_t   *p_storage_w;
+    int64_t        i_history_max;
+    int64_t        i_history; /* Size of the storages before p_storage_r */
 
     vlc_tick_t     i_cmd_delay;
+    vlc_tick_t     i_cmd_date; /* Date of the last read command */
+
+    /* Pending jump in the stored commands */
+    vlc_tick_t     i_jump;
 
 } ts_thread_t;
 
@@ -256,6 +288,7 @@ typedef struct
 
     /* Configuration */
     int64_t        i_tmp_size_max;    /* Maximal temporary file size in byte */
+    int64_t        i_history_max;     /* Played data kept in temporary files */
     char           *psz_tmp_path;     /* Path for temporary files */
 
     /* Lock for all following fields */
@@ -290,6 +323,7 @@ static bool         TsHasCmd( ts_thread_t * );
 static bool         TsIsUnused( ts_thread_t * );
 static int          TsChangePause( ts_thread_t *, bool b_source_paused, bool b_paused, vlc_tick_t i_date );
 static int          TsChangeRate( ts_thread_t *, float src_rate, float rate );
+static int          TsJump( ts_thread_t *, vlc_tick_t i_jump );
 
 static void         *TsRun( void * );
 
@@ -299,9 +333,15 @@ static void         TsStoragePack( ts_storage_t *p_storage );
 static bool         TsStorageIsFull( ts_storage_t *, const ts_cmd_t *p_cmd );
 static bool         TsStorageIsEmpty( ts_storage_t * );
 static void         TsStoragePushCmd( ts_storage_t *, const ts_cmd_t *p_cmd, bool b_flush );
-static void         TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_flush );
+static bool         TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_flush );
+static vlc_tick_t   TsStoragePeekDate( ts_storage_t * );
+static vlc_tick_t   TsStorageFirstDate( ts_storage_t * );
+static void         TsStorageSkip( ts_storage_t *, vlc_tick_t i_target );
+static void         TsStorageRewind( ts_storage_t *, vlc_tick_t i_target );
 
 static void CmdClean( ts_cmd_t * );
+static bool CmdIsSkippable( const ts_cmd_t * );
+static bool CmdIsBarrier( const ts_cmd_t * );
 
 static int  CmdInitAdd    ( ts_cmd_add_t *, input_source_t *, es_out_id_t *, const es_format_t *, bool b_copy );
 static void CmdInitSend   ( ts_cmd_send_t *, es_out_id_t *, block_t * );
@@ -759,6 +799,14 @@ static int PrivControlLocked( es_out_t *p_tsout, int i_query, va_list args )
     }
     case ES_OUT_PRIV_GET_GROUP_FORCED:
         return es_out_vaPrivControl( p_sys->p_out, i_query, args );
+    case ES_OUT_PRIV_JUMP_TIMESHIFT:
+    {
+        const vlc_tick_t i_jump = va_arg( args, vlc_tick_t );
+
+        if( !p_sys->b_delayed || i_jump == 0 )
+            return VLC_EGENERIC;
+        return TsJump( p_sys->p_ts, i_jump );
+    }
     /* Invalid queries for this es_out level */
     case ES_OUT_PRIV_SET_ES:
     case ES_OUT_PRIV_UNSET_ES:
@@ -837,6 +885,9 @@ es_out_t *input_EsOutTimeshiftNew( input_thread_t *p_input, es_out_t *p_next_out
     msg_Dbg( p_input, "using timeshift granularity of %d MiB",
              (int)p_sys->i_tmp_size_max/(1024*1024) );
 
+    const int64_t i_history_max = var_InheritInteger( p_input, "input-timeshift-history" );
+    p_sys->i_history_max = __MAX( i_history_max, 0 ) * 1024 * 1024;
+
     p_sys->psz_tmp_path = var_InheritString( p_input, "input-timeshift-path" );
 #if defined (_WIN32) && !defined(VLC_WINSTORE_APP)
     if( p_sys->psz_tmp_path == NULL )
@@ -929,8 +980,13 @@ static int TsStart( es_out_t *p_out )
     p_ts->i_rate_delay = 0;
     p_ts->i_buffering_delay = 0;
     p_ts->i_cmd_delay = 0;
+    p_ts->i_cmd_date = VLC_TICK_INVALID;
+    p_ts->i_jump = 0;
+    p_ts->p_storage_h = NULL;
     p_ts->p_storage_r = NULL;
     p_ts->p_storage_w = NULL;
+    p_ts->i_history_max = p_sys->i_history_max;
+    p_ts->i_history = 0;
 
     p_sys->b_delayed = true;
     if( vlc_clone( &p_ts->thread, TsRun, p_ts ) )
@@ -976,8 +1032,13 @@ static void TsStop( ts_thread_t *p_ts )
         CmdClean( &cmd );
     }
     assert( !p_ts->p_storage_r || !p_ts->p_storage_r->p_next );
-    if( p_ts->p_storage_r )
-        TsStorageDelete( p_ts->p_storage_r );
+    while( p_ts->p_storage_h )
+    {
+        ts_storage_t *p_next = p_ts->p_storage_h->p_next;
+
+        TsStorageDelete( p_ts->p_storage_h );
+        p_ts->p_storage_h = p_next;
+    }
     vlc_mutex_unlock( &p_ts->lock );
 
     TsDestroy( p_ts );
@@ -1000,7 +1061,7 @@ static void TsPushCmd( ts_thread_t *p_ts, ts_cmd_t *p_cmd )
 
         if( !p_ts->p_storage_w )
         {
-            p_ts->p_storage_r = p_ts->p_storage_w = p_storage;
+            p_ts->p_storage_h = p_ts->p_storage_r = p_ts->p_storage_w = p_storage;
         }
         else
         {
@@ -1017,26 +1078,71 @@ static void TsPushCmd( ts_thread_t *p_ts, ts_cmd_t *p_cmd )
 
     vlc_mutex_unlock( &p_ts->lock );
 }
-static int TsPopCmdLocked( ts_thread_t *p_ts, ts_cmd_t *p_cmd, bool b_flush )
+static void TsTrimHistoryLocked( ts_thread_t *p_ts )
 {
-    vlc_mutex_assert( &p_ts->lock );
+    while( p_ts->p_storage_h != p_ts->p_storage_r &&
+           p_ts->i_history > p_ts->i_history_max )
+    {
+        ts_storage_t *p_storage = p_ts->p_storage_h;
 
-    if( TsStorageIsEmpty( p_ts->p_storage_r ) )
-        return VLC_EGENERIC;
+        p_ts->i_history -= p_storage->i_file_size;
+        p_ts->p_storage_h = p_storage->p_next;
+        TsStorageDelete( p_storage );
+    }
+}
+static void TsDropHistoryLocked( ts_thread_t *p_ts )
+{
+    ts_storage_t *p_storage = p_ts->p_storage_r;
 
-    TsStoragePopCmd( p_ts->p_storage_r, p_cmd, b_flush );
+    /* Nothing read so far can be replayed anymore */
+    while( p_ts->p_storage_h != p_storage )
+    {
+        ts_storage_t *p_next = p_ts->p_storage_h->p_next;
+
+        TsStorageDelete( p_ts->p_storage_h );
+        p_ts->p_storage_h = p_next;
+    }
+    p_ts->i_history = 0;
 
+    p_storage->i_cmd_floor = p_storage->p_cmd_r - p_storage->p_cmd_buf;
+    p_storage->i_state_floor = p_storage->i_state_r;
+}
+static void TsNextStorageLocked( ts_thread_t *p_ts )
+{
+    /* Played storages are kept, up to the history size, to jump back */
     while( TsStorageIsEmpty( p_ts->p_storage_r ) )
     {
         ts_storage_t *p_next = p_ts->p_storage_r->p_next;
         if( !p_next )
             break;
 
-        TsStorageDelete( p_ts->p_storage_r );
+        p_ts->i_history += p_ts->p_storage_r->i_file_size;
         p_ts->p_storage_r = p_next;
+        TsTrimHistoryLocked( p_ts );
     }
+}
+static int TsPopCmdLocked( ts_thread_t *p_ts, ts_cmd_t *p_cmd, bool b_flush )
+{
+    vlc_mutex_assert( &p_ts->lock );
 
-    return VLC_SUCCESS;
+    for( ;; )
+    {
+        if( TsStorageIsEmpty( p_ts->p_storage_r ) )
+            return VLC_EGENERIC;
+
+        const bool b_replay = TsStoragePopCmd( p_ts->p_storage_r, p_cmd, b_flush );
+
+        p_ts->i_cmd_date = p_cmd->header.i_date;
+        if( !b_replay && CmdIsBarrier( p_cmd ) )
+            TsDropHistoryLocked( p_ts );
+
+        TsNextStorageLocked( p_ts );
+
+        /* Only data and clock commands are replayed after jumping back, the
+         * others were executed already and do not own anything anymore */
+        if( !b_replay || CmdIsSkippable( p_cmd ) )
+            return VLC_SUCCESS;
+    }
 }
 static bool TsHasCmd( ts_thread_t *p_ts )
 {
@@ -1109,6 +1215,137 @@ static int TsChangeRate( ts_thread_t *p_ts, float src_rate, float rate )
 
     return i_ret;
 }
+static int TsJump( ts_thread_t *p_ts, vlc_tick_t i_jump )
+{
+    int i_ret = VLC_EGENERIC;
+
+    vlc_mutex_lock( &p_ts->lock );
+    if( i_jump > 0 ? !TsStorageIsEmpty( p_ts->p_storage_r )
+                   : p_ts->i_cmd_date != VLC_TICK_INVALID )
+    {
+        /* The jump itself is done by the timeshift thread, in order with
+         * the commands it executes */
+        p_ts->i_jump += i_jump;
+        vlc_cond_signal( &p_ts->wait );
+        i_ret = VLC_SUCCESS;
+    }
+    vlc_mutex_unlock( &p_ts->lock );
+
+    return i_ret;
+}
+
+static void TsExecuteCmd( ts_thread_t *p_ts, ts_cmd_t *p_cmd )
+{
+    switch( p_cmd->header.i_type )
+    {
+    case C_ADD:
+        CmdExecuteAdd( p_ts->p_tsout, &p_cmd->add );
+        CmdCleanAdd( &p_cmd->add );
+        break;
+    case C_SEND:
+        CmdExecuteSend( p_ts->p_tsout, &p_cmd->send );
+        CmdCleanSend( &p_cmd->send );
+        break;
+    case C_CONTROL:
+        CmdExecuteControl( p_ts->p_tsout, &p_cmd->control );
+        CmdCleanControl( &p_cmd->control );
+        break;
+    case C_PRIVCONTROL:
+        CmdExecutePrivControl( p_ts->p_tsout, &p_cmd->privcontrol );
+        break;
+    case C_DEL:
+        CmdExecuteDel( p_ts->p_tsout, &p_cmd->del );
+        break;
+    default:
+        vlc_assert_unreachable();
+        break;
+    }
+}
+
+static void TsJumpBackLocked( ts_thread_t *p_ts, vlc_tick_t i_target )
+{
+    /* Find the last kept storage starting before the target */
+    ts_storage_t *p_storage = p_ts->p_storage_h;
+
+    while( p_storage != p_ts->p_storage_r &&
+           TsStorageFirstDate( p_storage->p_next ) <= i_target )
+        p_storage = p_storage->p_next;
+
+    /* The storages after it are read again from their beginning */
+    TsStorageRewind( p_storage, i_target );
+    for( ts_storage_t *p = p_storage; p != p_ts->p_storage_r; p = p->p_next )
+    {
+        p_ts->i_history -= p->i_file_size;
+        TsStorageRewind( p->p_next, i_target );
+    }
+    p_ts->p_storage_r = p_storage;
+
+    TsNextStorageLocked( p_ts );
+}
+
+static void TsJumpLocked( ts_thread_t *p_ts )
+{
+    const vlc_tick_t i_jump = p_ts->i_jump;
+    vlc_tick_t i_shift = i_jump;
+
+    p_ts->i_jump = 0;
+    if( i_jump < 0 )
+    {
+        if( p_ts->i_cmd_date == VLC_TICK_INVALID )
+            return;
+
+        const vlc_tick_t i_date = TsStorageIsEmpty( p_ts->p_storage_r )
+                                ? p_ts->i_cmd_date
+                                : TsStoragePeekDate( p_ts->p_storage_r );
+
+        /* Go back to the played commands, only their data and clock
+         * updates will be executed again */
+        TsJumpBackLocked( p_ts, i_date + i_jump );
+        i_shift = TsStorageIsEmpty( p_ts->p_storage_r ) ? 0
+                : TsStoragePeekDate( p_ts->p_storage_r ) - i_date;
+    }
+    else
+    {
+        if( TsStorageIsEmpty( p_ts->p_storage_r ) )
+            return;
+
+        const vlc_tick_t i_target = TsStoragePeekDate( p_ts->p_storage_r ) + i_jump;
+
+        /* Drop everything older than the target without reading the data
+         * back, only the commands changing the ES state are still
+         * executed */
+        while( !TsStorageIsEmpty( p_ts->p_storage_r ) )
+        {
+            ts_cmd_t cmd;
+
+            TsStorageSkip( p_ts->p_storage_r, i_target );
+            TsNextStorageLocked( p_ts );
+            if( TsStorageIsEmpty( p_ts->p_storage_r ) ||
+                TsStoragePeekDate( p_ts->p_storage_r ) >= i_target )
+                break;
+
+            if( TsPopCmdLocked( p_ts, &cmd, true ) )
+                break;
+            if( CmdIsSkippable( &cmd ) )
+            {
+                CmdClean( &cmd );
+                continue;
+            }
+            vlc_mutex_unlock( &p_ts->lock );
+            TsExecuteCmd( p_ts, &cmd );
+            vlc_mutex_lock( &p_ts->lock );
+        }
+    }
+
+    /* Restart the rate regulation from the new position */
+    p_ts->i_cmd_delay += p_ts->i_rate_delay;
+    p_ts->i_rate_date = -1;
+    p_ts->i_rate_delay = 0;
+
+    p_ts->i_cmd_delay = __MAX( p_ts->i_cmd_delay - i_shift, 0 );
+
+    es_out_Control( p_ts->p_out, ES_OUT_RESET_PCR );
+}
 
 static void *TsRun( void *p_data )
 {
@@ -1123,6 +1360,12 @@ static void *TsRun( void *p_data )
         ts_cmd_t cmd;
         vlc_tick_t  i_deadline;
 
+        if( p_ts->i_jump != 0 )
+        {
+            TsJumpLocked( p_ts );
+            continue;
+        }
+
         /* Pop a command to execute */
         bool b_buffering = es_out_GetBuffering( p_ts->p_out );
 
@@ -1189,30 +1432,7 @@ static void *TsRun( void *p_data )
         }
 
         /* Execute the command  */
-        switch( cmd.header.i_type )
-        {
-        case C_ADD:
-            CmdExecuteAdd( p_ts->p_tsout, &cmd.add );
-            CmdCleanAdd( &cmd.add );
-            break;
-        case C_SEND:
-            CmdExecuteSend( p_ts->p_tsout, &cmd.send );
-            CmdCleanSend( &cmd.send );
-            break;
-        case C_CONTROL:
-            CmdExecuteControl( p_ts->p_tsout, &cmd.control );
-            CmdCleanControl( &cmd.control );
-            break;
-        case C_PRIVCONTROL:
-            CmdExecutePrivControl( p_ts->p_tsout, &cmd.privcontrol );
-            break;
-        case C_DEL:
-            CmdExecuteDel( p_ts->p_tsout, &cmd.del );
-            break;
-        default:
-            vlc_assert_unreachable();
-            break;
-        }
+        TsExecuteCmd( p_ts, &cmd );
         vlc_mutex_lock( &p_ts->lock );
     }
     vlc_mutex_unlock( &p_ts->lock );
@@ -1224,6 +1444,7 @@ static void *TsRun( void *p_data )
  *****************************************************************************/
 #define MAX_COMMAND_SIZE sizeof(ts_cmd_t)
 #define TS_STORAGE_COMMAND_PREALLOC 30000
+#define TS_STORAGE_INDEX_INTERVAL VLC_TICK_FROM_MS(100)
 
 static const size_t TsStorageSizeofCommand[] =
 {
@@ -1275,12 +1496,27 @@ static ts_storage_t *TsStorageNew( const char *psz_tmp_path, int64_t i_tmp_size_
     /* */
     p_storage->i_file_max = i_tmp_size_max;
     p_storage->i_file_size = 0;
+#ifdef HAVE_MMAP
+    p_storage->p_map = NULL;
+    p_storage->i_map = 0;
+    p_storage->b_cmd_map = false;
+#endif
+
+    /* */
+    p_storage->p_index = NULL;
+    p_storage->i_index = 0;
+    p_storage->i_index_max = 0;
+    p_storage->i_state_r = 0;
+    p_storage->i_state_w = 0;
 
     /* */
     p_storage->p_cmd_buf = vlc_alloc( TS_STORAGE_COMMAND_PREALLOC, MAX_COMMAND_SIZE );
     p_storage->i_cmd_buf = TS_STORAGE_COMMAND_PREALLOC * MAX_COMMAND_SIZE;
     p_storage->p_cmd_w = p_storage->p_cmd_buf;
     p_storage->p_cmd_r = p_storage->p_cmd_buf;
+    p_storage->i_cmd_done = 0;
+    p_storage->i_cmd_floor = 0;
+    p_storage->i_state_floor = 0;
     //fprintf( stderr, "\nSTORAGE name=%s size=%d KiB\n", p_storage->psz_file, p_storage->i_cmd_max * sizeof(*p_storage->p_cmd) /1024 );
 
     if( !p_storage->p_cmd_buf )
@@ -1297,6 +1533,10 @@ error:
 
 static void TsStorageDelete( ts_storage_t *p_storage )
 {
+    /* Only the commands never read still own their resources */
+    if( p_storage->p_cmd_r < p_storage->p_cmd_buf + p_storage->i_cmd_done )
+        p_storage->p_cmd_r = p_storage->p_cmd_buf + p_storage->i_cmd_done;
+
     while( p_storage->p_cmd_r < p_storage->p_cmd_w )
     {
         ts_cmd_t cmd;
@@ -1305,8 +1545,16 @@ static void TsStorageDelete( ts_storage_t *p_storage )
 
         CmdClean( &cmd );
     }
-    free( p_storage->p_cmd_buf );
+#ifdef HAVE_MMAP
+    if( !p_storage->b_cmd_map )
+#endif
+        free( p_storage->p_cmd_buf );
+    free( p_storage->p_index );
 
+#ifdef HAVE_MMAP
+    if( p_storage->p_map != NULL )
+        munmap( p_storage->p_map, p_storage->i_map );
+#endif
     fclose( p_storage->p_filer );
     fclose( p_storage->p_filew );
 #ifdef _WIN32
@@ -1318,6 +1566,43 @@ static void TsStorageDelete( ts_storage_t *p_storage )
 
 static void TsStoragePack( ts_storage_t *p_storage )
 {
+#ifdef HAVE_MMAP
+    /* Nothing will be written anymore: append the commands after the data
+     * and read both back from a mapping instead of seeking and reading
+     * through the FILE. Only the index of a complete storage and what its
+     * ES state commands own stay in memory. */
+    const size_t i_cmd = p_storage->p_cmd_w - p_storage->p_cmd_buf;
+    const long i_cmd_pos = ftell( p_storage->p_filew );
+    const bool b_cmd_map = i_cmd > 0 && i_cmd_pos >= p_storage->i_file_size &&
+                           fwrite( p_storage->p_cmd_buf, i_cmd, 1, p_storage->p_filew ) == 1;
+    const size_t i_map = b_cmd_map ? i_cmd_pos + i_cmd : p_storage->i_file_size;
+
+    if( i_map > 0 && fflush( p_storage->p_filew ) == 0 )
+    {
+        uint8_t *p_map = mmap( NULL, i_map, PROT_READ, MAP_SHARED,
+                               fileno( p_storage->p_filew ), 0 );
+        if( p_map != MAP_FAILED )
+        {
+            posix_madvise( p_map, i_map, POSIX_MADV_SEQUENTIAL );
+            p_storage->p_map = p_map;
+            p_storage->i_map = i_map;
+        }
+    }
+
+    if( p_storage->p_map != NULL && b_cmd_map )
+    {
+        uint8_t *p_cmd_buf = &p_storage->p_map[i_cmd_pos];
+
+        p_storage->p_cmd_r = p_cmd_buf + (p_storage->p_cmd_r - p_storage->p_cmd_buf);
+        p_storage->p_cmd_w = p_cmd_buf + i_cmd;
+        free( p_storage->p_cmd_buf );
+        p_storage->p_cmd_buf = p_cmd_buf;
+        p_storage->i_cmd_buf = i_cmd;
+        p_storage->b_cmd_map = true;
+        return;
+    }
+#endif
+
     /* Try to release a bit of memory */
     if( (size_t)(p_storage->p_cmd_w - p_storage->p_cmd_buf) == p_storage->i_cmd_buf )
         return;
@@ -1350,6 +1635,28 @@ static bool TsStorageIsEmpty( ts_storage_t *p_storage )
     return !p_storage || p_storage->p_cmd_r >= p_storage->p_cmd_w;
 }
 
+static void TsStorageIndexCmd( ts_storage_t *p_storage, const ts_cmd_t *p_cmd )
+{
+    if( p_storage->i_index > 0 &&
+        p_cmd->header.i_date < p_storage->p_index[p_storage->i_index - 1].i_date + TS_STORAGE_INDEX_INTERVAL )
+        return;
+
+    if( p_storage->i_index >= p_storage->i_index_max )
+    {
+        size_t i_max = p_storage->i_index_max > 0 ? 2 * p_storage->i_index_max : 64;
+        ts_index_t *p_index = realloc( p_storage->p_index, i_max * sizeof(*p_index) );
+        if( !p_index )
+            return;
+        p_storage->p_index = p_index;
+        p_storage->i_index_max = i_max;
+    }
+
+    ts_index_t *p_entry = &p_storage->p_index[p_storage->i_index++];
+    p_entry->i_date = p_cmd->header.i_date;
+    p_entry->i_cmd = p_storage->p_cmd_w - p_storage->p_cmd_buf;
+    p_entry->i_state = p_storage->i_state_w;
+}
+
 static void TsStoragePushCmd( ts_storage_t *p_storage, const ts_cmd_t *p_cmd, bool b_flush )
 {
     assert( !TsStorageIsFull( p_storage, p_cmd ) );
@@ -1383,51 +1690,218 @@ static void TsStoragePushCmd( ts_storage_t *p_storage, const ts_cmd_t *p_cmd, bo
         if( b_flush )
             fflush( p_storage->p_filew );
     }
+    TsStorageIndexCmd( p_storage, &cmd );
+    if( !CmdIsSkippable( &cmd ) )
+        p_storage->i_state_w++;
+
     size_t i_cmdsize = TsStorageSizeofCommand[ cmd.header.i_type ];
     memcpy( p_storage->p_cmd_w, &cmd, i_cmdsize );
     p_storage->p_cmd_w += i_cmdsize;
 }
 
-static void TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_flush )
+static block_t *TsStorageReadBlock( ts_storage_t *p_storage, int i_offset )
+{
+    block_t block, *p_block;
+
+#ifdef HAVE_MMAP
+    if( p_storage->p_map != NULL )
+    {
+        const size_t i_size = p_storage->i_file_size;
+
+        if( (size_t)i_offset + sizeof(block) > i_size )
+            return NULL;
+        memcpy( &block, &p_storage->p_map[i_offset], sizeof(block) );
+        i_offset += sizeof(block);
+        if( block.i_buffer > i_size - i_offset )
+            return NULL;
+
+        p_block = block_Alloc( block.i_buffer );
+        if( p_block )
+            memcpy( p_block->p_buffer, &p_storage->p_map[i_offset], block.i_buffer );
+    }
+    else
+#endif
+    {
+        if( fseek( p_storage->p_filer, i_offset, SEEK_SET ) ||
+            fread( &block, sizeof(block), 1, p_storage->p_filer ) != 1 )
+            return NULL;
+
+        p_block = block_Alloc( block.i_buffer );
+        if( p_block )
+            p_block->i_buffer = fread( p_block->p_buffer, 1, block.i_buffer, p_storage->p_filer );
+    }
+
+    if( p_block )
+    {
+        p_block->i_dts      = block.i_dts;
+        p_block->i_pts      = block.i_pts;
+        p_block->i_flags    = block.i_flags;
+        p_block->i_length   = block.i_length;
+        p_block->i_nb_samples = block.i_nb_samples;
+    }
+    return p_block;
+}
+
+static bool TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_flush )
 {
     assert( !TsStorageIsEmpty( p_storage ) );
 
+    /* Commands read again after a jump back were already executed */
+    const bool b_replay = (size_t)(p_storage->p_cmd_r - p_storage->p_cmd_buf)
+                          < p_storage->i_cmd_done;
+
     p_cmd->header.i_type = p_storage->p_cmd_r[0];
     size_t i_cmdsize = TsStorageSizeofCommand[ p_cmd->header.i_type ];
     memcpy(p_cmd, p_storage->p_cmd_r, i_cmdsize);
     p_storage->p_cmd_r += i_cmdsize;
+    p_storage->i_cmd_done = __MAX( p_storage->i_cmd_done,
+                                   (size_t)(p_storage->p_cmd_r - p_storage->p_cmd_buf) );
+
+    if( !CmdIsSkippable( p_cmd ) )
+    {
+        p_storage->i_state_r++;
+        if( b_replay )
+            return true;
+    }
 
     if( p_cmd->header.i_type == C_SEND )
     {
-        block_t block;
+        block_t *p_block = NULL;
 
-        if( !b_flush &&
-            !fseek( p_storage->p_filer, p_cmd->send.i_offset, SEEK_SET ) &&
-            fread( &block, sizeof(block), 1, p_storage->p_filer ) == 1 )
-        {
-            block_t *p_block = block_Alloc( block.i_buffer );
-            if( p_block )
-            {
-                p_block->i_dts      = block.i_dts;
-                p_block->i_pts      = block.i_pts;
-                p_block->i_flags    = block.i_flags;
-                p_block->i_length   = block.i_length;
-                p_block->i_nb_samples = block.i_nb_samples;
-                p_block->i_buffer = fread( p_block->p_buffer, 1, block.i_buffer, p_storage->p_filer );
-            }
-            p_cmd->send.p_block = p_block;
-        }
-        else
+        if( !b_flush )
+            p_block = TsStorageReadBlock( p_storage, p_cmd->send.i_offset );
+        if( !p_block )
         {
             //perror( "TsStoragePopCmd" );
-            p_cmd->send.p_block = block_Alloc( 1 );
+            p_block = block_Alloc( 1 );
         }
+        p_cmd->send.p_block = p_block;
+    }
+    return b_replay;
+}
+
+static vlc_tick_t TsStoragePeekDate( ts_storage_t *p_storage )
+{
+    assert( !TsStorageIsEmpty( p_storage ) );
+
+    ts_cmd_header_t header;
+    memcpy( &header, p_storage->p_cmd_r, sizeof(header) );
+    return header.i_date;
+}
+
+static vlc_tick_t TsStorageFirstDate( ts_storage_t *p_storage )
+{
+    const uint8_t *p_cmd = p_storage->p_cmd_buf + p_storage->i_cmd_floor;
+
+    if( p_cmd >= p_storage->p_cmd_w )
+        return VLC_TICK_MAX;
+
+    ts_cmd_header_t header;
+    memcpy( &header, p_cmd, sizeof(header) );
+    return header.i_date;
+}
+
+static void TsStorageSkip( ts_storage_t *p_storage, vlc_tick_t i_target )
+{
+    /* Find the last indexed command older than the target with only
+     * skippable or already executed commands between it and the read
+     * position. The dates, the state counters and the offsets are all
+     * increasing along the index. */
+    size_t i_low = 0;
+    size_t i_high = p_storage->i_index;
+
+    while( i_low < i_high )
+    {
+        const size_t i_mid = i_low + (i_high - i_low) / 2;
+        const ts_index_t *p_entry = &p_storage->p_index[i_mid];
+
+        if( p_entry->i_date < i_target &&
+            ( p_entry->i_state <= p_storage->i_state_r ||
+              p_entry->i_cmd <= p_storage->i_cmd_done ) )
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
+    }
+    if( i_low == 0 )
+        return;
+
+    /* The skipped commands do not own anything, the data is left in the
+     * file */
+    const ts_index_t *p_entry = &p_storage->p_index[i_low - 1];
+    if( p_storage->p_cmd_buf + p_entry->i_cmd > p_storage->p_cmd_r )
+    {
+        p_storage->p_cmd_r = p_storage->p_cmd_buf + p_entry->i_cmd;
+        p_storage->i_state_r = p_entry->i_state;
+        p_storage->i_cmd_done = __MAX( p_storage->i_cmd_done, p_entry->i_cmd );
+    }
+}
+
+static void TsStorageRewind( ts_storage_t *p_storage, vlc_tick_t i_target )
+{
+    /* Find the last indexed command not after the target, the read position
+     * never goes back before the floor */
+    size_t i_low = 0;
+    size_t i_high = p_storage->i_index;
+
+    while( i_low < i_high )
+    {
+        const size_t i_mid = i_low + (i_high - i_low) / 2;
+
+        if( p_storage->p_index[i_mid].i_date <= i_target )
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
     }
+
+    size_t i_cmd = p_storage->i_cmd_floor;
+    size_t i_state = p_storage->i_state_floor;
+    if( i_low > 0 && p_storage->p_index[i_low - 1].i_cmd > i_cmd )
+    {
+        i_cmd = p_storage->p_index[i_low - 1].i_cmd;
+        i_state = p_storage->p_index[i_low - 1].i_state;
+    }
+    assert( i_cmd <= p_storage->i_cmd_done );
+
+    p_storage->p_cmd_r = p_storage->p_cmd_buf + i_cmd;
+    p_storage->i_state_r = i_state;
 }
 
 /*****************************************************************************
  *
  *****************************************************************************/
+static bool CmdIsSkippable( const ts_cmd_t *p_cmd )
+{
+    /* Data and clock updates are useless once jumped over, and they do not
+     * own any resource while stored */
+    switch( p_cmd->header.i_type )
+    {
+    case C_SEND:
+        return true;
+    case C_CONTROL:
+        return p_cmd->control.i_query == ES_OUT_SET_PCR ||
+               p_cmd->control.i_query == ES_OUT_SET_GROUP_PCR;
+    case C_PRIVCONTROL:
+        return p_cmd->privcontrol.i_query == ES_OUT_PRIV_SET_TIMES;
+    default:
+        return false;
+    }
+}
+
+static bool CmdIsBarrier( const ts_cmd_t *p_cmd )
+{
+    /* Data sent before a deleted ES or a format change cannot be replayed:
+     * the ES is gone or its decoder does not expect it anymore */
+    switch( p_cmd->header.i_type )
+    {
+    case C_DEL:
+        return true;
+    case C_CONTROL:
+        return p_cmd->control.i_query == ES_OUT_SET_ES_FMT;
+    default:
+        return false;
+    }
+}
+
 static void CmdClean( ts_cmd_t *p_cmd )
 {
     switch( p_cmd->header.i_type )
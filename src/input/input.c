@@ -1988,6 +1988,15 @@ static bool Control( input_thread_t *p_input,
                 break;
             }
 
+            /* Jump inside the timeshift buffer when possible, it does not
+             * involve the demuxer at all */
+            if( !absolute && param.time.i_val != 0 &&
+                es_out_JumpTimeshift( priv->p_es_out, param.time.i_val ) == VLC_SUCCESS )
+            {
+                b_force_update = true;
+                break;
+            }
+
             /* Reset the decoders states and clock sync (before calling the demuxer */
             es_out_Control( priv->p_es_out, ES_OUT_RESET_PCR );
 
@@ -28,6 +28,7 @@
 #include <string.h>
 
 #include <vlc_common.h>
+#include <vlc_frame.h>
 #include "input/input_internal.h"
 
 /**
@@ -111,6 +112,14 @@ void input_stats_Compute(struct input_stats *stats, input_stats_t *st)
                                                     memory_order_relaxed);
     st->i_lost_pictures = atomic_load_explicit(&stats->lost_pictures,
                                                memory_order_relaxed);
+
+    /* Frame allocator */
+    struct vlc_frame_cache_stats cache;
+    vlc_frame_GetCacheStats(&cache);
+    st->i_frame_cache_allocated = cache.allocated;
+    st->i_frame_cache_freed = cache.freed;
+    st->i_frame_cache_refills = cache.refills;
+    st->i_frame_cache_spills = cache.spills;
 }
 
 /** Update a counter element with new values
@@ -406,6 +406,11 @@ static const char *const screensaver_texts[] = {
     "picture quality, for instance deinterlacing, or distort " \
     "the video.")
 
+#define CHROMA_THREADS_TEXT N_("Chroma conversion threads")
+#define CHROMA_THREADS_LONGTEXT N_( \
+    "Number of threads used to convert each picture between chromas in " \
+    "software (0 = automatic, 1 = no threading).")
+
 #define SNAP_PATH_TEXT N_("Video snapshot directory (or filename)")
 #define SNAP_PATH_LONGTEXT N_( \
     "Directory where the video snapshots will be stored.")
@@ -761,6 +766,12 @@ static const char* const ppsz_restore_playback_desc[] = {
     "This is the maximum size in bytes of the temporary files " \
     "that will be used to store the timeshifted streams." )
 
+#define INPUT_TIMESHIFT_HISTORY_TEXT N_("Timeshift history (MiB)")
+#define INPUT_TIMESHIFT_HISTORY_LONGTEXT N_( \
+    "Amount of already played data kept in the timeshift temporary files, " \
+    "so that playback can jump back into it. With 0, only the file being " \
+    "played is kept." )
+
 #define INPUT_TITLE_FORMAT_TEXT N_( "Change title according to current media" )
 #define INPUT_TITLE_FORMAT_LONGTEXT N_( "This option allows you to set the title according to what's being played<br>"  \
     "$a: Artist<br>$b: Album<br>$c: Copyright<br>$t: Title<br>$g: Genre<br>"  \
@@ -920,6 +931,15 @@ static const char* const ppsz_restore_playback_desc[] = {
     "However allocation of port numbers below 1025 is usually restricted " \
     "by the operating system." )
 
+#define HTTP_OVERRUN_TEXT N_("HTTP stream slow clients")
+#define HTTP_OVERRUN_LONGTEXT N_( \
+    "What the HTTP server does with a client that falls behind a live " \
+    "stream by more than its buffer: skip ahead to the latest keyframe, " \
+    "or disconnect it." )
+static const int pi_http_overrun_values[] = { 0, 1 };
+static const char *const ppsz_http_overrun_text[] = {
+    N_("Skip ahead"), N_("Disconnect") };
+
 #define HTTP_CERT_TEXT N_("HTTP/TLS server certificate")
 #define CERT_LONGTEXT N_( \
    "This X.509 certificate file (PEM format) is used for server-side TLS. " \
@@ -1001,6 +1021,20 @@ static const char* const ppsz_restore_playback_desc[] = {
     "VLC will fallback automatically to software decoders in case of " \
     "hardware decoder failure." )
 
+#define DEC_OUTPUT_QUEUE_TEXT N_("Decoder output queue")
+#define DEC_OUTPUT_QUEUE_LONGTEXT N_( \
+    "Number of decoded audio or video buffers that can wait for the " \
+    "output. If not zero, decoded buffers are passed to the output from " \
+    "another thread, so that a slow output does not stall decoding. " \
+    "Hardware video decoders queue a single picture, as their surface " \
+    "pools are not enlarged.")
+
+#define DEC_POOL_THREADS_TEXT N_("Shared decoder threads")
+#define DEC_POOL_THREADS_LONGTEXT N_( \
+    "If not zero, audio and subtitle streams are decoded by a pool of this " \
+    "many threads, shared by all the inputs, rather than by one thread " \
+    "each. This suits many simultaneous low bitrate inputs.")
+
 #define DEC_DEV_TEXT N_("Preferred decoder hardware device")
 #define DEC_DEV_LONGTEXT N_("This allows hardware decoding when available.")
 
@@ -1736,6 +1770,8 @@ vlc_module_begin ()
     set_subcategory( SUBCAT_VIDEO_VFILTER )
     add_module_list("video-filter", "video filter", NULL,
                     VIDEO_FILTER_TEXT, VIDEO_FILTER_LONGTEXT)
+    add_integer_with_range( "chroma-threads", 1, 0, 16,
+                            CHROMA_THREADS_TEXT, CHROMA_THREADS_LONGTEXT )
 
 #if 0
     add_string( "pixel-ratio", "1", PIXEL_RATIO_TEXT, PIXEL_RATIO_TEXT )
@@ -1895,6 +1931,9 @@ vlc_module_begin ()
     add_string( "rtsp-host", NULL, RTSP_HOST_TEXT, RTSP_HOST_LONGTEXT )
     add_integer( "rtsp-port", 554, RTSP_PORT_TEXT, RTSP_PORT_LONGTEXT )
         change_integer_range( 1, 65535 )
+    add_integer( "http-stream-overrun", 0, HTTP_OVERRUN_TEXT,
+                 HTTP_OVERRUN_LONGTEXT )
+        change_integer_list( pi_http_overrun_values, ppsz_http_overrun_text )
     add_loadfile("http-cert", NULL, HTTP_CERT_TEXT, CERT_LONGTEXT)
     add_loadfile("http-key", NULL, HTTP_KEY_TEXT, KEY_LONGTEXT)
     add_obsolete_string( "http-ca" ) /* since 3.0.0 */
@@ -1985,6 +2024,9 @@ vlc_module_begin ()
                   INPUT_TIMESHIFT_PATH_TEXT, INPUT_TIMESHIFT_PATH_LONGTEXT)
     add_integer( "input-timeshift-granularity", -1, INPUT_TIMESHIFT_GRANULARITY_TEXT,
                  INPUT_TIMESHIFT_GRANULARITY_LONGTEXT )
+    add_integer_with_range( "input-timeshift-history", 0, 0, INT_MAX,
+                            INPUT_TIMESHIFT_HISTORY_TEXT,
+                            INPUT_TIMESHIFT_HISTORY_LONGTEXT )
 
     add_string( "input-title-format", "$Z", INPUT_TITLE_FORMAT_TEXT, INPUT_TITLE_FORMAT_LONGTEXT );
 
@@ -2004,6 +2046,12 @@ vlc_module_begin ()
 
     add_string( "codec", "any", CODEC_TEXT, CODEC_LONGTEXT )
     add_bool( "hw-dec", true, HW_DEC_TEXT, HW_DEC_LONGTEXT )
+    add_integer( "dec-output-queue", 0, DEC_OUTPUT_QUEUE_TEXT,
+                 DEC_OUTPUT_QUEUE_LONGTEXT )
+        change_integer_range( 0, 64 )
+    add_integer( "dec-pool-threads", 0, DEC_POOL_THREADS_TEXT,
+                 DEC_POOL_THREADS_LONGTEXT )
+        change_integer_range( 0, 256 )
     add_obsolete_string( "encoder" ) /* since 4.0.0 */
     add_module("dec-dev", "decoder device", "any", DEC_DEV_TEXT, DEC_DEV_LONGTEXT)
 
@@ -29,6 +29,25 @@
 #include <vlc_threads.h>
 #include "libvlc.h"
 
+#define PRIORITY_COUNT (VLC_EXECUTOR_PRIORITY_INTERACTIVE + 1)
+
+/**
+ * Queue of runnables owned by one executor thread.
+ *
+ * The owner takes its runnables in submission order. When its queue is
+ * empty, it steals runnables from the queues of the other threads, so that
+ * the threads only contend on the executor lock to sleep.
+ */
+struct vlc_executor_queue {
+    vlc_mutex_t lock;
+
+    /** Queues of vlc_runnable, one per priority */
+    struct vlc_list lanes[PRIORITY_COUNT];
+
+    /** Number of runnables in the lanes, readable without the lock */
+    atomic_uint count;
+};
+
 /**
  * An executor can spawn several threads.
  *
@@ -41,11 +60,20 @@ struct vlc_executor_thread {
     /** The executor owning the thread */
     vlc_executor_t *owner;
 
+    /** Index of the queue owned by the thread */
+    unsigned index;
+
     /** The system thread */
     vlc_thread_t thread;
 
     /** The current task executed by the thread, NULL if none */
     struct vlc_runnable *current_task;
+
+    /* Statistics, only written by the thread itself */
+    _Atomic uint64_t started;
+    _Atomic uint64_t stolen;
+    _Atomic vlc_tick_t latency_total;
+    _Atomic vlc_tick_t latency_max;
 };
 
 /**
@@ -53,6 +81,7 @@ struct vlc_executor_thread {
  * header).
  */
 struct vlc_executor {
+    /** Protect the threads list, and the sleeping and idle waits */
     vlc_mutex_t lock;
 
     /** Maximum number of threads to run the tasks */
@@ -62,57 +91,183 @@ struct vlc_executor {
     struct vlc_list threads;
 
     /** Thread count (in a separate field to quickly compare to max_threads) */
-    unsigned nthreads;
+    atomic_uint nthreads;
 
     /* Number of tasks requested but not finished. */
-    unsigned unfinished;
+    atomic_uint unfinished;
 
     /** Wait for the executor to be idle (i.e. unfinished == 0) */
     vlc_cond_t idle_wait;
 
-    /** Queue of vlc_runnable */
-    struct vlc_list queue;
+    /** Number of tasks queued and not taken by a thread yet */
+    atomic_uint pending;
+
+    /** Number of threads waiting on queue_wait */
+    atomic_uint sleepers;
 
-    /** Wait for the queue to be non-empty */
+    /** Round-robin counter to spread submissions from foreign threads */
+    atomic_uint next_queue;
+
+    /** Wait for a queue to be non-empty */
     vlc_cond_t queue_wait;
 
     /** True if executor deletion is requested */
     bool closing;
+
+    /** One queue per thread (max_threads) */
+    struct vlc_executor_queue queues[];
 };
 
+/** The executor thread running on the current thread, if any */
+static thread_local struct vlc_executor_thread *current_thread;
+
 static void
-QueuePush(vlc_executor_t *executor, struct vlc_runnable *runnable)
+QueuePush(vlc_executor_t *executor, struct vlc_runnable *runnable,
+          enum vlc_executor_priority priority)
 {
-    vlc_mutex_assert(&executor->lock);
+    struct vlc_executor_queue *queue;
+
+    /* Runnables submitted from a runnable stay on the same thread, unless
+     * stolen by an idle thread */
+    if (current_thread != NULL && current_thread->owner == executor)
+        queue = &executor->queues[current_thread->index];
+    else
+    {
+        unsigned nthreads = atomic_load(&executor->nthreads);
+        unsigned next = atomic_fetch_add_explicit(&executor->next_queue, 1,
+                                                  memory_order_relaxed);
+        queue = &executor->queues[next % nthreads];
+    }
 
-    vlc_list_append(&runnable->node, &executor->queue);
-    vlc_cond_signal(&executor->queue_wait);
+    runnable->queue = queue;
+    runnable->submitted = vlc_tick_now();
+
+    vlc_mutex_lock(&queue->lock);
+    vlc_list_append(&runnable->node, &queue->lanes[priority]);
+    atomic_fetch_add_explicit(&queue->count, 1, memory_order_relaxed);
+    atomic_fetch_add(&executor->pending, 1);
+    vlc_mutex_unlock(&queue->lock);
+
+    /* Pairs with the sleepers increment in ThreadRun() */
+    if (atomic_load(&executor->sleepers) > 0)
+    {
+        vlc_mutex_lock(&executor->lock);
+        vlc_cond_signal(&executor->queue_wait);
+        vlc_mutex_unlock(&executor->lock);
+    }
 }
 
 static struct vlc_runnable *
-QueueTake(vlc_executor_t *executor)
+QueueTakeFrom(vlc_executor_t *executor, struct vlc_executor_queue *queue,
+              unsigned lane)
 {
-    vlc_mutex_assert(&executor->lock);
-
-    while (!executor->closing && vlc_list_is_empty(&executor->queue))
-        vlc_cond_wait(&executor->queue_wait, &executor->lock);
-
-    if (executor->closing)
+    if (atomic_load_explicit(&queue->count, memory_order_relaxed) == 0)
         return NULL;
 
+    vlc_mutex_lock(&queue->lock);
+
     struct vlc_runnable *runnable =
-        vlc_list_first_entry_or_null(&executor->queue, struct vlc_runnable,
+        vlc_list_first_entry_or_null(&queue->lanes[lane], struct vlc_runnable,
                                      node);
-    assert(runnable);
-    vlc_list_remove(&runnable->node);
+    if (runnable)
+    {
+        vlc_list_remove(&runnable->node);
+
+        /* Set links to NULL to know that it has been taken by a thread in
+         * vlc_executor_Cancel() */
+        runnable->node.prev = runnable->node.next = NULL;
 
-    /* Set links to NULL to know that it has been taken by a thread in
-     * vlc_executor_Cancel() */
-    runnable->node.prev = runnable->node.next = NULL;
+        atomic_fetch_sub_explicit(&queue->count, 1, memory_order_relaxed);
+        atomic_fetch_sub(&executor->pending, 1);
+    }
+
+    vlc_mutex_unlock(&queue->lock);
 
     return runnable;
 }
 
+static struct vlc_runnable *
+QueueTake(vlc_executor_t *executor, struct vlc_executor_thread *thread)
+{
+    unsigned nthreads = atomic_load(&executor->nthreads);
+
+    for (unsigned lane = PRIORITY_COUNT; lane-- > 0;)
+    {
+        /* Own queue first, then steal from the next threads */
+        for (unsigned i = 0; i < nthreads; ++i)
+        {
+            struct vlc_executor_queue *queue =
+                &executor->queues[(thread->index + i) % nthreads];
+
+            struct vlc_runnable *runnable =
+                QueueTakeFrom(executor, queue, lane);
+            if (runnable)
+            {
+                if (i > 0)
+                    atomic_store_explicit(&thread->stolen,
+                        atomic_load_explicit(&thread->stolen,
+                                             memory_order_relaxed) + 1,
+                        memory_order_relaxed);
+                return runnable;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+static void
+UpdateStats(struct vlc_executor_thread *thread, vlc_tick_t latency)
+{
+    atomic_store_explicit(&thread->started,
+        atomic_load_explicit(&thread->started, memory_order_relaxed) + 1,
+        memory_order_relaxed);
+    atomic_store_explicit(&thread->latency_total,
+        atomic_load_explicit(&thread->latency_total, memory_order_relaxed)
+            + latency,
+        memory_order_relaxed);
+    if (latency > atomic_load_explicit(&thread->latency_max,
+                                       memory_order_relaxed))
+        atomic_store_explicit(&thread->latency_max, latency,
+                              memory_order_relaxed);
+}
+
+/**
+ * Wait until a runnable may be available.
+ *
+ * \retval false if the executor is closing
+ */
+static bool
+WaitPending(vlc_executor_t *executor)
+{
+    bool closing;
+
+    vlc_mutex_lock(&executor->lock);
+    /* Pairs with the sleepers check in QueuePush(): either the submitter sees
+     * a sleeper to wake up, or this thread sees the pending runnable */
+    atomic_fetch_add(&executor->sleepers, 1);
+    while (!executor->closing && atomic_load(&executor->pending) == 0)
+        vlc_cond_wait(&executor->queue_wait, &executor->lock);
+    atomic_fetch_sub(&executor->sleepers, 1);
+    closing = executor->closing;
+    vlc_mutex_unlock(&executor->lock);
+
+    return !closing;
+}
+
+static void
+TaskDone(vlc_executor_t *executor)
+{
+    unsigned unfinished = atomic_fetch_sub(&executor->unfinished, 1);
+    assert(unfinished > 0);
+    if (unfinished == 1)
+    {
+        vlc_mutex_lock(&executor->lock);
+        vlc_cond_broadcast(&executor->idle_wait);
+        vlc_mutex_unlock(&executor->lock);
+    }
+}
+
 static void *
 ThreadRun(void *userdata)
 {
@@ -120,31 +275,32 @@ ThreadRun(void *userdata)
     vlc_executor_t *executor = thread->owner;
 
     vlc_thread_set_name("vlc-exec-runner");
+    current_thread = thread;
 
-    vlc_mutex_lock(&executor->lock);
-
-    struct vlc_runnable *runnable;
-    /* When the executor is closing, QueueTake() returns NULL */
-    while ((runnable = QueueTake(executor)))
+    do
     {
-        thread->current_task = runnable;
-        vlc_mutex_unlock(&executor->lock);
+        struct vlc_runnable *runnable;
 
-        /* Execute the user-provided runnable, without the executor lock */
-        runnable->run(runnable->userdata);
+        while ((runnable = QueueTake(executor, thread)))
+        {
+            UpdateStats(thread, vlc_tick_now() - runnable->submitted);
 
-        vlc_mutex_lock(&executor->lock);
-        thread->current_task = NULL;
+            thread->current_task = runnable;
+
+            /* Execute the user-provided runnable, without the executor lock */
+            runnable->run(runnable->userdata);
 
-        vlc_thread_set_name("vlc-exec-runner");
+            thread->current_task = NULL;
 
-        assert(executor->unfinished > 0);
-        --executor->unfinished;
-        if (!executor->unfinished)
-            vlc_cond_signal(&executor->idle_wait);
+            vlc_thread_set_name("vlc-exec-runner");
+
+            TaskDone(executor);
+        }
     }
+    /* When the executor is closing, WaitPending() returns false */
+    while (WaitPending(executor));
 
-    vlc_mutex_unlock(&executor->lock);
+    current_thread = NULL;
 
     return NULL;
 }
@@ -152,14 +308,22 @@ ThreadRun(void *userdata)
 static int
 SpawnThread(vlc_executor_t *executor)
 {
-    assert(executor->nthreads < executor->max_threads);
+    vlc_mutex_assert(&executor->lock);
+
+    unsigned nthreads = atomic_load(&executor->nthreads);
+    assert(nthreads < executor->max_threads);
 
     struct vlc_executor_thread *thread = malloc(sizeof(*thread));
     if (!thread)
         return VLC_ENOMEM;
 
     thread->owner = executor;
+    thread->index = nthreads;
     thread->current_task = NULL;
+    atomic_init(&thread->started, 0);
+    atomic_init(&thread->stolen, 0);
+    atomic_init(&thread->latency_total, 0);
+    atomic_init(&thread->latency_max, 0);
 
     if (vlc_clone(&thread->thread, ThreadRun, thread))
     {
@@ -167,9 +331,11 @@ SpawnThread(vlc_executor_t *executor)
         return VLC_EGENERIC;
     }
 
-    executor->nthreads++;
     vlc_list_append(&thread->node, &executor->threads);
 
+    /* Expose the new queue to the submitters and to the other threads */
+    atomic_store(&executor->nthreads, nthreads + 1);
+
     return VLC_SUCCESS;
 }
 
@@ -177,18 +343,31 @@ vlc_executor_t *
 vlc_executor_New(unsigned max_threads)
 {
     assert(max_threads);
-    vlc_executor_t *executor = malloc(sizeof(*executor));
+    vlc_executor_t *executor =
+        malloc(sizeof(*executor) + max_threads * sizeof(executor->queues[0]));
     if (!executor)
         return NULL;
 
     vlc_mutex_init(&executor->lock);
 
     executor->max_threads = max_threads;
-    executor->nthreads = 0;
-    executor->unfinished = 0;
+    atomic_init(&executor->nthreads, 0);
+    atomic_init(&executor->unfinished, 0);
+    atomic_init(&executor->pending, 0);
+    atomic_init(&executor->sleepers, 0);
+    atomic_init(&executor->next_queue, 0);
 
     vlc_list_init(&executor->threads);
-    vlc_list_init(&executor->queue);
+
+    for (unsigned i = 0; i < max_threads; ++i)
+    {
+        struct vlc_executor_queue *queue = &executor->queues[i];
+
+        vlc_mutex_init(&queue->lock);
+        for (unsigned lane = 0; lane < PRIORITY_COUNT; ++lane)
+            vlc_list_init(&queue->lanes[lane]);
+        atomic_init(&queue->count, 0);
+    }
 
     vlc_cond_init(&executor->idle_wait);
     vlc_cond_init(&executor->queue_wait);
@@ -196,7 +375,9 @@ vlc_executor_New(unsigned max_threads)
     executor->closing = false;
 
     /* Create one thread on init so that vlc_executor_Submit() may never fail */
+    vlc_mutex_lock(&executor->lock);
     int ret = SpawnThread(executor);
+    vlc_mutex_unlock(&executor->lock);
     if (ret != VLC_SUCCESS)
     {
         free(executor);
@@ -207,26 +388,46 @@ vlc_executor_New(unsigned max_threads)
 }
 
 void
-vlc_executor_Submit(vlc_executor_t *executor, struct vlc_runnable *runnable)
+vlc_executor_SubmitWithPriority(vlc_executor_t *executor,
+                                struct vlc_runnable *runnable,
+                                enum vlc_executor_priority priority)
 {
-    vlc_mutex_lock(&executor->lock);
+    assert(priority < PRIORITY_COUNT);
+
+    unsigned unfinished = atomic_fetch_add(&executor->unfinished, 1) + 1;
 
-    assert(!executor->closing);
+    QueuePush(executor, runnable, priority);
 
-    QueuePush(executor, runnable);
+    if (unfinished > atomic_load(&executor->nthreads))
+    {
+        vlc_mutex_lock(&executor->lock);
 
-    if (++executor->unfinished > executor->nthreads
-            && executor->nthreads < executor->max_threads)
-        /* If it fails, this is not an error, there is at least one thread */
-        SpawnThread(executor);
+        assert(!executor->closing);
 
-    vlc_mutex_unlock(&executor->lock);
+        if (atomic_load(&executor->unfinished)
+                > atomic_load(&executor->nthreads)
+         && atomic_load(&executor->nthreads) < executor->max_threads)
+            /* If it fails, this is not an error, there is at least one
+             * thread */
+            SpawnThread(executor);
+
+        vlc_mutex_unlock(&executor->lock);
+    }
+}
+
+void
+vlc_executor_Submit(vlc_executor_t *executor, struct vlc_runnable *runnable)
+{
+    vlc_executor_SubmitWithPriority(executor, runnable,
+                                    VLC_EXECUTOR_PRIORITY_BACKGROUND);
 }
 
 bool
 vlc_executor_Cancel(vlc_executor_t *executor, struct vlc_runnable *runnable)
 {
-    vlc_mutex_lock(&executor->lock);
+    struct vlc_executor_queue *queue = runnable->queue;
+
+    vlc_mutex_lock(&queue->lock);
 
     /* Either both prev and next are set, either both are NULL */
     assert(!runnable->node.prev == !runnable->node.next);
@@ -235,14 +436,16 @@ vlc_executor_Cancel(vlc_executor_t *executor, struct vlc_runnable *runnable)
     if (in_queue)
     {
         vlc_list_remove(&runnable->node);
+        runnable->node.prev = runnable->node.next = NULL;
 
-        assert(executor->unfinished > 0);
-        --executor->unfinished;
-        if (!executor->unfinished)
-            vlc_cond_signal(&executor->idle_wait);
+        atomic_fetch_sub_explicit(&queue->count, 1, memory_order_relaxed);
+        atomic_fetch_sub(&executor->pending, 1);
     }
 
-    vlc_mutex_unlock(&executor->lock);
+    vlc_mutex_unlock(&queue->lock);
+
+    if (in_queue)
+        TaskDone(executor);
 
     return in_queue;
 }
@@ -251,11 +454,38 @@ void
 vlc_executor_WaitIdle(vlc_executor_t *executor)
 {
     vlc_mutex_lock(&executor->lock);
-    while (executor->unfinished)
+    while (atomic_load(&executor->unfinished))
         vlc_cond_wait(&executor->idle_wait, &executor->lock);
     vlc_mutex_unlock(&executor->lock);
 }
 
+void
+vlc_executor_GetStats(vlc_executor_t *executor,
+                      struct vlc_executor_stats *stats)
+{
+    *stats = (struct vlc_executor_stats) { 0 };
+
+    vlc_mutex_lock(&executor->lock);
+
+    struct vlc_executor_thread *thread;
+    vlc_list_foreach(thread, &executor->threads, node)
+    {
+        stats->started +=
+            atomic_load_explicit(&thread->started, memory_order_relaxed);
+        stats->stolen +=
+            atomic_load_explicit(&thread->stolen, memory_order_relaxed);
+        stats->latency_total +=
+            atomic_load_explicit(&thread->latency_total, memory_order_relaxed);
+
+        vlc_tick_t latency_max =
+            atomic_load_explicit(&thread->latency_max, memory_order_relaxed);
+        if (latency_max > stats->latency_max)
+            stats->latency_max = latency_max;
+    }
+
+    vlc_mutex_unlock(&executor->lock);
+}
+
 void
 vlc_executor_Delete(vlc_executor_t *executor)
 {
@@ -264,7 +494,7 @@ vlc_executor_Delete(vlc_executor_t *executor)
     executor->closing = true;
 
     /* All the tasks must be canceled on delete */
-    assert(vlc_list_is_empty(&executor->queue));
+    assert(atomic_load(&executor->pending) == 0);
 
     vlc_mutex_unlock(&executor->lock);
 
@@ -282,11 +512,11 @@ vlc_executor_Delete(vlc_executor_t *executor)
         free(thread);
     }
 
-    /* The queue must still be empty (no runnable submitted a new runnable) */
-    assert(vlc_list_is_empty(&executor->queue));
+    /* The queues must still be empty (no runnable submitted a new runnable) */
+    assert(atomic_load(&executor->pending) == 0);
 
     /* There are no tasks anymore */
-    assert(!executor->unfinished);
+    assert(!atomic_load(&executor->unfinished));
 
     free(executor);
 }
@@ -29,6 +29,7 @@
 #include <stdlib.h>
 
 #include <vlc_common.h>
+#include <vlc_atomic.h>
 #include <vlc_block.h>
 #include "libvlc.h"
 
@@ -141,3 +142,179 @@ block_t *vlc_fifo_Show( block_fifo_t *p_fifo )
 
     return b;
 }
+
+/**
+ * Internal state for lock-free single producer, single consumer queues
+ *
+ * Indexes are free-running: the ring slot is the index modulo the capacity.
+ * Each side caches the last seen index of the other side to avoid touching
+ * the other side cache line unless needed.
+ */
+#define VLC_SPSC_LINE 64
+
+struct vlc_spsc_fifo
+{
+    /* Producer side */
+    _Atomic size_t      tail;
+    size_t              head_cache;
+    char                pad_producer[VLC_SPSC_LINE - 2 * sizeof (size_t)];
+
+    /* Consumer side */
+    _Atomic size_t      head;
+    size_t              tail_cache;
+    char                pad_consumer[VLC_SPSC_LINE - 2 * sizeof (size_t)];
+
+    /* Shared */
+    _Atomic size_t      bytes;
+    atomic_uint         seq; /**< futex word, changed on wake-up */
+    atomic_bool         sleeping; /**< consumer waits for a wake-up */
+    atomic_bool         dead;
+    size_t              mask;
+    vlc_frame_t        *slots[];
+};
+
+vlc_spsc_fifo_t *vlc_spsc_fifo_New(size_t capacity)
+{
+    const size_t max = (SIZE_MAX - sizeof (vlc_spsc_fifo_t))
+                       / sizeof (vlc_frame_t *);
+    size_t size = 1;
+
+    while (size < capacity)
+    {
+        if (size > max / 2)
+            return NULL;
+        size <<= 1;
+    }
+
+    vlc_spsc_fifo_t *fifo = malloc(sizeof (*fifo) + size * sizeof (fifo->slots[0]));
+    if (unlikely(fifo == NULL))
+        return NULL;
+
+    atomic_init(&fifo->tail, 0);
+    fifo->head_cache = 0;
+    atomic_init(&fifo->head, 0);
+    fifo->tail_cache = 0;
+    atomic_init(&fifo->bytes, 0);
+    atomic_init(&fifo->seq, 0);
+    atomic_init(&fifo->sleeping, false);
+    atomic_init(&fifo->dead, false);
+    fifo->mask = size - 1;
+    return fifo;
+}
+
+void vlc_spsc_fifo_Delete(vlc_spsc_fifo_t *fifo)
+{
+    vlc_frame_t *frame;
+
+    while ((frame = vlc_spsc_fifo_TryGet(fifo)) != NULL)
+        vlc_frame_Release(frame);
+    free(fifo);
+}
+
+static void vlc_spsc_fifo_Wake(vlc_spsc_fifo_t *fifo)
+{
+    /* Pairs with the fence in vlc_spsc_fifo_Get(): either the consumer sees
+     * the new tail, or the producer sees the consumer going to sleep.
+     * Only the first frame after the consumer went to sleep wakes it up. */
+    atomic_thread_fence(memory_order_seq_cst);
+
+    if (atomic_load_explicit(&fifo->sleeping, memory_order_relaxed)
+     && atomic_exchange_explicit(&fifo->sleeping, false, memory_order_relaxed))
+    {
+        atomic_fetch_add_explicit(&fifo->seq, 1, memory_order_relaxed);
+        vlc_atomic_notify_one(&fifo->seq);
+    }
+}
+
+bool vlc_spsc_fifo_Put(vlc_spsc_fifo_t *fifo, vlc_frame_t *frame)
+{
+    size_t tail = atomic_load_explicit(&fifo->tail, memory_order_relaxed);
+
+    assert(frame->p_next == NULL);
+
+    if (tail - fifo->head_cache > fifo->mask)
+    {
+        fifo->head_cache = atomic_load_explicit(&fifo->head,
+                                                memory_order_acquire);
+        if (tail - fifo->head_cache > fifo->mask)
+            return false; /* full */
+    }
+
+    fifo->slots[tail & fifo->mask] = frame;
+    atomic_fetch_add_explicit(&fifo->bytes, frame->i_buffer,
+                              memory_order_relaxed);
+    atomic_store_explicit(&fifo->tail, tail + 1, memory_order_release);
+    vlc_spsc_fifo_Wake(fifo);
+    return true;
+}
+
+vlc_frame_t *vlc_spsc_fifo_TryGet(vlc_spsc_fifo_t *fifo)
+{
+    size_t head = atomic_load_explicit(&fifo->head, memory_order_relaxed);
+
+    if (head == fifo->tail_cache)
+    {
+        fifo->tail_cache = atomic_load_explicit(&fifo->tail,
+                                                memory_order_acquire);
+        if (head == fifo->tail_cache)
+            return NULL; /* empty */
+    }
+
+    vlc_frame_t *frame = fifo->slots[head & fifo->mask];
+
+    assert(atomic_load_explicit(&fifo->bytes, memory_order_relaxed)
+           >= frame->i_buffer);
+    atomic_fetch_sub_explicit(&fifo->bytes, frame->i_buffer,
+                              memory_order_relaxed);
+    atomic_store_explicit(&fifo->head, head + 1, memory_order_release);
+    return frame;
+}
+
+vlc_frame_t *vlc_spsc_fifo_Get(vlc_spsc_fifo_t *fifo)
+{
+    vlc_frame_t *frame;
+
+    while ((frame = vlc_spsc_fifo_TryGet(fifo)) == NULL)
+    {
+        unsigned seq = atomic_load_explicit(&fifo->seq, memory_order_relaxed);
+
+        atomic_store_explicit(&fifo->sleeping, true, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        frame = vlc_spsc_fifo_TryGet(fifo);
+        if (frame == NULL && !atomic_load(&fifo->dead))
+            vlc_atomic_wait(&fifo->seq, seq);
+        atomic_store_explicit(&fifo->sleeping, false, memory_order_relaxed);
+
+        if (frame != NULL)
+            break;
+        if (atomic_load(&fifo->dead))
+        {
+            /* Do not lose frames queued before the kill */
+            frame = vlc_spsc_fifo_TryGet(fifo);
+            break;
+        }
+    }
+
+    return frame;
+}
+
+void vlc_spsc_fifo_Kill(vlc_spsc_fifo_t *fifo)
+{
+    atomic_store(&fifo->dead, true);
+    atomic_fetch_add(&fifo->seq, 1);
+    vlc_atomic_notify_all(&fifo->seq);
+}
+
+size_t vlc_spsc_fifo_GetCount(const vlc_spsc_fifo_t *fifo)
+{
+    size_t head = atomic_load_explicit(&fifo->head, memory_order_acquire);
+    size_t tail = atomic_load_explicit(&fifo->tail, memory_order_acquire);
+
+    /* Snapshot from a third thread: the head may be newer than the tail */
+    return (tail - head <= fifo->mask + 1) ? tail - head : 0;
+}
+
+size_t vlc_spsc_fifo_GetBytes(const vlc_spsc_fifo_t *fifo)
+{
+    return atomic_load_explicit(&fifo->bytes, memory_order_relaxed);
+}
@@ -111,6 +111,385 @@ static const struct vlc_frame_callbacks vlc_frame_generic_cbs =
 /** Initial reserved header and footer size. */
 #define VLC_FRAME_PADDING      32
 
+#ifndef __SANITIZE_ADDRESS__
+/*
+ * Size-class frame cache
+ *
+ * Frames with a small enough buffer are allocated from power-of-two size
+ * classes and recycled instead of being returned to the heap. Each thread
+ * keeps a free list per class. Frames move between threads in batches
+ * through a shared depot, as frames are typically allocated by one thread
+ * (e.g. the demuxer) and released by another (e.g. the decoder). A thread
+ * hands its free frames over to the depot when it exits, and the depot drops
+ * the batches that no thread took back for a while.
+ *
+ * The cache is disabled with the address sanitizer, so that it keeps
+ * catching use-after-free errors.
+ */
+# define VLC_FRAME_CACHE 1
+
+/** Smallest and largest class buffer size, as powers of two */
+# define VLC_FRAME_CLASS_MIN_SHIFT 8
+# define VLC_FRAME_CLASS_MAX_SHIFT 16
+# define VLC_FRAME_CLASSES \
+    (VLC_FRAME_CLASS_MAX_SHIFT - VLC_FRAME_CLASS_MIN_SHIFT + 1)
+
+/** Maximum number of batches kept in the depot, per class */
+# define VLC_FRAME_DEPOT_BATCHES 4
+/** Time after which an unused depot batch is returned to the heap */
+# define VLC_FRAME_DEPOT_EXPIRY VLC_TICK_FROM_SEC(5)
+
+struct vlc_frame_slab
+{
+    vlc_frame_t frame;
+    unsigned cls; /**< size class index */
+    vlc_frame_t *next_batch; /**< next (older) batch in the depot */
+    vlc_tick_t spilled; /**< when the batch was put in the depot */
+};
+
+struct vlc_frame_cache
+{
+    struct
+    {
+        vlc_frame_t *head;
+        unsigned count;
+    } lists[VLC_FRAME_CLASSES];
+};
+
+static struct
+{
+    vlc_mutex_t lock;
+    vlc_frame_t *batches; /**< singly-linked batches of frames */
+    unsigned count;
+} vlc_frame_depot[VLC_FRAME_CLASSES];
+
+static vlc_threadvar_t vlc_frame_cache_key;
+static vlc_once_t vlc_frame_cache_once = VLC_STATIC_ONCE;
+static bool vlc_frame_cache_ready;
+
+static struct
+{
+    atomic_uint_least64_t allocated;
+    atomic_uint_least64_t freed;
+    atomic_uint_least64_t refills;
+    atomic_uint_least64_t spills;
+} vlc_frame_cache_stats;
+
+static size_t vlc_frame_class_size(unsigned cls)
+{
+    return (size_t)1 << (cls + VLC_FRAME_CLASS_MIN_SHIFT);
+}
+
+/** Number of frames moved at once between a thread and the depot */
+static unsigned vlc_frame_class_batch(unsigned cls)
+{
+    unsigned batch = (32 * 1024) >> (cls + VLC_FRAME_CLASS_MIN_SHIFT);
+
+    return VLC_CLIP(batch, 4, 64);
+}
+
+static void vlc_frame_chain_Free(vlc_frame_t *frame)
+{
+    while (frame != NULL)
+    {
+        vlc_frame_t *next = frame->p_next;
+
+        free(container_of(frame, struct vlc_frame_slab, frame));
+        atomic_fetch_add_explicit(&vlc_frame_cache_stats.freed, 1,
+                                  memory_order_relaxed);
+        frame = next;
+    }
+}
+
+static void vlc_frame_batches_Free(vlc_frame_t *batch)
+{
+    while (batch != NULL)
+    {
+        struct vlc_frame_slab *slab =
+            container_of(batch, struct vlc_frame_slab, frame);
+        vlc_frame_t *next = slab->next_batch;
+
+        vlc_frame_chain_Free(batch);
+        batch = next;
+    }
+}
+
+/**
+ * Detaches the expired batches of a depot.
+ *
+ * Batches are stacked from the most to the least recently spilled, so the
+ * expired ones are at the bottom. The depot lock must be held.
+ */
+static vlc_frame_t *vlc_frame_depot_Expire(unsigned cls, vlc_tick_t now)
+{
+    vlc_frame_t **pp = &vlc_frame_depot[cls].batches;
+    unsigned count = 0;
+
+    while (*pp != NULL)
+    {
+        struct vlc_frame_slab *slab =
+            container_of(*pp, struct vlc_frame_slab, frame);
+
+        if (now - slab->spilled > VLC_FRAME_DEPOT_EXPIRY)
+            break;
+        pp = &slab->next_batch;
+        count++;
+    }
+
+    vlc_frame_t *expired = *pp;
+
+    *pp = NULL;
+    vlc_frame_depot[cls].count = count;
+    return expired;
+}
+
+/**
+ * Puts a batch of free frames in the depot.
+ *
+ * @return the frames to return to the heap, or NULL
+ */
+static vlc_frame_t *vlc_frame_depot_Put(unsigned cls, vlc_frame_t *batch)
+{
+    struct vlc_frame_slab *slab =
+        container_of(batch, struct vlc_frame_slab, frame);
+    vlc_tick_t now = vlc_tick_now();
+
+    atomic_fetch_add_explicit(&vlc_frame_cache_stats.spills, 1,
+                              memory_order_relaxed);
+
+    vlc_mutex_lock(&vlc_frame_depot[cls].lock);
+    vlc_frame_t *expired = vlc_frame_depot_Expire(cls, now);
+
+    if (vlc_frame_depot[cls].count < VLC_FRAME_DEPOT_BATCHES)
+    {
+        slab->next_batch = vlc_frame_depot[cls].batches;
+        slab->spilled = now;
+        vlc_frame_depot[cls].batches = batch;
+        vlc_frame_depot[cls].count++;
+        batch = NULL;
+    }
+    vlc_mutex_unlock(&vlc_frame_depot[cls].lock);
+
+    vlc_frame_batches_Free(expired);
+    return batch;
+}
+
+/** Detaches one batch from the head of a thread free list */
+static vlc_frame_t *vlc_frame_cache_Split(struct vlc_frame_cache *cache,
+                                          unsigned cls, unsigned batch)
+{
+    vlc_frame_t *first = cache->lists[cls].head;
+    vlc_frame_t *last = first;
+
+    for (unsigned i = 1; i < batch; i++)
+        last = last->p_next;
+    cache->lists[cls].head = last->p_next;
+    cache->lists[cls].count -= batch;
+    last->p_next = NULL;
+    return first;
+}
+
+static void vlc_frame_cache_Destroy(void *data)
+{
+    struct vlc_frame_cache *cache = data;
+
+    for (unsigned i = 0; i < VLC_FRAME_CLASSES; i++)
+    {   /* Keep the free frames of the exiting thread for the other ones */
+        unsigned batch = vlc_frame_class_batch(i);
+
+        while (cache->lists[i].count >= batch)
+        {
+            vlc_frame_t *frames = vlc_frame_cache_Split(cache, i, batch);
+
+            frames = vlc_frame_depot_Put(i, frames);
+            if (frames != NULL)
+            {   /* The depot is full */
+                vlc_frame_chain_Free(frames);
+                break;
+            }
+        }
+        vlc_frame_chain_Free(cache->lists[i].head);
+    }
+    free(cache);
+}
+
+static void vlc_frame_cache_Init(void *data)
+{
+    (void) data;
+
+    for (unsigned i = 0; i < VLC_FRAME_CLASSES; i++)
+    {
+        vlc_mutex_init(&vlc_frame_depot[i].lock);
+        vlc_frame_depot[i].batches = NULL;
+        vlc_frame_depot[i].count = 0;
+    }
+
+    if (vlc_threadvar_create(&vlc_frame_cache_key, vlc_frame_cache_Destroy))
+        abort();
+    vlc_frame_cache_ready = true;
+}
+
+/*
+ * Thread-specific destructors do not run for the thread calling exit(),
+ * typically the main thread, and nothing owns the depot. Free both at exit
+ * so that leak checkers do not report the cached frames.
+ */
+__attribute__((destructor))
+static void vlc_frame_cache_Deinit(void)
+{
+    if (!vlc_frame_cache_ready)
+        return;
+
+    struct vlc_frame_cache *cache = vlc_threadvar_get(vlc_frame_cache_key);
+    if (cache != NULL)
+    {
+        vlc_threadvar_set(vlc_frame_cache_key, NULL);
+        vlc_frame_cache_Destroy(cache);
+    }
+
+    for (unsigned i = 0; i < VLC_FRAME_CLASSES; i++)
+    {
+        vlc_mutex_lock(&vlc_frame_depot[i].lock);
+        vlc_frame_t *batch = vlc_frame_depot[i].batches;
+        vlc_frame_depot[i].batches = NULL;
+        vlc_frame_depot[i].count = 0;
+        vlc_mutex_unlock(&vlc_frame_depot[i].lock);
+
+        vlc_frame_batches_Free(batch);
+    }
+}
+
+static struct vlc_frame_cache *vlc_frame_cache_Get(void)
+{
+    vlc_once(&vlc_frame_cache_once, vlc_frame_cache_Init, NULL);
+
+    struct vlc_frame_cache *cache = vlc_threadvar_get(vlc_frame_cache_key);
+    if (unlikely(cache == NULL))
+    {
+        cache = calloc(1, sizeof (*cache));
+        if (cache != NULL && vlc_threadvar_set(vlc_frame_cache_key, cache))
+        {
+            free(cache);
+            cache = NULL;
+        }
+    }
+    return cache;
+}
+
+static void vlc_frame_slab_Release(vlc_frame_t *frame)
+{
+    const struct vlc_frame_slab *slab =
+        container_of(frame, struct vlc_frame_slab, frame);
+    struct vlc_frame_cache *cache = vlc_frame_cache_Get();
+
+    if (unlikely(cache == NULL))
+    {
+        frame->p_next = NULL;
+        vlc_frame_chain_Free(frame);
+        return;
+    }
+
+    unsigned cls = slab->cls;
+    unsigned batch = vlc_frame_class_batch(cls);
+
+    frame->p_next = cache->lists[cls].head;
+    cache->lists[cls].head = frame;
+
+    if (++cache->lists[cls].count < 2 * batch)
+        return;
+
+    /* Too many free frames on this thread: hand one batch over */
+    frame = vlc_frame_cache_Split(cache, cls, batch);
+    vlc_frame_chain_Free(vlc_frame_depot_Put(cls, frame));
+}
+
+static const struct vlc_frame_callbacks vlc_frame_slab_cbs =
+{
+    vlc_frame_slab_Release,
+};
+
+static vlc_frame_t *vlc_frame_slab_Alloc(size_t size)
+{
+    const size_t needed = VLC_FRAME_ALIGN + (2 * VLC_FRAME_PADDING) + size;
+    unsigned cls = 0;
+
+    while (vlc_frame_class_size(cls) < needed)
+        if (++cls >= VLC_FRAME_CLASSES)
+            return NULL;
+
+    struct vlc_frame_cache *cache = vlc_frame_cache_Get();
+    if (unlikely(cache == NULL))
+        return NULL;
+
+    vlc_frame_t *frame = cache->lists[cls].head;
+
+    if (frame == NULL)
+    {   /* Refill from the depot */
+        vlc_mutex_lock(&vlc_frame_depot[cls].lock);
+        vlc_frame_t *expired = vlc_frame_depot_Expire(cls, vlc_tick_now());
+        frame = vlc_frame_depot[cls].batches;
+        if (frame != NULL)
+        {
+            struct vlc_frame_slab *slab =
+                container_of(frame, struct vlc_frame_slab, frame);
+
+            vlc_frame_depot[cls].batches = slab->next_batch;
+            vlc_frame_depot[cls].count--;
+        }
+        vlc_mutex_unlock(&vlc_frame_depot[cls].lock);
+        vlc_frame_batches_Free(expired);
+
+        if (frame != NULL)
+        {
+            cache->lists[cls].count = vlc_frame_class_batch(cls);
+            atomic_fetch_add_explicit(&vlc_frame_cache_stats.refills, 1,
+                                      memory_order_relaxed);
+        }
+    }
+
+    struct vlc_frame_slab *slab;
+
+    if (frame != NULL)
+    {
+        cache->lists[cls].head = frame->p_next;
+        cache->lists[cls].count--;
+        slab = container_of(frame, struct vlc_frame_slab, frame);
+    }
+    else
+    {
+        slab = malloc(sizeof (*slab) + vlc_frame_class_size(cls));
+        if (unlikely(slab == NULL))
+            return NULL;
+        slab->cls = cls;
+        atomic_fetch_add_explicit(&vlc_frame_cache_stats.allocated, 1,
+                                  memory_order_relaxed);
+    }
+
+    frame = vlc_frame_Init(&slab->frame, &vlc_frame_slab_cbs, slab + 1,
+                           vlc_frame_class_size(cls));
+    frame->p_buffer += VLC_FRAME_PADDING + VLC_FRAME_ALIGN - 1;
+    frame->p_buffer = (void *)(((uintptr_t)frame->p_buffer) & ~(VLC_FRAME_ALIGN - 1));
+    frame->i_buffer = size;
+    return frame;
+}
+#endif
+
+void vlc_frame_GetCacheStats(struct vlc_frame_cache_stats *stats)
+{
+#ifdef VLC_FRAME_CACHE
+    stats->allocated = atomic_load_explicit(&vlc_frame_cache_stats.allocated,
+                                            memory_order_relaxed);
+    stats->freed = atomic_load_explicit(&vlc_frame_cache_stats.freed,
+                                        memory_order_relaxed);
+    stats->refills = atomic_load_explicit(&vlc_frame_cache_stats.refills,
+                                          memory_order_relaxed);
+    stats->spills = atomic_load_explicit(&vlc_frame_cache_stats.spills,
+                                         memory_order_relaxed);
+#else
+    *stats = (struct vlc_frame_cache_stats) { 0 };
+#endif
+}
+
 vlc_frame_t *vlc_frame_Alloc (size_t size)
 {
     if (unlikely(size >> 28))
@@ -119,6 +498,12 @@ vlc_frame_t *vlc_frame_Alloc (size_t size)
         return NULL;
     }
 
+#ifdef VLC_FRAME_CACHE
+    vlc_frame_t *cached = vlc_frame_slab_Alloc(size);
+    if (cached != NULL)
+        return cached;
+#endif
+
     /* 2 * VLC_FRAME_PADDING: pre + post padding */
     const size_t alloc = sizeof (vlc_frame_t) + VLC_FRAME_ALIGN + (2 * VLC_FRAME_PADDING)
                        + size;
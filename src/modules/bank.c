@@ -304,7 +304,7 @@ typedef struct module_bank
 
     size_t        size;
     vlc_plugin_t **plugins;
-    vlc_plugin_t *cache;
+    vlc_plugin_cache_t *cache;
 } module_bank_t;
 
 /**
@@ -317,19 +317,8 @@ static int AllocatePluginFile (module_bank_t *bank, const char *abspath,
 
     /* Check our plugins cache first then load plugin if needed */
     if (bank->mode & CACHE_READ_FILE)
-    {
-        plugin = vlc_cache_lookup(&bank->cache, relpath);
-
-        if (plugin != NULL
-         && (plugin->mtime != (int64_t)st->st_mtime
-          || plugin->size != (uint64_t)st->st_size))
-        {
-            msg_Err(bank->obj, "stale plugins cache: modified %s",
-                    plugin->abspath);
-            vlc_plugin_destroy(plugin);
-            plugin = NULL;
-        }
-    }
+        plugin = vlc_cache_lookup(bank->cache, relpath, st->st_mtime,
+                                  st->st_size);
 
     if (plugin == NULL)
     {
@@ -536,16 +525,14 @@ static void AllocatePluginPath(libvlc_int_t *obj, const char *path,
     }
 
     /* Deal with unmatched cache entries from cache file */
-    while (bank.cache != NULL)
+    if (!(mode & CACHE_SCAN_DIR))
     {
-        vlc_plugin_t *plugin = bank.cache;
+        vlc_plugin_t *plugin;
 
-        bank.cache = plugin->next;
-        if (mode & CACHE_SCAN_DIR)
-            vlc_plugin_destroy(plugin);
-        else
+        while ((plugin = vlc_cache_next(bank.cache)) != NULL)
             vlc_plugin_store(plugin);
     }
+    vlc_cache_release(bank.cache);
 
     if (mode & CACHE_WRITE_FILE)
         CacheSave(obj, path, bank.plugins, bank.size);
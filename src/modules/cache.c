@@ -57,13 +57,39 @@
 #ifdef HAVE_DYNAMIC_PLUGINS
 /* Sub-version number
  * (only used to avoid breakage in dev version when cache structure changes) */
-#define CACHE_SUBVERSION_NUM 36
+#define CACHE_SUBVERSION_NUM 37
 
 /* Cache filename */
 #define CACHE_NAME "plugins.dat"
 /* Magic for the cache filename */
 #define CACHE_STRING "cache "PACKAGE_NAME" "PACKAGE_VERSION
 
+/*
+ * The cache file is mapped in memory and strings are referenced in place.
+ * Each plug-in record starts with its path, modification time, size and the
+ * length of its description, so that the cache can be indexed without
+ * parsing the descriptions. A description is only deserialized when the
+ * plug-in file is matched, and stale or unused entries are never parsed.
+ */
+struct vlc_cache_entry
+{
+    const char *path; /**< Relative path (within the cache mapping) */
+    int64_t mtime; /**< Last modification time */
+    uint64_t size; /**< File size */
+    const uint8_t *data; /**< Plug-in description (within the mapping) */
+    uint32_t length; /**< Plug-in description length */
+    bool used; /**< Whether the entry was already looked up */
+};
+
+struct vlc_plugin_cache
+{
+    libvlc_int_t *obj;
+    char *dir;
+    size_t count;
+    size_t next; /**< Next entry to check in vlc_cache_next() */
+    struct vlc_cache_entry entries[];
+};
+
 
 static int vlc_cache_load_immediate(void *out, block_t *in, size_t size)
 {
@@ -323,12 +349,18 @@ error:
     return -1;
 }
 
-static vlc_plugin_t *vlc_cache_load_plugin(block_t *file)
+static vlc_plugin_t *vlc_cache_load_plugin(const char *dir,
+                                           const struct vlc_cache_entry *entry)
 {
     vlc_plugin_t *plugin = vlc_plugin_create();
     if (unlikely(plugin == NULL))
         return NULL;
 
+    /* View of the description within the cache mapping, never released */
+    block_t view;
+    block_t *file = block_Init(&view, NULL, (void *)entry->data,
+                               entry->length);
+
     uint32_t modules;
     LOAD_IMMEDIATE(modules);
 
@@ -340,19 +372,23 @@ static vlc_plugin_t *vlc_cache_load_plugin(block_t *file)
         goto error;
 
     LOAD_STRING(plugin->textdomain);
-
-    const char *path;
-    LOAD_STRING(path);
-    if (path == NULL)
+    LOAD_FLAG(plugin->unloadable);
+    if (file->i_buffer != 0)
         goto error;
 
-    plugin->path = strdup(path);
+    plugin->path = strdup(entry->path);
     if (unlikely(plugin->path == NULL))
         goto error;
 
-    LOAD_FLAG(plugin->unloadable);
-    LOAD_IMMEDIATE(plugin->mtime);
-    LOAD_IMMEDIATE(plugin->size);
+    plugin->mtime = entry->mtime;
+    plugin->size = entry->size;
+
+    if (unlikely(asprintf(&plugin->abspath, "%s" DIR_SEP "%s", dir,
+                          plugin->path) == -1))
+    {
+        plugin->abspath = NULL;
+        goto error;
+    }
 
     if (plugin->textdomain != NULL)
         vlc_bindtextdomain(plugin->textdomain);
@@ -364,6 +400,41 @@ error:
     return NULL;
 }
 
+static int vlc_cache_load_entry(struct vlc_cache_entry *entry, block_t *file)
+{
+    LOAD_STRING(entry->path);
+    if (entry->path == NULL)
+        goto error;
+
+    LOAD_IMMEDIATE(entry->mtime);
+    LOAD_IMMEDIATE(entry->size);
+    LOAD_IMMEDIATE(entry->length);
+    if (file->i_buffer < entry->length)
+        goto error;
+
+    entry->data = file->p_buffer;
+    entry->used = false;
+    file->p_buffer += entry->length;
+    file->i_buffer -= entry->length;
+    return 0;
+error:
+    return -1;
+}
+
+static int vlc_cache_entry_cmp(const void *a, const void *b)
+{
+    const struct vlc_cache_entry *ea = a, *eb = b;
+
+    return strcmp(ea->path, eb->path);
+}
+
+static int vlc_cache_entry_find(const void *key, const void *elem)
+{
+    const struct vlc_cache_entry *entry = elem;
+
+    return strcmp(key, entry->path);
+}
+
 /**
  * Loads a plugins cache file.
  *
@@ -372,8 +443,8 @@ error:
  * actually load the dynamically loadable module.
  * This allows us to only fully load plugins when they are actually used.
  */
-vlc_plugin_t *vlc_cache_load(libvlc_int_t *p_this, const char *dir,
-                             block_t **backingp)
+vlc_plugin_cache_t *vlc_cache_load(libvlc_int_t *p_this, const char *dir,
+                                   block_t **backingp)
 {
     char *psz_filename;
 
@@ -443,26 +514,48 @@ vlc_plugin_t *vlc_cache_load(libvlc_int_t *p_this, const char *dir,
         return NULL;
     }
 
-    vlc_plugin_t *cache = NULL;
+    uint32_t count;
 
-    while (file->i_buffer > 0)
+    if (vlc_cache_load_immediate(&count, file, sizeof (count))
+     || count > file->i_buffer)
+        goto error;
+
+    vlc_plugin_cache_t *cache = malloc(sizeof (*cache)
+                                       + count * sizeof (cache->entries[0]));
+    if (unlikely(cache == NULL))
     {
-        vlc_plugin_t *plugin = vlc_cache_load_plugin(file);
-        if (plugin == NULL)
-            goto error;
+        block_Release(file);
+        return NULL;
+    }
 
-        if (unlikely(asprintf(&plugin->abspath, "%s" DIR_SEP "%s", dir,
-                              plugin->path) == -1))
+    cache->obj = p_this;
+    cache->dir = strdup(dir);
+    cache->count = count;
+    cache->next = 0;
+
+    if (unlikely(cache->dir == NULL))
+    {
+        free(cache);
+        block_Release(file);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < count; i++)
+        if (vlc_cache_load_entry(&cache->entries[i], file))
         {
-            plugin->abspath = NULL;
-            vlc_plugin_destroy(plugin);
+            vlc_cache_release(cache);
             goto error;
         }
 
-        plugin->next = cache;
-        cache = plugin;
+    if (file->i_buffer > 0)
+    {
+        vlc_cache_release(cache);
+        goto error;
     }
 
+    qsort(cache->entries, count, sizeof (cache->entries[0]),
+          vlc_cache_entry_cmp);
+
     file->p_next = *backingp;
     *backingp = file;
     return cache;
@@ -470,11 +563,19 @@ vlc_plugin_t *vlc_cache_load(libvlc_int_t *p_this, const char *dir,
 error:
     msg_Warn( p_this, "plugins cache not loaded (corrupted)" );
 
-    /* TODO: cleanup */
     block_Release(file);
     return NULL;
 }
 
+void vlc_cache_release(vlc_plugin_cache_t *cache)
+{
+    if (cache == NULL)
+        return;
+
+    free(cache->dir);
+    free(cache);
+}
+
 #define SAVE_IMMEDIATE( a ) \
     if (fwrite (&(a), sizeof(a), 1, file) != 1) \
         goto error
@@ -619,11 +720,25 @@ static int CacheSaveBank(FILE *file, vlc_plugin_t *const *cache, size_t n)
     if (fwrite (&i_file_size, sizeof (i_file_size), 1, file) != 1)
         goto error;
 
+    i_file_size = n;
+    if (fwrite (&i_file_size, sizeof (i_file_size), 1, file) != 1)
+        goto error;
+
     for (size_t i = 0; i < n; i++)
     {
         const vlc_plugin_t *plugin = cache[i];
         uint32_t count = plugin->modules_count;
 
+        /* Index part */
+        SAVE_STRING(plugin->path);
+        SAVE_IMMEDIATE(plugin->mtime);
+        SAVE_IMMEDIATE(plugin->size);
+
+        /* Description length, written back once known */
+        long start = ftell(file);
+        uint32_t length = 0;
+
+        SAVE_IMMEDIATE(length);
         SAVE_IMMEDIATE(count);
 
         for (module_t *module = plugin->module;
@@ -638,10 +753,18 @@ static int CacheSaveBank(FILE *file, vlc_plugin_t *const *cache, size_t n)
 
         /* Save common info */
         SAVE_STRING(plugin->textdomain);
-        SAVE_STRING(plugin->path);
         SAVE_FLAG(plugin->unloadable);
-        SAVE_IMMEDIATE(plugin->mtime);
-        SAVE_IMMEDIATE(plugin->size);
+
+        long end = ftell(file);
+        if (start < 0 || end < 0)
+            goto error;
+
+        length = end - start - sizeof (length);
+        if (fseek(file, start, SEEK_SET))
+            goto error;
+        SAVE_IMMEDIATE(length);
+        if (fseek(file, end, SEEK_SET))
+            goto error;
     }
 
     if (fflush (file)) /* flush libc buffers */
@@ -703,22 +826,62 @@ out:
 }
 
 /**
- * Looks up a plugin file in a table of cached plugins.
+ * Looks up a plugin file in a plugins cache.
+ *
+ * The plug-in description is deserialized from the cache, if the cache entry
+ * matches the plug-in file modification time and size.
  */
-vlc_plugin_t *vlc_cache_lookup(vlc_plugin_t **cache, const char *path)
+vlc_plugin_t *vlc_cache_lookup(vlc_plugin_cache_t *cache, const char *path,
+                               int64_t mtime, uint64_t size)
 {
-    vlc_plugin_t **pp = cache, *plugin;
+    if (cache == NULL)
+        return NULL;
+
+    struct vlc_cache_entry *entry =
+        bsearch(path, cache->entries, cache->count,
+                sizeof (cache->entries[0]), vlc_cache_entry_find);
+    if (entry == NULL || entry->used)
+        return NULL;
+
+    entry->used = true;
 
-    while ((plugin = *pp) != NULL)
+    if (entry->mtime != mtime || entry->size != size)
     {
-        if (plugin->path != NULL && !strcmp(plugin->path, path))
-        {
-            *pp = plugin->next;
-            plugin->next = NULL;
+        msg_Err(cache->obj, "stale plugins cache: modified %s" DIR_SEP "%s",
+                cache->dir, entry->path);
+        return NULL;
+    }
+
+    vlc_plugin_t *plugin = vlc_cache_load_plugin(cache->dir, entry);
+    if (plugin == NULL)
+        msg_Warn(cache->obj, "plugins cache entry %s corrupted", entry->path);
+    return plugin;
+}
+
+/**
+ * Takes the next plugin from a plugins cache that was not looked up yet.
+ *
+ * This is used when the plug-ins directory is not scanned, to trust the
+ * cache as is.
+ */
+vlc_plugin_t *vlc_cache_next(vlc_plugin_cache_t *cache)
+{
+    if (cache == NULL)
+        return NULL;
+
+    while (cache->next < cache->count)
+    {
+        struct vlc_cache_entry *entry = &cache->entries[cache->next++];
+
+        if (entry->used)
+            continue;
+        entry->used = true;
+
+        vlc_plugin_t *plugin = vlc_cache_load_plugin(cache->dir, entry);
+        if (plugin != NULL)
             return plugin;
-        }
 
-        pp = &plugin->next;
+        msg_Warn(cache->obj, "plugins cache entry %s corrupted", entry->path);
     }
 
     return NULL;
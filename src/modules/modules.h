@@ -175,8 +175,13 @@ void *vlc_dlsym(void *handle, const char *) VLC_USED;
 char *vlc_dlerror(void) VLC_USED;
 
 /* Plugins cache */
-vlc_plugin_t *vlc_cache_load(libvlc_int_t *, const char *, block_t **);
-vlc_plugin_t *vlc_cache_lookup(vlc_plugin_t **, const char *relpath);
+typedef struct vlc_plugin_cache vlc_plugin_cache_t;
+
+vlc_plugin_cache_t *vlc_cache_load(libvlc_int_t *, const char *, block_t **);
+vlc_plugin_t *vlc_cache_lookup(vlc_plugin_cache_t *, const char *relpath,
+                               int64_t mtime, uint64_t size);
+vlc_plugin_t *vlc_cache_next(vlc_plugin_cache_t *);
+void vlc_cache_release(vlc_plugin_cache_t *);
 
 void CacheSave(libvlc_int_t *, const char *, vlc_plugin_t *const *, size_t);
 
@@ -54,6 +54,9 @@
 #ifdef HAVE_POLL_H
 # include <poll.h>
 #endif
+#ifdef HAVE_SYS_EPOLL_H
+# include <sys/epoll.h>
+#endif
 
 #if defined(_WIN32)
 #   include <winsock2.h>
@@ -69,7 +72,6 @@
 #endif
 
 static void httpd_ClientDestroy(httpd_client_t *cl);
-static void httpd_AppendData(httpd_stream_t *stream, uint8_t *p_data, int i_data);
 
 /* each host run in his own thread */
 struct httpd_host_t
@@ -88,6 +90,15 @@ struct httpd_host_t
     vlc_thread_t thread;
     vlc_mutex_t lock;
 
+    /* event loop */
+    int          epfd;      /* -1 if using poll() */
+    int          wake[2];   /* wakes the loop up when stream data arrives */
+    atomic_bool  wake_pending;
+    struct vlc_list ready;    /* clients to run without waiting for I/O */
+    struct vlc_list deferred; /* clients waiting for their URL handler */
+    vlc_tick_t   deferred_date;
+    vlc_tick_t   next_sweep;
+
     /* all registered url (becarefull that 2 httpd_url_t could point at the same url)
      * This will slow down the url research but make my live easier
      * All url will have their cb trigger, but only the first one can answer
@@ -130,6 +141,7 @@ enum
     HTTPD_CLIENT_SEND_DONE,
 
     HTTPD_CLIENT_WAITING,
+    HTTPD_CLIENT_STREAMING,
 
     HTTPD_CLIENT_DEAD,
 
@@ -144,6 +156,13 @@ struct httpd_client_t
 
     struct vlc_list node;
 
+    /* event loop */
+    struct vlc_list queue_node;
+    uint8_t i_queue;
+    int     i_poll_fd;
+    short   i_poll_events;
+    bool    b_blocked;
+
     bool    b_stream_mode;
     uint8_t i_state;
 
@@ -161,11 +180,59 @@ struct httpd_client_t
      */
     int64_t i_keyframe_wait_to_pass;
 
+    /* Block of the shared stream chain holding i_body_offset, and its
+     * position. NULL until the client is given its first block. */
+    block_t *p_stream_block;
+    int64_t  i_stream_block_pos;
+
     /* */
     httpd_message_t query;  /* client -> httpd */
     httpd_message_t answer; /* httpd -> client */
 };
 
+enum
+{
+    HTTPD_QUEUE_NONE,
+    HTTPD_QUEUE_READY,
+    HTTPD_QUEUE_DEFERRED,
+};
+
+static void httpd_HostWake(httpd_host_t *host)
+{
+    if (host->wake[1] != -1
+     && !atomic_exchange_explicit(&host->wake_pending, true,
+                                  memory_order_relaxed))
+        vlc_send(host->wake[1], "", 1, 0);
+}
+
+static void httpd_ClientQueue(httpd_host_t *host, httpd_client_t *cl,
+                              uint8_t queue)
+{
+    if (host->epfd == -1 || cl->i_queue == queue)
+        return;
+
+    if (cl->i_queue != HTTPD_QUEUE_NONE)
+        vlc_list_remove(&cl->queue_node);
+    cl->i_queue = queue;
+
+    if (queue == HTTPD_QUEUE_READY)
+        vlc_list_append(&cl->queue_node, &host->ready);
+    else if (queue == HTTPD_QUEUE_DEFERRED)
+        vlc_list_append(&cl->queue_node, &host->deferred);
+}
+
+static void httpd_HostClientDestroy(httpd_host_t *host, httpd_client_t *cl)
+{
+    if (cl->i_queue != HTTPD_QUEUE_NONE)
+        vlc_list_remove(&cl->queue_node);
+#ifdef HAVE_SYS_EPOLL_H
+    if (cl->i_poll_fd != -1)
+        epoll_ctl(host->epfd, EPOLL_CTL_DEL, cl->i_poll_fd, NULL);
+#endif
+    host->client_count--;
+    httpd_ClientDestroy(cl);
+}
+
 
 /*****************************************************************************
  * Various functions
@@ -620,22 +687,145 @@ struct httpd_stream_t
     /* Some muxes, in particular the avformat mux, can mark given blocks
      * as keyframes, to ensure that the stream starts with one.
      * (This is particularly important for WebM streaming to certain
-     * browsers.) Store if we've ever seen any such keyframe blocks,
-     * and if so, the byte position of the start of the last one. */
+     * browsers.) Store if we've ever seen any such keyframe blocks. */
     bool        b_has_keyframes;
-    int64_t     i_last_keyframe_seen_pos;
 
-    /* circular buffer */
-    int         i_buffer_size;      /* buffer size, can't be reallocated smaller */
-    uint8_t     *p_buffer;          /* buffer */
+    /* Last block new clients can start with: a keyframe, or without
+     * keyframes, the first block of repeated headers (MPEG-TS PAT/PMT).
+     * p_sync is NULL once that block is dropped from the chain. */
+    block_t     *p_sync;
+    int64_t     i_sync_pos;
+
+    /* Shared block chain: clients all send from the same blocks, each
+     * from its own position, so no data is copied per client. */
+    block_t     *p_first;           /* oldest block */
+    block_t     *p_last;            /* newest block */
+    int64_t     i_first_pos;        /* absolute position of p_first */
+    int64_t     i_last_pos;         /* absolute position of p_last */
     int64_t     i_buffer_pos;       /* absolute position from beginning */
-    int64_t     i_buffer_last_pos;  /* a new connection will start with that */
+    size_t      i_buffer;           /* bytes held by the chain */
+    size_t      i_buffer_size;      /* maximum bytes held by the chain */
+
+    /* what to do with clients whose data was dropped from the chain */
+    int         i_overrun;
 
     /* custom headers */
     size_t        i_http_headers;
     httpd_header * p_http_headers;
 };
 
+enum
+{
+    HTTPD_STREAM_OVERRUN_SKIP,
+    HTTPD_STREAM_OVERRUN_DROP,
+};
+
+/* Positions a client at the start of a block of the chain */
+static void httpd_StreamSetBlock(httpd_client_t *cl, block_t *block,
+                                 int64_t pos)
+{
+    cl->p_stream_block = block;
+    cl->i_stream_block_pos = pos;
+    cl->answer.i_body_offset = pos;
+}
+
+/* Chooses where a new (or skipped) client starts in the stream */
+static void httpd_StreamJoin(httpd_stream_t *stream, httpd_client_t *cl)
+{
+    cl->i_keyframe_wait_to_pass = -1;
+
+    if (stream->p_sync != NULL)
+        httpd_StreamSetBlock(cl, stream->p_sync, stream->i_sync_pos);
+    else if (stream->b_has_keyframes) {
+        /* the last keyframe is gone, wait for the next one */
+        cl->i_keyframe_wait_to_pass = stream->i_sync_pos;
+        httpd_StreamSetBlock(cl, NULL, stream->i_buffer_pos);
+    } else if (stream->p_last != NULL)
+        httpd_StreamSetBlock(cl, stream->p_last, stream->i_last_pos);
+    else
+        httpd_StreamSetBlock(cl, NULL, stream->i_buffer_pos);
+}
+
+/**
+ * Finds the block holding the next byte to send to a client.
+ *
+ * \return the block, or NULL if there is nothing to send yet, or if the
+ * client was dropped for being too slow (HTTPD_CLIENT_DEAD)
+ */
+static block_t *httpd_StreamSeek(httpd_stream_t *stream, httpd_client_t *cl)
+{
+    httpd_message_t *answer = &cl->answer;
+
+    if (cl->i_keyframe_wait_to_pass >= 0) {
+        if (stream->p_sync == NULL
+         || stream->i_sync_pos <= cl->i_keyframe_wait_to_pass)
+            /* still waiting for the next keyframe */
+            return NULL;
+
+        /* seek to the new keyframe */
+        httpd_StreamSetBlock(cl, stream->p_sync, stream->i_sync_pos);
+        cl->i_keyframe_wait_to_pass = -1;
+    }
+
+    if (cl->p_stream_block == NULL) {
+        /* the client connected before any data was sent */
+        if (stream->p_first == NULL)
+            return NULL;
+        httpd_StreamSetBlock(cl, stream->p_first, stream->i_first_pos);
+    } else if (cl->i_stream_block_pos < stream->i_first_pos) {
+        /* this client isn't fast enough, its block was dropped */
+        if (stream->i_overrun == HTTPD_STREAM_OVERRUN_DROP) {
+            cl->i_state = HTTPD_CLIENT_DEAD;
+            return NULL;
+        }
+        httpd_StreamJoin(stream, cl);
+        return httpd_StreamSeek(stream, cl);
+    }
+
+    /* Skip the blocks already sent, but stay on the last one, so that the
+     * client finds the next block when it gets appended. */
+    block_t *block = cl->p_stream_block;
+    while (answer->i_body_offset >= cl->i_stream_block_pos
+                                    + (int64_t)block->i_buffer
+        && block->p_next != NULL) {
+        cl->i_stream_block_pos += block->i_buffer;
+        block = block->p_next;
+    }
+    cl->p_stream_block = block;
+
+    if (answer->i_body_offset >= cl->i_stream_block_pos
+                                 + (int64_t)block->i_buffer)
+        return NULL;    /* wait, no data available */
+    return block;
+}
+
+/**
+ * Gathers the data a client can be sent, from its body offset.
+ *
+ * \return the number of I/O vectors filled
+ */
+static unsigned httpd_StreamGather(httpd_stream_t *stream, httpd_client_t *cl,
+                                   struct iovec *iov, unsigned max,
+                                   size_t *total)
+{
+    block_t *block = httpd_StreamSeek(stream, cl);
+    size_t offset = 0;
+    unsigned n = 0;
+
+    *total = 0;
+    if (block != NULL)
+        offset = cl->answer.i_body_offset - cl->i_stream_block_pos;
+
+    for (; block != NULL && n < max; block = block->p_next) {
+        iov[n].iov_base = block->p_buffer + offset;
+        iov[n].iov_len = block->i_buffer - offset;
+        *total += iov[n].iov_len;
+        offset = 0;
+        n++;
+    }
+    return n;
+}
+
 static int httpd_StreamCallBack(httpd_callback_sys_t *p_sys,
                                  httpd_client_t *cl, httpd_message_t *answer,
                                  const httpd_message_t *query)
@@ -646,34 +836,19 @@ static int httpd_StreamCallBack(httpd_callback_sys_t *p_sys,
         return VLC_SUCCESS;
 
     if (answer->i_body_offset > 0) {
-        int     i_pos;
+        struct iovec iov[16];
+        size_t i_write;
 
-        if (answer->i_body_offset >= stream->i_buffer_pos)
+        vlc_mutex_lock(&stream->lock);
+        unsigned n = httpd_StreamGather(stream, cl, iov, ARRAY_SIZE(iov),
+                                        &i_write);
+        if (n == 0) {
+            vlc_mutex_unlock(&stream->lock);
             return VLC_EGENERIC;    /* wait, no data available */
-
-        if (cl->i_keyframe_wait_to_pass >= 0) {
-            if (stream->i_last_keyframe_seen_pos <= cl->i_keyframe_wait_to_pass)
-                /* still waiting for the next keyframe */
-                return VLC_EGENERIC;
-
-            /* seek to the new keyframe */
-            answer->i_body_offset = stream->i_last_keyframe_seen_pos;
-            cl->i_keyframe_wait_to_pass = -1;
         }
 
-        if (answer->i_body_offset + stream->i_buffer_size < stream->i_buffer_pos)
-            answer->i_body_offset = stream->i_buffer_last_pos; /* this client isn't fast enough */
-
-        i_pos   = answer->i_body_offset % stream->i_buffer_size;
-        int64_t i_write = stream->i_buffer_pos - answer->i_body_offset;
-
         if (i_write > HTTPD_CL_BUFSIZE)
             i_write = HTTPD_CL_BUFSIZE;
-        else if (i_write <= 0)
-            return VLC_EGENERIC;    /* wait, no data available */
-
-        /* Don't go past the end of the circular buffer */
-        i_write = __MIN(i_write, stream->i_buffer_size - i_pos);
 
         /* using HTTPD_MSG_ANSWER -> data available */
         answer->i_proto  = HTTPD_PROTO_HTTP;
@@ -682,9 +857,14 @@ static int httpd_StreamCallBack(httpd_callback_sys_t *p_sys,
 
         answer->i_body = i_write;
         answer->p_body = xmalloc(i_write);
-        memcpy(answer->p_body, &stream->p_buffer[i_pos], i_write);
+        for (unsigned i = 0, done = 0; done < i_write; i++) {
+            size_t i_copy = __MIN(iov[i].iov_len, i_write - done);
+            memcpy(answer->p_body + done, iov[i].iov_base, i_copy);
+            done += i_copy;
+        }
 
         answer->i_body_offset += i_write;
+        vlc_mutex_unlock(&stream->lock);
 
         return VLC_SUCCESS;
     } else {
@@ -719,11 +899,7 @@ static int httpd_StreamCallBack(httpd_callback_sys_t *p_sys,
                 answer->p_body = xmalloc(stream->i_header);
                 memcpy(answer->p_body, stream->p_header, stream->i_header);
             }
-            answer->i_body_offset = stream->i_buffer_last_pos;
-            if (stream->b_has_keyframes)
-                cl->i_keyframe_wait_to_pass = stream->i_last_keyframe_seen_pos;
-            else
-                cl->i_keyframe_wait_to_pass = -1;
+            httpd_StreamJoin(stream, cl);
             vlc_mutex_unlock(&stream->lock);
         } else {
             httpd_MsgAdd(answer, "Content-Length", "0");
@@ -761,6 +937,59 @@ static int httpd_StreamCallBack(httpd_callback_sys_t *p_sys,
     }
 }
 
+static httpd_stream_t *httpd_ClientStream(const httpd_client_t *cl)
+{
+    if (cl->url == NULL
+     || cl->url->catch[cl->query.i_type].cb != httpd_StreamCallBack)
+        return NULL;
+    return (httpd_stream_t *)cl->url->catch[cl->query.i_type].p_sys;
+}
+
+/**
+ * Sends stream data to a client straight from the shared block chain,
+ * without copying it to a per-client buffer.
+ *
+ * \return 0 if the client made progress, -1 if it must wait, either for
+ * more stream data or for room in its socket (b_blocked)
+ */
+static int httpd_StreamSendTo(httpd_stream_t *stream, httpd_client_t *cl)
+{
+    struct iovec iov[16];
+    size_t i_write;
+    int val = -1;
+
+    vlc_mutex_lock(&stream->lock);
+    cl->b_blocked = false;
+
+    unsigned n = httpd_StreamGather(stream, cl, iov, ARRAY_SIZE(iov),
+                                    &i_write);
+    if (n > 0) {
+        vlc_tls_t *sock = cl->sock;
+        ssize_t len = sock->ops->writev(sock, iov, n);
+
+        if (len >= 0) {
+            cl->answer.i_body_offset += len;
+            /* do not try again before the socket is writable */
+            cl->b_blocked = (size_t)len < i_write;
+            val = 0;
+        }
+#if defined(_WIN32)
+        else if (WSAGetLastError() == WSAEWOULDBLOCK)
+#else
+        else if (errno == EAGAIN)
+#endif
+            cl->b_blocked = true;
+        else {
+            /* Connection failed, or hung up (EPIPE) */
+            cl->i_state = HTTPD_CLIENT_DEAD;
+            val = 0;
+        }
+    } else if (cl->i_state == HTTPD_CLIENT_DEAD)
+        val = 0; /* dropped for being too slow */
+    vlc_mutex_unlock(&stream->lock);
+    return val;
+}
+
 httpd_stream_t *httpd_StreamNew(httpd_host_t *host,
                                  const char *psz_url, const char *psz_mime,
                                  const char *psz_user, const char *psz_password)
@@ -770,7 +999,6 @@ httpd_stream_t *httpd_StreamNew(httpd_host_t *host,
         return NULL;
 
     stream->psz_mime = NULL;
-    stream->p_buffer = NULL;
 
     stream->url = httpd_UrlNew(host, psz_url, psz_user, psz_password);
     if (!stream->url)
@@ -786,18 +1014,20 @@ httpd_stream_t *httpd_StreamNew(httpd_host_t *host,
 
     stream->i_header = 0;
     stream->p_header = NULL;
+    stream->p_first = NULL;
+    stream->p_last = NULL;
+    stream->i_buffer = 0;
     stream->i_buffer_size = 5000000;    /* 5 Mo per stream */
-
-    stream->p_buffer = malloc(stream->i_buffer_size);
-    if (stream->p_buffer == NULL)
-        goto error;
+    stream->i_overrun = var_InheritInteger(host, "http-stream-overrun");
 
     /* We set to 1 to make life simpler
      * (this way i_body_offset can never be 0) */
     stream->i_buffer_pos = 1;
-    stream->i_buffer_last_pos = 1;
+    stream->i_first_pos = 1;
+    stream->i_last_pos = 1;
     stream->b_has_keyframes = false;
-    stream->i_last_keyframe_seen_pos = 0;
+    stream->p_sync = NULL;
+    stream->i_sync_pos = 0;
     stream->i_http_headers = 0;
     stream->p_http_headers = NULL;
 
@@ -837,42 +1067,63 @@ int httpd_StreamHeader(httpd_stream_t *stream, uint8_t *p_data, int i_data)
     return VLC_SUCCESS;
 }
 
-static void httpd_AppendData(httpd_stream_t *stream, uint8_t *p_data, int i_data)
-{
-    int i_pos = stream->i_buffer_pos % stream->i_buffer_size;
-    int i_count = i_data;
-    while (i_count > 0) {
-        int i_copy = __MIN(i_count, stream->i_buffer_size - i_pos);
-
-        /* Ok, we can't go past the end of our buffer */
-        memcpy(&stream->p_buffer[i_pos], p_data, i_copy);
-
-        i_pos = (i_pos + i_copy) % stream->i_buffer_size;
-        i_count -= i_copy;
-        p_data  += i_copy;
-    }
-
-    stream->i_buffer_pos += i_data;
-}
-
 int httpd_StreamSend(httpd_stream_t *stream, const block_t *p_block)
 {
     if (!p_block || !p_block->p_buffer)
         return VLC_SUCCESS;
 
-    vlc_mutex_lock(&stream->lock);
+    /* The caller keeps its block: copy it once for all the clients. */
+    block_t *block = block_Duplicate(p_block);
+    if (unlikely(block == NULL))
+        return VLC_ENOMEM;
+    block->p_next = NULL;
 
-    /* save this pointer (to be used by new connection) */
-    stream->i_buffer_last_pos = stream->i_buffer_pos;
+    vlc_mutex_lock(&stream->lock);
 
-    if (p_block->i_flags & BLOCK_FLAG_TYPE_I) {
+    bool b_sync;
+    if (block->i_flags & BLOCK_FLAG_TYPE_I) {
         stream->b_has_keyframes = true;
-        stream->i_last_keyframe_seen_pos = stream->i_buffer_pos;
+        b_sync = true;
+    } else
+        /* Without keyframes, start on headers repeated within the stream
+         * (but not on the initial ones, already sent by httpd_StreamHeader) */
+        b_sync = !stream->b_has_keyframes
+              && (block->i_flags & BLOCK_FLAG_HEADER)
+              && stream->p_last != NULL
+              && !(stream->p_last->i_flags & BLOCK_FLAG_HEADER);
+
+    if (b_sync) {
+        stream->p_sync = block;
+        stream->i_sync_pos = stream->i_buffer_pos;
     }
 
-    httpd_AppendData(stream, p_block->p_buffer, p_block->i_buffer);
+    /* save this block (to be used by new connection) */
+    if (stream->p_last != NULL)
+        stream->p_last->p_next = block;
+    else {
+        stream->p_first = block;
+        stream->i_first_pos = stream->i_buffer_pos;
+    }
+    stream->p_last = block;
+    stream->i_last_pos = stream->i_buffer_pos;
+    stream->i_buffer_pos += block->i_buffer;
+    stream->i_buffer += block->i_buffer;
+
+    /* Drop the oldest blocks, clients still on them are too slow. */
+    while (stream->i_buffer > stream->i_buffer_size
+        && stream->p_first != stream->p_last) {
+        block_t *first = stream->p_first;
+
+        if (first == stream->p_sync)
+            stream->p_sync = NULL;
+        stream->p_first = first->p_next;
+        stream->i_first_pos += first->i_buffer;
+        stream->i_buffer -= first->i_buffer;
+        block_Release(first);
+    }
 
     vlc_mutex_unlock(&stream->lock);
+    httpd_HostWake(stream->url->host);
     return VLC_SUCCESS;
 }
 
@@ -886,7 +1137,7 @@ void httpd_StreamDelete(httpd_stream_t *stream)
     free(stream->p_http_headers);
     free(stream->psz_mime);
     free(stream->p_header);
-    free(stream->p_buffer);
+    block_ChainRelease(stream->p_first);
     free(stream);
 }
 
@@ -940,6 +1191,54 @@ static struct httpd
     struct vlc_list hosts;
 } httpd = { VLC_STATIC_MUTEX, VLC_LIST_INITIALIZER(&httpd.hosts) };
 
+static void httpd_HostOpenLoop(httpd_host_t *host)
+{
+    vlc_list_init(&host->ready);
+    vlc_list_init(&host->deferred);
+    host->deferred_date = VLC_TICK_INVALID;
+    host->next_sweep = VLC_TICK_0;
+    atomic_init(&host->wake_pending, false);
+
+#ifndef _WIN32
+    /* Not fatal: stream clients are then polled like the other ones */
+    if (vlc_socketpair(AF_LOCAL, SOCK_STREAM, 0, host->wake, true))
+#endif
+        return;
+
+#ifdef HAVE_SYS_EPOLL_H
+    /* TLS sessions may hold buffered data that epoll cannot report */
+    if (host->p_tls != NULL)
+        return;
+
+    host->epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (host->epfd == -1)
+        return;
+
+    struct epoll_event ev = { .events = EPOLLIN, .data.ptr = host->wake };
+    bool ok = epoll_ctl(host->epfd, EPOLL_CTL_ADD, host->wake[0], &ev) == 0;
+
+    for (unsigned i = 0; i < host->nfd && ok; i++) {
+        ev.data.ptr = &host->fds[i];
+        ok = epoll_ctl(host->epfd, EPOLL_CTL_ADD, host->fds[i], &ev) == 0;
+    }
+
+    if (!ok) {
+        vlc_close(host->epfd);
+        host->epfd = -1;
+    }
+#endif
+}
+
+static void httpd_HostCloseLoop(httpd_host_t *host)
+{
+    if (host->epfd != -1)
+        vlc_close(host->epfd);
+    if (host->wake[0] != -1) {
+        vlc_close(host->wake[0]);
+        vlc_close(host->wake[1]);
+    }
+}
+
 static httpd_host_t *httpd_HostCreate(vlc_object_t *p_this,
                                        const char *hostvar,
                                        const char *portvar,
@@ -975,6 +1274,8 @@ static httpd_host_t *httpd_HostCreate(vlc_object_t *p_this,
 
     vlc_mutex_init(&host->lock);
     atomic_init(&host->ref, 1);
+    host->epfd = -1;
+    host->wake[0] = host->wake[1] = -1;
 
     char *hostname = var_InheritString(p_this, hostvar);
 
@@ -993,6 +1294,7 @@ static httpd_host_t *httpd_HostCreate(vlc_object_t *p_this,
     vlc_list_init(&host->clients);
     host->timeout_sec = timeout_sec;
     host->p_tls    = p_tls;
+    httpd_HostOpenLoop(host);
 
     /* create the thread */
     if (vlc_clone(&host->thread, httpd_HostThread, host)) {
@@ -1010,6 +1312,7 @@ error:
     vlc_mutex_unlock(&httpd.mutex);
 
     if (host) {
+        httpd_HostCloseLoop(host);
         net_ListenClose(host->fds);
         vlc_object_delete(host);
     }
@@ -1039,12 +1342,14 @@ void httpd_HostDelete(httpd_host_t *host)
     msg_Dbg(host, "HTTP host removed");
 
     vlc_list_foreach(client, &host->clients, node) {
-        msg_Warn(host, "client still connected");
-        httpd_ClientDestroy(client);
+        if (client->i_state != HTTPD_CLIENT_DEAD)
+            msg_Warn(host, "client still connected");
+        httpd_HostClientDestroy(host, client);
     }
 
     assert(vlc_list_is_empty(&host->urls));
     vlc_tls_ServerDelete(host->p_tls);
+    httpd_HostCloseLoop(host);
     net_ListenClose(host->fds);
     vlc_object_delete(host);
     vlc_mutex_unlock(&httpd.mutex);
@@ -1141,8 +1446,14 @@ void httpd_UrlDelete(httpd_url_t *url)
 
         /* TODO complete it */
         msg_Warn(host, "force closing connections");
-        host->client_count--;
-        httpd_ClientDestroy(client);
+        if (host->epfd != -1) {
+            /* The event loop may still hold events for this client. */
+            client->url = NULL;
+            client->i_state = HTTPD_CLIENT_DEAD;
+            httpd_ClientQueue(host, client, HTTPD_QUEUE_READY);
+            httpd_HostWake(host);
+        } else
+            httpd_HostClientDestroy(host, client);
     }
     free(url);
     vlc_mutex_unlock(&host->lock);
@@ -1246,11 +1557,17 @@ static httpd_client_t *httpd_ClientNew(vlc_tls_t *sock)
 
     cl->sock    = sock;
     cl->url     = NULL;
+    cl->i_queue = HTTPD_QUEUE_NONE;
+    cl->i_poll_fd = -1;
+    cl->i_poll_events = 0;
+    cl->b_blocked = false;
     cl->i_state = HTTPD_CLIENT_RECEIVING;
     cl->i_buffer_size = HTTPD_CL_BUFSIZE;
     cl->i_buffer = 0;
     cl->p_buffer = xmalloc(cl->i_buffer_size);
     cl->i_keyframe_wait_to_pass = -1;
+    cl->p_stream_block = NULL;
+    cl->i_stream_block_pos = 0;
     cl->b_stream_mode = false;
 
     httpd_MsgInit(&cl->query);
@@ -1636,8 +1953,9 @@ static int httpd_ClientSend(httpd_client_t *cl)
     cl->i_buffer += i_len;
 
     if (cl->i_buffer >= cl->i_buffer_size) {
-        if (cl->answer.i_body == 0  && cl->answer.i_body_offset > 0) {
-            /* catch more body data */
+        if (cl->answer.i_body == 0  && cl->answer.i_body_offset > 0
+         && httpd_ClientStream(cl) == NULL) {
+            /* catch more body data (streams are sent without copying) */
             int     i_msg = cl->query.i_type;
             int64_t i_offset = cl->answer.i_body_offset;
 
@@ -1714,283 +2032,383 @@ auth_failed:
     return false;
 }
 
-static void httpdLoop(httpd_host_t *host)
+/**
+ * Runs the state machine of a client.
+ *
+ * \param events poll events to wait for [OUT], zero if waiting for the URL
+ *               handler to provide more data
+ * \param progress set if the client made any progress [OUT]
+ * \return the file descriptor to poll, or -1 if the client was destroyed
+ */
+static int httpd_ClientProcess(httpd_host_t *host, httpd_client_t *cl,
+                               vlc_tick_t now, short *events, bool *progress)
 {
-    struct pollfd ufd[host->nfd + host->client_count];
-    unsigned nfd;
-    for (nfd = 0; nfd < host->nfd; nfd++) {
-        ufd[nfd].fd = host->fds[nfd];
-        ufd[nfd].events = POLLIN;
-        ufd[nfd].revents = 0;
-    }
-
-    vlc_mutex_lock(&host->lock);
-    /* add all socket that should be read/write and close dead connection */
-    vlc_tick_t now = vlc_tick_now();
-    int delay = -1;
-    httpd_client_t *cl;
+    int val = -1;
 
-    int canc = vlc_savecancel();
-    vlc_list_foreach(cl, &host->clients, node) {
-        int val = -1;
-
-        switch (cl->i_state) {
-            case HTTPD_CLIENT_RECEIVING:
-                val = httpd_ClientRecv(cl);
-                break;
-            case HTTPD_CLIENT_SENDING:
-                val = httpd_ClientSend(cl);
-                break;
-            case HTTPD_CLIENT_TLS_HS_IN:
-            case HTTPD_CLIENT_TLS_HS_OUT:
-                httpd_ClientTlsHandshake(host, cl);
-                break;
-        }
-
-        if (cl->i_state == HTTPD_CLIENT_DEAD
-         || (host->timeout_sec > 0 && cl->i_timeout_date < now)) {
-            host->client_count--;
-            httpd_ClientDestroy(cl);
-            continue;
-        }
-
-        if (val == 0) {
-            cl->i_timeout_date = now + VLC_TICK_FROM_SEC(host->timeout_sec);
-            delay = 0;
-        }
+    switch (cl->i_state) {
+        case HTTPD_CLIENT_RECEIVING:
+            val = httpd_ClientRecv(cl);
+            break;
+        case HTTPD_CLIENT_SENDING:
+            val = httpd_ClientSend(cl);
+            break;
+        case HTTPD_CLIENT_TLS_HS_IN:
+        case HTTPD_CLIENT_TLS_HS_OUT:
+            httpd_ClientTlsHandshake(host, cl);
+            break;
+        case HTTPD_CLIENT_STREAMING:
+            val = httpd_StreamSendTo(httpd_ClientStream(cl), cl);
+            break;
+    }
 
-        struct pollfd *pufd = ufd + nfd;
-        assert (pufd < ufd + ARRAY_SIZE (ufd));
+    if (cl->i_state == HTTPD_CLIENT_DEAD
+     || (host->timeout_sec > 0 && cl->i_timeout_date < now)) {
+        httpd_HostClientDestroy(host, cl);
+        return -1;
+    }
 
-        pufd->events = pufd->revents = 0;
+    if (val == 0) {
+        cl->i_timeout_date = now + VLC_TICK_FROM_SEC(host->timeout_sec);
+        *progress = true;
+    }
 
-        switch (cl->i_state) {
-            case HTTPD_CLIENT_RECEIVING:
-            case HTTPD_CLIENT_TLS_HS_IN:
-                pufd->events = POLLIN;
-                break;
+    *events = 0;
 
-            case HTTPD_CLIENT_SENDING:
-            case HTTPD_CLIENT_TLS_HS_OUT:
-                pufd->events = POLLOUT;
-                break;
+    switch (cl->i_state) {
+        case HTTPD_CLIENT_RECEIVING:
+        case HTTPD_CLIENT_TLS_HS_IN:
+            *events = POLLIN;
+            break;
 
-            case HTTPD_CLIENT_RECEIVE_DONE: {
-                httpd_message_t *answer = &cl->answer;
-                httpd_message_t *query  = &cl->query;
+        case HTTPD_CLIENT_SENDING:
+        case HTTPD_CLIENT_TLS_HS_OUT:
+            *events = POLLOUT;
+            break;
 
-                httpd_MsgInit(answer);
+        case HTTPD_CLIENT_STREAMING:
+            /* Wait for the socket if it is full, otherwise for the stream */
+            if (cl->b_blocked)
+                *events = POLLOUT;
+            break;
 
-                /* Handle what we received */
-                switch (query->i_type) {
-                    case HTTPD_MSG_ANSWER:
-                        cl->url     = NULL;
-                        cl->i_state = HTTPD_CLIENT_DEAD;
+        case HTTPD_CLIENT_RECEIVE_DONE: {
+            httpd_message_t *answer = &cl->answer;
+            httpd_message_t *query  = &cl->query;
+
+            httpd_MsgInit(answer);
+
+            /* Handle what we received */
+            switch (query->i_type) {
+                case HTTPD_MSG_ANSWER:
+                    cl->url     = NULL;
+                    cl->i_state = HTTPD_CLIENT_DEAD;
+                    break;
+
+                case HTTPD_MSG_OPTIONS:
+                    answer->i_type   = HTTPD_MSG_ANSWER;
+                    answer->i_proto  = query->i_proto;
+                    answer->i_status = 200;
+                    answer->i_body = 0;
+                    answer->p_body = NULL;
+
+                    httpd_MsgAdd(answer, "Server", "VLC/%s", VERSION);
+                    httpd_MsgAdd(answer, "Content-Length", "0");
+
+                    switch(query->i_proto) {
+                    case HTTPD_PROTO_HTTP:
+                        answer->i_version = 1;
+                        httpd_MsgAdd(answer, "Allow", "GET,HEAD,POST,OPTIONS");
                         break;
 
-                    case HTTPD_MSG_OPTIONS:
-                        answer->i_type   = HTTPD_MSG_ANSWER;
-                        answer->i_proto  = query->i_proto;
-                        answer->i_status = 200;
-                        answer->i_body = 0;
-                        answer->p_body = NULL;
+                    case HTTPD_PROTO_RTSP:
+                        answer->i_version = 0;
 
-                        httpd_MsgAdd(answer, "Server", "VLC/%s", VERSION);
-                        httpd_MsgAdd(answer, "Content-Length", "0");
+                        const char *p = httpd_MsgGet(query, "Cseq");
+                        if (p)
+                            httpd_MsgAdd(answer, "Cseq", "%s", p);
+                        p = httpd_MsgGet(query, "Timestamp");
+                        if (p)
+                            httpd_MsgAdd(answer, "Timestamp", "%s", p);
 
-                        switch(query->i_proto) {
-                        case HTTPD_PROTO_HTTP:
-                            answer->i_version = 1;
-                            httpd_MsgAdd(answer, "Allow", "GET,HEAD,POST,OPTIONS");
-                            break;
+                        p = httpd_MsgGet(query, "Require");
+                        if (p) {
+                            answer->i_status = 551;
+                            httpd_MsgAdd(query, "Unsupported", "%s", p);
+                        }
 
-                        case HTTPD_PROTO_RTSP:
-                            answer->i_version = 0;
+                        httpd_MsgAdd(answer, "Public", "DESCRIBE,SETUP,"
+                                "TEARDOWN,PLAY,PAUSE,GET_PARAMETER");
+                        break;
+                    }
 
-                            const char *p = httpd_MsgGet(query, "Cseq");
-                            if (p)
-                                httpd_MsgAdd(answer, "Cseq", "%s", p);
-                            p = httpd_MsgGet(query, "Timestamp");
-                            if (p)
-                                httpd_MsgAdd(answer, "Timestamp", "%s", p);
+                    if (httpd_MsgGet(&cl->query, "Connection") != NULL)
+                        httpd_MsgAdd(answer, "Connection", "close");
 
-                            p = httpd_MsgGet(query, "Require");
-                            if (p) {
-                                answer->i_status = 551;
-                                httpd_MsgAdd(query, "Unsupported", "%s", p);
-                            }
+                    cl->i_buffer = -1;  /* Force the creation of the answer in
+                                         * httpd_ClientSend */
+                    cl->i_state = HTTPD_CLIENT_SENDING;
+                    break;
 
-                            httpd_MsgAdd(answer, "Public", "DESCRIBE,SETUP,"
-                                    "TEARDOWN,PLAY,PAUSE,GET_PARAMETER");
-                            break;
-                        }
+                case HTTPD_MSG_NONE:
+                    if (query->i_proto == HTTPD_PROTO_NONE) {
+                        cl->url = NULL;
+                        cl->i_state = HTTPD_CLIENT_DEAD;
+                    } else {
+                        /* unimplemented */
+                        answer->i_proto  = query->i_proto ;
+                        answer->i_type   = HTTPD_MSG_ANSWER;
+                        answer->i_version= 0;
+                        answer->i_status = 501;
 
-                        if (httpd_MsgGet(&cl->query, "Connection") != NULL)
-                            httpd_MsgAdd(answer, "Connection", "close");
+                        char *p;
+                        answer->i_body = httpd_HtmlError (&p, 501, NULL);
+                        answer->p_body = (uint8_t *)p;
+                        httpd_MsgAdd(answer, "Content-Length", "%d", answer->i_body);
+                        httpd_MsgAdd(answer, "Connection", "close");
 
-                        cl->i_buffer = -1;  /* Force the creation of the answer in
-                                             * httpd_ClientSend */
+                        cl->i_buffer = -1;  /* Force the creation of the answer in httpd_ClientSend */
                         cl->i_state = HTTPD_CLIENT_SENDING;
-                        break;
+                    }
+                    break;
 
-                    case HTTPD_MSG_NONE:
-                        if (query->i_proto == HTTPD_PROTO_NONE) {
-                            cl->url = NULL;
-                            cl->i_state = HTTPD_CLIENT_DEAD;
-                        } else {
-                            /* unimplemented */
-                            answer->i_proto  = query->i_proto ;
-                            answer->i_type   = HTTPD_MSG_ANSWER;
-                            answer->i_version= 0;
-                            answer->i_status = 501;
-
-                            char *p;
-                            answer->i_body = httpd_HtmlError (&p, 501, NULL);
-                            answer->p_body = (uint8_t *)p;
-                            httpd_MsgAdd(answer, "Content-Length", "%d", answer->i_body);
-                            httpd_MsgAdd(answer, "Connection", "close");
+                default: {
+                    httpd_url_t *url;
+                    int i_msg = query->i_type;
+                    bool b_auth_failed = false;
 
-                            cl->i_buffer = -1;  /* Force the creation of the answer in httpd_ClientSend */
-                            cl->i_state = HTTPD_CLIENT_SENDING;
-                        }
-                        break;
-
-                    default: {
-                        httpd_url_t *url;
-                        int i_msg = query->i_type;
-                        bool b_auth_failed = false;
-
-                        /* Search the url and trigger callbacks */
-                        vlc_list_foreach(url, &host->urls, node) {
-                            if (strcmp(url->psz_url, query->psz_url))
-                                continue;
-                            if (!url->catch[i_msg].cb)
-                                continue;
-
-                            if (answer) {
-                                b_auth_failed = !httpdAuthOk(url->psz_user,
-                                   url->psz_password,
-                                   httpd_MsgGet(query, "Authorization")); /* BASIC id */
-                                if (b_auth_failed)
-                                   break;
-                            }
-
-                            if (url->catch[i_msg].cb(url->catch[i_msg].p_sys, cl, answer, query))
-                                continue;
-
-                            if (answer->i_proto == HTTPD_PROTO_NONE)
-                                cl->i_buffer = cl->i_buffer_size; /* Raw answer from a CGI */
-                            else
-                                cl->i_buffer = -1;
-
-                            /* only one url can answer */
-                            answer = NULL;
-                            if (!cl->url)
-                                cl->url = url;
-                        }
+                    /* Search the url and trigger callbacks */
+                    vlc_list_foreach(url, &host->urls, node) {
+                        if (strcmp(url->psz_url, query->psz_url))
+                            continue;
+                        if (!url->catch[i_msg].cb)
+                            continue;
 
                         if (answer) {
-                            answer->i_proto  = query->i_proto;
-                            answer->i_type   = HTTPD_MSG_ANSWER;
-                            answer->i_version= 0;
-
-                           if (b_auth_failed) {
-                                httpd_MsgAdd(answer, "WWW-Authenticate",
-                                        "Basic realm=\"VLC stream\"");
-                                answer->i_status = 401;
-                            } else
-                                answer->i_status = 404; /* no url registered */
-
-                            char *p;
-                            answer->i_body = httpd_HtmlError (&p, answer->i_status,
-                                    query->psz_url);
-                            answer->p_body = (uint8_t *)p;
-
-                            cl->i_buffer = -1;  /* Force the creation of the answer in httpd_ClientSend */
-                            httpd_MsgAdd(answer, "Content-Length", "%d", answer->i_body);
-                            httpd_MsgAdd(answer, "Content-Type", "%s", "text/html");
-                            if (httpd_MsgGet(&cl->query, "Connection") != NULL)
-                                httpd_MsgAdd(answer, "Connection", "close");
+                            b_auth_failed = !httpdAuthOk(url->psz_user,
+                               url->psz_password,
+                               httpd_MsgGet(query, "Authorization")); /* BASIC id */
+                            if (b_auth_failed)
+                               break;
                         }
 
-                        cl->i_state = HTTPD_CLIENT_SENDING;
+                        if (url->catch[i_msg].cb(url->catch[i_msg].p_sys, cl, answer, query))
+                            continue;
+
+                        if (answer->i_proto == HTTPD_PROTO_NONE)
+                            cl->i_buffer = cl->i_buffer_size; /* Raw answer from a CGI */
+                        else
+                            cl->i_buffer = -1;
+
+                        /* only one url can answer */
+                        answer = NULL;
+                        if (!cl->url)
+                            cl->url = url;
+                    }
+
+                    if (answer) {
+                        answer->i_proto  = query->i_proto;
+                        answer->i_type   = HTTPD_MSG_ANSWER;
+                        answer->i_version= 0;
+
+                       if (b_auth_failed) {
+                            httpd_MsgAdd(answer, "WWW-Authenticate",
+                                    "Basic realm=\"VLC stream\"");
+                            answer->i_status = 401;
+                        } else
+                            answer->i_status = 404; /* no url registered */
+
+                        char *p;
+                        answer->i_body = httpd_HtmlError (&p, answer->i_status,
+                                query->psz_url);
+                        answer->p_body = (uint8_t *)p;
+
+                        cl->i_buffer = -1;  /* Force the creation of the answer in httpd_ClientSend */
+                        httpd_MsgAdd(answer, "Content-Length", "%d", answer->i_body);
+                        httpd_MsgAdd(answer, "Content-Type", "%s", "text/html");
+                        if (httpd_MsgGet(&cl->query, "Connection") != NULL)
+                            httpd_MsgAdd(answer, "Connection", "close");
                     }
+
+                    cl->i_state = HTTPD_CLIENT_SENDING;
                 }
-                break;
             }
+            break;
+        }
 
-            case HTTPD_CLIENT_SEND_DONE:
-                if (!cl->b_stream_mode || cl->answer.i_body_offset == 0) {
-                    bool do_close = false;
+        case HTTPD_CLIENT_SEND_DONE:
+            if (!cl->b_stream_mode || cl->answer.i_body_offset == 0) {
+                bool do_close = false;
 
-                    cl->url = NULL;
+                cl->url = NULL;
 
-                    if (cl->query.i_proto != HTTPD_PROTO_HTTP
-                     || cl->query.i_version > 0)
-                    {
-                        const char *psz_connection = httpd_MsgGet(&cl->answer,
-                                                                 "Connection");
-                        if (psz_connection != NULL)
-                            do_close = !strcasecmp(psz_connection, "close");
-                    }
-                    else
-                        do_close = true;
-
-                    if (!do_close) {
-                        httpd_MsgClean(&cl->query);
-                        httpd_MsgInit(&cl->query);
-
-                        cl->i_buffer = 0;
-                        cl->i_buffer_size = 1000;
-                        free(cl->p_buffer);
-                        // Allocate an extra byte for the null terminating byte
-                        cl->p_buffer = xmalloc(cl->i_buffer_size + 1);
-                        cl->i_state = HTTPD_CLIENT_RECEIVING;
-                    } else
-                        cl->i_state = HTTPD_CLIENT_DEAD;
-                    httpd_MsgClean(&cl->answer);
-                } else {
-                    int64_t i_offset = cl->answer.i_body_offset;
-                    httpd_MsgClean(&cl->answer);
+                if (cl->query.i_proto != HTTPD_PROTO_HTTP
+                 || cl->query.i_version > 0)
+                {
+                    const char *psz_connection = httpd_MsgGet(&cl->answer,
+                                                             "Connection");
+                    if (psz_connection != NULL)
+                        do_close = !strcasecmp(psz_connection, "close");
+                }
+                else
+                    do_close = true;
+
+                if (!do_close) {
+                    httpd_MsgClean(&cl->query);
+                    httpd_MsgInit(&cl->query);
 
-                    cl->answer.i_body_offset = i_offset;
-                    free(cl->p_buffer);
-                    cl->p_buffer = NULL;
                     cl->i_buffer = 0;
-                    cl->i_buffer_size = 0;
+                    cl->i_buffer_size = 1000;
+                    free(cl->p_buffer);
+                    // Allocate an extra byte for the null terminating byte
+                    cl->p_buffer = xmalloc(cl->i_buffer_size + 1);
+                    cl->i_state = HTTPD_CLIENT_RECEIVING;
+                } else
+                    cl->i_state = HTTPD_CLIENT_DEAD;
+                httpd_MsgClean(&cl->answer);
+            } else {
+                int64_t i_offset = cl->answer.i_body_offset;
+                httpd_MsgClean(&cl->answer);
 
+                cl->answer.i_body_offset = i_offset;
+                free(cl->p_buffer);
+                cl->p_buffer = NULL;
+                cl->i_buffer = 0;
+                cl->i_buffer_size = 0;
+
+                if (httpd_ClientStream(cl) != NULL) {
+                    cl->b_blocked = false;
+                    cl->i_state = HTTPD_CLIENT_STREAMING;
+                } else
                     cl->i_state = HTTPD_CLIENT_WAITING;
-                }
-                break;
+            }
+            break;
 
-            case HTTPD_CLIENT_WAITING: {
-                int64_t i_offset = cl->answer.i_body_offset;
-                int i_msg = cl->query.i_type;
+        case HTTPD_CLIENT_WAITING: {
+            int64_t i_offset = cl->answer.i_body_offset;
+            int i_msg = cl->query.i_type;
 
-                httpd_MsgInit(&cl->answer);
-                cl->answer.i_body_offset = i_offset;
+            httpd_MsgInit(&cl->answer);
+            cl->answer.i_body_offset = i_offset;
 
-                cl->url->catch[i_msg].cb(cl->url->catch[i_msg].p_sys, cl,
-                        &cl->answer, &cl->query);
-                if (cl->answer.i_type != HTTPD_MSG_NONE) {
-                    /* we have new data, so re-enter send mode */
-                    cl->i_buffer      = 0;
-                    cl->p_buffer      = cl->answer.p_body;
-                    cl->i_buffer_size = cl->answer.i_body;
-                    cl->answer.p_body = NULL;
-                    cl->answer.i_body = 0;
-                    cl->i_state = HTTPD_CLIENT_SENDING;
-                }
+            cl->url->catch[i_msg].cb(cl->url->catch[i_msg].p_sys, cl,
+                    &cl->answer, &cl->query);
+            if (cl->answer.i_type != HTTPD_MSG_NONE) {
+                /* we have new data, so re-enter send mode */
+                cl->i_buffer      = 0;
+                cl->p_buffer      = cl->answer.p_body;
+                cl->i_buffer_size = cl->answer.i_body;
+                cl->answer.p_body = NULL;
+                cl->answer.i_body = 0;
+                cl->i_state = HTTPD_CLIENT_SENDING;
             }
         }
+    }
+
+    return vlc_tls_GetPollFD(cl->sock, events);
+}
+
+static void httpd_HostAccept(httpd_host_t *host, int fd, vlc_tick_t now)
+{
+    fd = vlc_accept (fd, NULL, NULL, true);
+    if (fd == -1)
+        return;
+    setsockopt (fd, SOL_SOCKET, SO_REUSEADDR,
+            &(int){ 1 }, sizeof(int));
+
+    vlc_tls_t *sk = vlc_tls_SocketOpen(fd);
+    if (unlikely(sk == NULL))
+    {
+        vlc_close(fd);
+        return;
+    }
+
+    if (host->p_tls != NULL)
+    {
+        const char *alpn[] = { "http/1.1", NULL };
+        vlc_tls_t *tls;
+
+        tls = vlc_tls_ServerSessionCreate(host->p_tls, sk, alpn);
+        if (tls == NULL)
+        {
+            vlc_tls_SessionDelete(sk);
+            return;
+        }
+        sk = tls;
+    }
+
+    httpd_client_t *cl = httpd_ClientNew(sk);
+
+    if (unlikely(cl == NULL))
+    {
+        vlc_tls_Close(sk);
+        return;
+    }
+
+    if (host->p_tls != NULL)
+        cl->i_state = HTTPD_CLIENT_TLS_HS_OUT;
+
+    cl->i_timeout_date = now + VLC_TICK_FROM_SEC(host->timeout_sec);
+    host->client_count++;
+    vlc_list_append(&cl->node, &host->clients);
+    httpd_ClientQueue(host, cl, HTTPD_QUEUE_READY);
+}
+
+static void httpd_HostDrainWake(httpd_host_t *host)
+{
+    char buf[16];
+
+    atomic_store_explicit(&host->wake_pending, false, memory_order_relaxed);
+    while (recv(host->wake[0], buf, sizeof (buf), 0) > 0);
+}
+
+static void httpdLoopPoll(httpd_host_t *host)
+{
+    struct pollfd ufd[host->nfd + 1 + host->client_count];
+    unsigned nfd;
+    for (nfd = 0; nfd < host->nfd; nfd++) {
+        ufd[nfd].fd = host->fds[nfd];
+        ufd[nfd].events = POLLIN;
+        ufd[nfd].revents = 0;
+    }
+    if (host->wake[0] != -1) {
+        ufd[nfd].fd = host->wake[0];
+        ufd[nfd].events = POLLIN;
+        ufd[nfd].revents = 0;
+        nfd++;
+    }
 
-        pufd->fd = vlc_tls_GetPollFD(cl->sock, &pufd->events);
+    vlc_mutex_lock(&host->lock);
+    /* add all socket that should be read/write and close dead connection */
+    vlc_tick_t now = vlc_tick_now();
+    int delay = -1;
+    httpd_client_t *cl;
+
+    int canc = vlc_savecancel();
+    vlc_list_foreach(cl, &host->clients, node) {
+        struct pollfd *pufd = ufd + nfd;
+        bool progress = false;
+
+        assert (pufd < ufd + ARRAY_SIZE (ufd));
+
+        pufd->revents = 0;
+        pufd->fd = httpd_ClientProcess(host, cl, now, &pufd->events,
+                                       &progress);
+        if (pufd->fd == -1)
+            continue;
+        if (progress)
+            delay = 0;
 
         if (pufd->events != 0)
             nfd++;
         /* we will wait 20ms (not too big) if HTTPD_CLIENT_WAITING */
-        else if (delay != 0)
-            delay = 20;
+        else if (cl->i_state != HTTPD_CLIENT_STREAMING
+              || host->wake[0] == -1) {
+            if (delay != 0)
+                delay = 20;
+        }
+        /* streams wake us up, but the client may still time out */
+        else if (delay == -1 && host->timeout_sec > 0)
+            delay = 1000;
     }
     vlc_mutex_unlock(&host->lock);
     vlc_restorecancel(canc);
@@ -2004,65 +2422,157 @@ static void httpdLoop(httpd_host_t *host)
     canc = vlc_savecancel();
     vlc_mutex_lock(&host->lock);
 
-    /* Handle client sockets */
-    now = vlc_tick_now();
-    nfd = host->nfd;
+    if (host->wake[0] != -1 && ufd[host->nfd].revents)
+        httpd_HostDrainWake(host);
 
     /* Handle server sockets (accept new connections) */
+    now = vlc_tick_now();
     for (nfd = 0; nfd < host->nfd; nfd++) {
-        int fd = ufd[nfd].fd;
+        assert (ufd[nfd].fd == host->fds[nfd]);
 
-        assert (fd == host->fds[nfd]);
+        if (ufd[nfd].revents != 0)
+            httpd_HostAccept(host, ufd[nfd].fd, now);
+    }
 
-        if (ufd[nfd].revents == 0)
-            continue;
+    vlc_mutex_unlock(&host->lock);
+    vlc_restorecancel(canc);
+}
 
-        /* */
-        fd = vlc_accept (fd, NULL, NULL, true);
-        if (fd == -1)
-            continue;
-        setsockopt (fd, SOL_SOCKET, SO_REUSEADDR,
-                &(int){ 1 }, sizeof(int));
+#ifdef HAVE_SYS_EPOLL_H
+static void httpd_ClientRun(httpd_host_t *host, httpd_client_t *cl,
+                            vlc_tick_t now)
+{
+    bool progress = false;
+    short events;
+    int fd = httpd_ClientProcess(host, cl, now, &events, &progress);
 
-        vlc_tls_t *sk = vlc_tls_SocketOpen(fd);
-        if (unlikely(sk == NULL))
-        {
-            vlc_close(fd);
-            continue;
-        }
+    if (fd == -1)
+        return;
 
-        if (host->p_tls != NULL)
-        {
-            const char *alpn[] = { "http/1.1", NULL };
-            vlc_tls_t *tls;
-
-            tls = vlc_tls_ServerSessionCreate(host->p_tls, sk, alpn);
-            if (tls == NULL)
-            {
-                vlc_tls_SessionDelete(sk);
-                continue;
-            }
-            sk = tls;
-        }
+    if (progress)
+        httpd_ClientQueue(host, cl, HTTPD_QUEUE_READY);
+    else if (events == 0 && cl->i_state != HTTPD_CLIENT_STREAMING)
+        /* the URL handler has no data yet: try again later */
+        httpd_ClientQueue(host, cl, HTTPD_QUEUE_DEFERRED);
 
-        cl = httpd_ClientNew(sk);
+    if (fd == cl->i_poll_fd && events == cl->i_poll_events)
+        return;
 
-        if (unlikely(cl == NULL))
-        {
-            vlc_tls_Close(sk);
-            continue;
-        }
+    struct epoll_event ev = {
+        .events = ((events & POLLIN) ? EPOLLIN : 0)
+                | ((events & POLLOUT) ? EPOLLOUT : 0),
+        .data.ptr = cl,
+    };
 
-        if (host->p_tls != NULL)
-            cl->i_state = HTTPD_CLIENT_TLS_HS_OUT;
+    if (fd != cl->i_poll_fd) {
+        if (cl->i_poll_fd != -1)
+            epoll_ctl(host->epfd, EPOLL_CTL_DEL, cl->i_poll_fd, NULL);
+        cl->i_poll_fd = -1;
+        if (epoll_ctl(host->epfd, EPOLL_CTL_ADD, fd, &ev) == 0)
+            cl->i_poll_fd = fd;
+    } else
+        epoll_ctl(host->epfd, EPOLL_CTL_MOD, fd, &ev);
 
-        cl->i_timeout_date = now + VLC_TICK_FROM_SEC(host->timeout_sec);
-        host->client_count++;
-        vlc_list_append(&cl->node, &host->clients);
+    cl->i_poll_events = events;
+}
+
+/*
+ * Event driven loop: only the clients with socket events, or waiting for
+ * stream data that just arrived, are processed. This scales to a large
+ * number of mostly idle or blocked clients.
+ */
+static void httpdLoopEpoll(httpd_host_t *host)
+{
+    struct epoll_event ev[64];
+    struct vlc_list run;
+    httpd_client_t *cl;
+    int delay = -1;
+
+    int canc = vlc_savecancel();
+    vlc_mutex_lock(&host->lock);
+    vlc_tick_t now = vlc_tick_now();
+
+    vlc_list_init(&run);
+    if (!vlc_list_is_empty(&host->ready)) {
+        vlc_list_replace(&host->ready, &run);
+        vlc_list_init(&host->ready);
+    }
+    vlc_list_foreach(cl, &run, queue_node) {
+        vlc_list_remove(&cl->queue_node);
+        cl->i_queue = HTTPD_QUEUE_NONE;
+        httpd_ClientRun(host, cl, now);
+    }
+
+    /* Time out idle clients */
+    if (host->timeout_sec > 0 && now >= host->next_sweep) {
+        vlc_list_foreach(cl, &host->clients, node)
+            if (cl->i_timeout_date < now)
+                httpd_HostClientDestroy(host, cl);
+        host->next_sweep = now + VLC_TICK_FROM_SEC(1);
     }
 
+    if (!vlc_list_is_empty(&host->deferred)
+     && host->deferred_date == VLC_TICK_INVALID)
+        /* we will wait 20ms (not too big) for the URL handlers */
+        host->deferred_date = now + VLC_TICK_FROM_MS(20);
+
+    if (!vlc_list_is_empty(&host->ready))
+        delay = 0;
+    else if (host->deferred_date != VLC_TICK_INVALID)
+        delay = (host->deferred_date > now)
+              ? MS_FROM_VLC_TICK(host->deferred_date - now) + 1 : 0;
+    else if (host->timeout_sec > 0)
+        delay = MS_FROM_VLC_TICK(host->next_sweep - now) + 1;
+
     vlc_mutex_unlock(&host->lock);
     vlc_restorecancel(canc);
+
+    int n = epoll_wait(host->epfd, ev, ARRAY_SIZE(ev), delay);
+    if (n < 0 && errno != EINTR)
+        msg_Err(host, "polling error: %s", vlc_strerror_c(errno));
+
+    canc = vlc_savecancel();
+    vlc_mutex_lock(&host->lock);
+    now = vlc_tick_now();
+
+    for (int i = 0; i < n; i++) {
+        void *ptr = ev[i].data.ptr;
+
+        if (ptr == host->wake) {
+            httpd_HostDrainWake(host);
+            vlc_list_foreach(cl, &host->clients, node)
+                if (cl->i_state == HTTPD_CLIENT_STREAMING && !cl->b_blocked)
+                    httpd_ClientQueue(host, cl, HTTPD_QUEUE_READY);
+        }
+        else if (ptr >= (void *)host->fds
+              && ptr < (void *)(host->fds + host->nfd))
+            httpd_HostAccept(host, *(int *)ptr, now);
+        else
+            httpd_ClientQueue(host, ptr, HTTPD_QUEUE_READY);
+    }
+
+    /* Give the URL handlers another chance */
+    if (host->deferred_date != VLC_TICK_INVALID
+     && now >= host->deferred_date) {
+        vlc_list_foreach(cl, &host->deferred, queue_node)
+            httpd_ClientQueue(host, cl, HTTPD_QUEUE_READY);
+        host->deferred_date = VLC_TICK_INVALID;
+    }
+
+    vlc_mutex_unlock(&host->lock);
+    vlc_restorecancel(canc);
+}
+#endif
+
+static void httpdLoop(httpd_host_t *host)
+{
+#ifdef HAVE_SYS_EPOLL_H
+    if (host->epfd != -1) {
+        httpdLoopEpoll(host);
+        return;
+    }
+#endif
+    httpdLoopPoll(host);
 }
 
 static void* httpd_HostThread(void *data)
@@ -350,7 +350,13 @@ int input_preparser_Push( input_preparser_t *preparser,
 
     PreparserAddTask(preparser, task);
 
-    vlc_executor_Submit(preparser->executor, &task->runnable);
+    /* Requests a user interacts with overtake the background preparsing */
+    enum vlc_executor_priority priority =
+        i_options & META_REQUEST_OPTION_DO_INTERACT
+            ? VLC_EXECUTOR_PRIORITY_INTERACTIVE
+            : VLC_EXECUTOR_PRIORITY_BACKGROUND;
+    vlc_executor_SubmitWithPriority(preparser->executor, &task->runnable,
+                                    priority);
     return VLC_SUCCESS;
 }
 
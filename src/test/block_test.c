@@ -86,11 +86,69 @@ static void test_block (void)
     //assert (block == NULL);
 }
 
+#define CACHE_BLOCKS 1000
+
+static void *test_block_cache_Release(void *data)
+{
+    block_t **blocks = data;
+
+    for (size_t i = 0; i < CACHE_BLOCKS; i++)
+        block_Release(blocks[i]);
+    return NULL;
+}
+
+static void test_block_cache(void)
+{
+    static block_t *blocks[CACHE_BLOCKS];
+    struct vlc_frame_cache_stats before, after;
+    vlc_thread_t th;
+
+    vlc_frame_GetCacheStats(&before);
+
+    for (unsigned round = 0; round < 2; round++)
+    {
+        for (size_t i = 0; i < CACHE_BLOCKS; i++)
+        {
+            size_t size = (i * 97) % 70000;
+
+            blocks[i] = block_Alloc(size);
+            assert(blocks[i] != NULL);
+            assert(blocks[i]->i_buffer == size);
+            assert(((uintptr_t)blocks[i]->p_buffer % 32) == 0);
+            assert(blocks[i]->p_buffer >= blocks[i]->p_start + 32);
+            assert(blocks[i]->p_buffer + size + 32
+                   <= blocks[i]->p_start + blocks[i]->i_size);
+            assert(blocks[i]->i_pts == VLC_TICK_INVALID);
+            assert(blocks[i]->i_flags == 0);
+            memset(blocks[i]->p_buffer, 0xA5, size);
+            blocks[i]->i_flags = BLOCK_FLAG_DISCONTINUITY;
+            blocks[i]->i_pts = VLC_TICK_0;
+        }
+
+        /* Release from another thread, as a decoder would */
+        if (vlc_clone(&th, test_block_cache_Release, blocks))
+            abort();
+        vlc_join(th, NULL);
+    }
+
+    vlc_frame_GetCacheStats(&after);
+#ifndef __SANITIZE_ADDRESS__
+    /* The releasing thread spilled frames that the second round took back */
+    assert(after.allocated > before.allocated);
+    assert(after.spills > before.spills);
+    assert(after.refills > before.refills);
+#else
+    /* The cache is compiled out */
+    assert(after.allocated == 0 && after.spills == 0 && after.refills == 0);
+#endif
+}
+
 int main (void)
 {
     test_block_File(false);
     test_block_File(true);
     test_block ();
+    test_block_cache ();
     return 0;
 }
 
@@ -271,6 +271,99 @@ static void test_task_chain(void)
         assert(array[i] == 2 * i);
 }
 
+struct order_data
+{
+    vlc_mutex_t lock;
+    vlc_cond_t cond;
+    bool blocked;
+    int order[4];
+    int count;
+};
+
+struct order_task
+{
+    struct order_data *data;
+    int id;
+    struct vlc_runnable runnable;
+};
+
+static void BlockRun(void *userdata)
+{
+    struct order_data *data = userdata;
+
+    vlc_mutex_lock(&data->lock);
+    while (data->blocked)
+        vlc_cond_wait(&data->cond, &data->lock);
+    vlc_mutex_unlock(&data->lock);
+}
+
+static void OrderRun(void *userdata)
+{
+    struct order_task *task = userdata;
+    struct order_data *data = task->data;
+
+    vlc_mutex_lock(&data->lock);
+    data->order[data->count++] = task->id;
+    vlc_mutex_unlock(&data->lock);
+}
+
+static void test_priority(void)
+{
+    vlc_executor_t *executor = vlc_executor_New(1);
+    assert(executor);
+
+    struct order_data data = { .blocked = true, .count = 0 };
+    vlc_mutex_init(&data.lock);
+    vlc_cond_init(&data.cond);
+
+    /* Keep the single thread busy while queuing */
+    struct vlc_runnable blocker = {
+        .run = BlockRun,
+        .userdata = &data,
+    };
+    vlc_executor_Submit(executor, &blocker);
+
+    struct order_task tasks[4];
+    static const enum vlc_executor_priority priorities[] = {
+        VLC_EXECUTOR_PRIORITY_BACKGROUND,
+        VLC_EXECUTOR_PRIORITY_INTERACTIVE,
+        VLC_EXECUTOR_PRIORITY_BACKGROUND,
+        VLC_EXECUTOR_PRIORITY_INTERACTIVE,
+    };
+    for (int i = 0; i < 4; ++i)
+    {
+        tasks[i].data = &data;
+        tasks[i].id = i;
+        tasks[i].runnable.run = OrderRun;
+        tasks[i].runnable.userdata = &tasks[i];
+        vlc_executor_SubmitWithPriority(executor, &tasks[i].runnable,
+                                        priorities[i]);
+    }
+
+    vlc_mutex_lock(&data.lock);
+    data.blocked = false;
+    vlc_cond_signal(&data.cond);
+    vlc_mutex_unlock(&data.lock);
+
+    vlc_executor_WaitIdle(executor);
+
+    /* Interactive first, submission order within a lane */
+    assert(data.count == 4);
+    assert(data.order[0] == 1);
+    assert(data.order[1] == 3);
+    assert(data.order[2] == 0);
+    assert(data.order[3] == 2);
+
+    struct vlc_executor_stats stats;
+    vlc_executor_GetStats(executor, &stats);
+    assert(stats.started == 5);
+    assert(stats.stolen == 0);
+    assert(stats.latency_max >= 0);
+    assert(stats.latency_total >= stats.latency_max);
+
+    vlc_executor_Delete(executor);
+}
+
 int main(void)
 {
     test_single_runnable();
@@ -278,5 +371,6 @@ int main(void)
     test_blocking_delete();
     test_cancel();
     test_task_chain();
+    test_priority();
     return 0;
 }
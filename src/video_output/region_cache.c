@@ -0,0 +1,222 @@
+/*****************************************************************************
+ * region_cache.c : cache of converted subpicture regions
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_picture.h>
+
+#include "region_cache.h"
+
+static size_t PictureSize(const picture_t *picture)
+{
+    size_t size = 0;
+    for (int i = 0; i < picture->i_planes; i++)
+        size += (size_t)picture->p[i].i_pitch * picture->p[i].i_lines;
+    return size;
+}
+
+static bool PictureEqual(const picture_t *a, const picture_t *b)
+{
+    if (a->i_planes != b->i_planes)
+        return false;
+    for (int i = 0; i < a->i_planes; i++)
+    {
+        const plane_t *pa = &a->p[i], *pb = &b->p[i];
+        if (pa->i_visible_lines != pb->i_visible_lines ||
+            pa->i_visible_pitch != pb->i_visible_pitch)
+            return false;
+        for (int y = 0; y < pa->i_visible_lines; y++)
+            if (memcmp(&pa->p_pixels[y * pa->i_pitch],
+                       &pb->p_pixels[y * pb->i_pitch], pa->i_visible_pitch))
+                return false;
+    }
+    return true;
+}
+
+static bool FormatEqual(const video_format_t *a, const video_format_t *b,
+                        bool check_palette)
+{
+    if (a->i_chroma != b->i_chroma ||
+        a->i_width != b->i_width || a->i_height != b->i_height ||
+        a->i_x_offset != b->i_x_offset || a->i_y_offset != b->i_y_offset ||
+        a->i_visible_width != b->i_visible_width ||
+        a->i_visible_height != b->i_visible_height ||
+        a->i_sar_num != b->i_sar_num || a->i_sar_den != b->i_sar_den ||
+        a->orientation != b->orientation ||
+        a->primaries != b->primaries || a->transfer != b->transfer ||
+        a->space != b->space || a->color_range != b->color_range)
+        return false;
+    /* Only region formats own their palette */
+    if (check_palette && a->i_chroma == VLC_CODEC_YUVP)
+    {
+        if (!a->p_palette || !b->p_palette)
+            return a->p_palette == b->p_palette;
+        if (a->p_palette->i_entries != b->p_palette->i_entries ||
+            memcmp(a->p_palette->palette, b->p_palette->palette,
+                   a->p_palette->i_entries * sizeof(a->p_palette->palette[0])))
+            return false;
+    }
+    return true;
+}
+
+static void EntryClean(spu_region_cache_entry_t *entry)
+{
+    video_format_Clean(&entry->fmt);
+    picture_Release(entry->source);
+    picture_Release(entry->picture);
+}
+
+static void Remove(spu_region_cache_t *cache, size_t index)
+{
+    spu_region_cache_entry_t *entry = &cache->entries.data[index];
+    cache->size -= entry->size;
+    EntryClean(entry);
+    vlc_vector_remove(&cache->entries, index);
+}
+
+void spu_region_cache_Init(spu_region_cache_t *cache)
+{
+    vlc_vector_init(&cache->entries);
+    cache->size = 0;
+    cache->clock = 0;
+    cache->hits = 0;
+    cache->misses = 0;
+}
+
+void spu_region_cache_Flush(spu_region_cache_t *cache)
+{
+    for (size_t i = 0; i < cache->entries.size; i++)
+        EntryClean(&cache->entries.data[i]);
+    vlc_vector_clear(&cache->entries);
+    cache->size = 0;
+}
+
+void spu_region_cache_Clean(spu_region_cache_t *cache)
+{
+    spu_region_cache_Flush(cache);
+    vlc_vector_destroy(&cache->entries);
+}
+
+uint64_t spu_region_cache_Hash(const picture_t *picture)
+{
+    uint64_t hash = UINT64_C(0xcbf29ce484222325);
+    for (int i = 0; i < picture->i_planes; i++)
+    {
+        const plane_t *plane = &picture->p[i];
+        for (int y = 0; y < plane->i_visible_lines; y++)
+        {
+            const uint8_t *line = &plane->p_pixels[y * plane->i_pitch];
+            int x = 0;
+            for (; x + 8 <= plane->i_visible_pitch; x += 8)
+            {
+                uint64_t word;
+                memcpy(&word, &line[x], sizeof(word));
+                hash = (hash ^ word) * UINT64_C(0x100000001b3);
+                hash ^= hash >> 32;
+            }
+            for (; x < plane->i_visible_pitch; x++)
+                hash = (hash ^ line[x]) * UINT64_C(0x100000001b3);
+        }
+    }
+    return hash;
+}
+
+picture_t *spu_region_cache_Get(spu_region_cache_t *cache,
+                                const video_format_t *fmt,
+                                const picture_t *source, uint64_t hash,
+                                vlc_fourcc_t chroma,
+                                unsigned width, unsigned height)
+{
+    for (size_t i = 0; i < cache->entries.size; i++)
+    {
+        spu_region_cache_entry_t *entry = &cache->entries.data[i];
+        if (entry->hash != hash || entry->chroma != chroma ||
+            entry->width != width || entry->height != height ||
+            !FormatEqual(&entry->fmt, fmt, true) ||
+            !FormatEqual(&entry->source->format, &source->format, false) ||
+            !PictureEqual(entry->source, source))
+            continue;
+
+        entry->last_use = ++cache->clock;
+        cache->hits++;
+        return picture_Hold(entry->picture);
+    }
+    cache->misses++;
+    return NULL;
+}
+
+void spu_region_cache_Put(spu_region_cache_t *cache,
+                          const video_format_t *fmt,
+                          const picture_t *source, uint64_t hash,
+                          vlc_fourcc_t chroma,
+                          unsigned width, unsigned height,
+                          picture_t *picture)
+{
+    const size_t size = PictureSize(source) + PictureSize(picture);
+    if (size > SPU_REGION_CACHE_MAX_SIZE / 4)
+        return;
+
+    /* Evict the least recently used entries */
+    while (cache->entries.size > 0 &&
+           (cache->entries.size >= SPU_REGION_CACHE_MAX_COUNT ||
+            cache->size + size > SPU_REGION_CACHE_MAX_SIZE))
+    {
+        size_t lru = 0;
+        for (size_t i = 1; i < cache->entries.size; i++)
+            if (cache->entries.data[i].last_use <
+                cache->entries.data[lru].last_use)
+                lru = i;
+        Remove(cache, lru);
+    }
+
+    spu_region_cache_entry_t entry = {
+        .hash = hash,
+        .chroma = chroma,
+        .width = width,
+        .height = height,
+        .size = size,
+        .last_use = ++cache->clock,
+    };
+
+    /* Keep our own copy: producers may reuse their pictures */
+    entry.source = picture_NewFromFormat(&source->format);
+    if (!entry.source)
+        return;
+    picture_Copy(entry.source, source);
+
+    if (video_format_Copy(&entry.fmt, fmt))
+    {
+        picture_Release(entry.source);
+        return;
+    }
+    entry.picture = picture_Hold(picture);
+
+    if (!vlc_vector_push(&cache->entries, entry))
+    {
+        EntryClean(&entry);
+        return;
+    }
+    cache->size += size;
+}
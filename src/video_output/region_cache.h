@@ -0,0 +1,90 @@
+/*****************************************************************************
+ * region_cache.h : cache of converted subpicture regions
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef LIBVLC_VOUT_INTERNAL_REGION_CACHE_H
+#define LIBVLC_VOUT_INTERNAL_REGION_CACHE_H
+
+#include <vlc_picture.h>
+#include <vlc_vector.h>
+
+/* Converted and scaled regions, keyed by their source content and output
+ * size. Updaters and sub-sources recreate their regions (and lose the
+ * per-region cache) even when the content does not change. */
+#define SPU_REGION_CACHE_MAX_COUNT 16
+#define SPU_REGION_CACHE_MAX_SIZE  (32 << 20)
+
+typedef struct {
+    uint64_t hash;                        /**< hash of the source pixels */
+    video_format_t fmt;                  /**< source region format */
+    picture_t *source;                   /**< copy of the source pixels */
+    picture_t *picture;                  /**< converted/scaled picture */
+    vlc_fourcc_t chroma;
+    unsigned width;
+    unsigned height;
+    size_t size;
+    uint64_t last_use;
+} spu_region_cache_entry_t;
+
+typedef struct
+{
+    struct VLC_VECTOR(spu_region_cache_entry_t) entries;
+    size_t          size;
+    uint64_t        clock;
+    unsigned        hits;
+    unsigned        misses;
+} spu_region_cache_t;
+
+void spu_region_cache_Init(spu_region_cache_t *);
+void spu_region_cache_Clean(spu_region_cache_t *);
+
+/**
+ * Releases all the cached pictures.
+ */
+void spu_region_cache_Flush(spu_region_cache_t *);
+
+/**
+ * Returns the hash of the visible pixels of a source picture.
+ */
+uint64_t spu_region_cache_Hash(const picture_t *);
+
+/**
+ * Returns a reference to an already converted picture for this region
+ * content and output size, if any.
+ */
+picture_t *spu_region_cache_Get(spu_region_cache_t *,
+                                const video_format_t *fmt,
+                                const picture_t *source, uint64_t hash,
+                                vlc_fourcc_t chroma,
+                                unsigned width, unsigned height);
+
+/**
+ * Stores the converted picture of a region.
+ *
+ * The source pixels are copied, so the producer may reuse its picture.
+ * The cache holds its own reference to the converted picture.
+ */
+void spu_region_cache_Put(spu_region_cache_t *,
+                          const video_format_t *fmt,
+                          const picture_t *source, uint64_t hash,
+                          vlc_fourcc_t chroma,
+                          unsigned width, unsigned height,
+                          picture_t *picture);
+
+#endif
@@ -44,6 +44,7 @@
 #include "../misc/subpicture.h"
 #include "../input/input_internal.h"
 #include "../clock/clock.h"
+#include "region_cache.h"
 
 /*****************************************************************************
  * Local prototypes
@@ -129,6 +130,8 @@ struct spu_private_t {
         bool            live;
     } prerender;
 
+    spu_region_cache_t region_cache;
+
     /* */
     vlc_tick_t          last_sort_date;
     vout_thread_t       *vout;
@@ -182,6 +185,14 @@ static void spu_channel_Clean(spu_private_t *sys, struct spu_channel *channel)
     vlc_vector_destroy(&channel->entries);
 }
 
+static bool spu_HasSubpictures(spu_private_t *sys)
+{
+    for (size_t i = 0; i < sys->channels.size; i++)
+        if (sys->channels.data[i].entries.size > 0)
+            return true;
+    return false;
+}
+
 static struct spu_channel *spu_GetChannel(spu_t *spu, size_t channel_id)
 {
     spu_private_t *sys = spu->p;
@@ -781,6 +792,67 @@ spu_SelectSubpictures(spu_t *spu, vlc_tick_t system_now,
 
 
 
+/**
+ * Converts and scales the region picture into the given chroma and size.
+ */
+static picture_t *SpuConvertRegion(spu_t *spu, subpicture_region_t *region,
+                                   bool using_palette, bool convert_chroma,
+                                   const vlc_fourcc_t *chroma_list,
+                                   unsigned dst_width, unsigned dst_height)
+{
+    spu_private_t *sys = spu->p;
+    filter_t *scale = sys->scale;
+
+    picture_t *picture = region->p_picture;
+    picture_Hold(picture);
+
+    /* Convert YUVP to YUVA/RGBA first for better scaling quality */
+    if (using_palette) {
+        filter_t *scale_yuvp = sys->scale_yuvp;
+
+        scale_yuvp->fmt_in.video = region->fmt;
+
+        scale_yuvp->fmt_out.video = region->fmt;
+        scale_yuvp->fmt_out.video.i_chroma = chroma_list[0];
+
+        picture = scale_yuvp->ops->filter_video(scale_yuvp, picture);
+        assert(picture == NULL || !picture_HasChainedPics(picture)); // no chaining
+        if (!picture) {
+            /* Well we will try conversion+scaling */
+            msg_Warn(spu, "%4.4s to %4.4s conversion failed",
+                     (const char*)&scale_yuvp->fmt_in.video.i_chroma,
+                     (const char*)&scale_yuvp->fmt_out.video.i_chroma);
+        }
+    }
+
+    /* Conversion(except from YUVP)/Scaling */
+    if (picture &&
+        (picture->format.i_visible_width  != dst_width ||
+         picture->format.i_visible_height != dst_height ||
+         (convert_chroma && !using_palette)))
+    {
+        scale->fmt_in.video  = picture->format;
+        scale->fmt_out.video = picture->format;
+        if (using_palette)
+            scale->fmt_in.video.i_chroma = chroma_list[0];
+        if (convert_chroma)
+            scale->fmt_out.i_codec        =
+            scale->fmt_out.video.i_chroma = chroma_list[0];
+
+        scale->fmt_out.video.i_width  = dst_width;
+        scale->fmt_out.video.i_height = dst_height;
+
+        scale->fmt_out.video.i_visible_width  = dst_width;
+        scale->fmt_out.video.i_visible_height = dst_height;
+
+        picture = scale->ops->filter_video(scale, picture);
+        assert(picture == NULL || !picture_HasChainedPics(picture)); // no chaining
+        if (!picture)
+            msg_Err(spu, "scaling failed");
+    }
+    return picture;
+}
+
 /**
  * It will transform the provided region into another region suitable for rendering.
  */
@@ -983,56 +1055,23 @@ static void SpuRenderRegion(spu_t *spu,
 
         /* Scale if needed into cache */
         if (!region->p_private && dst_width > 0 && dst_height > 0) {
-            filter_t *scale = sys->scale;
-
-            picture_t *picture = region->p_picture;
-            picture_Hold(picture);
-
-            /* Convert YUVP to YUVA/RGBA first for better scaling quality */
-            if (using_palette) {
-                filter_t *scale_yuvp = sys->scale_yuvp;
-
-                scale_yuvp->fmt_in.video = region->fmt;
-
-                scale_yuvp->fmt_out.video = region->fmt;
-                scale_yuvp->fmt_out.video.i_chroma = chroma_list[0];
-
-                picture = scale_yuvp->ops->filter_video(scale_yuvp, picture);
-                assert(picture == NULL || !picture_HasChainedPics(picture)); // no chaining
-                if (!picture) {
-                    /* Well we will try conversion+scaling */
-                    msg_Warn(spu, "%4.4s to %4.4s conversion failed",
-                             (const char*)&scale_yuvp->fmt_in.video.i_chroma,
-                             (const char*)&scale_yuvp->fmt_out.video.i_chroma);
-                }
-            }
-
-            /* Conversion(except from YUVP)/Scaling */
-            if (picture &&
-                (picture->format.i_visible_width  != dst_width ||
-                 picture->format.i_visible_height != dst_height ||
-                 (convert_chroma && !using_palette)))
-            {
-                scale->fmt_in.video  = picture->format;
-                scale->fmt_out.video = picture->format;
-                if (using_palette)
-                    scale->fmt_in.video.i_chroma = chroma_list[0];
-                if (convert_chroma)
-                    scale->fmt_out.i_codec        =
-                    scale->fmt_out.video.i_chroma = chroma_list[0];
-
-                scale->fmt_out.video.i_width  = dst_width;
-                scale->fmt_out.video.i_height = dst_height;
-
-                scale->fmt_out.video.i_visible_width =
-                    spu_scale_w(region->fmt.i_visible_width, scale_size);
-                scale->fmt_out.video.i_visible_height =
-                    spu_scale_h(region->fmt.i_visible_height, scale_size);
-
-                picture = scale->ops->filter_video(scale, picture);
-                assert(picture == NULL || !picture_HasChainedPics(picture)); // no chaining
-                if (!picture)
-                    msg_Err(spu, "scaling failed");
+            /* Reuse the result of a previous region with the same content */
+            const vlc_fourcc_t dst_chroma = using_palette || convert_chroma ?
+                                            chroma_list[0] : region->fmt.i_chroma;
+            const uint64_t hash = spu_region_cache_Hash(region->p_picture);
+            picture_t *picture = spu_region_cache_Get(&sys->region_cache,
+                                                      &region->fmt,
+                                                      region->p_picture, hash,
+                                                      dst_chroma,
+                                                      dst_width, dst_height);
+            if (!picture) {
+                picture = SpuConvertRegion(spu, region, using_palette,
+                                           convert_chroma, chroma_list,
+                                           dst_width, dst_height);
+                if (picture)
+                    spu_region_cache_Put(&sys->region_cache, &region->fmt,
+                                         region->p_picture, hash, dst_chroma,
+                                         dst_width, dst_height, picture);
             }
 
             /* */
@@ -1606,6 +1645,10 @@ static void spu_Cleanup(spu_t *spu)
 
     vlc_vector_destroy(&sys->channels);
 
+    msg_Dbg(spu, "region cache: %u hits, %u misses",
+            sys->region_cache.hits, sys->region_cache.misses);
+    spu_region_cache_Clean(&sys->region_cache);
+
     vlc_vector_clear(&sys->prerender.vector);
     video_format_Clean(&sys->prerender.fmtdst);
     video_format_Clean(&sys->prerender.fmtsrc);
@@ -1686,6 +1729,8 @@ spu_t *spu_Create(vlc_object_t *object, vout_thread_t *vout)
     sys->prerender.chroma_list[SPU_CHROMALIST_COUNT] = 0;
     sys->prerender.live = true;
 
+    spu_region_cache_Init(&sys->region_cache);
+
     /* Load text and scale module */
     sys->text = SpuRenderCreateAndLoadText(spu);
     vlc_mutex_init(&sys->textlock);
@@ -1964,6 +2009,9 @@ subpicture_t *spu_Render(spu_t *spu,
                              ignore_osd, &subpicture_count);
     if (!subpicture_array)
     {
+        /* Do not keep converted regions once all subpictures are gone */
+        if (!spu_HasSubpictures(sys))
+            spu_region_cache_Flush(&sys->region_cache);
         vlc_mutex_unlock(&sys->lock);
         return NULL;
     }
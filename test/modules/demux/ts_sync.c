@@ -0,0 +1,99 @@
+/*****************************************************************************
+ * ts_sync.c: MPEG TS sync bytes scanning tests
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#undef NDEBUG
+#include <assert.h>
+
+#include <vlc_common.h>
+
+#include "../../../modules/demux/mpeg/ts_sync.h"
+
+static const size_t sizes[] = { 188, 192, 204 };
+
+static void check(const uint8_t *buf, size_t len, size_t size, unsigned count,
+                  size_t expected)
+{
+    size_t ref = ts_sync_Find_C(buf, len, size, count);
+    size_t simd = ts_sync_Find(buf, len, size, count);
+
+    if (ref != expected || simd != expected)
+        fprintf(stderr, "size %zu count %u len %zu: expected %zu, "
+                "got %zu (C) %zu (SIMD)\n", size, count, len, expected,
+                ref, simd);
+    assert(ref == expected);
+    assert(simd == expected);
+}
+
+int main(void)
+{
+    const size_t len = 204 * 64;
+    uint8_t *buf = malloc(len);
+    assert(buf != NULL);
+
+    srand(0);
+
+    for (size_t s = 0; s < ARRAY_SIZE(sizes); s++)
+    {
+        const size_t size = sizes[s];
+
+        /* Garbage only: the sync byte value is never used */
+        for (size_t i = 0; i < len; i++)
+            buf[i] = rand() % TS_SYNC_BYTE;
+        for (unsigned count = 1; count <= 4; count++)
+            check(buf, len, size, count, len);
+
+        /* Packets at every possible offset, including the unrolled tails */
+        for (size_t offset = 0; offset < 2 * size; offset++)
+        {
+            for (size_t i = 0; i < len; i++)
+                buf[i] = rand() % TS_SYNC_BYTE;
+            for (size_t i = offset; i < len; i += size)
+                buf[i] = TS_SYNC_BYTE;
+
+            for (unsigned count = 1; count <= 4; count++)
+                check(buf, len, size, count, offset);
+
+            /* Lone sync bytes before the packets must be ignored */
+            if (offset > 3)
+            {
+                buf[offset - 3] = TS_SYNC_BYTE;
+                check(buf, len, size, 3, offset);
+                buf[offset - 3] = 0;
+            }
+
+            /* Not enough data for the requested number of packets */
+            const size_t end = offset + 2 * size;
+            check(buf, end, size, 3, end);
+            check(buf, end + 1, size, 3, offset);
+        }
+    }
+
+    /* Empty and tiny buffers */
+    check(buf, 0, 188, 1, 0);
+    buf[0] = TS_SYNC_BYTE;
+    check(buf, 1, 188, 1, 0);
+    check(buf, 1, 188, 2, 1);
+
+    free(buf);
+    return 0;
+}
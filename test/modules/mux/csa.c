@@ -0,0 +1,119 @@
+/*****************************************************************************
+ * csa.c: CSA batch scrambling tests
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#undef NDEBUG
+#include <assert.h>
+
+#include <vlc_common.h>
+
+#include "../../../modules/mux/mpeg/csa.h"
+
+const char vlc_module_name[] = "test_csa";
+
+static const unsigned lanes[] = { 64, 128, 256 };
+static const size_t counts[] = { 1, 7, 8, 63, 64, 65, 129, 256, 1000 };
+static const int sizes[] = { 188, 100, 13 };
+
+/* Checks that the batch output matches csa_Encrypt() packet by packet */
+static bool check(csa_t *c, unsigned lane_count, size_t count, int size)
+{
+    uint8_t *ref = malloc(count * 188);
+    uint8_t *pkt = malloc(count * 188);
+    uint8_t **pkts = calloc(count, sizeof (*pkts));
+
+    assert(ref != NULL && pkt != NULL && pkts != NULL);
+
+    for (size_t i = 0; i < count * 188; i++)
+        ref[i] = rand();
+    for (size_t i = 0; i < count; i++)
+    {
+        uint8_t *p = &ref[188 * i];
+
+        p[0] = 0x47;
+        /* payload only, or adaptation field of any length */
+        p[3] = rand() % 2 ? 0x10 : 0x30;
+        p[4] %= 184;
+        pkts[i] = &pkt[188 * i];
+    }
+    memcpy(pkt, ref, count * 188);
+
+    for (size_t i = 0; i < count; i++)
+        csa_Encrypt(c, &ref[188 * i], size);
+
+    bool supported = csa_EncryptBatchLanes(c, pkts, count, size,
+                                           lane_count) == VLC_SUCCESS;
+    if (supported)
+        for (size_t i = 0; i < count; i++)
+        {
+            if (memcmp(&ref[188 * i], &pkt[188 * i], 188))
+                fprintf(stderr, "%u lanes: packet %zu of %zu (%d bytes) "
+                        "differs\n", lane_count, i, count, size);
+            assert(!memcmp(&ref[188 * i], &pkt[188 * i], 188));
+        }
+
+    free(pkts);
+    free(pkt);
+    free(ref);
+    return supported;
+}
+
+int main(void)
+{
+    char odd[] = "0x0123456789abcdef";
+    char even[] = "f0e1d2c3b4a59687";
+
+    srand(0);
+
+    csa_t *c = csa_New();
+    assert(c != NULL);
+    assert(csa_SetCW(NULL, c, odd, true) == VLC_SUCCESS);
+    assert(csa_SetCW(NULL, c, even, false) == VLC_SUCCESS);
+
+    for (size_t l = 0; l < ARRAY_SIZE(lanes); l++)
+    {
+        if (!check(c, lanes[l], 1, 188))
+        {
+            /* The portable version is always available */
+            assert(lanes[l] != 64);
+            fprintf(stderr, "%u lanes: not supported, skipped\n", lanes[l]);
+            continue;
+        }
+
+        for (size_t i = 0; i < ARRAY_SIZE(counts); i++)
+            for (size_t j = 0; j < ARRAY_SIZE(sizes); j++)
+            {
+                csa_UseKey(NULL, c, false);
+                check(c, lanes[l], counts[i], sizes[j]);
+                csa_UseKey(NULL, c, true);
+                check(c, lanes[l], counts[i], sizes[j]);
+            }
+    }
+
+    /* Unknown widths are rejected */
+    uint8_t pkt[188] = { 0x47 };
+    uint8_t *pkts[] = { pkt };
+    assert(csa_EncryptBatchLanes(c, pkts, 1, 188, 32) == VLC_EGENERIC);
+
+    csa_Delete(c);
+    return 0;
+}
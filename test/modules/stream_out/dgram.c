@@ -0,0 +1,130 @@
+/*****************************************************************************
+ * dgram.c: datagram pacer unit tests
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#undef NDEBUG
+
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_tick.h>
+
+#include "../modules/stream_out/dgram.h"
+
+#define MTU  1500
+#define SIZE 1000
+
+/* Sends count datagrams of SIZE bytes, returns the time it took */
+static vlc_tick_t Send(struct vlc_pacer *pacer, unsigned count)
+{
+    size_t sizes[64];
+    vlc_tick_t start = vlc_tick_now();
+
+    for (size_t i = 0; i < ARRAY_SIZE(sizes); i++)
+        sizes[i] = SIZE;
+
+    while (count > 0)
+    {
+        unsigned n = vlc_pacer_Take(pacer, sizes,
+                                    __MIN(count, ARRAY_SIZE(sizes)));
+        assert(n >= 1 && n <= __MIN(count, ARRAY_SIZE(sizes)));
+        count -= n;
+    }
+    return vlc_tick_now() - start;
+}
+
+static void test_unpaced(void)
+{
+    struct vlc_pacer pacer;
+    size_t sizes[16];
+
+    vlc_pacer_Init(&pacer, 0, MTU);
+    assert(pacer.rate == 0);
+
+    for (size_t i = 0; i < ARRAY_SIZE(sizes); i++)
+        sizes[i] = 64 * 1024;
+
+    /* Everything goes at once, however large */
+    for (int i = 0; i < 1000; i++)
+        assert(vlc_pacer_Take(&pacer, sizes, ARRAY_SIZE(sizes))
+               == ARRAY_SIZE(sizes));
+}
+
+static void test_depth(void)
+{
+    struct vlc_pacer pacer;
+    size_t sizes[16];
+
+    for (size_t i = 0; i < ARRAY_SIZE(sizes); i++)
+        sizes[i] = SIZE;
+
+    /* 1 MB/s: the bucket holds 10 ms of data */
+    vlc_pacer_Init(&pacer, 8000000, MTU);
+    assert(pacer.rate == 1000000);
+    assert(pacer.burst == 10000);
+    assert(pacer.tokens == pacer.burst);
+
+    /* A full bucket lets a burst through, without waiting */
+    assert(vlc_pacer_Take(&pacer, sizes, ARRAY_SIZE(sizes)) == 10);
+    assert(pacer.tokens == 0);
+
+    /* 10 kB/s: the bucket still holds a few full size datagrams */
+    vlc_pacer_Init(&pacer, 80000, MTU);
+    assert(pacer.rate == 10000);
+    assert(pacer.burst == 4 * MTU);
+    assert(vlc_pacer_Take(&pacer, sizes, ARRAY_SIZE(sizes)) == 6);
+
+    /* A datagram larger than the bucket is sent when the bucket is full */
+    vlc_pacer_Init(&pacer, 8000000, MTU);
+    sizes[0] = 3 * pacer.burst;
+    assert(vlc_pacer_Take(&pacer, sizes, ARRAY_SIZE(sizes)) == 1);
+    assert(pacer.tokens == 0);
+}
+
+static void test_rate(void)
+{
+    struct vlc_pacer pacer;
+
+    /* 1 MB/s: 100 kB take at least 90 ms once the first 10 kB burst is
+     * gone, however the datagrams are grouped */
+    vlc_pacer_Init(&pacer, 8000000, MTU);
+    vlc_tick_t elapsed = Send(&pacer, 100);
+    assert(elapsed >= VLC_TICK_FROM_MS(90));
+
+    /* The same again, now that the bucket starts empty */
+    elapsed = Send(&pacer, 100);
+    assert(elapsed >= VLC_TICK_FROM_MS(100) - VLC_TICK_FROM_MS(1));
+
+    /* An idle period refills the bucket up to its depth only */
+    vlc_tick_wait(vlc_tick_now() + VLC_TICK_FROM_MS(50));
+    elapsed = Send(&pacer, 30);
+    assert(elapsed >= VLC_TICK_FROM_MS(20) - VLC_TICK_FROM_MS(1));
+}
+
+int main(void)
+{
+    test_unpaced();
+    test_depth();
+    test_rate();
+    return 0;
+}
@@ -0,0 +1,176 @@
+/*****************************************************************************
+ * blend_kernels.c: line blending kernels tests
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#undef NDEBUG
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+
+#include "../../../modules/video_filter/blend_kernels.h"
+
+#define MAX_SAMPLES 100
+
+static const unsigned alphas[] = { 1, 77, 128, 255 };
+static const unsigned offsets[][3] = {
+    { 0, 1, 2 }, { 2, 1, 0 }, { 1, 2, 3 }, { 3, 2, 1 },
+};
+
+/* Same formulas as the generic blender */
+static unsigned Merge(unsigned d, unsigned s, unsigned sa, unsigned alpha)
+{
+    unsigned a = alpha * sa;
+    a = ((a >> 8) + a + 1) >> 8;
+    if (a == 0)
+        return d;
+    const unsigned v = (255 - a) * d + s * a;
+    return ((v >> 8) + v + 1) >> 8;
+}
+
+static void Fill(uint8_t *buf, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+        buf[i] = rand();
+}
+
+/* Alpha with transparent and opaque runs, to exercise the skipped blocks */
+static void FillAlpha(uint8_t *buf, size_t size, size_t stride)
+{
+    for (size_t i = 0; i < size; i += stride)
+    {
+        const int run = (i / 16 / stride) % 4;
+        buf[i] = run == 0 ? 0 : run == 1 ? 255 : rand();
+    }
+}
+
+/* Exactly sized copies, so that over-reads can be caught by sanitizers */
+static uint8_t *Dup(const uint8_t *buf, size_t size)
+{
+    uint8_t *dup = calloc(1, size ? size : 1);
+    assert(dup != NULL);
+    memcpy(dup, buf, size);
+    return dup;
+}
+
+static void CheckPlane(const struct blend_kernels *k, unsigned n, unsigned alpha)
+{
+    uint8_t d[MAX_SAMPLES], s[MAX_SAMPLES], a[MAX_SAMPLES];
+    Fill(d, n);
+    Fill(s, n);
+    Fill(a, n);
+    FillAlpha(a, n, 1);
+
+    uint8_t *dst = Dup(d, n), *src = Dup(s, n), *src_a = Dup(a, n);
+    k->plane(dst, src, src_a, alpha, n);
+    for (unsigned i = 0; i < n; i++)
+        assert(dst[i] == Merge(d[i], s[i], a[i], alpha));
+    free(dst);
+    free(src);
+    free(src_a);
+}
+
+static void CheckChroma(const struct blend_kernels *k, unsigned n, unsigned alpha)
+{
+    const size_t size = n ? 2 * n - 1 : 0;
+    uint8_t du[MAX_SAMPLES], dv[MAX_SAMPLES], duv[2 * MAX_SAMPLES];
+    uint8_t su[2 * MAX_SAMPLES], sv[2 * MAX_SAMPLES], a[2 * MAX_SAMPLES];
+    Fill(du, n);
+    Fill(dv, n);
+    Fill(duv, 2 * n);
+    Fill(su, size);
+    Fill(sv, size);
+    Fill(a, size);
+    FillAlpha(a, size, 2);
+
+    uint8_t *dst_u = Dup(du, n), *dst_v = Dup(dv, n), *dst_uv = Dup(duv, 2 * n);
+    uint8_t *src_u = Dup(su, size), *src_v = Dup(sv, size), *src_a = Dup(a, size);
+
+    k->chroma_planar(dst_u, dst_v, src_u, src_v, src_a, alpha, n);
+    k->chroma_packed(dst_uv, src_u, src_v, src_a, alpha, n);
+    for (unsigned i = 0; i < n; i++)
+    {
+        assert(dst_u[i] == Merge(du[i], su[2 * i], a[2 * i], alpha));
+        assert(dst_v[i] == Merge(dv[i], sv[2 * i], a[2 * i], alpha));
+        assert(dst_uv[2 * i] == Merge(duv[2 * i], su[2 * i], a[2 * i], alpha));
+        assert(dst_uv[2 * i + 1] == Merge(duv[2 * i + 1], sv[2 * i], a[2 * i], alpha));
+    }
+    free(dst_u);
+    free(dst_v);
+    free(dst_uv);
+    free(src_u);
+    free(src_v);
+    free(src_a);
+}
+
+static void CheckRgbx(const struct blend_kernels *k, unsigned n, unsigned alpha,
+                      const unsigned off[3])
+{
+    uint8_t d[4 * MAX_SAMPLES], s[4 * MAX_SAMPLES];
+    Fill(d, 4 * n);
+    Fill(s, 4 * n);
+    FillAlpha(&s[3], n ? 4 * n - 3 : 0, 4);
+
+    uint8_t *dst = Dup(d, 4 * n), *src = Dup(s, 4 * n);
+    k->rgbx(dst, src, alpha, n, off);
+    for (unsigned i = 0; i < n; i++)
+    {
+        const uint8_t *sp = &s[4 * i], *dp = &d[4 * i];
+        uint8_t expected[4];
+        memcpy(expected, dp, 4);
+        for (unsigned c = 0; c < 3; c++)
+            expected[off[c]] = Merge(dp[off[c]], sp[c], sp[3], alpha);
+        assert(!memcmp(&dst[4 * i], expected, 4));
+    }
+    free(dst);
+    free(src);
+}
+
+static void Check(const struct blend_kernels *k)
+{
+    fprintf(stderr, "checking %s kernels\n", k->name);
+
+    for (unsigned n = 0; n <= MAX_SAMPLES; n++)
+    {
+        for (size_t i = 0; i < ARRAY_SIZE(alphas); i++)
+        {
+            CheckPlane(k, n, alphas[i]);
+            CheckChroma(k, n, alphas[i]);
+            for (size_t j = 0; j < ARRAY_SIZE(offsets); j++)
+                CheckRgbx(k, n, alphas[i], offsets[j]);
+        }
+    }
+}
+
+int main(void)
+{
+    srand(0);
+
+    const unsigned cpu = vlc_CPU();
+    Check(blend_kernels_Get(cpu));
+#ifdef VLC_CPU_AVX2
+    /* The AVX2 kernels hand their tails to the SSE4.1 ones */
+    Check(blend_kernels_Get(cpu & ~VLC_CPU_AVX2));
+#endif
+    Check(&blend_kernels_c);
+    return 0;
+}
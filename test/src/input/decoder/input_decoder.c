@@ -34,6 +34,7 @@
 #include <vlc_access.h>
 #include <vlc_demux.h>
 #include <vlc_codec.h>
+#include <vlc_aout.h>
 #include <vlc_window.h>
 #include <vlc_interface.h>
 #include <vlc_player.h>
@@ -93,6 +94,15 @@ static int DecoderDecode(decoder_t *dec, block_t *block)
     return ret;
 }
 
+static int AudioDecoderDecode(decoder_t *dec, block_t *block)
+{
+    if (block == NULL)
+        return VLC_SUCCESS;
+
+    struct input_decoder_scenario *scenario = &input_decoder_scenarios[current_scenario];
+    return scenario->decoder_decode_audio(dec, block);
+}
+
 static void DecoderFlush(decoder_t *dec)
 {
     struct input_decoder_scenario *scenario = &input_decoder_scenarios[current_scenario];
@@ -137,6 +147,25 @@ static int OpenDecoder(vlc_object_t *obj)
     return VLC_SUCCESS;
 }
 
+static int OpenAudioDecoder(vlc_object_t *obj)
+{
+    decoder_t *dec = (decoder_t*)obj;
+
+    struct input_decoder_scenario *scenario = &input_decoder_scenarios[current_scenario];
+    if (scenario->decoder_decode_audio == NULL)
+        return VLC_EGENERIC;
+
+    /* The mock demux sends raw samples, pass them through */
+    dec->pf_decode = AudioDecoderDecode;
+    if (scenario->decoder_flush != NULL)
+        dec->pf_flush = DecoderFlush;
+    es_format_Clean(&dec->fmt_out);
+    es_format_Copy(&dec->fmt_out, dec->fmt_in);
+    dec->fmt_out.audio.i_format = dec->fmt_out.i_codec;
+
+    return VLC_SUCCESS;
+}
+
 static void DisplayPrepare(vout_display_t *vd, picture_t *picture,
         subpicture_t *subpic, vlc_tick_t date)
 {
@@ -176,6 +205,58 @@ static int OpenWindow(vlc_window_t *wnd)
     return VLC_SUCCESS;
 }
 
+static int AoutStart(audio_output_t *aout, audio_sample_format_t *restrict fmt)
+{
+    (void)aout;
+
+    if (!AOUT_FMT_LINEAR(fmt))
+        return VLC_EGENERIC;
+
+    fmt->i_format = VLC_CODEC_FL32;
+    fmt->channel_type = AUDIO_CHANNEL_TYPE_BITMAP;
+    return VLC_SUCCESS;
+}
+
+static void AoutStop(audio_output_t *aout)
+    { VLC_UNUSED(aout); }
+
+static int AoutTimeGet(audio_output_t *aout, vlc_tick_t *restrict delay)
+{
+    (void)aout; (void)delay;
+    return -1;
+}
+
+static void AoutPlay(audio_output_t *aout, block_t *block, vlc_tick_t date)
+{
+    (void)date;
+
+    struct input_decoder_scenario *scenario = &input_decoder_scenarios[current_scenario];
+    if (scenario->aout_play != NULL)
+        scenario->aout_play(aout, block);
+    else
+        block_Release(block);
+}
+
+static void AoutPause(audio_output_t *aout, bool paused, vlc_tick_t date)
+{
+    (void)aout; (void)paused; (void)date;
+}
+
+static int OpenAout(vlc_object_t *obj)
+{
+    audio_output_t *aout = (audio_output_t *)obj;
+
+    aout->start = AoutStart;
+    aout->stop = AoutStop;
+    aout->time_get = AoutTimeGet;
+    aout->play = AoutPlay;
+    aout->pause = AoutPause;
+    aout->flush = AoutStop;
+    aout->volume_set = NULL;
+    aout->mute_set = NULL;
+    return VLC_SUCCESS;
+}
+
 static void *SoutFilterAdd(sout_stream_t *stream, const es_format_t *fmt)
 {
     (void)stream; (void)fmt;
@@ -242,6 +323,13 @@ static void play_scenario(intf_thread_t *intf, struct input_decoder_scenario *sc
         free(sout);
     }
 
+    if (scenario->options != NULL)
+    {
+        for (const char *const *option = scenario->options; *option != NULL;
+             option++)
+            input_item_AddOption(media, *option, VLC_INPUT_OPTION_TRUSTED);
+    }
+
     vlc_player_t *player = vlc_player_New(&intf->obj,
         VLC_PLAYER_LOCK_NORMAL, NULL, NULL);
     assert(player);
@@ -296,6 +384,7 @@ static int OpenIntf(vlc_object_t *obj)
  * Inject the mocked modules as a static plugin:
  *  - access for triggering the correct decoder
  *  - decoder for generating video format and context
+ *  - audio decoder and output for the audio scenarios
  *  - filter for generating video format and context
  **/
 vlc_module_begin()
@@ -311,6 +400,14 @@ vlc_module_begin()
         set_callbacks(OpenDecoder, CloseDecoder)
         set_capability("video decoder", INT_MAX)
 
+    add_submodule()
+        set_callbacks(OpenAudioDecoder, CloseDecoder)
+        set_capability("audio decoder", INT_MAX)
+
+    add_submodule()
+        set_callback(OpenAout)
+        set_capability("audio output", 0)
+
     add_submodule()
         set_callback(OpenWindow)
         set_capability("vout window", INT_MAX)
@@ -338,7 +435,7 @@ int main( int argc, char **argv )
         "-vvv",
         "--vout=" MODULE_STRING,
         "--dec-dev=" MODULE_STRING,
-        "--aout=dummy",
+        "--aout=" MODULE_STRING,
         "--text-renderer=dummy",
         "--no-auto-preparse",
         "--no-spu",
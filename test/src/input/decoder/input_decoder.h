@@ -31,11 +31,14 @@ typedef struct intf_thread_t intf_thread_t;
 struct input_decoder_scenario {
     const char *source;
     const char *sout;
+    const char *const *options; /* NULL-terminated input item options */
     void (*decoder_setup)(decoder_t *);
     void (*decoder_destroy)(decoder_t *);
     int (*decoder_decode)(decoder_t *, picture_t *);
+    int (*decoder_decode_audio)(decoder_t *, block_t *);
     void (*decoder_flush)(decoder_t *);
     void (*display_prepare)(vout_display_t *vd, picture_t *pic);
+    void (*aout_play)(audio_output_t *aout, block_t *block);
     void (*interface_setup)(intf_thread_t *intf);
     int (*sout_filter_send)(sout_stream_t *stream, void *id, block_t *block);
     void (*sout_filter_flush)(sout_stream_t *stream, void *id);
@@ -31,8 +31,11 @@
 #include <vlc_player.h>
 #include <vlc_interface.h>
 #include <vlc_codec.h>
+#include <vlc_aout.h>
 #include <vlc_vout_display.h>
 
+#include <stdatomic.h>
+
 #include "input_decoder.h"
 
 static struct scenario_data
@@ -40,11 +43,17 @@ static struct scenario_data
     vlc_sem_t wait_stop;
     vlc_sem_t display_prepare_signal;
     vlc_sem_t wait_ready_to_flush;
+    vlc_sem_t wait_audio_queued;
     struct vlc_video_context *decoder_vctx;
     bool skip_decoder;
     bool has_reload;
     bool stream_out_sent;
     size_t decoder_image_sent;
+    size_t audio_queued;
+    size_t audio_played;
+    atomic_bool video_started;
+    atomic_uint decoding;
+    vlc_tick_t last_date;
 } scenario_data;
 
 static void decoder_fixed_size(decoder_t *dec, vlc_fourcc_t chroma,
@@ -96,6 +105,7 @@ struct picture_watcher_context {
     vlc_sem_t wait_picture;
     vlc_sem_t wait_prepare;
     vlc_atomic_rc_t rc;
+    bool stale; /* must never be displayed */
 };
 
 static void context_destroy(picture_context_t *context)
@@ -122,6 +132,27 @@ static int decoder_decode_drop(decoder_t *dec, picture_t *pic)
     return VLC_SUCCESS;
 }
 
+static int decoder_decode_audio_check_serial(decoder_t *dec, block_t *block)
+{
+    (void)dec;
+
+    /* Pooled decoders may run from any worker thread, but never
+     * concurrently with themselves, and in order. */
+    unsigned decoding = atomic_fetch_add(&scenario_data.decoding, 1);
+    assert(decoding == 0);
+    assert(block->i_pts > scenario_data.last_date);
+    scenario_data.last_date = block->i_pts;
+    block_Release(block);
+
+    /* Go past a few scheduling quanta, so that the decoder is requeued */
+    if (++scenario_data.decoder_image_sent == 64)
+        vlc_sem_post(&scenario_data.wait_stop);
+
+    atomic_fetch_sub(&scenario_data.decoding, 1);
+    (void)decoding;
+    return VLC_SUCCESS;
+}
+
 static int decoder_decode_check_flush_video(decoder_t *dec, picture_t *pic)
 {
     if (scenario_data.skip_decoder)
@@ -210,6 +241,174 @@ static int decoder_decode_check_flush_video(decoder_t *dec, picture_t *pic)
     return VLC_SUCCESS;
 }
 
+static int decoder_decode_check_flush_queue(decoder_t *dec, picture_t *pic)
+{
+    if (scenario_data.skip_decoder)
+    {
+        picture_Release(pic);
+        return VLC_SUCCESS;
+    }
+
+    if (scenario_data.decoder_image_sent == 0)
+    {
+        int ret = decoder_UpdateVideoOutput(dec, NULL);
+        assert(ret == VLC_SUCCESS);
+    }
+
+    /* See decoder_decode_check_flush_video() */
+    if (scenario_data.decoder_image_sent < 3)
+    {
+        decoder_QueueVideo(dec, pic);
+        scenario_data.decoder_image_sent++;
+        return VLC_SUCCESS;
+    }
+
+    struct picture_watcher_context shown = {
+        .context.destroy = context_destroy,
+        .context.copy = context_copy,
+    };
+    vlc_sem_init(&shown.wait_picture, 0);
+    vlc_atomic_rc_init(&shown.rc);
+
+    picture_t *shown_pic = picture_Clone(pic);
+    shown_pic->b_force = true;
+    shown_pic->date = VLC_TICK_0;
+    shown_pic->b_progressive = true;
+    shown_pic->context = &shown.context;
+
+    msg_Info(dec, "Wait for the output stage to display a picture");
+    decoder_QueueVideo(dec, shown_pic);
+    vlc_sem_wait(&shown.wait_prepare);
+
+    /* Not due before the flush: it is either still in the output queue,
+     * being handed to the vout by the output stage, or in the vout. It
+     * must be dropped in every case, the generation check covering the
+     * second one. */
+    struct picture_watcher_context stale = {
+        .context.destroy = context_destroy,
+        .context.copy = context_copy,
+        .stale = true,
+    };
+    vlc_sem_init(&stale.wait_picture, 0);
+    vlc_atomic_rc_init(&stale.rc);
+
+    picture_t *stale_pic = picture_Clone(pic);
+    stale_pic->date = VLC_TICK_0 + VLC_TICK_FROM_SEC(3600);
+    stale_pic->b_progressive = true;
+    stale_pic->context = &stale.context;
+    decoder_QueueVideo(dec, stale_pic);
+
+    msg_Info(dec, "Trigger decoder and output flush");
+    vlc_sem_post(&scenario_data.wait_ready_to_flush);
+
+    msg_Info(dec, "Wait for the queued pictures to be dropped");
+    vlc_sem_wait(&stale.wait_picture);
+    vlc_sem_wait(&shown.wait_picture);
+
+    picture_Release(pic);
+    scenario_data.skip_decoder = true;
+    return VLC_SUCCESS;
+}
+
+static int decoder_decode_audio_queue(decoder_t *dec, block_t *block)
+{
+    /* Like most audio decoders, check the output format for every frame:
+     * this must not wait for the output stage when nothing changed */
+    if (decoder_UpdateAudioFormat(dec) != VLC_SUCCESS)
+    {
+        block_Release(block);
+        return VLCDEC_SUCCESS;
+    }
+
+    decoder_QueueAudio(dec, block);
+    if (++scenario_data.audio_queued == 3)
+        vlc_sem_post(&scenario_data.wait_audio_queued);
+    return VLCDEC_SUCCESS;
+}
+
+static int decoder_decode_audio_flush(decoder_t *dec, block_t *block)
+{
+    (void)dec;
+    block_Release(block);
+
+    if (++scenario_data.audio_queued == 3)
+        vlc_sem_post(&scenario_data.wait_ready_to_flush);
+    return VLCDEC_SUCCESS;
+}
+
+static int decoder_decode_audio_stop(decoder_t *dec, block_t *block)
+{
+    (void)dec;
+    block_Release(block);
+
+    /* Stop while the decoder is still being fed */
+    if (++scenario_data.audio_queued == 1)
+        vlc_sem_post(&scenario_data.wait_stop);
+    return VLCDEC_SUCCESS;
+}
+
+static int decoder_decode_audio_buffering(decoder_t *dec, block_t *block)
+{
+    if (decoder_UpdateAudioFormat(dec) != VLC_SUCCESS)
+    {
+        block_Release(block);
+        return VLCDEC_SUCCESS;
+    }
+
+    decoder_QueueAudio(dec, block);
+    if (++scenario_data.audio_queued == 1)
+        vlc_sem_post(&scenario_data.wait_audio_queued);
+    return VLCDEC_SUCCESS;
+}
+
+static int decoder_decode_video_buffering(decoder_t *dec, picture_t *pic)
+{
+    if (scenario_data.decoder_image_sent == 0)
+    {
+        int ret = decoder_UpdateVideoOutput(dec, NULL);
+        assert(ret == VLC_SUCCESS);
+        (void)ret;
+
+        /* The buffering cannot end before this decoder outputs pictures,
+         * so the first audio buffer is output while buffering */
+        msg_Info(dec, "Wait for the audio decoder to output a buffer");
+        vlc_sem_wait(&scenario_data.wait_audio_queued);
+        atomic_store(&scenario_data.video_started, true);
+    }
+
+    scenario_data.decoder_image_sent++;
+    decoder_QueueVideo(dec, pic);
+    return VLC_SUCCESS;
+}
+
+static void aout_play_check_buffering(audio_output_t *aout, block_t *block)
+{
+    (void)aout;
+    block_Release(block);
+
+    /* A pooled decoder does not wait for the end of the buffering, its
+     * output is held until then */
+    assert(atomic_load(&scenario_data.video_started));
+    if (scenario_data.audio_played++ == 0)
+        vlc_sem_post(&scenario_data.wait_stop);
+}
+
+static void aout_play_wait_queue(audio_output_t *aout, block_t *block)
+{
+    block_Release(block);
+    if (scenario_data.audio_played++ > 0)
+        return;
+
+    /* The decoder keeps queueing buffers while the output stage is busy
+     * playing the first one */
+    msg_Info(aout, "Wait for more buffers to be queued while playing");
+    int ret = vlc_sem_timedwait(&scenario_data.wait_audio_queued,
+                                vlc_tick_now() + VLC_TICK_FROM_SEC(10));
+    assert(ret == 0);
+    (void)ret;
+    vlc_sem_post(&scenario_data.wait_stop);
+}
+
 static void decoder_flush_signal(decoder_t *dec)
 {
     (void)dec;
@@ -256,6 +455,7 @@ static void display_prepare_signal(vout_display_t *vd, picture_t *pic)
     msg_Info(vd, "Signal that the frame has been prepared from display");
     struct picture_watcher_context *watcher =
         container_of(pic->context, struct picture_watcher_context, context);
+    assert(!watcher->stale);
     vlc_sem_post(&watcher->wait_prepare);
 }
 
@@ -325,6 +525,14 @@ static void sout_filter_flush(sout_stream_t *stream, void *id)
 }
 
 const char source_800_600[] = "mock://video_track_count=1;length=100000000000;video_width=800;video_height=600";
+const char source_audio[] = "mock://audio_track_count=1;length=100000000000";
+const char source_audio_800_600[] = "mock://audio_track_count=1;video_track_count=1;length=100000000000;video_width=800;video_height=600";
+static const char *const options_pooled[] = {
+    ":dec-pool-threads=2", NULL
+};
+static const char *const options_output_queue[] = {
+    ":dec-output-queue=4", NULL
+};
 struct input_decoder_scenario input_decoder_scenarios[] =
 {{
     .source = source_800_600,
@@ -371,6 +579,58 @@ struct input_decoder_scenario input_decoder_scenarios[] =
     .decoder_setup = decoder_i420_800_600,
     .decoder_decode = decoder_decode_trigger_reload,
     .decoder_destroy = decoder_destroy_trigger_update,
+},
+{
+    /* Check that a decoder running from the shared worker pool decodes
+     * its frames one at a time and in order, across scheduling quanta. */
+    .source = source_audio,
+    .options = options_pooled,
+    .decoder_decode_audio = decoder_decode_audio_check_serial,
+},
+{
+    /* Check that a pooled decoder is flushed */
+    .source = source_audio,
+    .options = options_pooled,
+    .decoder_decode_audio = decoder_decode_audio_flush,
+    .decoder_flush = decoder_flush_signal,
+    .interface_setup = interface_setup_check_flush,
+},
+{
+    /* Check that a pooled decoder can be deleted while it is decoding,
+     * its pending task being canceled or waited for. */
+    .source = source_audio,
+    .options = options_pooled,
+    .decoder_decode_audio = decoder_decode_audio_stop,
+},
+{
+    /* Check that the output of a pooled decoder is not played before the
+     * end of the buffering, which waits for the video decoder here. */
+    .source = source_audio_800_600,
+    .options = options_pooled,
+    .decoder_setup = decoder_i420_800_600,
+    .decoder_decode = decoder_decode_video_buffering,
+    .decoder_decode_audio = decoder_decode_audio_buffering,
+    .display_prepare = display_prepare_signal,
+    .aout_play = aout_play_check_buffering,
+},
+{
+    /* Check that pictures decoded before a flush are dropped by the output
+     * stage and never displayed. */
+    .source = source_800_600,
+    .options = options_output_queue,
+    .decoder_setup = decoder_i420_800_600,
+    .decoder_decode = decoder_decode_check_flush_queue,
+    .decoder_flush = decoder_flush_signal,
+    .display_prepare = display_prepare_signal,
+    .interface_setup = interface_setup_check_flush,
+},
+{
+    /* Check that an audio decoder updating its output format for every
+     * frame keeps queueing buffers while the output stage plays. */
+    .source = source_audio,
+    .options = options_output_queue,
+    .decoder_decode_audio = decoder_decode_audio_queue,
+    .aout_play = aout_play_wait_queue,
 }};
 size_t input_decoder_scenarios_count = ARRAY_SIZE(input_decoder_scenarios);
 
@@ -381,9 +641,15 @@ void input_decoder_scenario_init(void)
     scenario_data.has_reload = false;
     scenario_data.stream_out_sent = false;
     scenario_data.decoder_image_sent = 0;
+    scenario_data.audio_queued = 0;
+    scenario_data.audio_played = 0;
+    atomic_init(&scenario_data.video_started, false);
+    atomic_init(&scenario_data.decoding, 0);
+    scenario_data.last_date = VLC_TICK_INVALID;
     vlc_sem_init(&scenario_data.wait_stop, 0);
     vlc_sem_init(&scenario_data.display_prepare_signal, 0);
     vlc_sem_init(&scenario_data.wait_ready_to_flush, 0);
+    vlc_sem_init(&scenario_data.wait_audio_queued, 0);
 }
 
 void input_decoder_scenario_wait(intf_thread_t *intf, struct input_decoder_scenario *scenario)
@@ -0,0 +1,227 @@
+/*****************************************************************************
+ * timeshift.c: test for the timeshift es_out
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "../../libvlc/test.h"
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_es_out.h>
+#include <vlc_block.h>
+#include "../../../lib/libvlc_internal.h"
+
+#include "input/input_internal.h"
+#include "input/es_out.h"
+
+#include <vlc/vlc.h>
+
+/* 15 blocks fit in a 1 MiB timeshift file */
+#define BLOCK_SIZE      (64 * 1024)
+#define BLOCK_COUNT     60
+#define BLOCK_INTERVAL  VLC_TICK_FROM_MS(20)
+#define BLOCKS_PER_FILE 15
+
+/* The timeshift es_out is run alone, without an input thread */
+bool input_CanPaceControl(input_thread_t *input)
+{
+    (void) input;
+    return false;
+}
+
+/* Output receiving the commands played from the timeshift files */
+static struct
+{
+    es_out_t out;
+    vlc_mutex_t lock;
+    vlc_cond_t wait;
+    int es;
+    vlc_tick_t last; /* DTS of the last block */
+    vlc_tick_t first; /* DTS of the first block after the last reset */
+    bool reset;
+} sink;
+
+static es_out_id_t *SinkAdd(es_out_t *out, input_source_t *in,
+                            const es_format_t *fmt)
+{
+    (void) out; (void) in; (void) fmt;
+    return (es_out_id_t *)&sink.es;
+}
+
+static int SinkSend(es_out_t *out, es_out_id_t *es, block_t *block)
+{
+    (void) out;
+    assert(es == (es_out_id_t *)&sink.es);
+
+    vlc_mutex_lock(&sink.lock);
+    if (sink.reset)
+    {
+        sink.first = block->i_dts;
+        sink.reset = false;
+    }
+    sink.last = block->i_dts;
+    vlc_cond_signal(&sink.wait);
+    vlc_mutex_unlock(&sink.lock);
+
+    block_Release(block);
+    return VLC_SUCCESS;
+}
+
+static void SinkDel(es_out_t *out, es_out_id_t *es)
+{
+    (void) out;
+    assert(es == (es_out_id_t *)&sink.es);
+}
+
+static int SinkControl(es_out_t *out, input_source_t *in, int query,
+                       va_list args)
+{
+    (void) out; (void) in;
+
+    switch (query)
+    {
+        case ES_OUT_RESET_PCR:
+            vlc_mutex_lock(&sink.lock);
+            sink.reset = true;
+            sink.first = VLC_TICK_INVALID;
+            vlc_mutex_unlock(&sink.lock);
+            break;
+        case ES_OUT_GET_EMPTY:
+            *va_arg(args, bool *) = true;
+            break;
+    }
+    return VLC_SUCCESS;
+}
+
+static int SinkPrivControl(es_out_t *out, int query, va_list args)
+{
+    (void) out;
+
+    if (query == ES_OUT_PRIV_GET_BUFFERING)
+        *va_arg(args, bool *) = false;
+    return VLC_SUCCESS;
+}
+
+static void SinkDestroy(es_out_t *out)
+{
+    (void) out;
+}
+
+static const struct es_out_callbacks sink_cbs =
+{
+    .add = SinkAdd,
+    .send = SinkSend,
+    .del = SinkDel,
+    .control = SinkControl,
+    .destroy = SinkDestroy,
+    .priv_control = SinkPrivControl,
+};
+
+static vlc_tick_t Jump(es_out_t *out, vlc_tick_t jump)
+{
+    vlc_mutex_lock(&sink.lock);
+    sink.first = VLC_TICK_INVALID;
+    vlc_mutex_unlock(&sink.lock);
+
+    int ret = es_out_JumpTimeshift(out, jump);
+    assert(ret == VLC_SUCCESS);
+
+    /* Return the first block played from the new position */
+    vlc_mutex_lock(&sink.lock);
+    while (sink.first == VLC_TICK_INVALID)
+        vlc_cond_wait(&sink.wait, &sink.lock);
+    vlc_tick_t first = sink.first;
+    vlc_mutex_unlock(&sink.lock);
+    return first;
+}
+
+int main(void)
+{
+    static const char *argv[] = {
+        "-v",
+        "--input-timeshift-granularity=1048576",
+        "--input-timeshift-history=16",
+    };
+
+    test_init();
+
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(argv), argv);
+    assert(vlc != NULL);
+
+    input_thread_t *input = vlc_object_create(vlc->p_libvlc_int,
+                                              sizeof (*input));
+    assert(input != NULL);
+
+    sink.out.cbs = &sink_cbs;
+    vlc_mutex_init(&sink.lock);
+    vlc_cond_init(&sink.wait);
+    sink.last = sink.first = VLC_TICK_INVALID;
+    sink.reset = false;
+
+    es_out_t *out = input_EsOutTimeshiftNew(input, &sink.out, 1.f);
+    assert(out != NULL);
+
+    es_format_t fmt;
+    es_format_Init(&fmt, VIDEO_ES, VLC_CODEC_H264);
+    es_out_id_t *es = es_out_Add(out, &fmt);
+    assert(es != NULL);
+
+    /* Pausing the input stores everything in the timeshift files */
+    int ret = es_out_SetPauseState(out, false, true, vlc_tick_now());
+    assert(ret == VLC_SUCCESS);
+
+    for (int i = 0; i < BLOCK_COUNT; i++)
+    {
+        block_t *block = block_Alloc(BLOCK_SIZE);
+        assert(block != NULL);
+        block->i_dts = block->i_pts = VLC_TICK_0 + i;
+        ret = es_out_Send(out, es, block);
+        assert(ret == VLC_SUCCESS);
+        vlc_tick_sleep(BLOCK_INTERVAL);
+    }
+
+    ret = es_out_SetPauseState(out, false, false, vlc_tick_now());
+    assert(ret == VLC_SUCCESS);
+
+    /* Once the third file is played, jump back to the start of the first
+     * one, that must still be kept */
+    vlc_mutex_lock(&sink.lock);
+    while (sink.last < VLC_TICK_0 + 2 * BLOCKS_PER_FILE)
+        vlc_cond_wait(&sink.wait, &sink.lock);
+    vlc_mutex_unlock(&sink.lock);
+
+    vlc_tick_t first = Jump(out, VLC_TICK_FROM_SEC(-60));
+    assert(first == VLC_TICK_0);
+
+    /* Jump ahead again, over the files played already and into the ones
+     * that were not */
+    first = Jump(out, BLOCK_INTERVAL * BLOCK_COUNT * 3 / 4);
+    assert(first > VLC_TICK_0 + BLOCKS_PER_FILE);
+
+    es_out_Delete(out);
+    vlc_object_delete(input);
+    libvlc_release(vlc);
+    return 0;
+}
@@ -0,0 +1,184 @@
+/*****************************************************************************
+ * fifo.c: test and benchmark of the frame FIFOs
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "../../libvlc/test.h"
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+#include <assert.h>
+#include <inttypes.h>
+#include <vlc_common.h>
+#include <vlc_frame.h>
+#include <vlc_tick.h>
+
+#define BENCH_FRAMES 200000
+
+static void test_spsc_single(void)
+{
+    vlc_spsc_fifo_t *fifo = vlc_spsc_fifo_New(3);
+    assert(fifo != NULL);
+    assert(vlc_spsc_fifo_GetCount(fifo) == 0);
+    assert(vlc_spsc_fifo_TryGet(fifo) == NULL);
+
+    /* Capacity is rounded up to a power of two */
+    vlc_frame_t *frames[4];
+    for (size_t i = 0; i < ARRAY_SIZE(frames); i++)
+    {
+        frames[i] = vlc_frame_Alloc(i + 1);
+        assert(frames[i] != NULL);
+        assert(vlc_spsc_fifo_Put(fifo, frames[i]));
+    }
+    assert(vlc_spsc_fifo_GetCount(fifo) == 4);
+    assert(vlc_spsc_fifo_GetBytes(fifo) == 1 + 2 + 3 + 4);
+
+    vlc_frame_t *extra = vlc_frame_Alloc(16);
+    assert(extra != NULL);
+    assert(!vlc_spsc_fifo_Put(fifo, extra));
+
+    assert(vlc_spsc_fifo_TryGet(fifo) == frames[0]);
+    assert(vlc_spsc_fifo_Get(fifo) == frames[1]);
+    assert(vlc_spsc_fifo_GetCount(fifo) == 2);
+    assert(vlc_spsc_fifo_GetBytes(fifo) == 3 + 4);
+    vlc_frame_Release(frames[0]);
+    vlc_frame_Release(frames[1]);
+
+    /* Wrap around */
+    assert(vlc_spsc_fifo_Put(fifo, extra));
+    assert(vlc_spsc_fifo_Get(fifo) == frames[2]);
+    vlc_frame_Release(frames[2]);
+
+    /* Frames queued before the kill are still delivered */
+    vlc_spsc_fifo_Kill(fifo);
+    assert(vlc_spsc_fifo_Get(fifo) == frames[3]);
+    vlc_frame_Release(frames[3]);
+    assert(vlc_spsc_fifo_GetCount(fifo) == 1);
+
+    /* Remaining frames are released with the queue */
+    vlc_spsc_fifo_Delete(fifo);
+
+    /* Capacities that cannot be rounded up nor allocated */
+    assert(vlc_spsc_fifo_New(SIZE_MAX) == NULL);
+    assert(vlc_spsc_fifo_New(SIZE_MAX / 2 + 2) == NULL);
+}
+
+struct bench
+{
+    vlc_spsc_fifo_t *spsc;
+    vlc_fifo_t *fifo;
+    unsigned count;
+};
+
+static void *spsc_producer(void *data)
+{
+    struct bench *b = data;
+
+    for (unsigned i = 0; i < b->count; i++)
+    {
+        vlc_frame_t *frame = vlc_frame_Alloc(0);
+        assert(frame != NULL);
+        frame->i_dts = i;
+
+        while (!vlc_spsc_fifo_Put(b->spsc, frame))
+            (vlc_tick_sleep)(VLC_TICK_FROM_US(50));
+    }
+    vlc_spsc_fifo_Kill(b->spsc);
+    return NULL;
+}
+
+static void *fifo_producer(void *data)
+{
+    struct bench *b = data;
+
+    for (unsigned i = 0; i < b->count; i++)
+    {
+        vlc_frame_t *frame = vlc_frame_Alloc(0);
+        assert(frame != NULL);
+        frame->i_dts = i;
+        vlc_fifo_Put(b->fifo, frame);
+    }
+    return NULL;
+}
+
+static vlc_tick_t bench_spsc(unsigned count)
+{
+    struct bench b = { .spsc = vlc_spsc_fifo_New(4096), .count = count };
+    vlc_thread_t th;
+    vlc_frame_t *frame;
+    unsigned received = 0;
+
+    assert(b.spsc != NULL);
+
+    vlc_tick_t start = vlc_tick_now();
+    if (vlc_clone(&th, spsc_producer, &b))
+        abort();
+
+    while ((frame = vlc_spsc_fifo_Get(b.spsc)) != NULL)
+    {
+        assert(frame->i_dts == (vlc_tick_t)received);
+        received++;
+        vlc_frame_Release(frame);
+    }
+    vlc_join(th, NULL);
+    vlc_tick_t duration = vlc_tick_now() - start;
+
+    assert(received == count);
+    vlc_spsc_fifo_Delete(b.spsc);
+    return duration;
+}
+
+static vlc_tick_t bench_fifo(unsigned count)
+{
+    struct bench b = { .fifo = vlc_fifo_New(), .count = count };
+    vlc_thread_t th;
+
+    assert(b.fifo != NULL);
+
+    vlc_tick_t start = vlc_tick_now();
+    if (vlc_clone(&th, fifo_producer, &b))
+        abort();
+
+    for (unsigned i = 0; i < count; i++)
+    {
+        vlc_frame_t *frame = vlc_fifo_Get(b.fifo);
+        assert(frame->i_dts == (vlc_tick_t)i);
+        vlc_frame_Release(frame);
+    }
+    vlc_join(th, NULL);
+    vlc_tick_t duration = vlc_tick_now() - start;
+
+    vlc_fifo_Delete(b.fifo);
+    return duration;
+}
+
+int main(void)
+{
+    test_init();
+
+    test_spsc_single();
+
+    vlc_tick_t spsc = bench_spsc(BENCH_FRAMES);
+    vlc_tick_t fifo = bench_fifo(BENCH_FRAMES);
+
+    printf("vlc_fifo:      %"PRId64" ns/frame\n",
+           NS_FROM_VLC_TICK(fifo) / BENCH_FRAMES);
+    printf("vlc_spsc_fifo: %"PRId64" ns/frame\n",
+           NS_FROM_VLC_TICK(spsc) / BENCH_FRAMES);
+    return 0;
+}
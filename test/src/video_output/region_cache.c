@@ -0,0 +1,262 @@
+/*****************************************************************************
+ * region_cache.c: test for the cache of converted subpicture regions
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "../../libvlc/test.h"
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_picture.h>
+
+#include "video_output/region_cache.h"
+
+#define WIDTH  64
+#define HEIGHT 32
+
+static void SetupFormat(video_format_t *fmt, vlc_fourcc_t chroma,
+                        unsigned width, unsigned height)
+{
+    video_format_Init(fmt, chroma);
+    video_format_Setup(fmt, chroma, width, height, width, height, 1, 1);
+}
+
+static picture_t *NewSource(const video_format_t *fmt, uint8_t value)
+{
+    picture_t *picture = picture_NewFromFormat(fmt);
+    assert(picture != NULL);
+    for (int i = 0; i < picture->i_planes; i++)
+        memset(picture->p[i].p_pixels, value,
+               picture->p[i].i_pitch * picture->p[i].i_lines);
+    return picture;
+}
+
+static picture_t *NewOutput(unsigned width, unsigned height)
+{
+    video_format_t fmt;
+    SetupFormat(&fmt, VLC_CODEC_RGBA, width, height);
+    picture_t *picture = picture_NewFromFormat(&fmt);
+    assert(picture != NULL);
+    return picture;
+}
+
+/* Puts a region filled with the given value, scaled to the given size */
+static picture_t *Put(spu_region_cache_t *cache, uint8_t value,
+                      unsigned width, unsigned height)
+{
+    video_format_t fmt;
+    SetupFormat(&fmt, VLC_CODEC_YUVA, WIDTH, HEIGHT);
+    picture_t *source = NewSource(&fmt, value);
+    picture_t *output = NewOutput(width, height);
+
+    spu_region_cache_Put(cache, &fmt, source,
+                         spu_region_cache_Hash(source),
+                         VLC_CODEC_RGBA, width, height, output);
+    picture_Release(source);
+    picture_Release(output);
+    return output;
+}
+
+/* Looks up a region filled with the given value */
+static picture_t *Get(spu_region_cache_t *cache, uint8_t value,
+                      unsigned width, unsigned height)
+{
+    video_format_t fmt;
+    SetupFormat(&fmt, VLC_CODEC_YUVA, WIDTH, HEIGHT);
+    picture_t *source = NewSource(&fmt, value);
+
+    picture_t *output = spu_region_cache_Get(cache, &fmt, source,
+                                             spu_region_cache_Hash(source),
+                                             VLC_CODEC_RGBA, width, height);
+    picture_Release(source);
+    if (output)
+        picture_Release(output); /* still held by the cache */
+    return output;
+}
+
+static void test_reuse(spu_region_cache_t *cache)
+{
+    video_format_t fmt;
+    SetupFormat(&fmt, VLC_CODEC_YUVA, WIDTH, HEIGHT);
+    picture_t *source = NewSource(&fmt, 0x10);
+    picture_t *output = NewOutput(2 * WIDTH, 2 * HEIGHT);
+    const uint64_t hash = spu_region_cache_Hash(source);
+
+    spu_region_cache_Put(cache, &fmt, source, hash, VLC_CODEC_RGBA,
+                         2 * WIDTH, 2 * HEIGHT, output);
+
+    picture_t *hit = spu_region_cache_Get(cache, &fmt, source, hash,
+                                          VLC_CODEC_RGBA,
+                                          2 * WIDTH, 2 * HEIGHT);
+    assert(hit == output);
+    picture_Release(hit);
+    assert(cache->hits == 1);
+
+    /* Another output size or chroma is another conversion */
+    assert(spu_region_cache_Get(cache, &fmt, source, hash, VLC_CODEC_RGBA,
+                                WIDTH, HEIGHT) == NULL);
+    assert(spu_region_cache_Get(cache, &fmt, source, hash, VLC_CODEC_YUVA,
+                                2 * WIDTH, 2 * HEIGHT) == NULL);
+
+    /* The producer draws into the same picture: the cached result must not
+     * be returned, even for a stale or colliding hash */
+    source->p[0].p_pixels[source->p[0].i_pitch + 1] ^= 0xff;
+    assert(spu_region_cache_Get(cache, &fmt, source, hash, VLC_CODEC_RGBA,
+                                2 * WIDTH, 2 * HEIGHT) == NULL);
+    assert(spu_region_cache_Get(cache, &fmt, source,
+                                spu_region_cache_Hash(source),
+                                VLC_CODEC_RGBA,
+                                2 * WIDTH, 2 * HEIGHT) == NULL);
+
+    /* The cache compared against the content it was given */
+    source->p[0].p_pixels[source->p[0].i_pitch + 1] ^= 0xff;
+    hit = spu_region_cache_Get(cache, &fmt, source, hash, VLC_CODEC_RGBA,
+                               2 * WIDTH, 2 * HEIGHT);
+    assert(hit == output);
+    picture_Release(hit);
+
+    picture_Release(source);
+    picture_Release(output);
+    spu_region_cache_Flush(cache);
+}
+
+static void test_palette(spu_region_cache_t *cache)
+{
+    video_format_t fmt;
+    SetupFormat(&fmt, VLC_CODEC_YUVP, WIDTH, HEIGHT);
+    fmt.p_palette = calloc(1, sizeof (*fmt.p_palette));
+    assert(fmt.p_palette != NULL);
+    fmt.p_palette->i_entries = 4;
+    for (int i = 0; i < 4; i++)
+        memset(fmt.p_palette->palette[i], 0x40 * i, 4);
+
+    picture_t *source = NewSource(&fmt, 1);
+    picture_t *output = NewOutput(WIDTH, HEIGHT);
+    const uint64_t hash = spu_region_cache_Hash(source);
+
+    spu_region_cache_Put(cache, &fmt, source, hash, VLC_CODEC_RGBA,
+                         WIDTH, HEIGHT, output);
+
+    /* The cache keeps its own copy of the palette */
+    video_format_t same;
+    assert(video_format_Copy(&same, &fmt) == VLC_SUCCESS);
+    picture_t *hit = spu_region_cache_Get(cache, &same, source, hash,
+                                          VLC_CODEC_RGBA, WIDTH, HEIGHT);
+    assert(hit == output);
+    picture_Release(hit);
+    video_format_Clean(&same);
+
+    /* Same indices, other colors */
+    fmt.p_palette->palette[1][0] ^= 0xff;
+    assert(spu_region_cache_Get(cache, &fmt, source, hash, VLC_CODEC_RGBA,
+                                WIDTH, HEIGHT) == NULL);
+    fmt.p_palette->palette[1][0] ^= 0xff;
+
+    /* Fewer entries */
+    fmt.p_palette->i_entries = 2;
+    assert(spu_region_cache_Get(cache, &fmt, source, hash, VLC_CODEC_RGBA,
+                                WIDTH, HEIGHT) == NULL);
+    fmt.p_palette->i_entries = 4;
+
+    hit = spu_region_cache_Get(cache, &fmt, source, hash, VLC_CODEC_RGBA,
+                               WIDTH, HEIGHT);
+    assert(hit == output);
+    picture_Release(hit);
+
+    picture_Release(source);
+    picture_Release(output);
+    video_format_Clean(&fmt);
+    spu_region_cache_Flush(cache);
+}
+
+static void test_evict_count(spu_region_cache_t *cache)
+{
+    picture_t *outputs[SPU_REGION_CACHE_MAX_COUNT + 1];
+
+    for (unsigned i = 0; i < SPU_REGION_CACHE_MAX_COUNT; i++)
+        outputs[i] = Put(cache, i, WIDTH, HEIGHT);
+    assert(cache->entries.size == SPU_REGION_CACHE_MAX_COUNT);
+
+    /* Use the oldest entry, so that the second one is evicted instead */
+    assert(Get(cache, 0, WIDTH, HEIGHT) == outputs[0]);
+
+    outputs[SPU_REGION_CACHE_MAX_COUNT] =
+        Put(cache, SPU_REGION_CACHE_MAX_COUNT, WIDTH, HEIGHT);
+    assert(cache->entries.size == SPU_REGION_CACHE_MAX_COUNT);
+
+    assert(Get(cache, 1, WIDTH, HEIGHT) == NULL);
+    for (unsigned i = 0; i <= SPU_REGION_CACHE_MAX_COUNT; i++)
+        if (i != 1)
+            assert(Get(cache, i, WIDTH, HEIGHT) == outputs[i]);
+
+    spu_region_cache_Flush(cache);
+    assert(cache->entries.size == 0);
+    assert(cache->size == 0);
+    assert(Get(cache, 0, WIDTH, HEIGHT) == NULL);
+}
+
+static void test_evict_size(spu_region_cache_t *cache)
+{
+    /* Each entry takes a bit more than an eighth of the cache */
+    const unsigned width = 1024, height = SPU_REGION_CACHE_MAX_SIZE / 8 / 4 / width;
+    picture_t *outputs[8];
+
+    for (unsigned i = 0; i < 8; i++)
+    {
+        outputs[i] = Put(cache, i, width, height);
+        assert(cache->size <= SPU_REGION_CACHE_MAX_SIZE);
+    }
+    assert(cache->entries.size < 8);
+    assert(Get(cache, 0, width, height) == NULL);
+    assert(Get(cache, 7, width, height) == outputs[7]);
+
+    /* An entry larger than a quarter of the cache is not kept, and does not
+     * evict anything */
+    const size_t count = cache->entries.size;
+    const size_t size = cache->size;
+    Put(cache, 8, 2 * width, 2 * height);
+    assert(cache->entries.size == count);
+    assert(cache->size == size);
+    assert(Get(cache, 8, 2 * width, 2 * height) == NULL);
+
+    spu_region_cache_Flush(cache);
+    assert(cache->size == 0);
+}
+
+int main(void)
+{
+    test_init();
+
+    spu_region_cache_t cache;
+    spu_region_cache_Init(&cache);
+
+    test_reuse(&cache);
+    test_palette(&cache);
+    test_evict_count(&cache);
+    test_evict_size(&cache);
+
+    spu_region_cache_Clean(&cache);
+    return 0;
+}